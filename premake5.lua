@@ -27,6 +27,16 @@ defines({
   "UNICODE",
 })
 
+newoption({
+  trigger = "global-lock-profiling",
+  description = "Record per-call-site contention statistics for the global critical region",
+})
+if _OPTIONS["global-lock-profiling"] then
+  defines({
+    "XE_ENABLE_GLOBAL_LOCK_PROFILING=1",
+  })
+end
+
 cppdialect("C++17")
 exceptionhandling("On")
 rtti("On")
@@ -301,6 +311,7 @@ workspace("xenia")
   include("src/xenia/gpu/vulkan")
   include("src/xenia/hid")
   include("src/xenia/hid/nop")
+  include("src/xenia/hid/replay")
   include("src/xenia/kernel")
   include("src/xenia/patcher")
   include("src/xenia/ui")
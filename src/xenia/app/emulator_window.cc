@@ -26,10 +26,12 @@
 #include "xenia/base/cvar.h"
 #include "xenia/base/debugging.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/math.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/profiling.h"
 #include "xenia/base/system.h"
 #include "xenia/base/threading.h"
+#include "xenia/base/timeline.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/emulator.h"
 #include "xenia/gpu/command_processor.h"
@@ -548,6 +550,70 @@ void EmulatorWindow::DisplayConfigDialog::OnDraw(ImGuiIO& io) {
   }
 }
 
+void EmulatorWindow::GlobalLockProfilerDialog::OnDraw(ImGuiIO& io) {
+  ImGui::SetNextWindowPos(ImVec2(20, 20), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(960, 480), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowBgAlpha(0.8f);
+  bool dialog_open = true;
+  if (!ImGui::Begin("Global Lock Contention", &dialog_open,
+                    ImGuiWindowFlags_NoCollapse |
+                        ImGuiWindowFlags_HorizontalScrollbar)) {
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::Button("Reset")) {
+    GlobalLockProfiler::Reset();
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Dump to Log")) {
+    GlobalLockProfiler::Dump(sort_key_);
+  }
+  ImGui::TextUnformatted(
+      "Click a column header to sort by it. Times are in microseconds.");
+  ImGui::Separator();
+
+  using SortKey = GlobalLockProfiler::SortKey;
+  static const std::pair<const char*, SortKey> kSortableColumns[] = {
+      {"Acquires", SortKey::kAcquireCount},
+      {"Contended", SortKey::kContendedCount},
+      {"Wait", SortKey::kTotalWait},
+      {"Max wait", SortKey::kMaxWait},
+      {"Hold", SortKey::kTotalHold},
+      {"Max hold", SortKey::kMaxHold},
+  };
+  ImGui::Columns(int(xe::countof(kSortableColumns)) + 1, "global_lock_sites");
+  for (const auto& column : kSortableColumns) {
+    if (ImGui::Selectable(column.first, sort_key_ == column.second)) {
+      sort_key_ = column.second;
+    }
+    ImGui::NextColumn();
+  }
+  ImGui::TextUnformatted("Site");
+  ImGui::NextColumn();
+  ImGui::Separator();
+  for (const GlobalLockProfiler::SiteStats& site :
+       GlobalLockProfiler::Snapshot(sort_key_)) {
+    for (uint64_t value :
+         {site.acquire_count, site.contended_count, site.total_wait_us,
+          site.max_wait_us, site.total_hold_us, site.max_hold_us}) {
+      ImGui::Text("%llu", static_cast<unsigned long long>(value));
+      ImGui::NextColumn();
+    }
+    ImGui::Text("%s:%u (%s)", site.file, site.line, site.function);
+    ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+
+  ImGui::End();
+
+  if (!dialog_open) {
+    emulator_window_.ToggleGlobalLockProfilerDialog();
+    // `this` might have been destroyed by ToggleGlobalLockProfilerDialog.
+    return;
+  }
+}
+
 bool EmulatorWindow::Initialize() {
   window_->AddListener(&window_listener_);
   window_->AddInputListener(&window_listener_, kZOrderEmulatorWindowInput);
@@ -613,6 +679,14 @@ bool EmulatorWindow::Initialize() {
     cpu_menu->AddChild(MenuItem::Create(MenuItem::Type::kString,
                                         "&Pause/Resume Profiler", "`",
                                         []() { Profiler::TogglePause(); }));
+    cpu_menu->AddChild(MenuItem::Create(MenuItem::Type::kString,
+                                        "Start/Stop &Timeline Recording",
+                                        []() { Timeline::Toggle(); }));
+    if (GlobalLockProfiler::is_enabled()) {
+      cpu_menu->AddChild(MenuItem::Create(
+          MenuItem::Type::kString, "Global &Lock Contention...",
+          std::bind(&EmulatorWindow::ToggleGlobalLockProfilerDialog, this)));
+    }
   }
   cpu_menu->AddChild(MenuItem::Create(MenuItem::Type::kSeparator));
   {
@@ -1324,6 +1398,15 @@ void EmulatorWindow::ToggleDisplayConfigDialog() {
   }
 }
 
+void EmulatorWindow::ToggleGlobalLockProfilerDialog() {
+  if (!global_lock_profiler_dialog_) {
+    global_lock_profiler_dialog_ = std::unique_ptr<GlobalLockProfilerDialog>(
+        new GlobalLockProfilerDialog(imgui_drawer_.get(), *this));
+  } else {
+    global_lock_profiler_dialog_.reset();
+  }
+}
+
 void EmulatorWindow::ToggleControllerVibration() {
   auto input_sys = emulator()->input_system();
   if (input_sys) {
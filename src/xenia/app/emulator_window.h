@@ -13,6 +13,7 @@
 #include <memory>
 #include <string>
 
+#include "xenia/base/global_lock_profiler.h"
 #include "xenia/emulator.h"
 #include "xenia/gpu/command_processor.h"
 #include "xenia/ui/imgui_dialog.h"
@@ -183,6 +184,21 @@ class EmulatorWindow {
     EmulatorWindow& emulator_window_;
   };
 
+  class GlobalLockProfilerDialog final : public ui::ImGuiDialog {
+   public:
+    GlobalLockProfilerDialog(ui::ImGuiDrawer* imgui_drawer,
+                             EmulatorWindow& emulator_window)
+        : ui::ImGuiDialog(imgui_drawer), emulator_window_(emulator_window) {}
+
+   protected:
+    void OnDraw(ImGuiIO& io) override;
+
+   private:
+    EmulatorWindow& emulator_window_;
+    GlobalLockProfiler::SortKey sort_key_ =
+        GlobalLockProfiler::SortKey::kTotalWait;
+  };
+
   explicit EmulatorWindow(Emulator* emulator,
                           ui::WindowedAppContext& app_context, uint32_t width,
                           uint32_t height);
@@ -224,6 +240,7 @@ class EmulatorWindow {
   void GpuTraceFrame();
   void GpuClearCaches();
   void ToggleDisplayConfigDialog();
+  void ToggleGlobalLockProfilerDialog();
   void ToggleControllerVibration();
   void ShowCompatibility();
   void ShowFAQ();
@@ -262,6 +279,7 @@ class EmulatorWindow {
   bool initializing_shader_storage_ = false;
 
   std::unique_ptr<DisplayConfigDialog> display_config_dialog_;
+  std::unique_ptr<GlobalLockProfilerDialog> global_lock_profiler_dialog_;
 
   std::vector<RecentTitleEntry> recently_launched_titles_;
 };
@@ -16,6 +16,7 @@ project("xenia-app")
     "xenia-gpu-vulkan",
     "xenia-hid",
     "xenia-hid-nop",
+    "xenia-hid-replay",
     "xenia-kernel",
     "xenia-patcher",
     "xenia-ui",
@@ -10,3 +10,15 @@
 #include "xenia/apu/apu_flags.h"
 
 DEFINE_bool(mute, false, "Mutes all audio output.", "APU")
+
+DEFINE_uint32(apu_target_queued_frames, 4,
+              "Number of audio frames (256 samples, about 5.3 ms, each) that "
+              "drivers with latency control initially try to keep queued for "
+              "playback. Raised automatically when playback runs out of frames "
+              "and lowered back after it has been stable for some time.",
+              "APU");
+DEFINE_bool(apu_drift_correction, true,
+            "Slightly resample the audio to keep the number of queued frames "
+            "near the target, stretching it rather than crackling when the "
+            "emulation runs below full speed.",
+            "APU");
@@ -13,4 +13,8 @@
 #include "xenia/base/cvar.h"
 DECLARE_bool(mute)
 
+DECLARE_uint32(apu_max_queued_frames)
+DECLARE_uint32(apu_target_queued_frames)
+DECLARE_bool(apu_drift_correction)
+
 #endif  // XENIA_APU_APU_FLAGS_H_
@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_APU_AUDIO_FRAME_RING_H_
+#define XENIA_APU_AUDIO_FRAME_RING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "xenia/base/assert.h"
+
+namespace xe {
+namespace apu {
+
+// Single-producer, single-consumer queue of fixed-size audio frames with all
+// the storage allocated upfront, for passing frames from the audio worker to
+// the real-time callback of the host audio API without allocating memory or
+// taking locks on either side.
+class AudioFrameRing {
+ public:
+  AudioFrameRing(uint32_t frame_count, uint32_t frame_samples)
+      : frame_count_(frame_count),
+        frame_samples_(frame_samples),
+        samples_(new float[size_t(frame_count) * frame_samples]) {
+    assert_not_zero(frame_count);
+  }
+  AudioFrameRing(const AudioFrameRing& ring) = delete;
+  AudioFrameRing& operator=(const AudioFrameRing& ring) = delete;
+
+  uint32_t frame_count() const { return frame_count_; }
+  uint32_t frame_samples() const { return frame_samples_; }
+
+  // Approximate when called by either side while the other is active, exact
+  // for the frames visible to the caller.
+  uint32_t queued_frame_count() const {
+    return write_index_.load(std::memory_order_acquire) -
+           read_index_.load(std::memory_order_acquire);
+  }
+
+  // Producer side. Returns nullptr if the ring is full, otherwise the frame to
+  // fill before calling EndWrite.
+  float* BeginWrite() {
+    uint32_t write_index = write_index_.load(std::memory_order_relaxed);
+    if (write_index - read_index_.load(std::memory_order_acquire) >=
+        frame_count_) {
+      return nullptr;
+    }
+    return GetFrame(write_index);
+  }
+  void EndWrite() {
+    write_index_.store(write_index_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+  }
+
+  // Consumer side. Returns nullptr if the ring is empty, otherwise the oldest
+  // frame, which stays valid until EndRead.
+  const float* BeginRead() const {
+    uint32_t read_index = read_index_.load(std::memory_order_relaxed);
+    if (write_index_.load(std::memory_order_acquire) == read_index) {
+      return nullptr;
+    }
+    return GetFrame(read_index);
+  }
+  void EndRead() {
+    read_index_.store(read_index_.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+  }
+
+ private:
+  float* GetFrame(uint32_t index) const {
+    return samples_.get() + size_t(index % frame_count_) * frame_samples_;
+  }
+
+  uint32_t frame_count_;
+  uint32_t frame_samples_;
+  std::unique_ptr<float[]> samples_;
+  // Free-running, wrapping around, so the queued frame count is the difference
+  // even after an overflow. On separate cache lines to avoid false sharing
+  // between the producer and the consumer.
+  alignas(64) std::atomic<uint32_t> write_index_ = {0};
+  alignas(64) std::atomic<uint32_t> read_index_ = {0};
+};
+
+}  // namespace apu
+}  // namespace xe
+
+#endif  // XENIA_APU_AUDIO_FRAME_RING_H_
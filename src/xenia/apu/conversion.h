@@ -21,51 +21,46 @@ namespace conversion {
 
 #if XE_ARCH_AMD64
 
-XE_NOINLINE
-static void _generic_sequential_6_BE_to_interleaved_6_LE(
-    float* XE_RESTRICT output, const float* XE_RESTRICT input,
-    unsigned ch_sample_count) {
-  for (unsigned sample = 0; sample < ch_sample_count; sample++) {
-    for (unsigned channel = 0; channel < 6; channel++) {
-      unsigned int value = *reinterpret_cast<const unsigned int*>(
-          &input[channel * ch_sample_count + sample]);
-
-      *reinterpret_cast<unsigned int*>(&output[sample * 6 + channel]) =
-          xe::byte_swap(value);
+inline void sequential_6_BE_to_interleaved_6_LE(float* output,
+                                                const float* input,
+                                                size_t ch_sample_count) {
+  const __m128i byte_swap_shuffle =
+      _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  size_t sample = 0;
+  // Byte swap and transpose 4 samples of all 6 channels at once.
+  for (; sample + 4 <= ch_sample_count; sample += 4) {
+    __m128 channels[6];
+    for (size_t channel = 0; channel < 6; ++channel) {
+      channels[channel] = _mm_castsi128_ps(_mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+              &input[channel * ch_sample_count + sample])),
+          byte_swap_shuffle));
     }
+    // Channel pairs for samples 0 and 1 (lo), and for samples 2 and 3 (hi).
+    __m128 ch01_lo = _mm_unpacklo_ps(channels[0], channels[1]);
+    __m128 ch01_hi = _mm_unpackhi_ps(channels[0], channels[1]);
+    __m128 ch23_lo = _mm_unpacklo_ps(channels[2], channels[3]);
+    __m128 ch23_hi = _mm_unpackhi_ps(channels[2], channels[3]);
+    __m128 ch45_lo = _mm_unpacklo_ps(channels[4], channels[5]);
+    __m128 ch45_hi = _mm_unpackhi_ps(channels[4], channels[5]);
+    float* sample_output = &output[sample * 6];
+    _mm_storeu_ps(sample_output, _mm_movelh_ps(ch01_lo, ch23_lo));
+    _mm_storeu_ps(sample_output + 4,
+                  _mm_shuffle_ps(ch45_lo, ch01_lo, _MM_SHUFFLE(3, 2, 1, 0)));
+    _mm_storeu_ps(sample_output + 8, _mm_movehl_ps(ch45_lo, ch23_lo));
+    _mm_storeu_ps(sample_output + 12, _mm_movelh_ps(ch01_hi, ch23_hi));
+    _mm_storeu_ps(sample_output + 16,
+                  _mm_shuffle_ps(ch45_hi, ch01_hi, _MM_SHUFFLE(3, 2, 1, 0)));
+    _mm_storeu_ps(sample_output + 20, _mm_movehl_ps(ch45_hi, ch23_hi));
   }
-}
-#if XE_COMPILER_CLANG_CL != 1
-// load_be_u32 unavailable on clang-cl
-XE_NOINLINE
-static void _movbe_sequential_6_BE_to_interleaved_6_LE(
-    float* XE_RESTRICT output, const float* XE_RESTRICT input,
-    unsigned ch_sample_count) {
-  for (unsigned sample = 0; sample < ch_sample_count; sample++) {
-    for (unsigned channel = 0; channel < 6; channel++) {
-      *reinterpret_cast<unsigned int*>(&output[sample * 6 + channel]) =
-          _load_be_u32(reinterpret_cast<const unsigned int*>(
-              &input[channel * ch_sample_count + sample]));
+  for (; sample < ch_sample_count; ++sample) {
+    for (size_t channel = 0; channel < 6; ++channel) {
+      output[sample * 6 + channel] =
+          xe::byte_swap(input[channel * ch_sample_count + sample]);
     }
   }
 }
 
-inline static void sequential_6_BE_to_interleaved_6_LE(
-    float* output, const float* input, unsigned ch_sample_count) {
-  if (amd64::GetFeatureFlags() & amd64::kX64EmitMovbe) {
-    _movbe_sequential_6_BE_to_interleaved_6_LE(output, input, ch_sample_count);
-  } else {
-    _generic_sequential_6_BE_to_interleaved_6_LE(output, input,
-                                                 ch_sample_count);
-  }
-}
-#else
-inline static void sequential_6_BE_to_interleaved_6_LE(
-    float* output, const float* input, unsigned ch_sample_count) {
-  _generic_sequential_6_BE_to_interleaved_6_LE(output, input, ch_sample_count);
-}
-#endif
-
 inline void sequential_6_BE_to_interleaved_2_LE(float* output,
                                                 const float* input,
                                                 size_t ch_sample_count) {
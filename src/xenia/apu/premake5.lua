@@ -17,3 +17,37 @@ project("xenia-apu")
     project_root.."/third_party/FFmpeg/",
   })
   local_platform_files()
+
+group("src")
+project("xenia-apu-xma-bench")
+  uuid("5c0e7a92-3d4f-4b61-8e2a-9f17c6d3b508")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "capstone", -- cpu-backend-x64
+    "fmt",
+    "imgui",
+    "libavcodec",
+    "libavutil",
+    "mspack",
+    "xenia-apu",
+    "xenia-base",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-kernel",
+    "xenia-patcher",
+  })
+  includedirs({
+    project_root.."/third_party/FFmpeg/",
+  })
+  files({
+    "xma_bench_main.cc",
+    "../base/console_app_main_"..platform_suffix..".cc",
+  })
+  filter("architecture:x86_64")
+    links({
+      "xenia-cpu-backend-x64",
+    })
+  filter({})
+
+include("testing")
@@ -9,13 +9,15 @@
 
 #include "xenia/apu/sdl/sdl_audio_driver.h"
 
-#include <array>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include "xenia/apu/apu_flags.h"
 #include "xenia/apu/conversion.h"
 #include "xenia/base/assert.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/math.h"
 #include "xenia/base/profiling.h"
 #include "xenia/helper/sdl/sdl_helper.h"
 
@@ -23,14 +25,21 @@ namespace xe {
 namespace apu {
 namespace sdl {
 
+// Number of callbacks (of one frame each) without running out of frames after
+// which the target latency is lowered by one frame, about 2 seconds.
+constexpr uint32_t kTargetLatencyDecreaseCallbacks = 384;
+// Playback rate change per frame of deviation from the target latency, and
+// its limits - slowing down more than speeding up as that's done when the
+// emulation can't keep up, which is usually less noticeable than crackling.
+constexpr float kDriftCorrectionStep = 0.01f;
+constexpr float kDriftCorrectionMaxSlowdown = 0.1f;
+constexpr float kDriftCorrectionMaxSpeedup = 0.02f;
+
 SDLAudioDriver::SDLAudioDriver(Memory* memory,
                                xe::threading::Semaphore* semaphore)
     : AudioDriver(memory), semaphore_(semaphore) {}
 
-SDLAudioDriver::~SDLAudioDriver() {
-  assert_true(frames_queued_.empty());
-  assert_true(frames_unused_.empty());
-};
+SDLAudioDriver::~SDLAudioDriver() = default;
 
 bool SDLAudioDriver::Initialize() {
   SDL_version ver = {};
@@ -50,6 +59,15 @@ bool SDLAudioDriver::Initialize() {
   }
   sdl_initialized_ = true;
 
+  // Enough for all the frames the audio system may submit without waiting.
+  frames_ = std::make_unique<AudioFrameRing>(
+      std::max(cvars::apu_max_queued_frames, uint32_t(16)), frame_samples_);
+  min_target_queued_frames_ =
+      std::clamp(cvars::apu_target_queued_frames, uint32_t(1),
+                 frames_->frame_count());
+  target_queued_frames_ = min_target_queued_frames_;
+  statistics_max_target_queued_frames_ = target_queued_frames_;
+
   SDL_AudioSpec desired_spec = {};
   SDL_AudioSpec obtained_spec;
   desired_spec.freq = frame_frequency_;
@@ -88,23 +106,18 @@ bool SDLAudioDriver::Initialize() {
 
 void SDLAudioDriver::SubmitFrame(uint32_t frame_ptr) {
   const auto input_frame = memory_->TranslateVirtual<float*>(frame_ptr);
-  float* output_frame;
-  {
-    std::unique_lock<std::mutex> guard(frames_mutex_);
-    if (frames_unused_.empty()) {
-      output_frame = new float[frame_samples_];
-    } else {
-      output_frame = frames_unused_.top();
-      frames_unused_.pop();
-    }
-  }
-
-  std::memcpy(output_frame, input_frame, frame_samples_ * sizeof(float));
-
-  {
-    std::unique_lock<std::mutex> guard(frames_mutex_);
-    frames_queued_.push(output_frame);
+  float* output_frame = frames_->BeginWrite();
+  if (!output_frame) {
+    // The audio system shouldn't submit more frames than the ring can hold,
+    // but if it does, drop the frame and give its semaphore count back.
+    statistics_frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    auto ret = semaphore_->Release(1, nullptr);
+    assert_true(ret);
+    return;
   }
+  conversion::sequential_6_BE_to_interleaved_6_LE(output_frame, input_frame,
+                                                  channel_samples_);
+  frames_->EndWrite();
 }
 
 void SDLAudioDriver::Shutdown() {
@@ -116,15 +129,77 @@ void SDLAudioDriver::Shutdown() {
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
     sdl_initialized_ = false;
   }
-  std::unique_lock<std::mutex> guard(frames_mutex_);
-  while (!frames_unused_.empty()) {
-    delete[] frames_unused_.top();
-    frames_unused_.pop();
-  };
-  while (!frames_queued_.empty()) {
-    delete[] frames_queued_.front();
-    frames_queued_.pop();
-  };
+  if (frames_) {
+    XELOGI(
+        "SDLAudioDriver: played {} frames, {} underruns, {} dropped frames, "
+        "target latency up to {} frames",
+        statistics_frames_played_, statistics_underruns_,
+        statistics_frames_dropped_.load(std::memory_order_relaxed),
+        statistics_max_target_queued_frames_);
+  }
+}
+
+bool SDLAudioDriver::AdvanceFrame() {
+  if (read_frame_) {
+    std::memcpy(previous_frame_last_sample_,
+                read_frame_ + (channel_samples_ - 1) * frame_channels_,
+                sizeof(previous_frame_last_sample_));
+    read_frame_ = nullptr;
+    frames_->EndRead();
+    ++statistics_frames_played_;
+    ReleaseFrame();
+  }
+  read_frame_ = frames_->BeginRead();
+  return read_frame_ != nullptr;
+}
+
+void SDLAudioDriver::ReleaseFrame() {
+  if (frames_->queued_frame_count() >= target_queued_frames_) {
+    // Enough frames are queued already - don't let the audio system submit
+    // another one yet, lowering the latency.
+    ++withheld_frames_;
+    return;
+  }
+  // Below the target - also return one of the withheld counts to refill.
+  uint32_t release_count = 1;
+  if (withheld_frames_) {
+    --withheld_frames_;
+    ++release_count;
+  }
+  auto ret = semaphore_->Release(release_count, nullptr);
+  assert_true(ret);
+}
+
+void SDLAudioDriver::UpdateTargetLatency(bool underrun) {
+  if (underrun) {
+    ++statistics_underruns_;
+    stable_callbacks_ = 0;
+    if (target_queued_frames_ < frames_->frame_count()) {
+      ++target_queued_frames_;
+      statistics_max_target_queued_frames_ = std::max(
+          statistics_max_target_queued_frames_, target_queued_frames_);
+    }
+    return;
+  }
+  if (++stable_callbacks_ >= kTargetLatencyDecreaseCallbacks) {
+    stable_callbacks_ = 0;
+    if (target_queued_frames_ > min_target_queued_frames_) {
+      --target_queued_frames_;
+    }
+  }
+}
+
+float SDLAudioDriver::GetResamplingRatio() const {
+  // Frames are consumed one by one while the producer refills, so deviating
+  // by one frame is normal.
+  int32_t deviation = int32_t(frames_->queued_frame_count()) -
+                      int32_t(target_queued_frames_);
+  if (deviation >= -1 && deviation <= 1) {
+    return 1.0f;
+  }
+  return 1.0f + xe::clamp_float(float(deviation) * kDriftCorrectionStep,
+                                -kDriftCorrectionMaxSlowdown,
+                                kDriftCorrectionMaxSpeedup);
 }
 
 void SDLAudioDriver::SDLCallback(void* userdata, Uint8* stream, int len) {
@@ -134,38 +209,89 @@ void SDLAudioDriver::SDLCallback(void* userdata, Uint8* stream, int len) {
     return;
   }
   const auto driver = static_cast<SDLAudioDriver*>(userdata);
+  const uint32_t output_channels = driver->sdl_device_channels_;
   assert_true(len ==
               sizeof(float) * channel_samples_ * driver->sdl_device_channels_);
 
-  std::unique_lock<std::mutex> guard(driver->frames_mutex_);
-  if (driver->frames_queued_.empty()) {
+  if (!driver->read_frame_ && !driver->AdvanceFrame()) {
+    // Only count running out of frames during playback, not while paused or
+    // before the title has started submitting.
+    if (driver->playing_) {
+      driver->playing_ = false;
+      driver->UpdateTargetLatency(true);
+    }
     std::memset(stream, 0, len);
-  } else {
-    auto buffer = driver->frames_queued_.front();
-    driver->frames_queued_.pop();
-    if (cvars::mute) {
-      std::memset(stream, 0, len);
-    } else {
-      switch (driver->sdl_device_channels_) {
-        case 2:
-          conversion::sequential_6_BE_to_interleaved_2_LE(
-              reinterpret_cast<float*>(stream), buffer, channel_samples_);
-          break;
-        case 6:
-          conversion::sequential_6_BE_to_interleaved_6_LE(
-              reinterpret_cast<float*>(stream), buffer, channel_samples_);
-          break;
-        default:
-          assert_unhandled_case(driver->sdl_device_channels_);
-          break;
+    return;
+  }
+  driver->playing_ = true;
+
+  const float ratio =
+      cvars::apu_drift_correction ? driver->GetResamplingRatio() : 1.0f;
+  const uint32_t output_samples =
+      uint32_t(len) / (sizeof(float) * output_channels);
+  auto output = reinterpret_cast<float*>(stream);
+  double position = driver->read_position_;
+  uint32_t sample = 0;
+  bool underrun = false;
+  for (; sample < output_samples; ++sample) {
+    while (position >= double(channel_samples_ - 1)) {
+      if (!driver->AdvanceFrame()) {
+        underrun = true;
+        break;
       }
+      position -= double(channel_samples_);
     }
-    driver->frames_unused_.push(buffer);
+    if (underrun) {
+      break;
+    }
+    // Linear interpolation between the two source samples around the
+    // position.
+    int32_t index = int32_t(std::floor(position));
+    float factor = float(position - double(index));
+    const float* sample_0 =
+        index < 0 ? driver->previous_frame_last_sample_
+                  : driver->read_frame_ + index * frame_channels_;
+    const float* sample_1 = driver->read_frame_ + (index + 1) * frame_channels_;
+    float interpolated[frame_channels_];
+    for (uint32_t i = 0; i < frame_channels_; ++i) {
+      interpolated[i] = sample_0[i] + (sample_1[i] - sample_0[i]) * factor;
+    }
+    float* output_sample = output + sample * output_channels;
+    switch (output_channels) {
+      case 2: {
+        // Default 5.1 channel mapping is fl, fr, fc, lf, bl, br - put center
+        // on left and right, discard low frequency.
+        float center_halved = interpolated[2] * 0.5f;
+        output_sample[0] =
+            (interpolated[0] + interpolated[4] + center_halved) * (1.0f / 2.5f);
+        output_sample[1] =
+            (interpolated[1] + interpolated[5] + center_halved) * (1.0f / 2.5f);
+      } break;
+      case 6:
+        std::memcpy(output_sample, interpolated, sizeof(interpolated));
+        break;
+      default:
+        assert_unhandled_case(output_channels);
+        break;
+    }
+    position += ratio;
+  }
 
-    auto ret = driver->semaphore_->Release(1, nullptr);
-    assert_true(ret);
+  if (underrun) {
+    // Resume from the last played sample when new frames arrive.
+    std::memset(output + sample * output_channels, 0,
+                sizeof(float) * (output_samples - sample) * output_channels);
+    position = -1.0;
+    driver->playing_ = false;
   }
-};
+  driver->read_position_ = position;
+  driver->UpdateTargetLatency(underrun);
+
+  if (cvars::mute) {
+    std::memset(stream, 0, len);
+  }
+}
+
 }  // namespace sdl
 }  // namespace apu
 }  // namespace xe
@@ -10,12 +10,13 @@
 #ifndef XENIA_APU_SDL_SDL_AUDIO_DRIVER_H_
 #define XENIA_APU_SDL_SDL_AUDIO_DRIVER_H_
 
-#include <mutex>
-#include <queue>
-#include <stack>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
 #include "SDL.h"
 #include "xenia/apu/audio_driver.h"
+#include "xenia/apu/audio_frame_ring.h"
 #include "xenia/base/threading.h"
 
 namespace xe {
@@ -34,6 +35,16 @@ class SDLAudioDriver : public AudioDriver {
  protected:
   static void SDLCallback(void* userdata, Uint8* stream, int len);
 
+  // Consumer side, only called from the SDL callback.
+  // Moves the read position to the next frame, returning false if none is
+  // queued.
+  bool AdvanceFrame();
+  // Returns the semaphore count for a consumed frame to the audio system, or
+  // withholds it if the number of queued frames is above the target latency.
+  void ReleaseFrame();
+  void UpdateTargetLatency(bool underrun);
+  float GetResamplingRatio() const;
+
   xe::threading::Semaphore* semaphore_ = nullptr;
 
   SDL_AudioDeviceID sdl_device_id_ = -1;
@@ -45,9 +56,31 @@ class SDLAudioDriver : public AudioDriver {
   static const uint32_t channel_samples_ = 256;
   static const uint32_t frame_samples_ = frame_channels_ * channel_samples_;
   static const uint32_t frame_size_ = sizeof(float) * frame_samples_;
-  std::queue<float*> frames_queued_ = {};
-  std::stack<float*> frames_unused_ = {};
-  std::mutex frames_mutex_ = {};
+
+  // Frames in the interleaved little-endian format, converted on submission
+  // so the real-time callback does as little work as possible.
+  std::unique_ptr<AudioFrameRing> frames_;
+
+  // Consumer state.
+  const float* read_frame_ = nullptr;
+  // Position of the next output sample in the read frame, in [-1,
+  // channel_samples_ - 1), -1 referring to the last sample of the previous
+  // frame, for interpolation across frame boundaries.
+  double read_position_ = -1.0;
+  float previous_frame_last_sample_[frame_channels_] = {};
+  bool playing_ = false;
+  // Minimum and current number of queued frames the consumer tries to keep,
+  // and the number of semaphore counts withheld to reduce the latency.
+  uint32_t min_target_queued_frames_ = 0;
+  uint32_t target_queued_frames_ = 0;
+  uint32_t withheld_frames_ = 0;
+  uint32_t stable_callbacks_ = 0;
+
+  // Statistics, written by the consumer except for the dropped frames.
+  uint64_t statistics_frames_played_ = 0;
+  uint32_t statistics_underruns_ = 0;
+  uint32_t statistics_max_target_queued_frames_ = 0;
+  std::atomic<uint32_t> statistics_frames_dropped_ = {0};
 };
 
 }  // namespace sdl
@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdint>
+#include <thread>
+
+#include "xenia/apu/audio_frame_ring.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::apu::test {
+
+// Fills the next frame with samples identifying it, returning whether there
+// was space for it.
+bool WriteFrame(AudioFrameRing& ring, uint32_t frame_number) {
+  float* frame = ring.BeginWrite();
+  if (!frame) {
+    return false;
+  }
+  for (uint32_t i = 0; i < ring.frame_samples(); ++i) {
+    frame[i] = float(frame_number * ring.frame_samples() + i);
+  }
+  ring.EndWrite();
+  return true;
+}
+
+// Checks that the oldest frame is the expected one and consumes it, returning
+// whether there was a frame to read.
+bool ReadFrame(AudioFrameRing& ring, uint32_t frame_number) {
+  const float* frame = ring.BeginRead();
+  if (!frame) {
+    return false;
+  }
+  for (uint32_t i = 0; i < ring.frame_samples(); ++i) {
+    REQUIRE(frame[i] == float(frame_number * ring.frame_samples() + i));
+  }
+  ring.EndRead();
+  return true;
+}
+
+TEST_CASE("AUDIO_FRAME_RING_EMPTY_FULL", "[audio_frame_ring]") {
+  // Not a power of two to check the wrapping of the frame indices.
+  AudioFrameRing ring(3, 4);
+  REQUIRE(ring.frame_count() == 3);
+  REQUIRE(ring.frame_samples() == 4);
+  REQUIRE(ring.queued_frame_count() == 0);
+  REQUIRE(ring.BeginRead() == nullptr);
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    REQUIRE(WriteFrame(ring, i));
+    REQUIRE(ring.queued_frame_count() == i + 1);
+  }
+  REQUIRE(ring.BeginWrite() == nullptr);
+  REQUIRE_FALSE(WriteFrame(ring, 3));
+  REQUIRE(ring.queued_frame_count() == 3);
+
+  // A frame being read must not be overwritten before EndRead.
+  REQUIRE(ring.BeginRead() != nullptr);
+  REQUIRE(ring.BeginWrite() == nullptr);
+  REQUIRE(ReadFrame(ring, 0));
+  REQUIRE(ring.queued_frame_count() == 2);
+  REQUIRE(WriteFrame(ring, 3));
+  REQUIRE(ring.BeginWrite() == nullptr);
+
+  for (uint32_t i = 1; i < 4; ++i) {
+    REQUIRE(ReadFrame(ring, i));
+  }
+  REQUIRE(ring.queued_frame_count() == 0);
+  REQUIRE(ring.BeginRead() == nullptr);
+  REQUIRE_FALSE(ReadFrame(ring, 4));
+}
+
+TEST_CASE("AUDIO_FRAME_RING_WRAP_AROUND", "[audio_frame_ring]") {
+  AudioFrameRing ring(3, 4);
+  uint32_t write_frame_number = 0;
+  uint32_t read_frame_number = 0;
+
+  SECTION("One frame at a time") {
+    for (uint32_t i = 0; i < 10; ++i) {
+      REQUIRE(WriteFrame(ring, write_frame_number++));
+      REQUIRE(ring.queued_frame_count() == 1);
+      REQUIRE(ReadFrame(ring, read_frame_number++));
+      REQUIRE(ring.queued_frame_count() == 0);
+    }
+  }
+
+  SECTION("Filled and drained across the end") {
+    // Start at a position other than the beginning of the storage.
+    REQUIRE(WriteFrame(ring, write_frame_number++));
+    REQUIRE(ReadFrame(ring, read_frame_number++));
+    for (uint32_t i = 0; i < 5; ++i) {
+      while (WriteFrame(ring, write_frame_number)) {
+        ++write_frame_number;
+      }
+      REQUIRE(ring.queued_frame_count() == 3);
+      while (ReadFrame(ring, read_frame_number)) {
+        ++read_frame_number;
+      }
+      REQUIRE(ring.queued_frame_count() == 0);
+    }
+    REQUIRE(write_frame_number == 16);
+  }
+
+  REQUIRE(read_frame_number == write_frame_number);
+}
+
+TEST_CASE("AUDIO_FRAME_RING_THREADS", "[audio_frame_ring]") {
+  // The frames must arrive in order and intact with the producer and the
+  // consumer racing each other.
+  AudioFrameRing ring(5, 64);
+  const uint32_t frame_count = 100000;
+  std::thread producer([&ring, frame_count]() {
+    for (uint32_t i = 0; i < frame_count;) {
+      if (WriteFrame(ring, i)) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t read_frame_count = 0;
+  bool frames_valid = true;
+  while (read_frame_count < frame_count) {
+    const float* frame = ring.BeginRead();
+    if (!frame) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (uint32_t i = 0; i < ring.frame_samples(); ++i) {
+      if (frame[i] != float(read_frame_count * ring.frame_samples() + i)) {
+        frames_valid = false;
+        break;
+      }
+    }
+    ring.EndRead();
+    ++read_frame_count;
+  }
+  producer.join();
+  REQUIRE(frames_valid);
+  REQUIRE(read_frame_count == frame_count);
+  REQUIRE(ring.queued_frame_count() == 0);
+}
+
+}  // namespace xe::apu::test
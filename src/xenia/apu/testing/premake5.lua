@@ -0,0 +1,9 @@
+project_root = "../../../.."
+include(project_root.."/tools/build")
+
+test_suite("xenia-apu-tests", project_root, ".", {
+  links = {
+    "fmt",
+    "xenia-base",
+  },
+})
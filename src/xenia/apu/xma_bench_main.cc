@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xenia/apu/xma_capture.h"
+#include "xenia/apu/xma_context.h"
+#include "xenia/apu/xma_context_new.h"
+#include "xenia/apu/xma_context_old.h"
+#include "xenia/base/clock.h"
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/xxhash.h"
+#include "xenia/memory.h"
+
+DEFINE_path(xma_bench_capture, "",
+            "XMA capture file to replay, written with xma_capture_path.",
+            "APU");
+DEFINE_string(xma_bench_decoders, "both",
+              "XMA decoders to replay the capture with: old, new or both.",
+              "APU");
+
+namespace xe {
+namespace apu {
+
+namespace {
+
+struct CapturedPass {
+  XmaCaptureRecord record;
+  std::vector<uint8_t> input_buffers[2];
+};
+
+struct ReplayResult {
+  uint64_t pass_count = 0;
+  uint64_t sample_count = 0;
+  uint64_t input_bit_count = 0;
+  uint64_t ticks = 0;
+  uint64_t max_pass_ticks = 0;
+  uint64_t checksum = 0;
+};
+
+double TicksToMilliseconds(uint64_t ticks) {
+  return double(ticks) * 1000.0 / double(Clock::QueryHostTickFrequency());
+}
+
+// Approximate, assuming the decoder has moved to the other buffer if the
+// current one or the read offset has changed backwards.
+uint64_t GetConsumedInputBits(const XMA_CONTEXT_DATA& before,
+                              const XMA_CONTEXT_DATA& after) {
+  if (after.current_buffer == before.current_buffer &&
+      after.input_buffer_read_offset >= before.input_buffer_read_offset) {
+    return after.input_buffer_read_offset - before.input_buffer_read_offset;
+  }
+  uint32_t before_buffer_bits =
+      before.GetCurrentInputBufferPacketCount() * XmaContext::kBitsPerPacket;
+  uint32_t before_read_offset = before.input_buffer_read_offset;
+  return std::max(before_buffer_bits, before_read_offset) - before_read_offset +
+         after.input_buffer_read_offset;
+}
+
+template <typename Context>
+bool Replay(const std::vector<CapturedPass>& passes, Memory& memory,
+            ReplayResult& result) {
+  struct ReplayContext {
+    std::unique_ptr<Context> context;
+    uint32_t context_ptr = 0;
+    uint32_t input_buffer_ptrs[2] = {};
+    uint32_t output_buffer_ptr = 0;
+  };
+  std::unordered_map<uint32_t, ReplayContext> contexts;
+
+  // Allocate the guest memory for every context upfront so only the decoding
+  // is measured.
+  std::unordered_map<uint32_t, std::array<uint32_t, 2>> input_buffer_sizes;
+  for (const CapturedPass& pass : passes) {
+    std::array<uint32_t, 2>& sizes =
+        input_buffer_sizes[pass.record.context_id];
+    for (uint32_t i = 0; i < 2; ++i) {
+      sizes[i] = std::max(sizes[i], pass.record.input_buffer_sizes[i]);
+    }
+  }
+  bool contexts_set_up = true;
+  for (const auto& sizes_pair : input_buffer_sizes) {
+    ReplayContext& replay_context = contexts[sizes_pair.first];
+    replay_context.context_ptr = memory.SystemHeapAlloc(
+        sizeof(XMA_CONTEXT_DATA), 256, kSystemHeapPhysical);
+    for (uint32_t i = 0; i < 2; ++i) {
+      replay_context.input_buffer_ptrs[i] = memory.SystemHeapAlloc(
+          std::max(sizes_pair.second[i], XmaContext::kBytesPerPacket), 256,
+          kSystemHeapPhysical);
+    }
+    replay_context.output_buffer_ptr = memory.SystemHeapAlloc(
+        XmaContextNew::kOutputMaxSizeBytes, 256, kSystemHeapPhysical);
+    replay_context.context = std::make_unique<Context>();
+    if (replay_context.context->Setup(sizes_pair.first, &memory,
+                                      replay_context.context_ptr)) {
+      XELOGE("Failed to set up the XMA context {}", sizes_pair.first);
+      contexts_set_up = false;
+      break;
+    }
+    replay_context.context->set_is_allocated(true);
+  }
+
+  result = ReplayResult();
+  result.checksum = XXH3_64bits(nullptr, 0);
+  for (const CapturedPass& pass : passes) {
+    if (!contexts_set_up) {
+      break;
+    }
+    ReplayContext& replay_context = contexts[pass.record.context_id];
+    XMA_CONTEXT_DATA data(pass.record.context_data);
+    for (uint32_t i = 0; i < 2; ++i) {
+      if (pass.record.input_buffer_sizes[i]) {
+        std::memcpy(
+            memory.TranslateVirtual(replay_context.input_buffer_ptrs[i]),
+            pass.input_buffers[i].data(), pass.record.input_buffer_sizes[i]);
+      }
+    }
+    data.input_buffer_0_ptr =
+        memory.GetPhysicalAddress(replay_context.input_buffer_ptrs[0]);
+    data.input_buffer_1_ptr =
+        memory.GetPhysicalAddress(replay_context.input_buffer_ptrs[1]);
+    data.output_buffer_ptr =
+        memory.GetPhysicalAddress(replay_context.output_buffer_ptr);
+    void* guest_context_data =
+        memory.TranslateVirtual(replay_context.context_ptr);
+    data.Store(guest_context_data);
+
+    replay_context.context->Enable();
+    uint64_t pass_start = Clock::QueryHostTickCount();
+    replay_context.context->Work();
+    uint64_t pass_ticks = Clock::QueryHostTickCount() - pass_start;
+    ++result.pass_count;
+    result.ticks += pass_ticks;
+    result.max_pass_ticks = std::max(result.max_pass_ticks, pass_ticks);
+
+    XMA_CONTEXT_DATA data_after(guest_context_data);
+    result.input_bit_count += GetConsumedInputBits(data, data_after);
+    // The output buffer is a ring of 256-byte blocks, and the decoder only
+    // writes to its free part - if the write offset is the same, either
+    // nothing has been written, or the ring has been filled, with the output
+    // buffer marked as not valid.
+    uint32_t block_count = data.output_buffer_block_count;
+    if (!block_count) {
+      continue;
+    }
+    uint32_t write_offset = data.output_buffer_write_offset % block_count;
+    uint32_t written_block_count =
+        (data_after.output_buffer_write_offset + block_count - write_offset) %
+        block_count;
+    if (!written_block_count && data.output_buffer_valid &&
+        !data_after.output_buffer_valid &&
+        write_offset == data.output_buffer_read_offset) {
+      written_block_count = block_count;
+    }
+    const uint8_t* output_buffer = memory.TranslateVirtual<const uint8_t*>(
+        replay_context.output_buffer_ptr);
+    for (uint32_t i = 0; i < written_block_count; ++i) {
+      result.checksum = XXH3_64bits_withSeed(
+          output_buffer + ((write_offset + i) % block_count) * 256, 256,
+          result.checksum);
+    }
+    result.sample_count +=
+        written_block_count * 256 / XmaContext::kBytesPerSample;
+  }
+
+  for (auto& context_pair : contexts) {
+    ReplayContext& replay_context = context_pair.second;
+    replay_context.context.reset();
+    memory.SystemHeapFree(replay_context.output_buffer_ptr);
+    memory.SystemHeapFree(replay_context.input_buffer_ptrs[1]);
+    memory.SystemHeapFree(replay_context.input_buffer_ptrs[0]);
+    memory.SystemHeapFree(replay_context.context_ptr);
+  }
+  return contexts_set_up;
+}
+
+void LogResult(const char* decoder_name, const ReplayResult& result) {
+  double milliseconds = TicksToMilliseconds(result.ticks);
+  double packet_count =
+      double(result.input_bit_count) / double(XmaContext::kBitsPerPacket);
+  XELOGI(
+      "{}: {} passes, {} samples in {:.3f} ms - {:.0f} samples/s, "
+      "{:.3f} ms per pass (longest {:.3f} ms), {:.1f} packets - {:.3f} ms per "
+      "packet, output checksum {:016X}",
+      decoder_name, result.pass_count, result.sample_count, milliseconds,
+      milliseconds > 0.0 ? result.sample_count * 1000.0 / milliseconds : 0.0,
+      result.pass_count ? milliseconds / result.pass_count : 0.0,
+      TicksToMilliseconds(result.max_pass_ticks), packet_count,
+      packet_count > 0.0 ? milliseconds / packet_count : 0.0, result.checksum);
+}
+
+}  // namespace
+
+int xma_bench_main(const std::vector<std::string>& args) {
+  bool replay_old = cvars::xma_bench_decoders == "old" ||
+                    cvars::xma_bench_decoders == "both";
+  bool replay_new = cvars::xma_bench_decoders == "new" ||
+                    cvars::xma_bench_decoders == "both";
+  if (!replay_old && !replay_new) {
+    XELOGE("Unknown XMA decoders {}", cvars::xma_bench_decoders);
+    return 1;
+  }
+
+  auto reader = XmaCaptureReader::Open(cvars::xma_bench_capture);
+  if (!reader) {
+    return 1;
+  }
+  // Load the whole capture so reading it doesn't affect the measurements.
+  std::vector<CapturedPass> passes;
+  while (true) {
+    CapturedPass pass;
+    if (!reader->ReadRecord(pass.record, pass.input_buffers)) {
+      break;
+    }
+    passes.push_back(std::move(pass));
+  }
+  reader.reset();
+  XELOGI("Loaded {} XMA decoding passes", passes.size());
+
+  auto memory = std::make_unique<Memory>();
+  if (!memory->Initialize()) {
+    XELOGE("Failed to initialize the guest memory.");
+    return 1;
+  }
+
+  ReplayResult old_result, new_result;
+  if (replay_old) {
+    if (!Replay<XmaContextOld>(passes, *memory, old_result)) {
+      return 1;
+    }
+    LogResult("XmaContextOld", old_result);
+  }
+  if (replay_new) {
+    if (!Replay<XmaContextNew>(passes, *memory, new_result)) {
+      return 1;
+    }
+    LogResult("XmaContextNew", new_result);
+  }
+  if (replay_old && replay_new) {
+    XELOGI("Output checksums of the decoders {}",
+           old_result.checksum == new_result.checksum ? "match" : "differ");
+  }
+  return 0;
+}
+
+}  // namespace apu
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-apu-xma-bench", xe::apu::xma_bench_main,
+                      "capture.xmac", "xma_bench_capture");
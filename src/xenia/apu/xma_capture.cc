@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/apu/xma_capture.h"
+
+#include <cstring>
+#include <mutex>
+
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+
+namespace xe {
+namespace apu {
+
+std::unique_ptr<XmaCaptureWriter> XmaCaptureWriter::Create(
+    const std::filesystem::path& path) {
+  FILE* file = filesystem::OpenFile(path, "wb");
+  if (!file) {
+    XELOGE("XMA: Failed to create the capture file {}",
+           xe::path_to_utf8(path));
+    return nullptr;
+  }
+  XmaCaptureHeader header;
+  header.signature = kXmaCaptureSignature;
+  header.version = kXmaCaptureVersion;
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    XELOGE("XMA: Failed to write the capture file header");
+    fclose(file);
+    return nullptr;
+  }
+  XELOGI("XMA: Capturing decoding passes to {}", xe::path_to_utf8(path));
+  return std::unique_ptr<XmaCaptureWriter>(new XmaCaptureWriter(file));
+}
+
+XmaCaptureWriter::~XmaCaptureWriter() { fclose(file_); }
+
+void XmaCaptureWriter::CaptureWork(uint32_t context_id,
+                                   const void* guest_context_data,
+                                   const Memory& memory) {
+  XmaCaptureRecord record;
+  record.context_id = context_id;
+  std::memcpy(record.context_data, guest_context_data,
+              sizeof(record.context_data));
+  XMA_CONTEXT_DATA data(guest_context_data);
+  const uint8_t* input_buffers[2] = {};
+  for (uint8_t i = 0; i < 2; ++i) {
+    record.input_buffer_sizes[i] = 0;
+    if (!data.IsInputBufferValid(i)) {
+      continue;
+    }
+    uint32_t input_buffer_size =
+        data.GetInputBufferPacketCount(i) * XmaContext::kBytesPerPacket;
+    input_buffers[i] = memory.TranslatePhysical(data.GetInputBufferAddress(i));
+    if (input_buffers[i]) {
+      record.input_buffer_sizes[i] = input_buffer_size;
+    }
+  }
+
+  std::lock_guard<xe_mutex> lock(lock_);
+  fwrite(&record, sizeof(record), 1, file_);
+  for (uint8_t i = 0; i < 2; ++i) {
+    if (record.input_buffer_sizes[i]) {
+      fwrite(input_buffers[i], 1, record.input_buffer_sizes[i], file_);
+    }
+  }
+}
+
+std::unique_ptr<XmaCaptureReader> XmaCaptureReader::Open(
+    const std::filesystem::path& path) {
+  FILE* file = filesystem::OpenFile(path, "rb");
+  if (!file) {
+    XELOGE("XMA: Failed to open the capture file {}", xe::path_to_utf8(path));
+    return nullptr;
+  }
+  XmaCaptureHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.signature != kXmaCaptureSignature ||
+      header.version != kXmaCaptureVersion) {
+    XELOGE("XMA: {} is not a supported capture file",
+           xe::path_to_utf8(path));
+    fclose(file);
+    return nullptr;
+  }
+  return std::unique_ptr<XmaCaptureReader>(new XmaCaptureReader(file));
+}
+
+XmaCaptureReader::~XmaCaptureReader() { fclose(file_); }
+
+bool XmaCaptureReader::ReadRecord(XmaCaptureRecord& record,
+                                  std::vector<uint8_t> (&input_buffers)[2]) {
+  if (fread(&record, sizeof(record), 1, file_) != 1) {
+    return false;
+  }
+  for (uint32_t i = 0; i < 2; ++i) {
+    input_buffers[i].resize(record.input_buffer_sizes[i]);
+    if (record.input_buffer_sizes[i] &&
+        fread(input_buffers[i].data(), 1, record.input_buffer_sizes[i],
+              file_) != record.input_buffer_sizes[i]) {
+      XELOGE("XMA: The capture file is truncated");
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace apu
+}  // namespace xe
@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_APU_XMA_CAPTURE_H_
+#define XENIA_APU_XMA_CAPTURE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "xenia/apu/xma_context.h"
+#include "xenia/base/memory.h"
+#include "xenia/base/mutex.h"
+#include "xenia/memory.h"
+
+// Captures of the XMA context state and the input packets before every
+// decoding pass that has work to do, taken by the context with its lock held,
+// for replaying the decoding outside a running title, such as in
+// xenia-apu-xma-bench, to measure the performance of the decoders and to
+// verify that changes to them don't modify the output.
+
+namespace xe {
+namespace apu {
+
+constexpr fourcc_t kXmaCaptureSignature = make_fourcc("XMAC");
+constexpr uint32_t kXmaCaptureVersion = 1;
+
+struct XmaCaptureHeader {
+  fourcc_t signature;
+  uint32_t version;
+};
+
+// Followed by the valid input buffers, in the order of their indices.
+struct XmaCaptureRecord {
+  uint32_t context_id;
+  // Zero for invalid buffers.
+  uint32_t input_buffer_sizes[2];
+  // In the guest byte order.
+  uint8_t context_data[sizeof(XMA_CONTEXT_DATA)];
+};
+
+class XmaCaptureWriter {
+ public:
+  static std::unique_ptr<XmaCaptureWriter> Create(
+      const std::filesystem::path& path);
+  ~XmaCaptureWriter();
+
+  // Can be called from any thread, with the lock of the context held.
+  void CaptureWork(uint32_t context_id, const void* guest_context_data,
+                   const Memory& memory);
+
+ private:
+  explicit XmaCaptureWriter(FILE* file) : file_(file) {}
+
+  xe_mutex lock_;
+  FILE* file_;
+};
+
+class XmaCaptureReader {
+ public:
+  static std::unique_ptr<XmaCaptureReader> Open(
+      const std::filesystem::path& path);
+  ~XmaCaptureReader();
+
+  // Returns false at the end of the capture or if it's truncated.
+  bool ReadRecord(XmaCaptureRecord& record,
+                  std::vector<uint8_t> (&input_buffers)[2]);
+
+ private:
+  explicit XmaCaptureReader(FILE* file) : file_(file) {}
+
+  FILE* file_;
+};
+
+}  // namespace apu
+}  // namespace xe
+
+#endif  // XENIA_APU_XMA_CAPTURE_H_
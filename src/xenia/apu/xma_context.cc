@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <cstring>
 
+#include "xenia/apu/xma_capture.h"
 #include "xenia/apu/xma_decoder.h"
 #include "xenia/base/bit_stream.h"
 #include "xenia/base/logging.h"
@@ -40,6 +41,12 @@ XmaContext::XmaContext() = default;
 
 XmaContext::~XmaContext() {}
 
+void XmaContext::CaptureWork(const void* context_ptr) {
+  if (capture_writer_) {
+    capture_writer_->CaptureWork(id(), context_ptr, *memory());
+  }
+}
+
 void XmaContext::DumpRaw(AVFrame* frame, int id) {
   FILE* outfile =
       xe::filesystem::OpenFile(fmt::format("out{}.raw", id).c_str(), "ab");
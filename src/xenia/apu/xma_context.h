@@ -158,6 +158,8 @@ struct Xma2ExtraData {
 static_assert_size(Xma2ExtraData, 34);
 #pragma pack(pop)
 
+class XmaCaptureWriter;
+
 class XmaContext {
  public:
   static const uint32_t kBytesPerPacket = 2048;
@@ -199,12 +201,20 @@ class XmaContext {
   void set_is_allocated(bool is_allocated) { is_allocated_ = is_allocated; }
   void set_is_enabled(bool is_enabled) { is_enabled_ = is_enabled; }
 
+  // The passes that will decode something are captured if set.
+  void set_capture_writer(XmaCaptureWriter* capture_writer) {
+    capture_writer_ = capture_writer;
+  }
+
  protected:
   static void DumpRaw(AVFrame* frame, int id);
   // Convert sample format and swap bytes
   static void ConvertFrame(const uint8_t** samples, bool is_two_channel,
                            uint8_t* output_buffer);
 
+  // Captures the context data before decoding. The lock must be held.
+  void CaptureWork(const void* context_ptr);
+
   Memory* memory_ = nullptr;
 
   uint32_t id_ = 0;
@@ -212,6 +222,7 @@ class XmaContext {
   xe_mutex lock_;
   volatile bool is_allocated_ = false;
   volatile bool is_enabled_ = false;
+  XmaCaptureWriter* capture_writer_ = nullptr;
 
   // ffmpeg structures
   AVPacket* av_packet_ = nullptr;
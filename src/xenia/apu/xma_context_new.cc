@@ -144,6 +144,8 @@ bool XmaContextNew::Work() {
     return true;
   }
 
+  CaptureWork(context_ptr);
+
   while (remaining_subframe_blocks_in_output_buffer_ >=
          minimum_subframe_decode_count) {
     XELOGAPU(
@@ -102,6 +102,10 @@ bool XmaContextOld::Work() {
 
     auto context_ptr = memory()->TranslateVirtual(guest_ptr());
     XMA_CONTEXT_DATA data(context_ptr);
+    // Same conditions as in Decode.
+    if (data.output_buffer_valid && data.IsAnyInputBufferValid()) {
+      CaptureWork(context_ptr);
+    }
     Decode(&data);
     data.Store(context_ptr);
     return true;
@@ -57,6 +57,12 @@ DEFINE_bool(ffmpeg_verbose, false, "Verbose FFmpeg output (debug and above)",
 DEFINE_bool(use_new_decoder, false,
             "Enables usage of new experimental XMA audio decoder.", "APU");
 
+DEFINE_path(xma_capture_path, "",
+            "Path to the file to write the XMA context state and input packets "
+            "to before every decoding pass that has work to do, for replaying "
+            "them in xenia-apu-xma-bench.",
+            "APU");
+
 DEFINE_bool(use_dedicated_xma_thread, true,
             "Enables XMA decoding on separate thread. Disabled should produce "
             "better results, but decrease performance a bit.",
@@ -137,6 +143,10 @@ X_STATUS XmaDecoder::Setup(kernel::KernelState* kernel_state) {
   register_file_[XmaRegister::ContextArrayAddress] =
       memory()->GetPhysicalAddress(context_data_first_ptr_);
 
+  if (!cvars::xma_capture_path.empty()) {
+    capture_writer_ = XmaCaptureWriter::Create(cvars::xma_capture_path);
+  }
+
   // Setup XMA contexts.
   for (int i = 0; i < kContextCount; ++i) {
     if (cvars::use_new_decoder) {
@@ -149,6 +159,7 @@ X_STATUS XmaDecoder::Setup(kernel::KernelState* kernel_state) {
     if (contexts_[i]->Setup(i, memory(), guest_ptr)) {
       assert_always();
     }
+    contexts_[i]->set_capture_writer(capture_writer_.get());
   }
   register_file_[XmaRegister::NextContextIndex] = 1;
   context_bitmap_.Resize(kContextCount);
@@ -220,6 +231,13 @@ void XmaDecoder::Shutdown() {
     worker_thread_.reset();
   }
 
+  if (capture_writer_) {
+    for (int i = 0; i < kContextCount; ++i) {
+      contexts_[i]->set_capture_writer(nullptr);
+    }
+    capture_writer_.reset();
+  }
+
   if (context_data_first_ptr_) {
     memory()->SystemHeapFree(context_data_first_ptr_);
   }
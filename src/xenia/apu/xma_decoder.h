@@ -11,9 +11,11 @@
 #define XENIA_APU_XMA_DECODER_H_
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <queue>
 
+#include "xenia/apu/xma_capture.h"
 #include "xenia/apu/xma_context.h"
 #include "xenia/apu/xma_register_file.h"
 #include "xenia/base/bit_map.h"
@@ -84,6 +86,8 @@ class XmaDecoder {
   XmaContext* contexts_[kContextCount];
   BitMap context_bitmap_;
 
+  std::unique_ptr<XmaCaptureWriter> capture_writer_;
+
   uint32_t context_data_first_ptr_ = 0;
   uint32_t context_data_last_ptr_ = 0;
 };
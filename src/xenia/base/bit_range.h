@@ -100,6 +100,32 @@ void SetRange(Block* bits, size_t first, size_t length) {
   bits[block_last] |= set_last;
 }
 
+template <typename Block>
+void ClearRange(Block* bits, size_t first, size_t length) {
+  if (!length) {
+    return;
+  }
+  size_t last = first + length - 1;
+  const size_t block_bits = sizeof(Block) * CHAR_BIT;
+  size_t block_first = first / block_bits;
+  size_t block_last = last / block_bits;
+  Block clear_first = ~((Block(1) << (first & (block_bits - 1))) - 1);
+  Block clear_last = ~Block(0);
+  if ((last & (block_bits - 1)) != (block_bits - 1)) {
+    clear_last &= (Block(1) << ((last & (block_bits - 1)) + 1)) - 1;
+  }
+  if (block_first == block_last) {
+    bits[block_first] &= ~(clear_first & clear_last);
+    return;
+  }
+  bits[block_first] &= ~clear_first;
+  if (block_first + 1 < block_last) {
+    std::memset(bits + block_first + 1, 0,
+                (block_last - (block_first + 1)) * sizeof(Block));
+  }
+  bits[block_last] &= ~clear_last;
+}
+
 }  // namespace bit_range
 }  // namespace xe
 
@@ -0,0 +1,327 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/global_lock_profiler.h"
+
+#include <algorithm>
+#include <array>
+
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/clock.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/profiling.h"
+
+namespace xe {
+
+#if XE_ENABLE_GLOBAL_LOCK_PROFILING == 1
+
+namespace {
+
+struct Site {
+  const char* file;
+  const char* function;
+  uint32_t line;
+  uint64_t acquire_count;
+  uint64_t contended_count;
+  uint64_t total_wait_ticks;
+  uint64_t max_wait_ticks;
+  uint64_t total_hold_ticks;
+  uint64_t max_hold_ticks;
+#if XE_OPTION_PROFILING
+  bool counters_registered;
+  MicroProfileToken acquires_token;
+  MicroProfileToken contended_token;
+  MicroProfileToken wait_token;
+  MicroProfileToken hold_token;
+#endif  // XE_OPTION_PROFILING
+};
+
+// Open addressing, keyed by the file name pointer and the line. Sites are
+// never removed, and the table is only modified with the global mutex held.
+constexpr uint32_t kSiteTableSize = 2048;
+std::array<Site, kSiteTableSize> sites_;
+uint32_t site_count_ = 0;
+// Catch-all for direct mutex().lock() calls, AcquireDeferred and the lock
+// calls made by std::unique_lock after construction, as well as for sites that
+// don't fit in the table.
+const global_lock_site kUnattributedSite = {"(unattributed)", "(direct lock)",
+                                            0};
+Site unattributed_site_ = {kUnattributedSite.file, kUnattributedSite.function,
+                           kUnattributedSite.line};
+
+struct ThreadState {
+  const global_lock_site* next_site = nullptr;
+  global_lock_site next_site_storage;
+  uint32_t depth = 0;
+  Site* outer_site = nullptr;
+  uint64_t outer_acquire_tick = 0;
+};
+thread_local ThreadState thread_state_;
+
+uint64_t TicksToMicroseconds(uint64_t ticks) {
+  static const uint64_t frequency = Clock::QueryHostTickFrequency();
+  return uint64_t(double(ticks) * 1000000.0 / double(frequency));
+}
+
+#if XE_OPTION_PROFILING
+// The counters are updated on every acquisition rather than copied from the
+// statistics periodically, as that would require taking the global mutex.
+void RegisterCounters(Site& site) {
+  if (site.counters_registered) {
+    return;
+  }
+  // '/' separates the levels of the counter hierarchy in microprofile, so only
+  // the file name is used.
+  const char* file_name = site.file;
+  for (const char* c = site.file; *c; ++c) {
+    if (*c == '/' || *c == '\\') {
+      file_name = c + 1;
+    }
+  }
+  std::string prefix = fmt::format("global_lock {}:{} ", file_name, site.line);
+  site.acquires_token =
+      MicroProfileGetCounterToken((prefix + "acquires").c_str());
+  site.contended_token =
+      MicroProfileGetCounterToken((prefix + "contended").c_str());
+  site.wait_token = MicroProfileGetCounterToken((prefix + "wait_us").c_str());
+  site.hold_token = MicroProfileGetCounterToken((prefix + "hold_us").c_str());
+  site.counters_registered = true;
+}
+#endif  // XE_OPTION_PROFILING
+
+// Must be called with the mutex held.
+Site* LookupSite(const global_lock_site& location) {
+  if (location.file == kUnattributedSite.file) {
+#if XE_OPTION_PROFILING
+    RegisterCounters(unattributed_site_);
+#endif  // XE_OPTION_PROFILING
+    return &unattributed_site_;
+  }
+  uint32_t hash = uint32_t(reinterpret_cast<uintptr_t>(location.file) >> 3) *
+                      0x9E3779B1u ^
+                  location.line;
+  for (uint32_t i = 0; i < kSiteTableSize; ++i) {
+    Site& site = sites_[(hash + i) & (kSiteTableSize - 1)];
+    if (!site.file) {
+      if (site_count_ >= kSiteTableSize - 1) {
+        // Keep one free slot so lookups of new sites always terminate early.
+        break;
+      }
+      ++site_count_;
+      site.file = location.file;
+      site.function = location.function;
+      site.line = location.line;
+#if XE_OPTION_PROFILING
+      RegisterCounters(site);
+#endif  // XE_OPTION_PROFILING
+      return &site;
+    }
+    if (site.file == location.file && site.line == location.line) {
+      return &site;
+    }
+  }
+#if XE_OPTION_PROFILING
+  RegisterCounters(unattributed_site_);
+#endif  // XE_OPTION_PROFILING
+  return &unattributed_site_;
+}
+
+template <typename Function>
+void ForEachSite(Function function) {
+  for (Site& site : sites_) {
+    if (site.file) {
+      function(site);
+    }
+  }
+  function(unattributed_site_);
+}
+
+const global_lock_site& TakeNextSite() {
+  ThreadState& state = thread_state_;
+  const global_lock_site* site = state.next_site;
+  state.next_site = nullptr;
+  return site ? *site : kUnattributedSite;
+}
+
+void OnAcquired(const global_lock_site& location, bool contended,
+                uint64_t wait_start_tick) {
+  uint64_t now = Clock::QueryHostTickCount();
+  Site* site = LookupSite(location);
+  ++site->acquire_count;
+#if XE_OPTION_PROFILING
+  MicroProfileCounterAdd(site->acquires_token, 1);
+#endif  // XE_OPTION_PROFILING
+  if (contended) {
+    ++site->contended_count;
+    uint64_t wait_ticks = now - wait_start_tick;
+    site->total_wait_ticks += wait_ticks;
+    site->max_wait_ticks = std::max(site->max_wait_ticks, wait_ticks);
+#if XE_OPTION_PROFILING
+    MicroProfileCounterAdd(site->contended_token, 1);
+    MicroProfileCounterAdd(site->wait_token,
+                           int64_t(TicksToMicroseconds(wait_ticks)));
+#endif  // XE_OPTION_PROFILING
+  }
+  ThreadState& state = thread_state_;
+  if (!state.depth++) {
+    state.outer_site = site;
+    state.outer_acquire_tick = now;
+  }
+}
+
+}  // namespace
+
+void profiled_global_mutex::SetNextSite(const global_lock_site& site) {
+  // The site may be a temporary from a default argument, copy it.
+  ThreadState& state = thread_state_;
+  state.next_site_storage = site;
+  state.next_site = &state.next_site_storage;
+}
+
+void profiled_global_mutex::lock() {
+  const global_lock_site& location = TakeNextSite();
+  uint64_t wait_start_tick = 0;
+  bool contended = !mutex_.try_lock();
+  if (contended) {
+    wait_start_tick = Clock::QueryHostTickCount();
+    mutex_.lock();
+  }
+  OnAcquired(location, contended, wait_start_tick);
+}
+
+bool profiled_global_mutex::try_lock() {
+  const global_lock_site& location = TakeNextSite();
+  if (!mutex_.try_lock()) {
+    return false;
+  }
+  OnAcquired(location, false, 0);
+  return true;
+}
+
+void profiled_global_mutex::unlock() {
+  ThreadState& state = thread_state_;
+  if (state.depth && !--state.depth) {
+    Site* site = state.outer_site;
+    uint64_t hold_ticks =
+        Clock::QueryHostTickCount() - state.outer_acquire_tick;
+    site->total_hold_ticks += hold_ticks;
+    site->max_hold_ticks = std::max(site->max_hold_ticks, hold_ticks);
+#if XE_OPTION_PROFILING
+    MicroProfileCounterAdd(site->hold_token,
+                           int64_t(TicksToMicroseconds(hold_ticks)));
+#endif  // XE_OPTION_PROFILING
+    state.outer_site = nullptr;
+  }
+  mutex_.unlock();
+}
+
+std::vector<GlobalLockProfiler::SiteStats> GlobalLockProfiler::Snapshot(
+    SortKey sort_key) {
+  std::vector<SiteStats> result;
+  {
+    // Bypass the profiling wrapper so reading doesn't count as an acquisition.
+    std::lock_guard<raw_global_mutex_type> lock(
+        global_critical_region::mutex().raw_mutex());
+    result.reserve(site_count_ + 1);
+    ForEachSite([&result](const Site& site) {
+      if (!site.acquire_count) {
+        return;
+      }
+      SiteStats& stats = result.emplace_back();
+      stats.file = site.file;
+      stats.function = site.function;
+      stats.line = site.line;
+      stats.acquire_count = site.acquire_count;
+      stats.contended_count = site.contended_count;
+      stats.total_wait_us = TicksToMicroseconds(site.total_wait_ticks);
+      stats.max_wait_us = TicksToMicroseconds(site.max_wait_ticks);
+      stats.total_hold_us = TicksToMicroseconds(site.total_hold_ticks);
+      stats.max_hold_us = TicksToMicroseconds(site.max_hold_ticks);
+    });
+  }
+  auto key = [sort_key](const SiteStats& stats) -> uint64_t {
+    switch (sort_key) {
+      case SortKey::kAcquireCount:
+        return stats.acquire_count;
+      case SortKey::kContendedCount:
+        return stats.contended_count;
+      case SortKey::kTotalWait:
+        return stats.total_wait_us;
+      case SortKey::kMaxWait:
+        return stats.max_wait_us;
+      case SortKey::kTotalHold:
+        return stats.total_hold_us;
+      case SortKey::kMaxHold:
+        return stats.max_hold_us;
+    }
+    return 0;
+  };
+  std::stable_sort(result.begin(), result.end(),
+                   [&key](const SiteStats& a, const SiteStats& b) {
+                     return key(a) > key(b);
+                   });
+  return result;
+}
+
+void GlobalLockProfiler::Reset() {
+  std::lock_guard<raw_global_mutex_type> lock(
+      global_critical_region::mutex().raw_mutex());
+  ForEachSite([](Site& site) {
+    site.acquire_count = 0;
+    site.contended_count = 0;
+    site.total_wait_ticks = 0;
+    site.max_wait_ticks = 0;
+    site.total_hold_ticks = 0;
+    site.max_hold_ticks = 0;
+#if XE_OPTION_PROFILING
+    if (site.counters_registered) {
+      MicroProfileCounterSet(site.acquires_token, 0);
+      MicroProfileCounterSet(site.contended_token, 0);
+      MicroProfileCounterSet(site.wait_token, 0);
+      MicroProfileCounterSet(site.hold_token, 0);
+    }
+#endif  // XE_OPTION_PROFILING
+  });
+}
+
+#else
+
+std::vector<GlobalLockProfiler::SiteStats> GlobalLockProfiler::Snapshot(
+    SortKey sort_key) {
+  return {};
+}
+void GlobalLockProfiler::Reset() {}
+
+#endif  // XE_ENABLE_GLOBAL_LOCK_PROFILING
+
+std::string GlobalLockProfiler::FormatTable(SortKey sort_key,
+                                            size_t max_rows) {
+  std::vector<SiteStats> stats = Snapshot(sort_key);
+  std::string table = fmt::format(
+      "{:>12} {:>10} {:>12} {:>10} {:>12} {:>10}  {}\n", "acquires",
+      "contended", "wait us", "max wait", "hold us", "max hold", "site");
+  for (size_t i = 0; i < std::min(stats.size(), max_rows); ++i) {
+    const SiteStats& site = stats[i];
+    table += fmt::format(
+        "{:>12} {:>10} {:>12} {:>10} {:>12} {:>10}  {}:{} ({})\n",
+        site.acquire_count, site.contended_count, site.total_wait_us,
+        site.max_wait_us, site.total_hold_us, site.max_hold_us, site.file,
+        site.line, site.function);
+  }
+  return table;
+}
+
+void GlobalLockProfiler::Dump(SortKey sort_key) {
+  if (!is_enabled()) {
+    return;
+  }
+  XELOGI("Global critical region contention:\n{}", FormatTable(sort_key));
+}
+
+}  // namespace xe
@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_BASE_GLOBAL_LOCK_PROFILER_H_
+#define XENIA_BASE_GLOBAL_LOCK_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+
+namespace xe {
+
+// Contention statistics for the global critical region, gathered per call site
+// when XE_ENABLE_GLOBAL_LOCK_PROFILING is set in mutex.h. With profiling
+// compiled out, all of the methods are no-ops and snapshots are empty. With
+// microprofile enabled, the statistics are also exposed as counters, updated
+// as the sites are entered.
+class GlobalLockProfiler {
+ public:
+  enum class SortKey {
+    kAcquireCount,
+    kContendedCount,
+    kTotalWait,
+    kMaxWait,
+    kTotalHold,
+    kMaxHold,
+  };
+
+  struct SiteStats {
+    const char* file;
+    const char* function;
+    uint32_t line;
+    // Acquisitions, including recursive ones.
+    uint64_t acquire_count;
+    // Acquisitions that did not succeed on the first try.
+    uint64_t contended_count;
+    // Times in microseconds. Hold time is only measured for the outermost
+    // acquisition on a thread, and is attributed to its site.
+    uint64_t total_wait_us;
+    uint64_t max_wait_us;
+    uint64_t total_hold_us;
+    uint64_t max_hold_us;
+  };
+
+  static constexpr bool is_enabled() {
+    return XE_ENABLE_GLOBAL_LOCK_PROFILING == 1;
+  }
+
+  // Copies the statistics of every site seen so far, sorted in descending
+  // order by the given key.
+  static std::vector<SiteStats> Snapshot(SortKey sort_key);
+  // Clears all counters, keeping the known sites.
+  static void Reset();
+
+  // Formats a snapshot as a fixed-width text table.
+  static std::string FormatTable(SortKey sort_key, size_t max_rows = SIZE_MAX);
+  // Writes the table to the log.
+  static void Dump(SortKey sort_key = SortKey::kTotalWait);
+};
+
+}  // namespace xe
+
+#endif  // XENIA_BASE_GLOBAL_LOCK_PROFILER_H_
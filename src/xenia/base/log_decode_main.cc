@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+
+DEFINE_path(log_decode_input, "", "Binary log file written with --log_binary.",
+            "Logging");
+DEFINE_path(log_decode_output, "",
+            "Text log file to write, or empty to write to stdout.", "Logging");
+
+namespace xe {
+
+namespace {
+
+template <typename T>
+bool Read(FILE* file, T& value) {
+  return fread(&value, sizeof(T), 1, file) == 1;
+}
+
+bool ReadBytes(FILE* file, uint32_t size, std::vector<uint8_t>& data) {
+  data.resize(size);
+  return !size || fread(data.data(), size, 1, file) == 1;
+}
+
+void WriteLine(FILE* output, uint32_t thread_id, char prefix_char,
+               const std::string_view text) {
+  // Same as the text log written directly.
+  if (prefix_char) {
+    fmt::print(output, "{}> {:08X} ", prefix_char, thread_id);
+  }
+  fwrite(text.data(), 1, text.size(), output);
+  if (text.empty() || text.back() != '\n') {
+    fputc('\n', output);
+  }
+}
+
+}  // namespace
+
+int log_decode_main(const std::vector<std::string>& args) {
+  using logging::internal::BinaryLogEntryType;
+
+  FILE* input = xe::filesystem::OpenFile(cvars::log_decode_input, "rb");
+  if (!input) {
+    XELOGE("Failed to open {}", xe::path_to_utf8(cvars::log_decode_input));
+    return 1;
+  }
+  uint32_t header[2];
+  if (fread(header, sizeof(header), 1, input) != 1 ||
+      header[0] != logging::internal::kBinaryLogMagic ||
+      header[1] != logging::internal::kBinaryLogVersion) {
+    XELOGE("{} is not a supported binary log",
+           xe::path_to_utf8(cvars::log_decode_input));
+    fclose(input);
+    return 1;
+  }
+  FILE* output = stdout;
+  if (!cvars::log_decode_output.empty()) {
+    output = xe::filesystem::OpenFile(cvars::log_decode_output, "wt");
+    if (!output) {
+      XELOGE("Failed to open {} for writing",
+             xe::path_to_utf8(cvars::log_decode_output));
+      fclose(input);
+      return 1;
+    }
+  }
+
+  std::unordered_map<uint32_t, std::string> formats;
+  std::vector<uint8_t> data;
+  std::string text;
+  size_t line_count = 0;
+  bool truncated = false;
+  BinaryLogEntryType type;
+  while (Read(input, type)) {
+    uint32_t id_or_thread_id, size;
+    char prefix_char = 0;
+    if (!Read(input, id_or_thread_id) ||
+        (type != BinaryLogEntryType::kFormat && !Read(input, prefix_char)) ||
+        !Read(input, size) || !ReadBytes(input, size, data)) {
+      truncated = true;
+      break;
+    }
+    switch (type) {
+      case BinaryLogEntryType::kFormat:
+        formats[id_or_thread_id].assign(data.begin(), data.end());
+        continue;
+      case BinaryLogEntryType::kRecord: {
+        uint32_t format_id;
+        if (size < sizeof(format_id)) {
+          truncated = true;
+          break;
+        }
+        std::memcpy(&format_id, data.data(), sizeof(format_id));
+        auto format_it = formats.find(format_id);
+        text.clear();
+        if (format_it == formats.end() ||
+            !logging::internal::FormatLogRecordArgs(
+                format_it->second.c_str(), data.data() + sizeof(format_id),
+                size - sizeof(format_id), text)) {
+          text = "<malformed log record>";
+        }
+        WriteLine(output, id_or_thread_id, prefix_char, text);
+      } break;
+      case BinaryLogEntryType::kText:
+        WriteLine(output, id_or_thread_id, prefix_char,
+                  std::string_view(reinterpret_cast<const char*>(data.data()),
+                                   data.size()));
+        break;
+      default:
+        truncated = true;
+        break;
+    }
+    if (truncated) {
+      break;
+    }
+    ++line_count;
+  }
+  fclose(input);
+  if (output != stdout) {
+    fclose(output);
+  }
+  if (truncated) {
+    XELOGW("The log is truncated or corrupted after {} lines", line_count);
+  }
+  return 0;
+}
+
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-log-decode", xe::log_decode_main,
+                      "[binary log] [output]", "log_decode_input",
+                      "log_decode_output");
@@ -13,7 +13,10 @@
 #include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <iterator>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "third_party/disruptorplus/include/disruptorplus/multi_threaded_claim_strategy.hpp"
@@ -29,6 +32,7 @@
 #include "xenia/base/literals.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/base/mutex.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/ring_buffer.h"
 #include "xenia/base/string.h"
@@ -43,6 +47,7 @@
 #include "xenia/base/platform_win.h"
 #endif  // XE_PLATFORM
 
+#include "third_party/fmt/include/fmt/args.h"
 #include "third_party/fmt/include/fmt/format.h"
 
 #if XE_PLATFORM_ANDROID
@@ -55,6 +60,17 @@ DEFINE_bool(log_to_debugprint, false, "Dump the log to DebugPrint.", "Logging");
 #endif  // XE_PLATFORM_ANDROID
 DEFINE_bool(flush_log, true, "Flush log file after each log line batch.",
             "Logging");
+DEFINE_bool(log_binary, false,
+            "Log the format string IDs and the arguments instead of formatted "
+            "text, leaving formatting to the logging thread. The log file is "
+            "written in the binary format, which can be converted to text with "
+            "xenia-log-decode.",
+            "Logging");
+DEFINE_uint32(log_crash_ring_size, 0,
+              "Keep the last log lines, up to the given size in KB, in memory "
+              "and write them to <app name>_crash.log next to the executable "
+              "on a fatal error.",
+              "Logging");
 
 DEFINE_uint32(log_mask, 0,
               "Disables specific categorizes for more granular debug logging. "
@@ -78,7 +94,9 @@ Logger* logger_ = nullptr;
 struct LogLine {
   size_t buffer_length;
   uint32_t thread_id;
-  uint16_t _pad_0;  // (2b) padding
+  // The buffer contains a binary log record rather than text.
+  bool binary;
+  uint8_t _pad_0;  // (1b) padding
   bool terminate;
   char prefix_char;
 };
@@ -110,6 +128,97 @@ void DebugPrintLogSink::Write(const char* buf, size_t size) {
   debugging::DebugPrint("{}", std::string_view(buf, size));
 }
 
+// Keeps the most recent log text for writing it out on a fatal error.
+class CrashRingLogSink final : public LogSink {
+ public:
+  explicit CrashRingLogSink(size_t size) : buffer_(size) {}
+
+  void Write(const char* buf, size_t size) override {
+    if (size > buffer_.size()) {
+      buf += size - buffer_.size();
+      size = buffer_.size();
+    }
+    size_t offset = size_t(written_ % buffer_.size());
+    size_t first_size = std::min(size, buffer_.size() - offset);
+    std::memcpy(buffer_.data() + offset, buf, first_size);
+    std::memcpy(buffer_.data(), buf + first_size, size - first_size);
+    written_ += size;
+  }
+  void Flush() override {}
+
+  void WriteTo(FILE* file) const {
+    if (written_ > buffer_.size()) {
+      size_t offset = size_t(written_ % buffer_.size());
+      fwrite(buffer_.data() + offset, 1, buffer_.size() - offset, file);
+      fwrite(buffer_.data(), 1, offset, file);
+    } else {
+      fwrite(buffer_.data(), 1, size_t(written_), file);
+    }
+  }
+
+ private:
+  std::vector<char> buffer_;
+  uint64_t written_ = 0;
+};
+
+// Log file with the binary records as they were logged, see
+// BinaryLogEntryType.
+class BinaryLogFile {
+ public:
+  explicit BinaryLogFile(FILE* file) : file_(file) {
+    const uint32_t header[] = {logging::internal::kBinaryLogMagic,
+                               logging::internal::kBinaryLogVersion};
+    fwrite(header, sizeof(header), 1, file_);
+  }
+  ~BinaryLogFile() { fclose(file_); }
+
+  void WriteRecord(uint32_t thread_id, char prefix_char, const uint8_t* record,
+                   size_t record_size) {
+    uint32_t format_id;
+    std::memcpy(&format_id, record, sizeof(format_id));
+    if (format_id >= written_formats_.size()) {
+      written_formats_.resize(format_id + 1);
+    }
+    if (!written_formats_[format_id]) {
+      written_formats_[format_id] = true;
+      const char* format = logging::internal::GetLogFormat(format_id);
+      uint32_t format_length = uint32_t(std::strlen(format));
+      WriteEntryType(logging::internal::BinaryLogEntryType::kFormat);
+      fwrite(&format_id, sizeof(format_id), 1, file_);
+      fwrite(&format_length, sizeof(format_length), 1, file_);
+      fwrite(format, 1, format_length, file_);
+    }
+    WriteEntry(logging::internal::BinaryLogEntryType::kRecord, thread_id,
+               prefix_char, record, record_size);
+  }
+
+  void WriteText(uint32_t thread_id, char prefix_char, const char* text,
+                 size_t length) {
+    WriteEntry(logging::internal::BinaryLogEntryType::kText, thread_id,
+               prefix_char, text, length);
+  }
+
+  void Flush() { fflush(file_); }
+
+ private:
+  void WriteEntryType(logging::internal::BinaryLogEntryType type) {
+    fwrite(&type, sizeof(type), 1, file_);
+  }
+  void WriteEntry(logging::internal::BinaryLogEntryType type,
+                  uint32_t thread_id, char prefix_char, const void* data,
+                  size_t size) {
+    uint32_t size_32 = uint32_t(size);
+    WriteEntryType(type);
+    fwrite(&thread_id, sizeof(thread_id), 1, file_);
+    fwrite(&prefix_char, sizeof(prefix_char), 1, file_);
+    fwrite(&size_32, sizeof(size_32), 1, file_);
+    fwrite(data, 1, size, file_);
+  }
+
+  FILE* file_;
+  std::vector<bool> written_formats_;
+};
+
 #if XE_PLATFORM_ANDROID
 class AndroidLogSink final : public LogSink {
  public:
@@ -225,7 +334,8 @@ class Logger {
   explicit Logger(const std::string_view app_name)
       : wait_strategy_(),
         claim_strategy_(kBlockCount, wait_strategy_),
-        consumed_(wait_strategy_) {
+        consumed_(wait_strategy_),
+        app_name_(app_name) {
     claim_strategy_.add_claim_barrier(consumed_);
 
     write_thread_ =
@@ -237,12 +347,34 @@ class Logger {
   ~Logger() {
     AppendLine(0, '\0', nullptr, 0, true);  // append a terminator
     xe::threading::Wait(write_thread_.get(), true);
+    if (crash_ring_ && write_crash_ring_) {
+      auto file_path = xe::filesystem::GetExecutableFolder() /
+                       fmt::format("{}_crash.log", app_name_);
+      FILE* file = xe::filesystem::OpenFile(file_path, "wt");
+      if (file) {
+        crash_ring_->WriteTo(file);
+        fclose(file);
+      }
+    }
   }
 
   void AddLogSink(std::unique_ptr<LogSink>&& sink) {
     sinks_.push_back(std::move(sink));
   }
 
+  void SetBinaryLogFile(std::unique_ptr<BinaryLogFile> binary_file) {
+    binary_file_ = std::move(binary_file);
+  }
+
+  void AddCrashRing(size_t size) {
+    auto crash_ring = std::make_unique<CrashRingLogSink>(size);
+    crash_ring_ = crash_ring.get();
+    AddLogSink(std::move(crash_ring));
+  }
+
+  // Writes the crash ring, if enabled, when the logger is destroyed.
+  void RequestCrashRingWrite() { write_crash_ring_ = true; }
+
  private:
   static const size_t kBufferSize = 8_MiB;
   uint8_t buffer_[kBufferSize];
@@ -267,15 +399,73 @@ class Logger {
   dp::sequence_barrier<dp::spin_wait_strategy> consumed_;
 
   std::vector<std::unique_ptr<LogSink>> sinks_;
+  std::unique_ptr<BinaryLogFile> binary_file_;
+  CrashRingLogSink* crash_ring_ = nullptr;
+  bool write_crash_ring_ = false;
+  std::string app_name_;
 
   std::unique_ptr<xe::threading::Thread> write_thread_;
 
+  // Only used by the writer thread.
+  std::vector<uint8_t> line_buffer_;
+  std::string formatted_buffer_;
+
   void Write(const char* buf, size_t size) {
     for (const auto& sink : sinks_) {
       sink->Write(buf, size);
     }
   }
 
+  void WritePrefix(const LogLine& line) {
+    char prefix[] = {
+        line.prefix_char,
+        '>',
+        ' ',
+        '?',  // Thread ID gets placed here (8 chars).
+        '?',
+        '?',
+        '?',
+        '?',
+        '?',
+        '?',
+        '?',
+        ' ',
+        0,
+    };
+    fmt::format_to_n(prefix + 3, sizeof(prefix) - 3, "{:08X}", line.thread_id);
+    Write(prefix, sizeof(prefix) - 1);
+  }
+
+  // Writes a binary log record to the binary log file, and formatted to the
+  // text sinks.
+  void WriteRecord(const LogLine& line, const uint8_t* record) {
+    if (binary_file_) {
+      binary_file_->WriteRecord(line.thread_id, line.prefix_char, record,
+                                line.buffer_length);
+    }
+    if (sinks_.empty()) {
+      return;
+    }
+    uint32_t format_id;
+    std::memcpy(&format_id, record, sizeof(format_id));
+    const char* format = logging::internal::GetLogFormat(format_id);
+    formatted_buffer_.clear();
+    if (!format ||
+        !logging::internal::FormatLogRecordArgs(
+            format, record + sizeof(format_id),
+            line.buffer_length - sizeof(format_id), formatted_buffer_)) {
+      formatted_buffer_ = "<malformed log record>";
+    }
+    if (line.prefix_char) {
+      WritePrefix(line);
+    }
+    // Always ensure there is a newline.
+    if (formatted_buffer_.empty() || formatted_buffer_.back() != '\n') {
+      formatted_buffer_.push_back('\n');
+    }
+    Write(formatted_buffer_.data(), formatted_buffer_.size());
+  }
+
   void WriteThread() {
     RingBuffer rb(buffer_, kBufferSize);
 
@@ -315,25 +505,37 @@ class Logger {
           read_count += needed_count;
           i += needed_count;
 
+          if (line.binary || (binary_file_ && line.buffer_length)) {
+            // Records are decoded, and the binary log file is written, from
+            // a contiguous copy.
+            line_buffer_.resize(line.buffer_length);
+            rb.Read(line_buffer_.data(), line.buffer_length);
+            if (line.binary) {
+              WriteRecord(line, line_buffer_.data());
+            } else {
+              binary_file_->WriteText(
+                  line.thread_id, line.prefix_char,
+                  reinterpret_cast<const char*>(line_buffer_.data()),
+                  line.buffer_length);
+            }
+            if (line.binary || sinks_.empty()) {
+              continue;
+            }
+            if (line.prefix_char) {
+              WritePrefix(line);
+            }
+            Write(reinterpret_cast<const char*>(line_buffer_.data()),
+                  line.buffer_length);
+            // Always ensure there is a newline.
+            if (line_buffer_.back() != '\n') {
+              const char suffix[1] = {'\n'};
+              Write(suffix, 1);
+            }
+            continue;
+          }
+
           if (line.prefix_char) {
-            char prefix[] = {
-                line.prefix_char,
-                '>',
-                ' ',
-                '?',  // Thread ID gets placed here (8 chars).
-                '?',
-                '?',
-                '?',
-                '?',
-                '?',
-                '?',
-                '?',
-                ' ',
-                0,
-            };
-            fmt::format_to_n(prefix + 3, sizeof(prefix) - 3, "{:08X}",
-                             line.thread_id);
-            Write(prefix, sizeof(prefix) - 1);
+            WritePrefix(line);
           }
 
           if (line.buffer_length) {
@@ -388,6 +590,9 @@ class Logger {
           for (const auto& sink : sinks_) {
             sink->Flush();
           }
+          if (binary_file_) {
+            binary_file_->Flush();
+          }
         }
 
         idle_loops = 0;
@@ -405,7 +610,7 @@ class Logger {
  public:
   void AppendLine(uint32_t thread_id, const char prefix_char,
                   const char* buffer_data, size_t buffer_length,
-                  bool terminate = false) {
+                  bool terminate = false, bool binary = false) {
     size_t count = BlockCount(sizeof(LogLine) + buffer_length);
 
     auto range = claim_strategy_.claim(count);
@@ -420,6 +625,7 @@ class Logger {
     line.thread_id = thread_id;
     line.prefix_char = prefix_char;
     line.terminate = terminate;
+    line.binary = binary;
 
     rb.Write(&line, sizeof(LogLine));
     if (buffer_length) {
@@ -441,17 +647,25 @@ void InitializeLogging(const std::string_view app_name) {
     logger_->AddLogSink(std::make_unique<AndroidLogSink>(app_name));
   }
 #else
+  const char* log_file_mode = cvars::log_binary ? "wb" : "wt";
   FILE* log_file = nullptr;
   if (cvars::log_file.empty()) {
     // Default to app name.
-    auto file_name = fmt::format("{}.log", app_name);
+    auto file_name =
+        fmt::format("{}.{}", app_name, cvars::log_binary ? "xlog" : "log");
     auto file_path = xe::filesystem::GetExecutableFolder() / file_name;
-    log_file = xe::filesystem::OpenFile(file_path, "wt");
+    log_file = xe::filesystem::OpenFile(file_path, log_file_mode);
   } else {
     xe::filesystem::CreateParentFolder(cvars::log_file);
-    log_file = xe::filesystem::OpenFile(cvars::log_file, "wt");
+    log_file = xe::filesystem::OpenFile(cvars::log_file, log_file_mode);
+  }
+  if (cvars::log_binary) {
+    if (log_file) {
+      logger_->SetBinaryLogFile(std::make_unique<BinaryLogFile>(log_file));
+    }
+  } else {
+    logger_->AddLogSink(std::make_unique<FileLogSink>(log_file, true));
   }
-  logger_->AddLogSink(std::make_unique<FileLogSink>(log_file, true));
 
   if (cvars::log_to_stdout) {
     logger_->AddLogSink(std::make_unique<FileLogSink>(stdout, false));
@@ -461,6 +675,10 @@ void InitializeLogging(const std::string_view app_name) {
     logger_->AddLogSink(std::make_unique<DebugPrintLogSink>());
   }
 #endif  // XE_PLATFORM_ANDROID
+
+  if (cvars::log_crash_ring_size) {
+    logger_->AddCrashRing(size_t(cvars::log_crash_ring_size) * 1024);
+  }
 }
 
 void ShutdownLogging() {
@@ -483,6 +701,171 @@ bool logging::internal::ShouldLog(LogLevel log_level, uint32_t log_mask) {
          (log_mask & cvars::log_mask) == 0;
 }
 
+namespace {
+
+struct LogFormatRegistry {
+  xe_mutex mutex;
+  // Deque so the strings are never moved.
+  std::deque<std::string> formats;
+  std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+LogFormatRegistry& GetLogFormatRegistry() {
+  static LogFormatRegistry registry;
+  return registry;
+}
+
+// Most lines are logged with literal format strings, so the IDs are cached by
+// the pointer, but the contents are still compared in case the string is not
+// a literal.
+struct LogFormatCacheEntry {
+  const char* pointer;
+  const std::string* format;
+  uint32_t id;
+};
+thread_local LogFormatCacheEntry log_format_cache_[64] = {};
+
+template <typename T>
+bool ReadLogArg(const uint8_t*& args, const uint8_t* args_end, T& value) {
+  if (size_t(args_end - args) < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&value, args, sizeof(T));
+  args += sizeof(T);
+  return true;
+}
+
+}  // namespace
+
+bool logging::internal::ShouldLogBinary() { return cvars::log_binary; }
+
+uint32_t logging::internal::GetLogFormatId(const char* format) {
+  size_t cache_index =
+      (uintptr_t(format) >> 4) % xe::countof(log_format_cache_);
+  LogFormatCacheEntry& cache_entry = log_format_cache_[cache_index];
+  if (cache_entry.pointer == format &&
+      !std::strcmp(cache_entry.format->c_str(), format)) {
+    return cache_entry.id;
+  }
+  LogFormatRegistry& registry = GetLogFormatRegistry();
+  std::lock_guard<xe_mutex> lock(registry.mutex);
+  auto it = registry.ids.find(format);
+  if (it == registry.ids.end()) {
+    const std::string& new_format = registry.formats.emplace_back(format);
+    it = registry.ids
+             .emplace(std::string_view(new_format),
+                      uint32_t(registry.formats.size() - 1))
+             .first;
+  }
+  cache_entry.pointer = format;
+  cache_entry.format = &registry.formats[it->second];
+  cache_entry.id = it->second;
+  return it->second;
+}
+
+const char* logging::internal::GetLogFormat(uint32_t format_id) {
+  LogFormatRegistry& registry = GetLogFormatRegistry();
+  std::lock_guard<xe_mutex> lock(registry.mutex);
+  if (format_id >= registry.formats.size()) {
+    return nullptr;
+  }
+  return registry.formats[format_id].c_str();
+}
+
+bool logging::internal::FormatLogRecordArgs(const char* format,
+                                            const uint8_t* args,
+                                            size_t args_size,
+                                            std::string& out) {
+  // String views point to the record, which outlives the formatting.
+  fmt::dynamic_format_arg_store<fmt::format_context> store;
+  const uint8_t* args_end = args + args_size;
+  while (args != args_end) {
+    LogArgType type;
+    if (!ReadLogArg(args, args_end, type)) {
+      return false;
+    }
+    bool read = false;
+    switch (type) {
+      case LogArgType::kSigned: {
+        int64_t value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(value);
+        }
+      } break;
+      case LogArgType::kUnsigned: {
+        uint64_t value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(value);
+        }
+      } break;
+      case LogArgType::kFloat: {
+        float value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(value);
+        }
+      } break;
+      case LogArgType::kDouble: {
+        double value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(value);
+        }
+      } break;
+      case LogArgType::kBool: {
+        uint8_t value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(value != 0);
+        }
+      } break;
+      case LogArgType::kChar: {
+        char value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(value);
+        }
+      } break;
+      case LogArgType::kPointer: {
+        uint64_t value;
+        if ((read = ReadLogArg(args, args_end, value))) {
+          store.push_back(reinterpret_cast<const void*>(uintptr_t(value)));
+        }
+      } break;
+      case LogArgType::kString: {
+        uint32_t length;
+        if (ReadLogArg(args, args_end, length) &&
+            length <= size_t(args_end - args)) {
+          store.push_back(fmt::string_view(
+              reinterpret_cast<const char*>(args), length));
+          args += length;
+          read = true;
+        }
+      } break;
+    }
+    if (!read) {
+      return false;
+    }
+  }
+  try {
+    fmt::vformat_to(std::back_inserter(out), fmt::string_view(format),
+                    store);
+  } catch (const std::exception& e) {
+    out.append("<log format error: ");
+    out.append(e.what());
+    out.append("> ");
+    out.append(format);
+  }
+  return true;
+}
+
+XE_NOALIAS
+void logging::internal::AppendLogRecord(LogLevel log_level,
+                                        const char prefix_char,
+                                        size_t written) {
+  if (!logger_ || !ShouldLog(log_level)) {
+    return;
+  }
+  logger_->AppendLine(xe::threading::current_thread_id(), prefix_char,
+                      thread_log_buffer_, written, false, true);
+}
+
 std::pair<char*, size_t> logging::internal::GetThreadBuffer() {
   return {thread_log_buffer_, sizeof(thread_log_buffer_)};
 }
@@ -512,6 +895,9 @@ void FatalError(const std::string_view str) {
     ShowSimpleMessageBox(SimpleMessageBoxType::Error, str);
   }
 
+  if (logger_) {
+    logger_->RequestCrashRingWrite();
+  }
   ShutdownLogging();
 
 #if XE_PLATFORM_ANDROID
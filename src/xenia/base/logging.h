@@ -12,7 +12,10 @@
 
 #include <cstdarg>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/string.h"
@@ -90,6 +93,129 @@ std::pair<char*, size_t> GetThreadBuffer();
 XE_NOALIAS
 void AppendLogLine(LogLevel log_level, const char prefix_char, size_t written);
 
+// Binary log records, enabled by the log_binary cvar, contain the ID of the
+// format string and the raw arguments, and are formatted on the writer thread
+// or offline by xenia-log-decode rather than on the logging thread. Only lines
+// with arguments of basic types are logged this way, others are formatted
+// immediately.
+bool ShouldLogBinary();
+// Returns the ID of the format string, registering it if not seen before. The
+// string doesn't have to outlive the call.
+uint32_t GetLogFormatId(const char* format);
+// Returns nullptr if the ID is not registered.
+const char* GetLogFormat(uint32_t format_id);
+XE_NOALIAS
+void AppendLogRecord(LogLevel log_level, const char prefix_char,
+                     size_t written);
+// Formats the arguments of a binary log record, returning false if they're
+// malformed.
+bool FormatLogRecordArgs(const char* format, const uint8_t* args,
+                         size_t args_size, std::string& out);
+
+// Binary log files start with the magic and the version, followed by entries
+// starting with a BinaryLogEntryType byte.
+constexpr uint32_t kBinaryLogMagic = 0x474F4C58;  // 'XLOG'
+constexpr uint32_t kBinaryLogVersion = 1;
+enum class BinaryLogEntryType : uint8_t {
+  // Format ID, length and the characters, before the first record using it.
+  kFormat,
+  // Thread ID, prefix character, size and the record - the format ID followed
+  // by the arguments.
+  kRecord,
+  // Thread ID, prefix character, length and the characters of a line that was
+  // formatted when logged.
+  kText,
+};
+
+enum class LogArgType : uint8_t {
+  kSigned,
+  kUnsigned,
+  kFloat,
+  kDouble,
+  kBool,
+  kChar,
+  kPointer,
+  // Followed by a 32-bit length and the characters.
+  kString,
+};
+
+template <typename T>
+constexpr bool IsBinaryLogArg() {
+  using U = std::remove_cv_t<T>;
+  if constexpr (std::is_array_v<U>) {
+    return std::is_same_v<std::remove_cv_t<std::remove_extent_t<U>>, char>;
+  } else {
+    return std::is_same_v<U, bool> || std::is_same_v<U, char> ||
+           ((std::is_integral_v<U> && !std::is_same_v<U, wchar_t> &&
+             !std::is_same_v<U, char16_t> && !std::is_same_v<U, char32_t>) ||
+            std::is_same_v<U, float> || std::is_same_v<U, double>) ||
+           std::is_same_v<U, const char*> || std::is_same_v<U, char*> ||
+           std::is_same_v<U, const void*> || std::is_same_v<U, void*> ||
+           std::is_same_v<U, std::string> ||
+           std::is_same_v<U, std::string_view>;
+  }
+}
+
+class LogRecordWriter {
+ public:
+  LogRecordWriter(char* data, size_t capacity)
+      : data_(data), capacity_(capacity) {}
+
+  size_t size() const { return size_; }
+  bool overflowed() const { return overflowed_; }
+
+  template <typename T>
+  void WriteArg(const T& value) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+      WriteTyped(LogArgType::kBool, uint8_t(value));
+    } else if constexpr (std::is_same_v<U, char>) {
+      WriteTyped(LogArgType::kChar, value);
+    } else if constexpr (std::is_same_v<U, float>) {
+      WriteTyped(LogArgType::kFloat, value);
+    } else if constexpr (std::is_same_v<U, double>) {
+      WriteTyped(LogArgType::kDouble, value);
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+      WriteTyped(LogArgType::kSigned, int64_t(value));
+    } else if constexpr (std::is_integral_v<U>) {
+      WriteTyped(LogArgType::kUnsigned, uint64_t(value));
+    } else if constexpr (std::is_same_v<U, const void*> ||
+                         std::is_same_v<U, void*>) {
+      WriteTyped(LogArgType::kPointer, uint64_t(uintptr_t(value)));
+    } else if constexpr (std::is_same_v<U, const char*> ||
+                         std::is_same_v<U, char*>) {
+      WriteString(value ? std::string_view(value) : std::string_view());
+    } else {
+      WriteString(std::string_view(value));
+    }
+  }
+
+  void Write(const void* value, size_t size) {
+    if (overflowed_ || size > capacity_ - size_) {
+      overflowed_ = true;
+      return;
+    }
+    std::memcpy(data_ + size_, value, size);
+    size_ += size;
+  }
+
+ private:
+  template <typename T>
+  void WriteTyped(LogArgType type, T value) {
+    Write(&type, sizeof(type));
+    Write(&value, sizeof(value));
+  }
+  void WriteString(const std::string_view value) {
+    WriteTyped(LogArgType::kString, uint32_t(value.size()));
+    Write(value.data(), value.size());
+  }
+
+  char* data_;
+  size_t capacity_;
+  size_t size_ = 0;
+  bool overflowed_ = false;
+};
+
 }  // namespace internal
 // technically, noalias is incorrect here, these functions do in fact alias
 // global memory, but msvc will not optimize the calls away, and the global
@@ -100,6 +226,18 @@ XE_NOALIAS XE_NOINLINE XE_COLD static void AppendLogLineFormat_Impl(
     LogLevel log_level, const char prefix_char, const char* format,
     const Args&... args) {
   auto target = internal::GetThreadBuffer();
+  if constexpr ((internal::IsBinaryLogArg<Args>() && ...)) {
+    if (internal::ShouldLogBinary()) {
+      internal::LogRecordWriter writer(target.first, target.second);
+      uint32_t format_id = internal::GetLogFormatId(format);
+      writer.Write(&format_id, sizeof(format_id));
+      (writer.WriteArg(args), ...);
+      if (!writer.overflowed()) {
+        internal::AppendLogRecord(log_level, prefix_char, writer.size());
+        return;
+      }
+    }
+  }
   auto result = fmt::format_to_n(target.first, target.second, format, args...);
   internal::AppendLogLine(log_level, prefix_char, result.size);
 }
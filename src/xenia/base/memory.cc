@@ -24,6 +24,11 @@ DEFINE_bool(
     "Allow mapping memory with both write and execute access, for simulating "
     "behavior on platforms where that's not supported",
     "Memory");
+DEFINE_bool(
+    large_pages, false,
+    "Back guest memory and the generated code with large pages where "
+    "possible (transparent huge pages on Linux), to reduce TLB misses.",
+    "Memory");
 
 namespace xe {
 namespace memory {
@@ -33,6 +38,8 @@ bool IsWritableExecutableMemoryPreferred() {
          cvars::writable_executable_memory;
 }
 
+bool IsLargePageBackingPreferred() { return cvars::large_pages; }
+
 using xe::swcache::CacheLine;
 
 static constexpr unsigned NUM_CACHELINES_IN_PAGE = 4096 / sizeof(CacheLine);
@@ -223,240 +230,382 @@ void vastcpy(uint8_t* XE_RESTRICT physaddr, uint8_t* XE_RESTRICT rdmapping,
 }
 }  // namespace memory
 
-// TODO(benvanik): fancy AVX versions.
-// https://github.com/gnuradio/volk/blob/master/kernels/volk/volk_16u_byteswap.h
-// https://github.com/gnuradio/volk/blob/master/kernels/volk/volk_32u_byteswap.h
-// https://github.com/gnuradio/volk/blob/master/kernels/volk/volk_64u_byteswap.h
-// Original links:
-// https://gnuradio.org/redmine/projects/gnuradio/repository/revisions/cb32b70b79f430456208a2cd521d028e0ece5d5b/entry/volk/kernels/volk/volk_16u_byteswap.h
-// https://gnuradio.org/redmine/projects/gnuradio/repository/revisions/f2bc76cc65ffba51a141950f98e75364e49df874/entry/volk/kernels/volk/volk_32u_byteswap.h
-// https://gnuradio.org/redmine/projects/gnuradio/repository/revisions/2c4c371885c31222362f70a1cd714415d1398021/entry/volk/kernels/volk/volk_64u_byteswap.h
-
 void copy_128_aligned(void* dest, const void* src, size_t count) {
   std::memcpy(dest, src, count * 16);
 }
 
 #if XE_ARCH_AMD64
 
-// This works around a GCC bug
-// https://gcc.gnu.org/bugzilla/show_bug.cgi?id=100801
-// TODO(Joel Linn): Remove this when fixed GCC versions are common place.
-#if XE_COMPILER_GNUC
-#define XE_WORKAROUND_CONSTANT_RETURN_IF(x) \
-  if (__builtin_constant_p(x) && (x)) return;
+// The file is built for AVX, newer instruction sets must be enabled per
+// function.
+#if XE_COMPILER_HAS_GNU_EXTENSIONS == 1
+#define XE_TARGET_AVX2 __attribute__((target("avx2")))
+#define XE_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
 #else
-#define XE_WORKAROUND_CONSTANT_RETURN_IF(x)
+#define XE_TARGET_AVX2
+#define XE_TARGET_AVX512
 #endif
-void copy_and_swap_16_aligned(void* dest_ptr, const void* src_ptr,
-                              size_t count) {
-  assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
-  assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
-
-  auto dest = reinterpret_cast<uint16_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint16_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x0E, 0x0F, 0x0C, 0x0D, 0x0A, 0x0B, 0x08, 0x09, 0x06, 0x07,
-                   0x04, 0x05, 0x02, 0x03, 0x00, 0x01);
 
+using CopyAndSwapFunction = void (*)(void* dest, const void* src,
+                                     size_t count);
+
+// Byte permutations within each 128-bit lane, same for every instruction set
+// since vpshufb doesn't cross lanes.
+struct CopyAndSwap16 {
+  using T = uint16_t;
+  static T Swap(T value) { return byte_swap(value); }
+  static __m128i Shuffle() {
+    return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  }
+};
+struct CopyAndSwap32 {
+  using T = uint32_t;
+  static T Swap(T value) { return byte_swap(value); }
+  static __m128i Shuffle() {
+    return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  }
+};
+struct CopyAndSwap64 {
+  using T = uint64_t;
+  static T Swap(T value) { return byte_swap(value); }
+  static __m128i Shuffle() {
+    return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  }
+};
+struct CopyAndSwap16In32 {
+  using T = uint32_t;
+  static T Swap(T value) { return (value >> 16) | (value << 16); }
+  static __m128i Shuffle() {
+    return _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  }
+};
+
+// The loops process whole vectors only, returning the number of elements
+// copied. With non-temporal stores, the destination must be aligned to the
+// vector size.
+
+template <typename Swap, bool kNonTemporal>
+static size_t CopyAndSwapLoopSSSE3(typename Swap::T* dest,
+                                   const typename Swap::T* src, size_t count) {
+  constexpr size_t kVectorCount = sizeof(__m128i) / sizeof(typename Swap::T);
+  const __m128i shufmask = Swap::Shuffle();
   size_t i = 0;
-  for (i = 0; i + 8 <= count; i += 8) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+  // pshufb has a reciprocal throughput of 0.5 on most CPUs, so do two vectors
+  // per iteration.
+  for (; i + kVectorCount * 2 <= count; i += kVectorCount * 2) {
+    __m128i output1 = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i])), shufmask);
+    __m128i output2 = _mm_shuffle_epi8(
+        _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(&src[i + kVectorCount])),
+        shufmask);
+    if constexpr (kNonTemporal) {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(&dest[i]), output1);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(&dest[i + kVectorCount]),
+                       output2);
+    } else {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output1);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i + kVectorCount]),
+                       output2);
+    }
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 8 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+  if (i + kVectorCount <= count) {
+    __m128i output = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i])), shufmask);
+    if constexpr (kNonTemporal) {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+    } else {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+    }
+    i += kVectorCount;
   }
+  return i;
 }
 
-void copy_and_swap_16_unaligned(void* dest_ptr, const void* src_ptr,
-                                size_t count) {
-  auto dest = reinterpret_cast<uint16_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint16_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x0E, 0x0F, 0x0C, 0x0D, 0x0A, 0x0B, 0x08, 0x09, 0x06, 0x07,
-                   0x04, 0x05, 0x02, 0x03, 0x00, 0x01);
-
-  size_t i;
-  for (i = 0; i + 8 <= count; i += 8) {
-    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+template <typename Swap, bool kNonTemporal>
+XE_TARGET_AVX2 static size_t CopyAndSwapLoopAVX2(typename Swap::T* dest,
+                                                 const typename Swap::T* src,
+                                                 size_t count) {
+  constexpr size_t kVectorCount = sizeof(__m256i) / sizeof(typename Swap::T);
+  const __m256i shufmask = _mm256_broadcastsi128_si256(Swap::Shuffle());
+  size_t i = 0;
+  for (; i + kVectorCount * 2 <= count; i += kVectorCount * 2) {
+    __m256i output1 = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i])),
+        shufmask);
+    __m256i output2 = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(&src[i + kVectorCount])),
+        shufmask);
+    if constexpr (kNonTemporal) {
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(&dest[i]), output1);
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(&dest[i + kVectorCount]),
+                          output2);
+    } else {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), output1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i + kVectorCount]),
+                          output2);
+    }
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 8 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+  if (i + kVectorCount <= count) {
+    __m256i output = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i])),
+        shufmask);
+    if constexpr (kNonTemporal) {
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(&dest[i]), output);
+    } else {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), output);
+    }
+    i += kVectorCount;
+  }
+  if (i + kVectorCount / 2 <= count) {
+    __m128i output = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i])),
+        _mm256_castsi256_si128(shufmask));
+    if constexpr (kNonTemporal) {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+    } else {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+    }
+    i += kVectorCount / 2;
   }
+  return i;
 }
 
-void copy_and_swap_32_aligned(void* dest_ptr, const void* src_ptr,
-                              size_t count) {
-  assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
-  assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
+template <typename Swap, bool kNonTemporal>
+XE_TARGET_AVX512 static size_t CopyAndSwapLoopAVX512(
+    typename Swap::T* dest, const typename Swap::T* src, size_t count) {
+  using T = typename Swap::T;
+  constexpr size_t kVectorCount = sizeof(__m512i) / sizeof(T);
+  const __m512i shufmask = _mm512_broadcast_i32x4(Swap::Shuffle());
+  size_t i = 0;
+  for (; i + kVectorCount <= count; i += kVectorCount) {
+    __m512i output = _mm512_shuffle_epi8(_mm512_loadu_si512(&src[i]), shufmask);
+    if constexpr (kNonTemporal) {
+      _mm512_stream_si512(reinterpret_cast<__m512i*>(&dest[i]), output);
+    } else {
+      _mm512_storeu_si512(&dest[i], output);
+    }
+  }
+  if constexpr (!kNonTemporal) {
+    // Masked-out bytes are not accessed, so the remainder can be handled
+    // without the scalar loop.
+    if (i < count) {
+      __mmask64 mask = (__mmask64(1) << ((count - i) * sizeof(T))) - 1;
+      __m512i output = _mm512_shuffle_epi8(
+          _mm512_maskz_loadu_epi8(mask, &src[i]), shufmask);
+      _mm512_mask_storeu_epi8(&dest[i], mask, output);
+      i = count;
+    }
+  }
+  return i;
+}
 
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B, 0x04, 0x05,
-                   0x06, 0x07, 0x00, 0x01, 0x02, 0x03);
+static size_t copy_and_swap_non_temporal_threshold =
+    memory::kCopyAndSwapNonTemporalThresholdDefault;
 
-  size_t i;
-  for (i = 0; i + 4 <= count; i += 4) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+template <typename Swap, size_t kVectorSize,
+          size_t (*kLoop)(typename Swap::T*, const typename Swap::T*, size_t),
+          size_t (*kNonTemporalLoop)(typename Swap::T*,
+                                     const typename Swap::T*, size_t)>
+static void CopyAndSwap(void* dest_ptr, const void* src_ptr, size_t count) {
+  using T = typename Swap::T;
+  auto dest = reinterpret_cast<T*>(dest_ptr);
+  auto src = reinterpret_cast<const T*>(src_ptr);
+  size_t i = 0;
+  uintptr_t dest_address = reinterpret_cast<uintptr_t>(dest);
+  // Streaming stores must be aligned, which is only reachable element by
+  // element if the destination is aligned to the element size.
+  if (count * sizeof(T) >= copy_and_swap_non_temporal_threshold &&
+      !(dest_address & (sizeof(T) - 1))) {
+    size_t head_count = std::min(
+        ((kVectorSize - (dest_address & (kVectorSize - 1))) &
+         (kVectorSize - 1)) /
+            sizeof(T),
+        count);
+    for (; i < head_count; ++i) {
+      dest[i] = Swap::Swap(src[i]);
+    }
+    i += kNonTemporalLoop(dest + i, src + i, count - i);
+    // Order the streaming stores with the following ones, including those of
+    // other threads consuming the data.
+    _mm_sfence();
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
+  i += kLoop(dest + i, src + i, count - i);
   for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+    dest[i] = Swap::Swap(src[i]);
   }
 }
 
-void copy_and_swap_32_unaligned(void* dest_ptr, const void* src_ptr,
-                                size_t count) {
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  size_t i;
-  // chrispy: this optimization mightt backfire if our unaligned load spans two
-  // cachelines... which it probably will
-  if (amd64::GetFeatureFlags() & amd64::kX64EmitAVX2) {
-    __m256i shufmask = _mm256_set_epi8(
-        0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B, 0x04, 0x05, 0x06, 0x07,
-        0x00, 0x01, 0x02, 0x03, 0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B,
-        0x04, 0x05, 0x06, 0x07, 0x00, 0x01, 0x02, 0x03);
-    // with vpshufb being a 0.5 through instruction, it makes the most sense to
-    // double up on our iters
-    for (i = 0; i + 16 <= count; i += 16) {
-      __m256i input1 =
-          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
-      __m256i input2 =
-          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i + 8]));
-
-      __m256i output1 = _mm256_shuffle_epi8(input1, shufmask);
-      __m256i output2 = _mm256_shuffle_epi8(input2, shufmask);
-// chrispy: todo, benchmark this w/ and w/out these prefetches here on multiple
-// machines finding a good distance for prefetchw in particular is probably
-// important for when we're writing across 2 cachelines
-#if 0
-      if (i + 48 <= count) {
-        swcache::PrefetchNTA(&src[i + 32]);
-        if (amd64::GetFeatureFlags() & amd64::kX64EmitPrefetchW) {
-          swcache::PrefetchW(&dest[i + 32]);
-        }
-      }
-#endif
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), output1);
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i + 8]), output2);
-    }
-    if (i + 8 <= count) {
-      __m256i input =
-          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
-      __m256i output = _mm256_shuffle_epi8(input, shufmask);
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), output);
-      i += 8;
-    }
-    if (i + 4 <= count) {
-      __m128i input =
-          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-      __m128i output =
-          _mm_shuffle_epi8(input, _mm256_castsi256_si128(shufmask));
-      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-      i += 4;
-    }
-  } else {
-    __m128i shufmask =
-        _mm_set_epi8(0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B, 0x04, 0x05,
-                     0x06, 0x07, 0x00, 0x01, 0x02, 0x03);
-
-    for (i = 0; i + 4 <= count; i += 4) {
-      __m128i input =
-          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-      __m128i output = _mm_shuffle_epi8(input, shufmask);
-      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+template <typename Swap>
+static CopyAndSwapFunction GetCopyAndSwapFunction(memory::CopyAndSwapIsa isa) {
+  switch (isa) {
+    case memory::CopyAndSwapIsa::kAVX512:
+      return CopyAndSwap<Swap, sizeof(__m512i),
+                         CopyAndSwapLoopAVX512<Swap, false>,
+                         CopyAndSwapLoopAVX512<Swap, true>>;
+    case memory::CopyAndSwapIsa::kAVX2:
+      return CopyAndSwap<Swap, sizeof(__m256i),
+                         CopyAndSwapLoopAVX2<Swap, false>,
+                         CopyAndSwapLoopAVX2<Swap, true>>;
+    default:
+      return CopyAndSwap<Swap, sizeof(__m128i),
+                         CopyAndSwapLoopSSSE3<Swap, false>,
+                         CopyAndSwapLoopSSSE3<Swap, true>>;
+  }
+}
+
+XE_COLD
+static void first_copy_and_swap_16(void* dest, const void* src, size_t count);
+XE_COLD
+static void first_copy_and_swap_32(void* dest, const void* src, size_t count);
+XE_COLD
+static void first_copy_and_swap_64(void* dest, const void* src, size_t count);
+XE_COLD
+static void first_copy_and_swap_16_in_32(void* dest, const void* src,
+                                         size_t count);
+
+static CopyAndSwapFunction copy_and_swap_16_dispatch = first_copy_and_swap_16;
+static CopyAndSwapFunction copy_and_swap_32_dispatch = first_copy_and_swap_32;
+static CopyAndSwapFunction copy_and_swap_64_dispatch = first_copy_and_swap_64;
+static CopyAndSwapFunction copy_and_swap_16_in_32_dispatch =
+    first_copy_and_swap_16_in_32;
+static bool copy_and_swap_isa_selected = false;
+static memory::CopyAndSwapIsa copy_and_swap_isa =
+    memory::CopyAndSwapIsa::kSSSE3;
+
+static bool IsCopyAndSwapIsaSupported(memory::CopyAndSwapIsa isa) {
+  uint64_t feature_flags = amd64::GetFeatureFlags();
+  switch (isa) {
+    case memory::CopyAndSwapIsa::kAVX512: {
+      // Only AVX-512BW is needed, but VBMI is used as an indicator of CPUs
+      // that don't lower the clock speed heavily when executing 512-bit
+      // instructions.
+      uint64_t avx512_flags = amd64::kX64EmitAVX512F |
+                              amd64::kX64EmitAVX512BW |
+                              amd64::kX64EmitAVX512VBMI;
+      return (feature_flags & avx512_flags) == avx512_flags;
     }
+    case memory::CopyAndSwapIsa::kAVX2:
+      return (feature_flags & amd64::kX64EmitAVX2) != 0;
+    default:
+      return true;
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+}
+
+static void SetCopyAndSwapFunctions(memory::CopyAndSwapIsa isa) {
+  copy_and_swap_16_dispatch = GetCopyAndSwapFunction<CopyAndSwap16>(isa);
+  copy_and_swap_32_dispatch = GetCopyAndSwapFunction<CopyAndSwap32>(isa);
+  copy_and_swap_64_dispatch = GetCopyAndSwapFunction<CopyAndSwap64>(isa);
+  copy_and_swap_16_in_32_dispatch =
+      GetCopyAndSwapFunction<CopyAndSwap16In32>(isa);
+  copy_and_swap_isa = isa;
+  copy_and_swap_isa_selected = true;
+}
+
+XE_COLD
+static void SelectCopyAndSwapFunctions() {
+  memory::CopyAndSwapIsa isa;
+  if (IsCopyAndSwapIsaSupported(memory::CopyAndSwapIsa::kAVX512)) {
+    XELOGI("Selecting AVX-512 copy_and_swap.");
+    isa = memory::CopyAndSwapIsa::kAVX512;
+  } else if (IsCopyAndSwapIsaSupported(memory::CopyAndSwapIsa::kAVX2)) {
+    XELOGI("Selecting AVX2 copy_and_swap.");
+    isa = memory::CopyAndSwapIsa::kAVX2;
+  } else {
+    XELOGI("Selecting SSSE3 copy_and_swap.");
+    isa = memory::CopyAndSwapIsa::kSSSE3;
   }
+  // All future calls will go through the selected path.
+  SetCopyAndSwapFunctions(isa);
 }
 
-void copy_and_swap_64_aligned(void* dest_ptr, const void* src_ptr,
-                              size_t count) {
-  assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
-  assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
+XE_COLD
+static void first_copy_and_swap_16(void* dest, const void* src, size_t count) {
+  SelectCopyAndSwapFunctions();
+  copy_and_swap_16_dispatch(dest, src, count);
+}
 
-  auto dest = reinterpret_cast<uint64_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint64_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x01,
-                   0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+XE_COLD
+static void first_copy_and_swap_32(void* dest, const void* src, size_t count) {
+  SelectCopyAndSwapFunctions();
+  copy_and_swap_32_dispatch(dest, src, count);
+}
 
-  size_t i;
-  for (i = 0; i + 2 <= count; i += 2) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 2 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
-  }
+XE_COLD
+static void first_copy_and_swap_64(void* dest, const void* src, size_t count) {
+  SelectCopyAndSwapFunctions();
+  copy_and_swap_64_dispatch(dest, src, count);
 }
 
-void copy_and_swap_64_unaligned(void* dest_ptr, const void* src_ptr,
-                                size_t count) {
-  auto dest = reinterpret_cast<uint64_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint64_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x01,
-                   0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
+XE_COLD
+static void first_copy_and_swap_16_in_32(void* dest, const void* src,
+                                         size_t count) {
+  SelectCopyAndSwapFunctions();
+  copy_and_swap_16_in_32_dispatch(dest, src, count);
+}
 
-  size_t i;
-  for (i = 0; i + 2 <= count; i += 2) {
-    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+memory::CopyAndSwapIsa memory::GetCopyAndSwapIsa() {
+  if (!copy_and_swap_isa_selected) {
+    SelectCopyAndSwapFunctions();
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 2 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+  return copy_and_swap_isa;
+}
+
+bool memory::SetCopyAndSwapIsa(CopyAndSwapIsa isa) {
+  if (!IsCopyAndSwapIsaSupported(isa)) {
+    return false;
   }
+  SetCopyAndSwapFunctions(isa);
+  return true;
+}
+
+size_t memory::GetCopyAndSwapNonTemporalThreshold() {
+  return copy_and_swap_non_temporal_threshold;
 }
 
-void copy_and_swap_16_in_32_aligned(void* dest_ptr, const void* src_ptr,
+void memory::SetCopyAndSwapNonTemporalThreshold(size_t threshold) {
+  copy_and_swap_non_temporal_threshold = threshold;
+}
+
+void copy_and_swap_16_aligned(void* dest, const void* src, size_t count) {
+  assert_zero(reinterpret_cast<uintptr_t>(dest) & 0xF);
+  assert_zero(reinterpret_cast<uintptr_t>(src) & 0xF);
+  copy_and_swap_16_dispatch(dest, src, count);
+}
+
+void copy_and_swap_16_unaligned(void* dest, const void* src, size_t count) {
+  copy_and_swap_16_dispatch(dest, src, count);
+}
+
+void copy_and_swap_32_aligned(void* dest, const void* src, size_t count) {
+  assert_zero(reinterpret_cast<uintptr_t>(dest) & 0xF);
+  assert_zero(reinterpret_cast<uintptr_t>(src) & 0xF);
+  copy_and_swap_32_dispatch(dest, src, count);
+}
+
+void copy_and_swap_32_unaligned(void* dest, const void* src, size_t count) {
+  copy_and_swap_32_dispatch(dest, src, count);
+}
+
+void copy_and_swap_64_aligned(void* dest, const void* src, size_t count) {
+  assert_zero(reinterpret_cast<uintptr_t>(dest) & 0xF);
+  assert_zero(reinterpret_cast<uintptr_t>(src) & 0xF);
+  copy_and_swap_64_dispatch(dest, src, count);
+}
+
+void copy_and_swap_64_unaligned(void* dest, const void* src, size_t count) {
+  copy_and_swap_64_dispatch(dest, src, count);
+}
+
+void copy_and_swap_16_in_32_aligned(void* dest, const void* src,
                                     size_t count) {
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  size_t i;
-  for (i = 0; i + 4 <= count; i += 4) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output =
-        _mm_or_si128(_mm_slli_epi32(input, 16), _mm_srli_epi32(input, 16));
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = (src[i] >> 16) | (src[i] << 16);
-  }
+  copy_and_swap_16_in_32_dispatch(dest, src, count);
 }
 
-void copy_and_swap_16_in_32_unaligned(void* dest_ptr, const void* src_ptr,
+void copy_and_swap_16_in_32_unaligned(void* dest, const void* src,
                                       size_t count) {
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  size_t i;
-  for (i = 0; i + 4 <= count; i += 4) {
-    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output =
-        _mm_or_si128(_mm_slli_epi32(input, 16), _mm_srli_epi32(input, 16));
-    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = (src[i] >> 16) | (src[i] << 16);
-  }
+  copy_and_swap_16_in_32_dispatch(dest, src, count);
 }
 
 #elif XE_ARCH_ARM64
@@ -14,11 +14,15 @@
 #include <cstring>
 #include <filesystem>
 #include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "xenia/base/byte_order.h"
+#include "xenia/base/platform.h"
 
 namespace xe {
 namespace memory {
@@ -89,6 +93,23 @@ bool IsWritableExecutableMemorySupported();
 // writable executable memory on a system with it.
 bool IsWritableExecutableMemoryPreferred();
 
+// Whether guest memory and generated code should be backed by large pages
+// where the host supports it.
+bool IsLargePageBackingPreferred();
+
+// Hints the host to back the range with large pages (transparent huge pages on
+// Linux) where possible. Unlike fixed large page allocations, this doesn't
+// restrict the granularity of Protect - the host splits the large pages where
+// access rights of individual pages differ. Committing parts of the range
+// with AllocFixed keeps the advice, so this needs to be called only once for
+// the whole reservation. Returns false if not supported.
+bool AdviseLargePages(void* base_address, size_t length);
+
+// Returns the size of the part of the range currently backed by large pages,
+// or 0 if unknown. This is only a proxy for the TLB effect - the actual TLB
+// misses can only be measured with the host's performance counters.
+size_t QueryLargePageBackedSize(void* base_address, size_t length);
+
 // Allocates a block of memory at the given page-aligned base address.
 // Fails if the memory is not available.
 // Specify nullptr for base_address to leave it up to the system.
@@ -156,6 +177,37 @@ void* MapFileView(FileMappingHandle handle, void* base_address, size_t length,
                   PageAccess access, size_t file_offset);
 bool UnmapFileView(FileMappingHandle handle, void* base_address, size_t length);
 
+// Tracking of writes to a range of memory without delivering a page fault to
+// the process for every first write to a page, unlike with Protect - the host
+// kernel only records that the pages have been written, and the written pages
+// are retrieved in batches. Currently available on Linux 6.7+ (asynchronous
+// userfaultfd write protection and the PAGEMAP_SCAN ioctl).
+class WriteWatch {
+ public:
+  // Returns nullptr if not supported by the host. The range must be mapped
+  // for the whole lifetime of the object.
+  static std::unique_ptr<WriteWatch> Create(void* base_address, size_t length);
+  ~WriteWatch();
+
+  // Starts recording writes to the pages in the range, dropping the written
+  // state of them. Both base_address and length will be adjusted to
+  // page_size().
+  bool Reset(void* base_address, size_t length);
+
+  // Appends the ranges of pages written since the last reset (as offsets from
+  // base_address and lengths) to written_ranges, atomically resetting them.
+  bool GetAndReset(void* base_address, size_t length,
+                   std::vector<std::pair<size_t, size_t>>& written_ranges);
+
+ private:
+  WriteWatch() = default;
+
+#if XE_PLATFORM_LINUX
+  int userfaultfd_ = -1;
+  int pagemap_ = -1;
+#endif
+};
+
 inline size_t hash_combine(size_t seed) { return seed; }
 
 template <typename T, typename... Ts>
@@ -169,6 +221,26 @@ XE_NOINLINE
 void vastcpy(uint8_t* XE_RESTRICT physaddr, uint8_t* XE_RESTRICT rdmapping,
              uint32_t written_length);
 
+#if XE_ARCH_AMD64
+// Instruction set used by the copy_and_swap functions, selected on the first
+// call based on the host CPU features. Changing it is not thread-safe, and is
+// meant only for testing and benchmarking.
+enum class CopyAndSwapIsa {
+  kSSSE3,
+  kAVX2,
+  kAVX512,
+};
+CopyAndSwapIsa GetCopyAndSwapIsa();
+// Returns false if the host CPU doesn't support the instruction set.
+bool SetCopyAndSwapIsa(CopyAndSwapIsa isa);
+
+// Blocks of at least this many bytes are written with non-temporal stores, so
+// large uploads don't evict the working set from the cache.
+constexpr size_t kCopyAndSwapNonTemporalThresholdDefault = 1024 * 1024;
+size_t GetCopyAndSwapNonTemporalThreshold();
+void SetCopyAndSwapNonTemporalThreshold(size_t threshold);
+#endif  // XE_ARCH_AMD64
+
 }  // namespace memory
 
 // TODO(benvanik): move into xe::memory::
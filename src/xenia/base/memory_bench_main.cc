@@ -0,0 +1,143 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/clock.h"
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/memory.h"
+#include "xenia/base/platform.h"
+
+DEFINE_uint64(memory_bench_bytes, 256 * 1024 * 1024,
+              "Number of bytes to swap for every measured combination of the "
+              "element size, the block size and the implementation.",
+              "Memory");
+
+namespace xe {
+
+namespace {
+
+struct SwapFunction {
+  const char* name;
+  size_t element_size;
+  void (*function)(void* dest, const void* src, size_t count);
+};
+
+const SwapFunction kSwapFunctions[] = {
+    {"16", sizeof(uint16_t), copy_and_swap_16_unaligned},
+    {"32", sizeof(uint32_t), copy_and_swap_32_unaligned},
+    {"64", sizeof(uint64_t), copy_and_swap_64_unaligned},
+    {"16_in_32", sizeof(uint32_t), copy_and_swap_16_in_32_unaligned},
+};
+
+// From a few texels to larger than the last level cache.
+const size_t kBlockSizes[] = {
+    64, 1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024, 32 * 1024 * 1024,
+};
+
+// Returns the throughput in GB/s.
+double Measure(const SwapFunction& swap_function, uint8_t* dest,
+               const uint8_t* src, size_t block_size) {
+  size_t count = block_size / swap_function.element_size;
+  size_t iteration_count =
+      std::max(size_t(cvars::memory_bench_bytes / block_size), size_t(1));
+  // Warm up the caches and select the implementation.
+  swap_function.function(dest, src, count);
+  uint64_t start = Clock::QueryHostTickCount();
+  for (size_t i = 0; i < iteration_count; ++i) {
+    swap_function.function(dest, src, count);
+  }
+  uint64_t ticks = Clock::QueryHostTickCount() - start;
+  if (!ticks) {
+    return 0.0;
+  }
+  double seconds = double(ticks) / double(Clock::QueryHostTickFrequency());
+  return double(block_size) * double(iteration_count) / seconds / 1.0e9;
+}
+
+void MeasureAll(const char* implementation_name, uint8_t* dest,
+                const uint8_t* src) {
+  for (const SwapFunction& swap_function : kSwapFunctions) {
+    for (size_t block_size : kBlockSizes) {
+      // Aligned, and with the destination offset by one element, so it's not
+      // aligned to the vector size.
+      double aligned_throughput =
+          Measure(swap_function, dest, src, block_size);
+      double unaligned_throughput =
+          Measure(swap_function, dest + swap_function.element_size, src,
+                  block_size);
+      XELOGI(
+          "{} copy_and_swap_{} {} bytes: {:.2f} GB/s, {:.2f} GB/s unaligned",
+          implementation_name, swap_function.name, block_size,
+          aligned_throughput, unaligned_throughput);
+    }
+  }
+}
+
+}  // namespace
+
+int memory_bench_main(const std::vector<std::string>& args) {
+  size_t buffer_size = kBlockSizes[xe::countof(kBlockSizes) - 1] + 64;
+  // Page-aligned, so the alignment is the same for every implementation.
+  auto src = static_cast<uint8_t*>(memory::AllocFixed(
+      nullptr, buffer_size, memory::AllocationType::kReserveCommit,
+      memory::PageAccess::kReadWrite));
+  auto dest = static_cast<uint8_t*>(memory::AllocFixed(
+      nullptr, buffer_size, memory::AllocationType::kReserveCommit,
+      memory::PageAccess::kReadWrite));
+  if (!src || !dest) {
+    XELOGE("Failed to allocate the buffers.");
+    return 1;
+  }
+  for (size_t i = 0; i < buffer_size; ++i) {
+    src[i] = uint8_t(i * 7);
+  }
+  std::memset(dest, 0, buffer_size);
+
+#if XE_ARCH_AMD64
+  static const std::pair<memory::CopyAndSwapIsa, const char*> kIsas[] = {
+      {memory::CopyAndSwapIsa::kSSSE3, "SSSE3"},
+      {memory::CopyAndSwapIsa::kAVX2, "AVX2"},
+      {memory::CopyAndSwapIsa::kAVX512, "AVX-512"},
+  };
+  memory::CopyAndSwapIsa default_isa = memory::GetCopyAndSwapIsa();
+  size_t default_threshold = memory::GetCopyAndSwapNonTemporalThreshold();
+  for (const auto& isa : kIsas) {
+    if (!memory::SetCopyAndSwapIsa(isa.first)) {
+      XELOGI("{} is not supported by the host CPU.", isa.second);
+      continue;
+    }
+    memory::SetCopyAndSwapNonTemporalThreshold(SIZE_MAX);
+    MeasureAll(isa.second, dest, src);
+    memory::SetCopyAndSwapNonTemporalThreshold(0);
+    MeasureAll(fmt::format("{} non-temporal", isa.second).c_str(), dest, src);
+  }
+  memory::SetCopyAndSwapIsa(default_isa);
+  memory::SetCopyAndSwapNonTemporalThreshold(default_threshold);
+#else
+  MeasureAll("Default", dest, src);
+#endif  // XE_ARCH_AMD64
+
+  memory::DeallocFixed(dest, buffer_size, memory::DeallocationType::kRelease);
+  memory::DeallocFixed(src, buffer_size, memory::DeallocationType::kRelease);
+  return 0;
+}
+
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-base-memory-bench", xe::memory_bench_main, "");
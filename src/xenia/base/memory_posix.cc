@@ -12,7 +12,9 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstddef>
+#include <cstdio>
 
 #include "xenia/base/math.h"
 #include "xenia/base/platform.h"
@@ -27,6 +29,13 @@
 #include "xenia/base/main_android.h"
 #endif
 
+#if XE_PLATFORM_LINUX
+#include <linux/fs.h>
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
 namespace xe {
 namespace memory {
 
@@ -87,6 +96,14 @@ void* AllocFixed(void* base_address, size_t length,
   uint32_t prot = ToPosixProtectFlags(access);
   int flags = 0;
   if (base_address != nullptr) {
+    // Committing a range that's already mapped (a view of the guest memory or
+    // of the code cache) must keep the mapping, along with the data shared
+    // with other views and any large page advice, so only change the
+    // protection.
+    if (allocation_type == AllocationType::kCommit &&
+        mprotect(base_address, length, prot) == 0) {
+      return base_address;
+    }
     flags = MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS;
   } else {
     flags = MAP_PRIVATE | MAP_ANONYMOUS;
@@ -118,6 +135,52 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return false;
 }
 
+bool AdviseLargePages(void* base_address, size_t length) {
+#ifdef MADV_HUGEPAGE
+  // Not MFD_HUGETLB - hugetlbfs mappings can only be protected as a whole huge
+  // page, while guest memory protection and watches work with 4 KB pages.
+  size_t page_mask = page_size() - 1;
+  uintptr_t start = uintptr_t(base_address) & ~page_mask;
+  uintptr_t end = (uintptr_t(base_address) + length + page_mask) & ~page_mask;
+  return madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE) ==
+         0;
+#else
+  return false;
+#endif
+}
+
+size_t QueryLargePageBackedSize(void* base_address, size_t length) {
+  FILE* smaps = fopen("/proc/self/smaps", "r");
+  if (!smaps) {
+    return 0;
+  }
+  uintptr_t range_start = uintptr_t(base_address);
+  uintptr_t range_end = range_start + length;
+  // Mappings only partially in the range are counted proportionally.
+  double overlap_fraction = 0.0;
+  double large_page_kb = 0.0;
+  char line[256];
+  while (fgets(line, sizeof(line), smaps)) {
+    unsigned long long mapping_start, mapping_end;
+    unsigned long long kb;
+    if (sscanf(line, "%llx-%llx", &mapping_start, &mapping_end) == 2) {
+      uintptr_t overlap_start = std::max(uintptr_t(mapping_start), range_start);
+      uintptr_t overlap_end = std::min(uintptr_t(mapping_end), range_end);
+      overlap_fraction =
+          overlap_end > overlap_start
+              ? double(overlap_end - overlap_start) /
+                    double(mapping_end - mapping_start)
+              : 0.0;
+    } else if (overlap_fraction > 0.0 &&
+               (sscanf(line, "AnonHugePages: %llu kB", &kb) == 1 ||
+                sscanf(line, "ShmemPmdMapped: %llu kB", &kb) == 1)) {
+      large_page_kb += kb * overlap_fraction;
+    }
+  }
+  fclose(smaps);
+  return size_t(large_page_kb) * 1024;
+}
+
 FileMappingHandle CreateFileMappingHandle(const std::filesystem::path& path,
                                           size_t length, PageAccess access,
                                           bool commit) {
@@ -193,5 +256,112 @@ bool UnmapFileView(FileMappingHandle handle, void* base_address,
   return munmap(base_address, length) == 0;
 }
 
+// Asynchronous userfaultfd write protection (the kernel clears the protection
+// by itself on write instead of notifying the userfaultfd reader) and the
+// PAGEMAP_SCAN ioctl are Linux 6.7+.
+#if XE_PLATFORM_LINUX && defined(UFFD_FEATURE_WP_ASYNC) && defined(PAGEMAP_SCAN)
+#define XE_MEMORY_WRITE_WATCH_UFFD 1
+#endif
+
+std::unique_ptr<WriteWatch> WriteWatch::Create(void* base_address,
+                                               size_t length) {
+#ifdef XE_MEMORY_WRITE_WATCH_UFFD
+  std::unique_ptr<WriteWatch> write_watch(new WriteWatch);
+  // User mode only is enough since the kernel doesn't write to guest memory,
+  // and it's allowed with vm.unprivileged_userfaultfd = 0.
+  write_watch->userfaultfd_ = int(syscall(
+      SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY));
+  if (write_watch->userfaultfd_ < 0) {
+    return nullptr;
+  }
+  uffdio_api api = {};
+  api.api = UFFD_API;
+  // Without WP_UNPOPULATED, pages not populated yet wouldn't be protected.
+  api.features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED |
+                 UFFD_FEATURE_WP_HUGETLBFS_SHMEM;
+  if (ioctl(write_watch->userfaultfd_, UFFDIO_API, &api) < 0) {
+    return nullptr;
+  }
+  uffdio_register register_range = {};
+  register_range.range.start = uint64_t(base_address);
+  register_range.range.len = length;
+  register_range.mode = UFFDIO_REGISTER_MODE_WP;
+  if (ioctl(write_watch->userfaultfd_, UFFDIO_REGISTER, &register_range) < 0) {
+    return nullptr;
+  }
+  write_watch->pagemap_ = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+  if (write_watch->pagemap_ < 0) {
+    return nullptr;
+  }
+  return write_watch;
+#else
+  return nullptr;
+#endif
+}
+
+WriteWatch::~WriteWatch() {
+#if XE_PLATFORM_LINUX
+  if (pagemap_ >= 0) {
+    close(pagemap_);
+  }
+  // Closing the userfaultfd also unregisters all its ranges.
+  if (userfaultfd_ >= 0) {
+    close(userfaultfd_);
+  }
+#endif
+}
+
+bool WriteWatch::Reset(void* base_address, size_t length) {
+#ifdef XE_MEMORY_WRITE_WATCH_UFFD
+  size_t page_mask = page_size() - 1;
+  uintptr_t start = uintptr_t(base_address) & ~page_mask;
+  uffdio_writeprotect writeprotect = {};
+  writeprotect.range.start = start;
+  writeprotect.range.len =
+      ((uintptr_t(base_address) + length + page_mask) & ~page_mask) - start;
+  writeprotect.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+  return ioctl(userfaultfd_, UFFDIO_WRITEPROTECT, &writeprotect) == 0;
+#else
+  return false;
+#endif
+}
+
+bool WriteWatch::GetAndReset(
+    void* base_address, size_t length,
+    std::vector<std::pair<size_t, size_t>>& written_ranges) {
+#ifdef XE_MEMORY_WRITE_WATCH_UFFD
+  size_t page_mask = page_size() - 1;
+  uint64_t end = (uintptr_t(base_address) + length + page_mask) & ~page_mask;
+  page_region regions[256];
+  pm_scan_arg scan = {};
+  scan.size = sizeof(scan);
+  // Protect the written pages again in the same walk so writes done during the
+  // scan are not lost.
+  scan.flags = PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC;
+  scan.start = uintptr_t(base_address) & ~page_mask;
+  scan.end = end;
+  scan.vec = uint64_t(regions);
+  scan.vec_len = xe::countof(regions);
+  scan.category_mask = PAGE_IS_WRITTEN;
+  scan.return_mask = PAGE_IS_WRITTEN;
+  while (scan.start < end) {
+    int region_count = ioctl(pagemap_, PAGEMAP_SCAN, &scan);
+    if (region_count < 0) {
+      return false;
+    }
+    for (int i = 0; i < region_count; ++i) {
+      written_ranges.emplace_back(
+          size_t(regions[i].start - uintptr_t(base_address)),
+          size_t(regions[i].end - regions[i].start));
+    }
+    // If the region buffer is full, the walk stops early.
+    scan.start = scan.walk_end;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 }  // namespace memory
 }  // namespace xe
@@ -185,6 +185,17 @@ bool Protect(void* base_address, size_t length, PageAccess access,
   return true;
 }
 
+bool AdviseLargePages(void* base_address, size_t length) {
+  // Large pages on Windows require the SeLockMemoryPrivilege, can't back file
+  // mappings with views at arbitrary addresses, and can't be protected with 4
+  // KB granularity.
+  return false;
+}
+
+size_t QueryLargePageBackedSize(void* base_address, size_t length) {
+  return 0;
+}
+
 bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   access_out = PageAccess::kNoAccess;
 
@@ -283,5 +294,22 @@ bool UnmapFileView(FileMappingHandle handle, void* base_address,
   return UnmapViewOfFile(base_address) ? true : false;
 }
 
+// GetWriteWatch only works with memory allocated via VirtualAlloc with
+// MEM_WRITE_WATCH, not with views of file mappings.
+std::unique_ptr<WriteWatch> WriteWatch::Create(void* base_address,
+                                               size_t length) {
+  return nullptr;
+}
+
+WriteWatch::~WriteWatch() = default;
+
+bool WriteWatch::Reset(void* base_address, size_t length) { return false; }
+
+bool WriteWatch::GetAndReset(
+    void* base_address, size_t length,
+    std::vector<std::pair<size_t, size_t>>& written_ranges) {
+  return false;
+}
+
 }  // namespace memory
 }  // namespace xe
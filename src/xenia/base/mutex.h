@@ -13,6 +13,13 @@
 #include "memory.h"
 #include "platform.h"
 #define XE_ENABLE_FAST_WIN32_MUTEX 1
+// Records per-call-site acquire counts, wait times and hold times for the
+// global critical region. See global_lock_profiler.h. When disabled, none of
+// the call site plumbing is compiled in. Enabled with the
+// --global-lock-profiling premake option.
+#ifndef XE_ENABLE_GLOBAL_LOCK_PROFILING
+#define XE_ENABLE_GLOBAL_LOCK_PROFILING 0
+#endif
 namespace xe {
 
 #if XE_PLATFORM_WIN32 == 1 && XE_ENABLE_FAST_WIN32_MUTEX == 1
@@ -36,7 +43,7 @@ class alignas(4096) xe_global_mutex {
   void unlock();
   bool try_lock();
 };
-using global_mutex_type = xe_global_mutex;
+using raw_global_mutex_type = xe_global_mutex;
 
 class alignas(64) xe_fast_mutex {
   XE_MAYBE_UNUSED
@@ -81,7 +88,7 @@ class xe_unlikely_mutex {
 };
 using xe_mutex = xe_fast_mutex;
 #else
-using global_mutex_type = std::recursive_mutex;
+using raw_global_mutex_type = std::recursive_mutex;
 using xe_mutex = std::mutex;
 using xe_unlikely_mutex = std::mutex;
 #endif
@@ -92,6 +99,50 @@ struct null_mutex {
   static bool try_lock() { return true; }
 };
 
+#if XE_ENABLE_GLOBAL_LOCK_PROFILING == 1
+// Source location of a global critical region acquisition. std::source_location
+// is C++20, so the equivalent compiler builtins (available in MSVC, Clang and
+// GCC) are used as default arguments, which are evaluated at the call site.
+struct global_lock_site {
+  const char* file;
+  const char* function;
+  uint32_t line;
+};
+#define XE_GLOBAL_LOCK_SITE_CURRENT()                        \
+  xe::global_lock_site {                                     \
+    __builtin_FILE(), __builtin_FUNCTION(), __builtin_LINE() \
+  }
+#define XE_GLOBAL_LOCK_SITE_PARAM \
+  const xe::global_lock_site& site = XE_GLOBAL_LOCK_SITE_CURRENT()
+#define XE_GLOBAL_LOCK_SITE_SET() xe::profiled_global_mutex::SetNextSite(site)
+
+// Wraps the global mutex, attributing every acquisition to the site passed to
+// SetNextSite by the same thread immediately before locking (or to a catch-all
+// site for direct mutex().lock() calls).
+// Statistics are only ever modified while the wrapped mutex is held, so they
+// need no synchronization of their own.
+class profiled_global_mutex {
+ public:
+  void lock();
+  void unlock();
+  bool try_lock();
+
+  static void SetNextSite(const global_lock_site& site);
+
+  raw_global_mutex_type& raw_mutex() { return mutex_; }
+
+ private:
+  raw_global_mutex_type mutex_;
+};
+using global_mutex_type = profiled_global_mutex;
+#else
+#define XE_GLOBAL_LOCK_SITE_PARAM
+#define XE_GLOBAL_LOCK_SITE_SET() \
+  do {                             \
+  } while (false)
+using global_mutex_type = raw_global_mutex_type;
+#endif  // XE_ENABLE_GLOBAL_LOCK_PROFILING
+
 using global_unique_lock_type = std::unique_lock<global_mutex_type>;
 // The global critical region mutex singleton.
 // This must guard any operation that may suspend threads or be sensitive to
@@ -140,12 +191,14 @@ class global_critical_region {
   // Use this when keeping an instance is not possible. Otherwise, prefer
   // to keep an instance of global_critical_region near the members requiring
   // it to keep things readable.
-  static global_unique_lock_type AcquireDirect() {
+  static global_unique_lock_type AcquireDirect(XE_GLOBAL_LOCK_SITE_PARAM) {
+    XE_GLOBAL_LOCK_SITE_SET();
     return global_unique_lock_type(mutex());
   }
 
   // Acquires a lock on the global critical section.
-  static inline global_unique_lock_type Acquire() {
+  static inline global_unique_lock_type Acquire(XE_GLOBAL_LOCK_SITE_PARAM) {
+    XE_GLOBAL_LOCK_SITE_SET();
     return global_unique_lock_type(mutex());
   }
 
@@ -162,7 +215,8 @@ class global_critical_region {
 
   // Tries to acquire a lock on the glboal critical section.
   // Check owns_lock() to see if the lock was successfully acquired.
-  static inline global_unique_lock_type TryAcquire() {
+  static inline global_unique_lock_type TryAcquire(XE_GLOBAL_LOCK_SITE_PARAM) {
+    XE_GLOBAL_LOCK_SITE_SET();
     return global_unique_lock_type(mutex(), std::try_to_lock);
   }
 };
@@ -17,4 +17,32 @@ project("xenia-base")
     "debug_visualizers.natvis",
   })
 
+group("src")
+project("xenia-log-decode")
+  uuid("2b7e9c14-5f3a-4d86-a1e0-7c9d3b6f2a58")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "fmt",
+    "xenia-base",
+  })
+  files({
+    "log_decode_main.cc",
+    "console_app_main_"..platform_suffix..".cc",
+  })
+
+group("src")
+project("xenia-base-memory-bench")
+  uuid("6f1d3a2e-8b4c-4e95-a7d0-2c5b9e81f437")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "fmt",
+    "xenia-base",
+  })
+  files({
+    "memory_bench_main.cc",
+    "console_app_main_"..platform_suffix..".cc",
+  })
+
 include("testing")
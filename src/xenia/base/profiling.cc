@@ -72,6 +72,8 @@ bool Profiler::is_enabled() { return true; }
 bool Profiler::is_visible() { return is_enabled() && MicroProfileIsDrawing(); }
 
 void Profiler::Initialize() {
+  Timeline::Initialize();
+
   // Custom groups.
   MicroProfileSetEnableAllGroups(false);
   MicroProfileForceEnableGroup("apu", MicroProfileTokenTypeCpu);
@@ -111,6 +113,7 @@ void Profiler::Dump() {
 }
 
 void Profiler::Shutdown() {
+  Timeline::Shutdown();
   SetUserIO(0, nullptr, nullptr, nullptr);
   window_ = nullptr;
   MicroProfileShutdown();
@@ -123,6 +126,7 @@ uint32_t Profiler::GetColor(const char* str) {
 }
 
 void Profiler::ThreadEnter(const char* name) {
+  Timeline::ThreadEnter(name);
   MicroProfileOnThreadCreate(name);
 }
 
@@ -335,11 +339,11 @@ void Profiler::PostInputEvent() {
 
 bool Profiler::is_enabled() { return false; }
 bool Profiler::is_visible() { return false; }
-void Profiler::Initialize() {}
+void Profiler::Initialize() { Timeline::Initialize(); }
 void Profiler::Dump() {}
-void Profiler::Shutdown() {}
+void Profiler::Shutdown() { Timeline::Shutdown(); }
 uint32_t Profiler::GetColor(const char* str) { return 0; }
-void Profiler::ThreadEnter(const char* name) {}
+void Profiler::ThreadEnter(const char* name) { Timeline::ThreadEnter(name); }
 void Profiler::ThreadExit() {}
 void Profiler::ToggleDisplay() {}
 void Profiler::TogglePause() {}
@@ -16,6 +16,7 @@
 
 #include "xenia/base/platform.h"
 #include "xenia/base/string.h"
+#include "xenia/base/timeline.h"
 #include "xenia/ui/ui_drawer.h"
 #include "xenia/ui/virtual_key.h"
 #include "xenia/ui/window_listener.h"
@@ -68,17 +69,37 @@ namespace xe {
 // of the containing block.
 #define SCOPE_profile_cpu(name) MICROPROFILE_SCOPE(name)
 
+// Enters both the Microprofile and the timeline scope with a single
+// declaration, so the macros using it are a single statement.
+class CpuProfileScope {
+ public:
+  CpuProfileScope(MicroProfileToken token, const char* group_name,
+                  const char* scope_name)
+      : microprofile_scope_(token), timeline_scope_(group_name, scope_name) {}
+
+ private:
+  MicroProfileScopeHandler microprofile_scope_;
+  TimelineScope timeline_scope_;
+};
+#define XE_CPU_PROFILE_SCOPE(group_name, scope_name)          \
+  xe::CpuProfileScope XE_TIMELINE_SCOPE_NAME(__LINE__)(       \
+      [](const char* name) {                                  \
+        static MicroProfileToken token = MicroProfileGetToken( \
+            group_name, name, xe::Profiler::GetColor(name),   \
+            MicroProfileTokenTypeCpu);                        \
+        return token;                                         \
+      }(scope_name),                                          \
+      group_name, scope_name)
+
 // Enters a CPU profiling scope, active for the duration of the containing
 // block. No previous definition required.
 #define SCOPE_profile_cpu_i(group_name, scope_name) \
-  MICROPROFILE_SCOPEI(group_name, scope_name,       \
-                      xe::Profiler::GetColor(scope_name))
+  XE_CPU_PROFILE_SCOPE(group_name, scope_name)
 
 // Enters a CPU profiling scope by function name, active for the duration of
 // the containing block. No previous definition required.
-#define SCOPE_profile_cpu_f(group_name)         \
-  MICROPROFILE_SCOPEI(group_name, __FUNCTION__, \
-                      xe::Profiler::GetColor(__FUNCTION__))
+#define SCOPE_profile_cpu_f(group_name) \
+  XE_CPU_PROFILE_SCOPE(group_name, __FUNCTION__)
 
 // Enters a previously defined GPU profiling scope, active for the duration
 // of the containing block.
@@ -120,12 +141,10 @@ namespace xe {
 #define SCOPE_profile_cpu(name) \
   do {                          \
   } while (false)
-#define SCOPE_profile_cpu_f(name) \
-  do {                            \
-  } while (false)
+// The CPU scopes are still recorded by the timeline.
+#define SCOPE_profile_cpu_f(name) XE_TIMELINE_SCOPE(name, __FUNCTION__)
 #define SCOPE_profile_cpu_i(group_name, scope_name) \
-  do {                                              \
-  } while (false)
+  XE_TIMELINE_SCOPE(group_name, scope_name)
 #define SCOPE_profile_gpu(name) \
   do {                          \
   } while (false)
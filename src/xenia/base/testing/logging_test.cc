@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <string>
+
+#include "xenia/base/logging.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::base::test {
+
+template <typename... Args>
+std::string FormatAsRecord(const char* format, const Args&... args) {
+  char buffer[256];
+  logging::internal::LogRecordWriter writer(buffer, sizeof(buffer));
+  (writer.WriteArg(args), ...);
+  REQUIRE(!writer.overflowed());
+  std::string out;
+  REQUIRE(logging::internal::FormatLogRecordArgs(
+      format, reinterpret_cast<const uint8_t*>(buffer), writer.size(), out));
+  return out;
+}
+
+TEST_CASE("Binary log records", "[logging]") {
+  SECTION("Formatted like text") {
+    std::string name = "XamInputGetState";
+    REQUIRE(FormatAsRecord("{} {:08X} {} {} {} {:.2f} {}", name,
+                           uint32_t(0x8200ABCD), int8_t(-5), true, 'c', 0.5,
+                           std::string_view("view")) ==
+            "XamInputGetState 8200ABCD -5 true c 0.50 view");
+    REQUIRE(FormatAsRecord("{} {}", "literal", 1.5f) == "literal 1.5");
+  }
+
+  SECTION("Format IDs") {
+    std::string format = "Format {}";
+    uint32_t id = logging::internal::GetLogFormatId(format.c_str());
+    REQUIRE(logging::internal::GetLogFormatId("Format {}") == id);
+    REQUIRE(std::string(logging::internal::GetLogFormat(id)) == format);
+    // Same pointer with different contents.
+    format[0] = 'f';
+    REQUIRE(logging::internal::GetLogFormatId(format.c_str()) != id);
+  }
+
+  SECTION("Overflow") {
+    char buffer[8];
+    logging::internal::LogRecordWriter writer(buffer, sizeof(buffer));
+    writer.WriteArg(std::string_view("too long for the buffer"));
+    REQUIRE(writer.overflowed());
+  }
+
+  SECTION("Malformed") {
+    const uint8_t args[] = {uint8_t(logging::internal::LogArgType::kUnsigned),
+                            1, 2};
+    std::string out;
+    REQUIRE(!logging::internal::FormatLogRecordArgs("{}", args, sizeof(args),
+                                                    out));
+  }
+}
+
+}  // namespace xe::base::test
@@ -506,6 +506,69 @@ TEST_CASE("copy_and_swap_16_in_32_unaligned", "[copy_and_swap]") {
   }
 }
 
+#if XE_ARCH_AMD64
+TEST_CASE("copy_and_swap_isa", "[copy_and_swap]") {
+  constexpr size_t max_count = 1000;
+  std::array<uint8_t, max_count * 8 + 64> src{};
+  std::array<uint8_t, max_count * 8 + 64> dst{};
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<uint8_t>(i * 7 + 1);
+  }
+
+  memory::CopyAndSwapIsa default_isa = memory::GetCopyAndSwapIsa();
+  size_t default_threshold = memory::GetCopyAndSwapNonTemporalThreshold();
+  for (memory::CopyAndSwapIsa isa :
+       {memory::CopyAndSwapIsa::kSSSE3, memory::CopyAndSwapIsa::kAVX2,
+        memory::CopyAndSwapIsa::kAVX512}) {
+    if (!memory::SetCopyAndSwapIsa(isa)) {
+      continue;
+    }
+    // Both without and with non-temporal stores.
+    for (size_t threshold : {SIZE_MAX, size_t(0)}) {
+      memory::SetCopyAndSwapNonTemporalThreshold(threshold);
+      for (size_t count : {1, 7, 31, 64, 129, 1000}) {
+        for (size_t dst_offset : {0, 4, 12}) {
+          // Check the bytes around the written range too.
+          dst.fill(0xCD);
+          uint8_t* dst_data = dst.data() + dst_offset;
+          copy_and_swap_32_unaligned(dst_data, src.data() + 1, count);
+          for (size_t i = 0; i < count; ++i) {
+            REQUIRE(load<uint32_t>(dst_data + i * 4) ==
+                    byte_swap(load<uint32_t>(src.data() + 1 + i * 4)));
+          }
+          REQUIRE(dst_data[count * 4] == 0xCD);
+
+          copy_and_swap_16_unaligned(dst_data, src.data(), count);
+          for (size_t i = 0; i < count; ++i) {
+            REQUIRE(load<uint16_t>(dst_data + i * 2) ==
+                    byte_swap(load<uint16_t>(src.data() + i * 2)));
+          }
+
+          copy_and_swap_64_unaligned(dst_data, src.data(), count);
+          for (size_t i = 0; i < count; ++i) {
+            REQUIRE(load<uint64_t>(dst_data + i * 8) ==
+                    byte_swap(load<uint64_t>(src.data() + i * 8)));
+          }
+          REQUIRE(dst_data[count * 8] == 0xCD);
+
+          copy_and_swap_16_in_32_unaligned(dst_data, src.data(), count);
+          for (size_t i = 0; i < count; ++i) {
+            uint32_t value = load<uint32_t>(src.data() + i * 4);
+            REQUIRE(load<uint32_t>(dst_data + i * 4) ==
+                    ((value >> 16) | (value << 16)));
+          }
+          if (dst_offset) {
+            REQUIRE(dst[dst_offset - 1] == 0xCD);
+          }
+        }
+      }
+    }
+  }
+  memory::SetCopyAndSwapIsa(default_isa);
+  memory::SetCopyAndSwapNonTemporalThreshold(default_threshold);
+}
+#endif  // XE_ARCH_AMD64
+
 TEST_CASE("create_and_close_file_mapping", "Virtual Memory Mapping") {
   auto path = fmt::format("xenia_test_{}", Clock::QueryHostTickCount());
   auto memory = xe::memory::CreateFileMappingHandle(
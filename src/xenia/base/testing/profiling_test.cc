@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "xenia/base/filesystem.h"
+#include "xenia/base/profiling.h"
+#include "xenia/base/timeline.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::base::test {
+
+void ProfilingTestFunction() { SCOPE_profile_cpu_f("test"); }
+
+void ProfilingTestConditional(bool enter) {
+  // Must be a single statement, entering nothing if the condition is false.
+  if (enter) SCOPE_profile_cpu_i("test", "ProfilingTestConditionalScope");
+}
+
+std::string RecordTrace(void (*record)()) {
+  Timeline::Enable();
+  record();
+  Timeline::Disable();
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "xenia_profiling_test.json";
+  REQUIRE(Timeline::WriteTrace(path));
+  std::string trace;
+  FILE* file = filesystem::OpenFile(path, "rb");
+  REQUIRE(file);
+  char buffer[256];
+  size_t read_size;
+  while ((read_size = fread(buffer, 1, sizeof(buffer), file)) != 0) {
+    trace.append(buffer, read_size);
+  }
+  fclose(file);
+  std::filesystem::remove(path);
+  return trace;
+}
+
+TEST_CASE("CPU profiling scopes", "[profiling]") {
+  SECTION("Recorded") {
+    std::string trace = RecordTrace([]() {
+      {
+        SCOPE_profile_cpu_i("test", "ProfilingTestScope");
+        SCOPE_profile_cpu_i("test", "ProfilingTestNestedScope");
+      }
+      ProfilingTestFunction();
+    });
+    REQUIRE(trace.find("ProfilingTestScope") != std::string::npos);
+    REQUIRE(trace.find("ProfilingTestNestedScope") != std::string::npos);
+    REQUIRE(trace.find("ProfilingTestFunction") != std::string::npos);
+  }
+
+  SECTION("Single statement") {
+    std::string trace =
+        RecordTrace([]() { ProfilingTestConditional(false); });
+    REQUIRE(trace.find("ProfilingTestConditionalScope") == std::string::npos);
+    trace = RecordTrace([]() { ProfilingTestConditional(true); });
+    REQUIRE(trace.find("ProfilingTestConditionalScope") != std::string::npos);
+  }
+
+  SECTION("Not recorded when disabled") {
+    Timeline::Disable();
+    ProfilingTestFunction();
+    std::string trace = RecordTrace([]() {});
+    REQUIRE(trace.find("ProfilingTestFunction") == std::string::npos);
+  }
+}
+
+}  // namespace xe::base::test
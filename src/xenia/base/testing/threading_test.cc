@@ -145,6 +145,25 @@ TEST_CASE("Sleep Current Thread in Alertable State", "[sleep]") {
   // Need callback to call extended I/O function (ReadFileEx or WriteFileEx)
 }
 
+TEST_CASE("Wait on Address", "[wait_on_address]") {
+  std::atomic<uint32_t> value(0);
+
+  // Must not block if the value is already different.
+  WaitOnAddress(&value, 1);
+
+  std::thread thread([&value] {
+    Sleep(50ms);
+    value.store(1, std::memory_order_release);
+    WakeAllOnAddress(&value);
+  });
+  // Spurious wakeups are allowed.
+  while (value.load(std::memory_order_acquire) == 0) {
+    WaitOnAddress(&value, 0);
+  }
+  REQUIRE(value.load(std::memory_order_relaxed) == 1);
+  thread.join();
+}
+
 TEST_CASE("TlsHandle") {
   // Test Allocate
   auto handle = threading::AllocateTlsHandle();
@@ -121,6 +121,13 @@ void Sleep(std::chrono::duration<Rep, Period> duration) {
   Sleep(std::chrono::duration_cast<std::chrono::microseconds>(duration));
 }
 
+// Blocks the current thread while the value at the address is equal to the
+// expected one, until WakeAllOnAddress is called for it (like a futex). May
+// return spuriously, so the value must be rechecked in a loop.
+void WaitOnAddress(const std::atomic<uint32_t>* address, uint32_t expected);
+// Wakes all threads blocked in WaitOnAddress for the address.
+void WakeAllOnAddress(std::atomic<uint32_t>* address);
+
 enum class SleepResult {
   kSuccess,
   kAlerted,
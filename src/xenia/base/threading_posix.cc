@@ -27,6 +27,10 @@
 #include <ctime>
 #include <memory>
 
+#if XE_PLATFORM_LINUX
+#include <linux/futex.h>
+#endif
+
 #if XE_PLATFORM_ANDROID
 #include <dlfcn.h>
 
@@ -159,6 +163,27 @@ void Sleep(std::chrono::microseconds duration) {
   } while (ret == -1 && errno == EINTR);
 }
 
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Futexes operate on plain 32-bit values");
+
+void WaitOnAddress(const std::atomic<uint32_t>* address, uint32_t expected) {
+#if XE_PLATFORM_LINUX
+  // Returns immediately with EAGAIN if the value has already changed.
+  syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr,
+          0);
+#else
+  // Spurious returns are allowed, the caller will check the value again.
+  MaybeYield();
+#endif
+}
+
+void WakeAllOnAddress(std::atomic<uint32_t>* address) {
+#if XE_PLATFORM_LINUX
+  syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr,
+          0);
+#endif
+}
+
 // TODO(bwrsandman) Implement by allowing alert interrupts from IO operations
 thread_local bool alertable_state_ = false;
 SleepResult AlertableSleep(std::chrono::microseconds duration) {
@@ -169,6 +169,18 @@ void Sleep(std::chrono::microseconds duration) {
   }
 }
 
+// WaitOnAddress and WakeByAddressAll are in the API set of Windows 8+.
+#pragma comment(lib, "Synchronization.lib")
+
+void WaitOnAddress(const std::atomic<uint32_t>* address, uint32_t expected) {
+  ::WaitOnAddress(const_cast<std::atomic<uint32_t>*>(address), &expected,
+                  sizeof(expected), INFINITE);
+}
+
+void WakeAllOnAddress(std::atomic<uint32_t>* address) {
+  ::WakeByAddressAll(address);
+}
+
 SleepResult AlertableSleep(std::chrono::microseconds duration) {
   if (SleepEx(static_cast<DWORD>(duration.count() / 1000), TRUE) ==
       WAIT_IO_COMPLETION) {
@@ -0,0 +1,280 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/timeline.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/mutex.h"
+#include "xenia/base/string_buffer.h"
+#include "xenia/base/threading.h"
+
+DEFINE_bool(timeline, false,
+            "Record the profiling scopes of all threads from startup, for "
+            "viewing in chrome://tracing or ui.perfetto.dev. The trace is "
+            "written to timeline_trace_path on exit or when recording is "
+            "toggled off.",
+            "Logging");
+DEFINE_path(timeline_trace_path, "xenia_timeline.json",
+            "File to write the recorded timeline to.", "Logging");
+DEFINE_int32(timeline_budget_mb, 64,
+             "Memory available for the per-thread timeline buffers, in MB.",
+             "Logging");
+
+namespace xe {
+
+namespace {
+
+// 1 MB per thread with 32-byte events.
+constexpr size_t kThreadBufferEventCount = 32768;
+
+struct ThreadBuffer {
+  std::unique_ptr<Timeline::Event[]> events;
+  // Total number of events written in the recording, only written by the
+  // owning thread.
+  std::atomic<uint64_t> write_index = 0;
+  // The recording the events are from.
+  std::atomic<uint32_t> recording = 0;
+  uint32_t thread_id;
+  // Guarded by the registry mutex.
+  std::string thread_name;
+};
+
+struct Registry {
+  xe_mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  size_t allocated_bytes = 0;
+  bool budget_exhausted = false;
+  std::atomic<uint32_t> recording = 0;
+  uint64_t recording_start_ticks = 0;
+};
+
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+thread_local ThreadBuffer* thread_buffer_ = nullptr;
+thread_local bool thread_buffer_unavailable_ = false;
+thread_local std::string thread_name_;
+
+ThreadBuffer* GetThreadBuffer() {
+  if (thread_buffer_ || thread_buffer_unavailable_) {
+    return thread_buffer_;
+  }
+  Registry& registry = GetRegistry();
+  std::lock_guard<xe_mutex> lock(registry.mutex);
+  size_t buffer_size = sizeof(Timeline::Event) * kThreadBufferEventCount;
+  if (registry.allocated_bytes + buffer_size >
+      size_t(std::max(cvars::timeline_budget_mb, 0)) * 1024 * 1024) {
+    thread_buffer_unavailable_ = true;
+    if (!registry.budget_exhausted) {
+      registry.budget_exhausted = true;
+      XELOGW("Timeline memory budget exhausted after {} threads",
+             registry.buffers.size());
+    }
+    return nullptr;
+  }
+  registry.allocated_bytes += buffer_size;
+  auto buffer = std::make_unique<ThreadBuffer>();
+  buffer->events.reset(new Timeline::Event[kThreadBufferEventCount]);
+  buffer->thread_id = threading::current_thread_system_id();
+  buffer->thread_name = thread_name_;
+  thread_buffer_ = buffer.get();
+  registry.buffers.push_back(std::move(buffer));
+  return thread_buffer_;
+}
+
+void AppendJsonString(StringBuffer& buffer, const std::string_view value) {
+  buffer.Append('"');
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      buffer.Append('\\');
+    }
+    buffer.Append(c);
+  }
+  buffer.Append('"');
+}
+
+}  // namespace
+
+std::atomic<bool> Timeline::enabled_ = false;
+
+void Timeline::Initialize() {
+  if (cvars::timeline) {
+    Enable();
+  }
+}
+
+void Timeline::Shutdown() {
+  if (is_enabled()) {
+    Disable();
+    WriteTrace(cvars::timeline_trace_path);
+  }
+}
+
+void Timeline::Enable() {
+  Registry& registry = GetRegistry();
+  {
+    std::lock_guard<xe_mutex> lock(registry.mutex);
+    if (is_enabled()) {
+      return;
+    }
+    registry.recording_start_ticks = Clock::QueryHostTickCount();
+    // Threads reset their buffers when they see the new recording.
+    registry.recording.fetch_add(1, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+  }
+  XELOGI("Timeline recording started");
+}
+
+void Timeline::Disable() {
+  enabled_.store(false, std::memory_order_release);
+}
+
+void Timeline::Toggle() {
+  if (is_enabled()) {
+    Disable();
+    WriteTrace(cvars::timeline_trace_path);
+  } else {
+    Enable();
+  }
+}
+
+void Timeline::ThreadEnter(const char* name) {
+  thread_name_ = name ? name : "";
+  if (thread_buffer_) {
+    std::lock_guard<xe_mutex> lock(GetRegistry().mutex);
+    thread_buffer_->thread_name = thread_name_;
+  }
+}
+
+void Timeline::AddEvent(const Event& event) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  if (!buffer) {
+    return;
+  }
+  uint32_t recording =
+      GetRegistry().recording.load(std::memory_order_acquire);
+  uint64_t write_index;
+  if (buffer->recording.load(std::memory_order_relaxed) != recording) {
+    write_index = 0;
+    buffer->write_index.store(0, std::memory_order_relaxed);
+    buffer->recording.store(recording, std::memory_order_release);
+  } else {
+    write_index = buffer->write_index.load(std::memory_order_relaxed);
+  }
+  buffer->events[write_index % kThreadBufferEventCount] = event;
+  buffer->write_index.store(write_index + 1, std::memory_order_release);
+}
+
+void Timeline::MarkFrame() {
+  if (is_enabled()) {
+    uint64_t ticks = Clock::QueryHostTickCount();
+    AddEvent({"frame", "Frame", ticks, ticks});
+  }
+}
+
+bool Timeline::WriteTrace(const std::filesystem::path& path) {
+  FILE* file = xe::filesystem::OpenFile(path, "wb");
+  if (!file) {
+    XELOGE("Failed to open {} for writing the timeline",
+           xe::path_to_utf8(path));
+    return false;
+  }
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<xe_mutex> lock(registry.mutex);
+  uint32_t recording = registry.recording.load(std::memory_order_acquire);
+  double microseconds_per_tick =
+      1000000.0 / double(Clock::QueryHostTickFrequency());
+  StringBuffer buffer;
+  buffer.Append("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+  bool first_event = true;
+  size_t event_count = 0;
+  std::vector<Event> events;
+  for (const auto& thread_buffer : registry.buffers) {
+    if (thread_buffer->recording.load(std::memory_order_acquire) !=
+        recording) {
+      continue;
+    }
+    // The thread may still be writing if recording was toggled off just now,
+    // so only keep the events that weren't overwritten while copying.
+    uint64_t end = thread_buffer->write_index.load(std::memory_order_acquire);
+    uint64_t begin = end - std::min(end, uint64_t(kThreadBufferEventCount));
+    events.clear();
+    for (uint64_t i = begin; i < end; ++i) {
+      events.push_back(thread_buffer->events[i % kThreadBufferEventCount]);
+    }
+    uint64_t written_end =
+        thread_buffer->write_index.load(std::memory_order_acquire);
+    if (written_end >= begin + kThreadBufferEventCount) {
+      events.erase(events.begin(),
+                   events.begin() +
+                       std::min(size_t(written_end + 1 - begin -
+                                       kThreadBufferEventCount),
+                                events.size()));
+    }
+
+    buffer.Append(first_event ? "\n" : ",\n");
+    first_event = false;
+    buffer.AppendFormat(
+        "{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, "
+        "\"args\": {{\"name\": ",
+        thread_buffer->thread_id);
+    AppendJsonString(buffer, thread_buffer->thread_name.empty()
+                                 ? std::string_view("Unnamed")
+                                 : thread_buffer->thread_name);
+    buffer.Append("}}");
+    for (const Event& event : events) {
+      double timestamp =
+          double(int64_t(event.start_ticks - registry.recording_start_ticks)) *
+          microseconds_per_tick;
+      buffer.Append(",\n{\"name\": ");
+      AppendJsonString(buffer, event.name);
+      buffer.Append(", \"cat\": ");
+      AppendJsonString(buffer, event.group);
+      if (event.end_ticks == event.start_ticks) {
+        buffer.AppendFormat(
+            ", \"ph\": \"i\", \"s\": \"g\", \"ts\": {:.3f}, \"pid\": 1, "
+            "\"tid\": {}}}",
+            timestamp, thread_buffer->thread_id);
+      } else {
+        buffer.AppendFormat(
+            ", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, \"pid\": 1, "
+            "\"tid\": {}}}",
+            timestamp,
+            double(event.end_ticks - event.start_ticks) * microseconds_per_tick,
+            thread_buffer->thread_id);
+      }
+      // Don't keep the whole trace in memory.
+      if (buffer.length() >= 1024 * 1024) {
+        fwrite(buffer.buffer(), 1, buffer.length(), file);
+        buffer.Reset();
+      }
+    }
+    event_count += events.size();
+  }
+  buffer.Append("\n]}\n");
+  fwrite(buffer.buffer(), 1, buffer.length(), file);
+  fclose(file);
+  XELOGI("Wrote {} timeline events to {}", event_count,
+         xe::path_to_utf8(path));
+  return true;
+}
+
+}  // namespace xe
@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_BASE_TIMELINE_H_
+#define XENIA_BASE_TIMELINE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+#include "xenia/base/clock.h"
+
+namespace xe {
+
+// Records the profiling scopes of all threads while enabled, for exporting as
+// a Chrome trace event JSON timeline that can be opened in chrome://tracing or
+// ui.perfetto.dev. Unlike Microprofile, it's meant to be left on for whole
+// play sessions, so each thread only writes to its own ring buffer without
+// locking, and the oldest events are overwritten once the buffer is full.
+// Buffers are allocated on the first event of a thread and are kept for the
+// lifetime of the process, up to the memory budget in the timeline_budget_mb
+// cvar - threads started after that are not recorded.
+class Timeline {
+ public:
+  struct Event {
+    // Both must be strings with static storage duration.
+    const char* group;
+    const char* name;
+    uint64_t start_ticks;
+    // Same as the start for instant events, such as frame markers.
+    uint64_t end_ticks;
+  };
+
+  static bool is_enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Starts recording if the timeline cvar is set. Call at startup.
+  static void Initialize();
+  // Writes the trace if recording. Call at shutdown.
+  static void Shutdown();
+
+  // Starts recording, discarding the events from the previous recording.
+  static void Enable();
+  // Stops recording, keeping the events for WriteTrace.
+  static void Disable();
+  // Starts recording, or stops it and writes the trace to
+  // timeline_trace_path.
+  static void Toggle();
+
+  // Names the calling thread in the trace.
+  static void ThreadEnter(const char* name);
+
+  static void AddEvent(const Event& event);
+  // Adds an instant event for the end of a guest frame.
+  static void MarkFrame();
+
+  // Writes the events of the current or the last recording.
+  static bool WriteTrace(const std::filesystem::path& path);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Adds an event for the duration of the containing block if the timeline is
+// being recorded.
+class TimelineScope {
+ public:
+  TimelineScope(const char* group, const char* name) {
+    if (Timeline::is_enabled()) {
+      group_ = group;
+      name_ = name;
+      start_ticks_ = Clock::QueryHostTickCount();
+    }
+  }
+  ~TimelineScope() {
+    if (name_) {
+      Timeline::AddEvent(
+          {group_, name_, start_ticks_, Clock::QueryHostTickCount()});
+    }
+  }
+  TimelineScope(const TimelineScope&) = delete;
+  TimelineScope& operator=(const TimelineScope&) = delete;
+
+ private:
+  const char* group_ = nullptr;
+  const char* name_ = nullptr;
+  uint64_t start_ticks_ = 0;
+};
+
+#define XE_TIMELINE_SCOPE_NAME_(line) xe_timeline_scope_##line
+#define XE_TIMELINE_SCOPE_NAME(line) XE_TIMELINE_SCOPE_NAME_(line)
+// Used by the SCOPE_profile_cpu macros in profiling.h.
+#define XE_TIMELINE_SCOPE(group_name, scope_name) \
+  xe::TimelineScope XE_TIMELINE_SCOPE_NAME(__LINE__)(group_name, scope_name)
+
+}  // namespace xe
+
+#endif  // XENIA_BASE_TIMELINE_H_
@@ -92,8 +92,13 @@ bool X64Assembler::Assemble(GuestFunction* function, HIRBuilder* builder,
   }
 
   function->set_debug_info(std::move(debug_info));
-  static_cast<X64Function*>(function)->Setup(
-      reinterpret_cast<uint8_t*>(machine_code), code_size);
+  auto x64_function = static_cast<X64Function*>(function);
+  x64_function->Setup(reinterpret_cast<uint8_t*>(machine_code), code_size);
+
+  // Code placed in a reservation is published by its owner.
+  if (x64_function->code_reservation()) {
+    return true;
+  }
 
   // Install into indirection table.
   uint64_t host_address = reinterpret_cast<uint64_t>(machine_code);
@@ -16,6 +16,8 @@
 
 #include "xenia/base/exception_handler.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/threading.h"
 #include "xenia/cpu/backend/x64/x64_assembler.h"
 #include "xenia/cpu/backend/x64/x64_code_cache.h"
 #include "xenia/cpu/backend/x64/x64_emitter.h"
@@ -23,6 +25,7 @@
 #include "xenia/cpu/backend/x64/x64_sequences.h"
 #include "xenia/cpu/backend/x64/x64_stack_layout.h"
 #include "xenia/cpu/breakpoint.h"
+#include "xenia/cpu/ppc/ppc_frontend.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/cpu/stack_walker.h"
 #include "xenia/cpu/xex_module.h"
@@ -41,6 +44,20 @@ DEFINE_bool(enable_host_guest_stack_synchronization, true,
             "and checks for reentry at return sites. Has slight performance "
             "impact, but fixes crashes in games that use setjmp/longjmp.",
             "x64");
+DEFINE_bool(x64_hot_code_relayout, false,
+            "Count entries into guest functions, and after "
+            "x64_hot_code_relayout_delay seconds, recompile the most "
+            "frequently executed ones into a contiguous region of the code "
+            "cache, to reduce instruction TLB and cache misses.",
+            "x64");
+DEFINE_int32(x64_hot_code_relayout_delay, 60,
+             "Seconds after the initialization of the CPU to relayout the hot "
+             "code after (for x64_hot_code_relayout).",
+             "x64");
+DEFINE_int32(x64_hot_code_relayout_size, 2048,
+             "Maximum total size in KB of the functions recompiled into the "
+             "hot code region (for x64_hot_code_relayout).",
+             "x64");
 #if XE_X64_PROFILER_AVAILABLE == 1
 DECLARE_bool(instrument_call_times);
 #endif
@@ -136,6 +153,12 @@ X64Backend::X64Backend() : Backend(), code_cache_(nullptr) {
 }
 
 X64Backend::~X64Backend() {
+  if (hot_code_relayout_thread_) {
+    hot_code_relayout_shutdown_event_->Set();
+    xe::threading::Wait(hot_code_relayout_thread_.get(), false);
+    hot_code_relayout_thread_.reset();
+  }
+
   if (capstone_handle_) {
     cs_close(&capstone_handle_);
   }
@@ -320,6 +343,26 @@ bool X64Backend::Initialize(Processor* processor) {
   }
 #endif
 
+  if (cvars::x64_hot_code_relayout) {
+    hot_code_relayout_shutdown_event_ =
+        xe::threading::Event::CreateManualResetEvent(false);
+    xe::threading::Thread::CreationParameters relayout_thread_params;
+    relayout_thread_params.create_suspended = false;
+    relayout_thread_params.initial_priority =
+        xe::threading::ThreadPriority::kBelowNormal;
+    hot_code_relayout_thread_ = xe::threading::Thread::Create(
+        relayout_thread_params, [this]() {
+          xe::threading::set_name("x64 Hot Code Relayout");
+          if (xe::threading::Wait(
+                  hot_code_relayout_shutdown_event_.get(), false,
+                  std::chrono::seconds(
+                      std::max(cvars::x64_hot_code_relayout_delay, 0))) ==
+              xe::threading::WaitResult::kTimeout) {
+            RelayoutHotCode();
+          }
+        });
+  }
+
   return true;
 }
 
@@ -332,6 +375,127 @@ std::unique_ptr<Assembler> X64Backend::CreateAssembler() {
   return std::make_unique<X64Assembler>(this);
 }
 
+uint32_t X64Backend::RelayoutHotCode() {
+  if (processor()->is_debugger_attached()) {
+    // Breakpoints are placed in the current machine code of functions.
+    XELOGW("Hot code relayout skipped as a debugger is attached");
+    return 0;
+  }
+
+  std::vector<X64Function*> hot_functions;
+  for (Module* module : processor()->GetModules()) {
+    module->ForEachFunction([&hot_functions](Function* function) {
+      if (!function->is_guest() ||
+          function->status() != Symbol::Status::kDefined) {
+        return;
+      }
+      auto x64_function = static_cast<X64Function*>(function);
+      if (x64_function->machine_code() && !x64_function->is_relaid_out() &&
+          x64_function->entry_count()) {
+        hot_functions.push_back(x64_function);
+      }
+    });
+  }
+  std::sort(hot_functions.begin(), hot_functions.end(),
+            [](const X64Function* a, const X64Function* b) {
+              return a->entry_count() > b->entry_count();
+            });
+  uint64_t total_entries = 0;
+  for (X64Function* function : hot_functions) {
+    total_entries += function->entry_count();
+  }
+
+  // Select the functions by the size of their current copies. The copies in
+  // the hot region won't have the entry counter and the patch point, so they
+  // will normally fit, and if one doesn't, it will be placed outside the
+  // region instead.
+  size_t size_limit =
+      size_t(std::max(cvars::x64_hot_code_relayout_size, 0)) * 1024;
+  size_t hot_region_size = 0;
+  std::vector<X64Function*> relaid_out_functions;
+  for (X64Function* function : hot_functions) {
+    size_t code_size = xe::round_up(function->machine_code_length(), 16);
+    if (hot_region_size + code_size <= size_limit) {
+      hot_region_size += code_size;
+      relaid_out_functions.push_back(function);
+    }
+  }
+  if (relaid_out_functions.empty()) {
+    return 0;
+  }
+
+  // Reserve the whole region, so code compiled by other threads meanwhile
+  // doesn't get between the hot functions. Start it at the beginning of a
+  // large page so it can be covered by a single TLB entry if the code cache is
+  // backed by large pages.
+  const size_t kHotRegionAlignment = 2 * 1024 * 1024;
+  CodeReservation hot_region;
+  if (!code_cache_->ReserveCode(kHotRegionAlignment, hot_region_size,
+                                relaid_out_functions.size(), hot_region)) {
+    XELOGE("Failed to reserve {} KB of the code cache for the hot code",
+           hot_region_size / 1024);
+    return 0;
+  }
+
+  // Compile all the hot copies as separate functions before publishing any,
+  // so the original copies, which threads may be executing, and their source
+  // maps stay untouched. The code map refers to the copies from when they're
+  // placed, so they're kept for the lifetime of the backend.
+  std::vector<X64Function*> hot_copies(relaid_out_functions.size());
+  for (size_t i = 0; i < relaid_out_functions.size(); ++i) {
+    X64Function* function = relaid_out_functions[i];
+    auto hot_copy =
+        std::make_unique<X64Function>(function->module(), function->address());
+    hot_copy->set_name(function->name());
+    hot_copy->set_code_reservation(&hot_region);
+    bool defined = processor()->frontend()->DefineFunction(
+        hot_copy.get(), processor()->debug_info_flags());
+    hot_copy->set_code_reservation(nullptr);
+    if (defined) {
+      hot_copies[i] = hot_copy.get();
+    } else {
+      XELOGE("Failed to recompile hot function {:08X}", function->address());
+    }
+    hot_code_functions_.push_back(std::move(hot_copy));
+  }
+
+  // Publish the hot copies now that all of them are placed. Calls through the
+  // indirection table go to the hot copy directly, and direct calls baked
+  // into other functions via the jump at the entry of the original copy.
+  uint32_t relaid_out_count = 0;
+  size_t relaid_out_size = 0;
+  uint64_t relaid_out_entries = 0;
+  for (size_t i = 0; i < relaid_out_functions.size(); ++i) {
+    X64Function* function = relaid_out_functions[i];
+    X64Function* hot_copy = hot_copies[i];
+    if (!hot_copy) {
+      continue;
+    }
+    code_cache_->AddIndirection(
+        function->address(),
+        uint32_t(reinterpret_cast<uintptr_t>(hot_copy->machine_code())));
+    if (!code_cache_->RedirectFunctionEntry(function->machine_code(),
+                                            hot_copy->machine_code())) {
+      XELOGW("Hot function {:08X} has no entry patch point",
+             function->address());
+    }
+    function->set_relaid_out(true);
+    relaid_out_size += hot_copy->machine_code_length();
+    relaid_out_entries += function->entry_count();
+    ++relaid_out_count;
+  }
+
+  XELOGI(
+      "Hot code relayout: moved {} of {} executed functions ({} KB, {} outside "
+      "the hot region), covering {:.1f}% of the function entries",
+      relaid_out_count, hot_functions.size(), relaid_out_size / 1024,
+      relaid_out_count - std::min(uint32_t(hot_region.placed_function_count),
+                                  relaid_out_count),
+      total_entries ? double(relaid_out_entries) * 100.0 / total_entries
+                    : 0.0);
+  return relaid_out_count;
+}
+
 std::unique_ptr<GuestFunction> X64Backend::CreateGuestFunction(
     Module* module, uint32_t address) {
   return std::make_unique<X64Function>(module, address);
@@ -11,9 +11,11 @@
 #define XENIA_CPU_BACKEND_X64_X64_BACKEND_H_
 
 #include <memory>
+#include <vector>
 
 #include "xenia/base/bit_map.h"
 #include "xenia/base/cvar.h"
+#include "xenia/base/threading.h"
 #include "xenia/cpu/backend/backend.h"
 
 #if XE_PLATFORM_WIN32 == 1
@@ -27,6 +29,7 @@
 DECLARE_int64(x64_extension_mask);
 DECLARE_int64(max_stackpoints);
 DECLARE_bool(enable_host_guest_stack_synchronization);
+DECLARE_bool(x64_hot_code_relayout);
 namespace xe {
 class Exception;
 }  // namespace xe
@@ -38,6 +41,7 @@ namespace x64 {
 using GuestProfilerData = std::map<uint32_t, uint64_t>;
 
 class X64CodeCache;
+class X64Function;
 
 typedef void* (*HostToGuestThunk)(void* target, void* arg0, void* arg1);
 typedef void* (*GuestToHostThunk)(void* target, void* arg0, void* arg1);
@@ -190,6 +194,14 @@ class X64Backend : public Backend {
 #if XE_X64_PROFILER_AVAILABLE == 1
   uint64_t* GetProfilerRecordForFunction(uint32_t guest_address);
 #endif
+
+  // Recompiles copies of the most frequently entered guest functions into a
+  // contiguous region reserved at the end of the code cache, and redirects the
+  // original copies, which are kept, there.
+  // Normally done by a background thread x64_hot_code_relayout_delay seconds
+  // after initialization. Returns the number of functions moved.
+  uint32_t RelayoutHotCode();
+
  private:
   static bool ExceptionCallbackThunk(Exception* ex, void* data);
   bool ExceptionCallback(Exception* ex);
@@ -228,6 +240,11 @@ class X64Backend : public Backend {
   // range that will be used to dispatch to host code
   BitMap guest_trampoline_address_bitmap_;
   uint8_t* guest_trampoline_memory_;
+
+  std::unique_ptr<xe::threading::Event> hot_code_relayout_shutdown_event_;
+  std::unique_ptr<xe::threading::Thread> hot_code_relayout_thread_;
+  // Copies of the functions in the hot region, referenced by the code cache.
+  std::vector<std::unique_ptr<X64Function>> hot_code_functions_;
 };
 
 }  // namespace x64
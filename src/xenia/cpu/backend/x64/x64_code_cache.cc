@@ -9,6 +9,7 @@
 
 #include "xenia/cpu/backend/x64/x64_code_cache.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
@@ -19,6 +20,7 @@
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/atomic.h"
 #include "xenia/base/clock.h"
 #include "xenia/base/literals.h"
 #include "xenia/base/logging.h"
@@ -120,6 +122,20 @@ bool X64CodeCache::Initialize() {
     }
   }
 
+  if (xe::memory::IsLargePageBackingPreferred()) {
+    // Committing keeps the advice, so only needed once for the reservation.
+    bool large_pages_advised = xe::memory::AdviseLargePages(
+        generated_code_execute_base_, kGeneratedCodeSize);
+    if (generated_code_write_base_ != generated_code_execute_base_ &&
+        !xe::memory::AdviseLargePages(generated_code_write_base_,
+                                      kGeneratedCodeSize)) {
+      large_pages_advised = false;
+    }
+    if (!large_pages_advised) {
+      XELOGW("Large pages are not supported for the generated code");
+    }
+  }
+
   // Preallocate the function map to a large, reasonable size.
   generated_code_map_.reserve(kMaximumFunctionCount);
 
@@ -160,6 +176,30 @@ void X64CodeCache::CommitExecutableRange(uint32_t guest_low,
   }
 }
 
+void X64CodeCache::CommitGeneratedCode(size_t high_mark) {
+  // It's ok if multiple threads do this, as redundant commits aren't harmful.
+  size_t old_commit_mark, new_commit_mark;
+  do {
+    old_commit_mark = generated_code_commit_mark_;
+    if (high_mark <= old_commit_mark) break;
+
+    new_commit_mark = old_commit_mark + 16_MiB;
+    if (generated_code_execute_base_ == generated_code_write_base_) {
+      xe::memory::AllocFixed(generated_code_execute_base_, new_commit_mark,
+                             xe::memory::AllocationType::kCommit,
+                             xe::memory::PageAccess::kExecuteReadWrite);
+    } else {
+      xe::memory::AllocFixed(generated_code_execute_base_, new_commit_mark,
+                             xe::memory::AllocationType::kCommit,
+                             xe::memory::PageAccess::kExecuteReadOnly);
+      xe::memory::AllocFixed(generated_code_write_base_, new_commit_mark,
+                             xe::memory::AllocationType::kCommit,
+                             xe::memory::PageAccess::kReadWrite);
+    }
+  } while (generated_code_commit_mark_.compare_exchange_weak(old_commit_mark,
+                                                             new_commit_mark));
+}
+
 void X64CodeCache::PlaceHostCode(uint32_t guest_address, void* machine_code,
                                  const EmitFunctionInfo& func_info,
                                  void*& code_execute_address_out,
@@ -174,7 +214,8 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
                                   const EmitFunctionInfo& func_info,
                                   GuestFunction* function_info,
                                   void*& code_execute_address_out,
-                                  void*& code_write_address_out) {
+                                  void*& code_write_address_out,
+                                  CodeReservation* code_reservation) {
   // Hold a lock while we bump the pointers up. This is important as the
   // unwind table requires entries AND code to be sorted in order.
   size_t low_mark;
@@ -182,69 +223,73 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
   uint8_t* code_execute_address;
   UnwindReservation unwind_reservation;
   {
-    auto global_lock = global_critical_region_.Acquire();
+    std::lock_guard<xe_mutex> placement_lock(placement_mutex_);
 
-    low_mark = generated_code_offset_;
+    // Always move the code to land on 16b alignment.
+    size_t code_size = xe::round_up(func_info.code_size.total, 16);
+
+    // Code in a reservation takes its next reserved table slots, so the tables
+    // stay sorted, if it fits - otherwise it's placed at the end as usual.
+    bool reserved = false;
+    if (code_reservation && code_reservation->placed_function_count <
+                                code_reservation->function_count) {
+      unwind_reservation = RequestUnwindReservation(
+          generated_code_write_base_ + code_reservation->code_offset +
+              code_size,
+          code_reservation);
+      reserved = code_reservation->code_offset + code_size +
+                     xe::round_up(unwind_reservation.data_size, 16) <=
+                 code_reservation->code_end;
+    }
+    size_t& offset =
+        reserved ? code_reservation->code_offset : generated_code_offset_;
+
+    low_mark = offset;
 
     // Reserve code.
-    // Always move the code to land on 16b alignment.
-    code_execute_address =
-        generated_code_execute_base_ + generated_code_offset_;
+    code_execute_address = generated_code_execute_base_ + offset;
     code_execute_address_out = code_execute_address;
-    uint8_t* code_write_address =
-        generated_code_write_base_ + generated_code_offset_;
+    uint8_t* code_write_address = generated_code_write_base_ + offset;
     code_write_address_out = code_write_address;
-    generated_code_offset_ += xe::round_up(func_info.code_size.total, 16);
+    offset += code_size;
 
-    auto tail_write_address =
-        generated_code_write_base_ + generated_code_offset_;
+    auto tail_write_address = generated_code_write_base_ + offset;
 
     // Reserve unwind info.
     // We go on the high size of the unwind info as we don't know how big we
     // need it, and a few extra bytes of padding isn't the worst thing.
-    unwind_reservation = RequestUnwindReservation(generated_code_write_base_ +
-                                                  generated_code_offset_);
-    generated_code_offset_ += xe::round_up(unwind_reservation.data_size, 16);
+    if (!reserved) {
+      unwind_reservation = RequestUnwindReservation(
+          generated_code_write_base_ + offset, nullptr);
+    }
+    offset += xe::round_up(unwind_reservation.data_size, 16);
 
-    auto end_write_address =
-        generated_code_write_base_ + generated_code_offset_;
+    auto end_write_address = generated_code_write_base_ + offset;
 
-    high_mark = generated_code_offset_;
+    high_mark = offset;
 
     // Store in map. It is maintained in sorted order of host PC dependent on
-    // us also being append-only.
-    generated_code_map_.emplace_back(
+    // us also being append-only, or replacing the placeholders of a
+    // reservation in order, which are located after all the code in it.
+    std::pair<uint64_t, GuestFunction*> code_map_entry(
         (uint64_t(code_execute_address - generated_code_execute_base_) << 32) |
-            generated_code_offset_,
+            offset,
         function_info);
+    if (reserved) {
+      generated_code_map_[code_reservation->code_map_index +
+                          code_reservation->placed_function_count++] =
+          code_map_entry;
+    } else {
+      generated_code_map_.push_back(code_map_entry);
+    }
 
     // TODO(DrChat): The following code doesn't really need to be under the
-    // global lock except for PlaceCode (but it depends on the previous code
+    // lock except for PlaceCode (but it depends on the previous code
     // already being ran)
 
     // If we are going above the high water mark of committed memory, commit
-    // some more. It's ok if multiple threads do this, as redundant commits
-    // aren't harmful.
-    size_t old_commit_mark, new_commit_mark;
-    do {
-      old_commit_mark = generated_code_commit_mark_;
-      if (high_mark <= old_commit_mark) break;
-
-      new_commit_mark = old_commit_mark + 16_MiB;
-      if (generated_code_execute_base_ == generated_code_write_base_) {
-        xe::memory::AllocFixed(generated_code_execute_base_, new_commit_mark,
-                               xe::memory::AllocationType::kCommit,
-                               xe::memory::PageAccess::kExecuteReadWrite);
-      } else {
-        xe::memory::AllocFixed(generated_code_execute_base_, new_commit_mark,
-                               xe::memory::AllocationType::kCommit,
-                               xe::memory::PageAccess::kExecuteReadOnly);
-        xe::memory::AllocFixed(generated_code_write_base_, new_commit_mark,
-                               xe::memory::AllocationType::kCommit,
-                               xe::memory::PageAccess::kReadWrite);
-      }
-    } while (generated_code_commit_mark_.compare_exchange_weak(
-        old_commit_mark, new_commit_mark));
+    // some more.
+    CommitGeneratedCode(high_mark);
 
     // Copy code.
     std::memcpy(code_write_address, machine_code, func_info.code_size.total);
@@ -282,7 +327,7 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
   // Now that everything is ready, fix up the indirection table.
   // Note that we do support code that doesn't have an indirection fixup, so
   // ignore those when we see them.
-  if (guest_address && indirection_table_base_) {
+  if (guest_address && indirection_table_base_ && !code_reservation) {
     uint32_t* indirection_slot = reinterpret_cast<uint32_t*>(
         indirection_table_base_ + (guest_address - kIndirectionTableBase));
     *indirection_slot =
@@ -295,7 +340,7 @@ uint32_t X64CodeCache::PlaceData(const void* data, size_t length) {
   size_t high_mark;
   uint8_t* data_address = nullptr;
   {
-    auto global_lock = global_critical_region_.Acquire();
+    std::lock_guard<xe_mutex> placement_lock(placement_mutex_);
 
     // Reserve code.
     // Always move the code to land on 16b alignment.
@@ -306,28 +351,8 @@ uint32_t X64CodeCache::PlaceData(const void* data, size_t length) {
   }
 
   // If we are going above the high water mark of committed memory, commit some
-  // more. It's ok if multiple threads do this, as redundant commits aren't
-  // harmful.
-  size_t old_commit_mark, new_commit_mark;
-  do {
-    old_commit_mark = generated_code_commit_mark_;
-    if (high_mark <= old_commit_mark) break;
-
-    new_commit_mark = old_commit_mark + 16_MiB;
-    if (generated_code_execute_base_ == generated_code_write_base_) {
-      xe::memory::AllocFixed(generated_code_execute_base_, new_commit_mark,
-                             xe::memory::AllocationType::kCommit,
-                             xe::memory::PageAccess::kExecuteReadWrite);
-    } else {
-      xe::memory::AllocFixed(generated_code_execute_base_, new_commit_mark,
-                             xe::memory::AllocationType::kCommit,
-                             xe::memory::PageAccess::kExecuteReadOnly);
-      xe::memory::AllocFixed(generated_code_write_base_, new_commit_mark,
-                             xe::memory::AllocationType::kCommit,
-                             xe::memory::PageAccess::kReadWrite);
-    }
-  } while (generated_code_commit_mark_.compare_exchange_weak(old_commit_mark,
-                                                             new_commit_mark));
+  // more.
+  CommitGeneratedCode(high_mark);
 
   // Copy code.
   std::memcpy(data_address, data, length);
@@ -335,6 +360,73 @@ uint32_t X64CodeCache::PlaceData(const void* data, size_t length) {
   return uint32_t(uintptr_t(data_address));
 }
 
+bool X64CodeCache::ReserveCode(size_t alignment, size_t code_size,
+                               size_t function_count,
+                               CodeReservation& code_reservation_out) {
+  std::lock_guard<xe_mutex> placement_lock(placement_mutex_);
+
+  size_t code_offset = xe::round_up(generated_code_offset_, alignment);
+  size_t placeholder_offset = code_offset + xe::round_up(code_size, 16);
+  size_t end_offset =
+      placeholder_offset + function_count * kCodeReservationPlaceholderSize;
+  if (end_offset > kGeneratedCodeSize) {
+    return false;
+  }
+
+  CommitGeneratedCode(end_offset);
+  std::memset(generated_code_write_base_ + generated_code_offset_, 0xCC,
+              end_offset - generated_code_offset_);
+
+  code_reservation_out.code_offset = code_offset;
+  code_reservation_out.code_end = placeholder_offset;
+  code_reservation_out.function_count = function_count;
+  code_reservation_out.placed_function_count = 0;
+
+  // Placeholders keeping the tables sorted until the functions are placed,
+  // after the code of all of them.
+  code_reservation_out.code_map_index = generated_code_map_.size();
+  for (size_t i = 0; i < function_count; ++i) {
+    uint64_t placeholder =
+        placeholder_offset + i * kCodeReservationPlaceholderSize;
+    generated_code_map_.emplace_back((placeholder << 32) | placeholder,
+                                     nullptr);
+  }
+  code_reservation_out.unwind_table_slot = ReserveUnwindTableSlots(
+      function_count, generated_code_execute_base_ + placeholder_offset,
+      kCodeReservationPlaceholderSize);
+
+  generated_code_offset_ = end_offset;
+  return true;
+}
+
+bool X64CodeCache::RedirectFunctionEntry(void* old_code_execute_address,
+                                         const void* new_code_execute_address) {
+  // nop dword [rax + rax * 1 + 0], which X64Emitter places at the entry when
+  // counting function entries.
+  static const uint8_t kEntryNop[] = {0x0F, 0x1F, 0x44, 0x00, 0x00};
+  size_t old_offset = static_cast<uint8_t*>(old_code_execute_address) -
+                      generated_code_execute_base_;
+  int64_t jump_displacement =
+      int64_t(uintptr_t(new_code_execute_address)) -
+      int64_t(uintptr_t(old_code_execute_address) + sizeof(kEntryNop));
+  assert_zero(old_offset & 7);
+  assert_true(jump_displacement >= INT32_MIN && jump_displacement <= INT32_MAX);
+  auto patch_write_address = reinterpret_cast<volatile uint64_t*>(
+      generated_code_write_base_ + old_offset);
+  uint64_t old_bytes = *patch_write_address;
+  if (std::memcmp(&old_bytes, kEntryNop, sizeof(kEntryNop))) {
+    return false;
+  }
+  // Replace the whole nop with jmp rel32, keeping the following bytes, with a
+  // single aligned store, so no thread can see a partially written jump.
+  uint64_t new_bytes = old_bytes;
+  uint8_t jump[5] = {0xE9};
+  uint32_t jump_displacement32 = uint32_t(jump_displacement);
+  std::memcpy(&jump[1], &jump_displacement32, sizeof(jump_displacement32));
+  std::memcpy(&new_bytes, jump, sizeof(jump));
+  return xe::atomic_cas(old_bytes, new_bytes, patch_write_address);
+}
+
 GuestFunction* X64CodeCache::LookupFunction(uint64_t host_pc) {
   uint32_t key = uint32_t(host_pc - kGeneratedCodeExecuteBase);
   void* fn_entry = std::bsearch(
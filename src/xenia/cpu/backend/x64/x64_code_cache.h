@@ -39,6 +39,22 @@ struct EmitFunctionInfo {
   size_t stack_size;
 };
 
+// A range of the generated code reserved for placing a number of functions next
+// to each other, without code placed by other threads getting in between. Code
+// placed in a reservation is not added to the indirection table, the owner
+// publishes it once it can be executed.
+struct CodeReservation {
+  // Offset of the free space, and the end of the space for the code.
+  size_t code_offset = 0;
+  size_t code_end = 0;
+  // Slots in the code map and the unwind table reserved for the functions, in
+  // the order they're placed.
+  size_t code_map_index = 0;
+  size_t unwind_table_slot = 0;
+  size_t function_count = 0;
+  size_t placed_function_count = 0;
+};
+
 class X64CodeCache : public CodeCache {
  public:
   ~X64CodeCache() override;
@@ -67,13 +83,27 @@ class X64CodeCache : public CodeCache {
                      const EmitFunctionInfo& func_info,
                      void*& code_execute_address_out,
                      void*& code_write_address_out);
+  // If code_reservation is not null, the code is placed in it if it fits, or
+  // at the end otherwise, but it's not published in the indirection table in
+  // either case.
   void PlaceGuestCode(uint32_t guest_address, void* machine_code,
                       const EmitFunctionInfo& func_info,
                       GuestFunction* function_info,
                       void*& code_execute_address_out,
-                      void*& code_write_address_out);
+                      void*& code_write_address_out,
+                      CodeReservation* code_reservation = nullptr);
   uint32_t PlaceData(const void* data, size_t length);
 
+  // Reserves code_size bytes, starting at an aligned offset, for placing up to
+  // function_count functions contiguously, such as the hot code region.
+  bool ReserveCode(size_t alignment, size_t code_size, size_t function_count,
+                   CodeReservation& code_reservation_out);
+  // Atomically replaces the 5-byte nop at the entry of a previously placed
+  // function with a jump to another copy of it, so existing direct calls and
+  // return paths keep working. Returns false if there's no patch point.
+  bool RedirectFunctionEntry(void* old_code_execute_address,
+                             const void* new_code_execute_address);
+
   GuestFunction* LookupFunction(uint64_t host_pc) override;
 
  protected:
@@ -105,9 +135,28 @@ class X64CodeCache : public CodeCache {
 
   X64CodeCache();
 
-  virtual UnwindReservation RequestUnwindReservation(uint8_t* entry_address) {
+  // Commits the generated code memory up to at least high_mark.
+  void CommitGeneratedCode(size_t high_mark);
+
+  // Space in the end of a code reservation for each function, not containing
+  // any code, so the reserved table slots can be filled with sorted placeholder
+  // entries until the functions are placed.
+  static const size_t kCodeReservationPlaceholderSize = 16;
+
+  // If code_reservation is not null, must use its next reserved table slot.
+  virtual UnwindReservation RequestUnwindReservation(
+      uint8_t* entry_address, const CodeReservation* code_reservation) {
     return UnwindReservation();
   }
+  // Reserves count consecutive unwind table slots for a code reservation,
+  // with placeholders (placeholder_stride bytes apart, starting at
+  // placeholder_execute_address) until the functions are placed. Returns the
+  // index of the first slot.
+  virtual size_t ReserveUnwindTableSlots(size_t count,
+                                         uint8_t* placeholder_execute_address,
+                                         size_t placeholder_stride) {
+    return 0;
+  }
   virtual void PlaceCode(uint32_t guest_address, void* machine_code,
                          const EmitFunctionInfo& func_info,
                          void* code_execute_address,
@@ -117,9 +166,10 @@ class X64CodeCache : public CodeCache {
   xe::memory::FileMappingHandle mapping_ =
       xe::memory::kFileMappingHandleInvalid;
 
-  // NOTE: the global critical region must be held when manipulating the offsets
-  // or counts of anything, to keep the tables consistent and ordered.
-  xe::global_critical_region global_critical_region_;
+  // NOTE: must be held when manipulating the offsets or counts of anything, to
+  // keep the tables consistent and ordered. Not the global critical region, so
+  // placing code doesn't stall guest threads.
+  xe_mutex placement_mutex_;
 
   // Value that the indirection table will be initialized with upon commit.
   uint32_t indirection_default_value_ = 0xFEEDF00D;
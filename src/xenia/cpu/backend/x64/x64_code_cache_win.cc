@@ -105,7 +105,11 @@ class Win32X64CodeCache : public X64CodeCache {
   void* LookupUnwindInfo(uint64_t host_pc) override;
 
  private:
-  UnwindReservation RequestUnwindReservation(uint8_t* entry_address) override;
+  UnwindReservation RequestUnwindReservation(
+      uint8_t* entry_address, const CodeReservation* code_reservation) override;
+  size_t ReserveUnwindTableSlots(size_t count,
+                                 uint8_t* placeholder_execute_address,
+                                 size_t placeholder_stride) override;
   void PlaceCode(uint32_t guest_address, void* machine_code,
                  const EmitFunctionInfo& func_info, void* code_execute_address,
                  UnwindReservation unwind_reservation) override;
@@ -208,7 +212,16 @@ bool Win32X64CodeCache::Initialize() {
 }
 
 Win32X64CodeCache::UnwindReservation
-Win32X64CodeCache::RequestUnwindReservation(uint8_t* entry_address) {
+Win32X64CodeCache::RequestUnwindReservation(
+    uint8_t* entry_address, const CodeReservation* code_reservation) {
+  if (code_reservation) {
+    UnwindReservation unwind_reservation;
+    unwind_reservation.data_size = xe::round_up(kUnwindInfoSize, 16);
+    unwind_reservation.table_slot = code_reservation->unwind_table_slot +
+                                    code_reservation->placed_function_count;
+    unwind_reservation.entry_address = entry_address;
+    return unwind_reservation;
+  }
 #if defined(NDEBUG)
   if (unwind_table_count_ >= kMaximumFunctionCount) {
     // we should not just be ignoring this in release if it happens
@@ -227,6 +240,35 @@ Win32X64CodeCache::RequestUnwindReservation(uint8_t* entry_address) {
   return unwind_reservation;
 }
 
+size_t Win32X64CodeCache::ReserveUnwindTableSlots(
+    size_t count, uint8_t* placeholder_execute_address,
+    size_t placeholder_stride) {
+  assert_false(unwind_table_count_ + count > kMaximumFunctionCount);
+  assert_true(placeholder_stride >= sizeof(UNWIND_INFO));
+  size_t first_slot = unwind_table_count_;
+  for (size_t i = 0; i < count; ++i) {
+    // One byte entries with empty unwind info in the placeholder itself - it
+    // contains no code, so they're never actually looked up.
+    uint8_t* placeholder_address =
+        placeholder_execute_address + i * placeholder_stride;
+    auto unwind_info = reinterpret_cast<UNWIND_INFO*>(
+        generated_code_write_base_ +
+        (placeholder_address - generated_code_execute_base_));
+    std::memset(unwind_info, 0, sizeof(UNWIND_INFO));
+    unwind_info->Version = 1;
+    auto& fn_entry = unwind_table_[first_slot + i];
+    fn_entry.BeginAddress =
+        DWORD(placeholder_address - generated_code_execute_base_);
+    fn_entry.EndAddress = fn_entry.BeginAddress + 1;
+    fn_entry.UnwindData = fn_entry.BeginAddress;
+  }
+  unwind_table_count_ += uint32_t(count);
+  if (supports_growable_table_) {
+    grow_table_(unwind_table_handle_, unwind_table_count_);
+  }
+  return first_slot;
+}
+
 void Win32X64CodeCache::PlaceCode(uint32_t guest_address, void* machine_code,
                                   const EmitFunctionInfo& func_info,
                                   void* code_execute_address,
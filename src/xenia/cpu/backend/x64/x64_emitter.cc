@@ -58,6 +58,8 @@ DEFINE_uint32(align_all_basic_blocks, 0,
               "power of 2, 16 is the recommended value. Results in larger "
               "icache usage, but potentially faster loops",
               "x64");
+DECLARE_bool(x64_hot_code_relayout);
+
 #if XE_X64_PROFILER_AVAILABLE == 1
 DEFINE_bool(instrument_call_times, false,
             "Compute time taken for functions, for profiling guest code",
@@ -120,10 +122,17 @@ bool X64Emitter::Emit(GuestFunction* function, HIRBuilder* builder,
   debug_info_flags_ = debug_info_flags;
   trace_data_ = &function->trace_data();
   source_map_arena_.Reset();
+  auto x64_function = static_cast<X64Function*>(function);
+  current_entry_count_ =
+      cvars::x64_hot_code_relayout && !x64_function->code_reservation()
+          ? x64_function->entry_count_address()
+          : nullptr;
 
   // Fill the generator with code.
   EmitFunctionInfo func_info = {};
-  if (!Emit(builder, func_info)) {
+  bool emitted = Emit(builder, func_info);
+  current_entry_count_ = nullptr;
+  if (!emitted) {
     return false;
   }
 
@@ -151,8 +160,10 @@ void* X64Emitter::Emplace(const EmitFunctionInfo& func_info,
   void* new_write_address;
   assert_true(func_info.code_size.total == size_);
   if (function) {
-    code_cache_->PlaceGuestCode(function->address(), top_, func_info, function,
-                                new_execute_address, new_write_address);
+    code_cache_->PlaceGuestCode(
+        function->address(), top_, func_info, function, new_execute_address,
+        new_write_address,
+        static_cast<X64Function*>(function)->code_reservation());
   } else {
     code_cache_->PlaceHostCode(0, top_, func_info, new_execute_address,
                                new_write_address);
@@ -201,6 +212,13 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
 
   code_offsets.prolog = getSize();
 
+  if (current_entry_count_) {
+    // Patch point for redirecting the calls to this copy of the function to
+    // the copy in the hot region after relayout - a single instruction, so it
+    // can be replaced with a jmp atomically (the function is 16b aligned).
+    nop(5);
+  }
+
   // Function prolog.
   // Must be 16b aligned.
   // Windows is very strict about the form of this and the epilog:
@@ -286,6 +304,12 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
     bts(qword[low_address(&trace_header->function_thread_use)], rax);
   }
 
+  if (current_entry_count_) {
+    // Not locked, lost increments don't matter for finding hot functions.
+    mov(rdx, reinterpret_cast<uintptr_t>(current_entry_count_));
+    inc(dword[rdx]);
+  }
+
   // Load membase.
   /*
   * chrispy: removed this, as long as we load it in HostToGuestThunk we can
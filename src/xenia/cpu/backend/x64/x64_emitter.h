@@ -405,6 +405,9 @@ class X64Emitter : public Xbyak::CodeGenerator {
   Xbyak::util::Cpu cpu_;
   uint64_t feature_flags_ = 0;
   uint32_t current_guest_function_ = 0;
+  // Entry counter of the function for hot code relayout, or nullptr if the
+  // function is not being counted.
+  uint32_t* current_entry_count_ = nullptr;
   Xbyak::Label* epilog_label_ = nullptr;
 
   hir::Instr* current_instr_ = nullptr;
@@ -18,6 +18,8 @@ namespace cpu {
 namespace backend {
 namespace x64 {
 
+struct CodeReservation;
+
 class X64Function : public GuestFunction {
  public:
   X64Function(Module* module, uint32_t address);
@@ -28,12 +30,31 @@ class X64Function : public GuestFunction {
 
   void Setup(uint8_t* machine_code, size_t machine_code_length);
 
+  // Incremented by the generated code on every entry when hot code relayout is
+  // enabled (x64_hot_code_relayout). Not atomic, so only approximate.
+  uint32_t* entry_count_address() { return &entry_count_; }
+  uint32_t entry_count() const { return entry_count_; }
+  // Whether a copy of this function has been placed in the hot region, and
+  // entering this copy jumps to it.
+  bool is_relaid_out() const { return is_relaid_out_; }
+  void set_relaid_out(bool relaid_out) { is_relaid_out_ = relaid_out; }
+  // If not null, the machine code is placed in the reservation rather than at
+  // the end of the code cache, and it's not published in the indirection
+  // table - used for the copies in the hot region, which are not counted.
+  CodeReservation* code_reservation() const { return code_reservation_; }
+  void set_code_reservation(CodeReservation* code_reservation) {
+    code_reservation_ = code_reservation;
+  }
+
  protected:
   bool CallImpl(ThreadState* thread_state, uint32_t return_address) override;
 
  private:
   uint8_t* machine_code_ = nullptr;
   size_t machine_code_length_ = 0;
+  uint32_t entry_count_ = 0;
+  bool is_relaid_out_ = false;
+  CodeReservation* code_reservation_ = nullptr;
 };
 
 }  // namespace x64
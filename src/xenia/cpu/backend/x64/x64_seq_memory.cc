@@ -301,32 +301,17 @@ RegExp ComputeMemoryAddressOffset(X64Emitter& e, const T& guest,
 // ============================================================================
 // OPCODE_ATOMIC_EXCHANGE
 // ============================================================================
-// Note that the address we use here is a real, host address!
-// This is weird, and should be fixed.
 template <typename SEQ, typename REG, typename ARGS>
 void EmitAtomicExchangeXX(X64Emitter& e, const ARGS& i) {
-  if (i.dest == i.src1) {
-    e.mov(e.rax, i.src1);
-    if (i.dest != i.src2) {
-      if (i.src2.is_constant) {
-        e.mov(i.dest, i.src2.constant());
-      } else {
-        e.mov(i.dest, i.src2);
-      }
-    }
-    e.lock();
-    e.xchg(e.dword[e.rax], i.dest);
-  } else {
-    if (i.dest != i.src2) {
-      if (i.src2.is_constant) {
-        e.mov(i.dest, i.src2.constant());
-      } else {
-        e.mov(i.dest, i.src2);
-      }
-    }
-    e.lock();
-    e.xchg(e.dword[i.src1.reg()], i.dest);
-  }
+  // The destination is in a register the address computation doesn't touch.
+  e.lea(e.rcx, e.ptr[ComputeMemoryAddress(e, i.src1)]);
+  if (i.src2.is_constant) {
+    e.mov(i.dest, i.src2.constant());
+  } else if (i.dest != i.src2) {
+    e.mov(i.dest, i.src2);
+  }
+  // xchg with a memory operand is always locked.
+  e.xchg(e.ptr[e.rcx], i.dest);
 }
 struct ATOMIC_EXCHANGE_I8
     : Sequence<ATOMIC_EXCHANGE_I8,
@@ -563,64 +548,38 @@ EMITTER_OPCODE_TABLE(OPCODE_RESERVED_STORE, RESERVED_STORE_INT32,
 // ============================================================================
 // OPCODE_ATOMIC_COMPARE_EXCHANGE
 // ============================================================================
+template <typename SEQ, typename REG, typename ARGS>
+void EmitAtomicCompareExchangeXX(X64Emitter& e, const ARGS& i) {
+  // Address first, as ComputeMemoryAddress may use rax.
+  e.lea(e.rcx, e.ptr[ComputeMemoryAddress(e, i.src1)]);
+  REG comparand = REG(e.rax.getIdx());
+  if (i.src2.is_constant) {
+    e.mov(comparand, i.src2.constant());
+  } else {
+    e.mov(comparand, i.src2);
+  }
+  REG new_value = REG(e.rdx.getIdx());
+  if (i.src3.is_constant) {
+    e.mov(new_value, i.src3.constant());
+  } else {
+    new_value = i.src3;
+  }
+  e.lock();
+  e.cmpxchg(e.ptr[e.rcx], new_value);
+  e.sete(i.dest);
+}
 struct ATOMIC_COMPARE_EXCHANGE_I32
     : Sequence<ATOMIC_COMPARE_EXCHANGE_I32,
                I<OPCODE_ATOMIC_COMPARE_EXCHANGE, I8Op, I64Op, I32Op, I32Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    e.mov(e.eax, i.src2);
-    if (xe::memory::allocation_granularity() > 0x1000) {
-      // Emulate the 4 KB physical address offset in 0xE0000000+ when can't do
-      // it via memory mapping.
-      e.mov(e.ecx, i.src1.reg().cvt32());
-      e.cmp(i.src1.reg().cvt32(), e.GetContextReg().cvt32());
-      Xbyak::Label& backtous = e.NewCachedLabel();
-
-      Xbyak::Label& fixup_label =
-          e.AddToTail([&backtous](X64Emitter& e, Xbyak::Label& our_tail_label) {
-            e.L(our_tail_label);
-
-            Do0x1000Add(e, e.ecx);
-
-            e.jmp(backtous, e.T_NEAR);
-          });
-      e.jae(fixup_label, e.T_NEAR);
-      e.L(backtous);
-    } else {
-      e.mov(e.ecx, i.src1.reg().cvt32());
-    }
-    e.lock();
-    e.cmpxchg(e.dword[e.GetMembaseReg() + e.rcx], i.src3);
-    e.sete(i.dest);
+    EmitAtomicCompareExchangeXX<ATOMIC_COMPARE_EXCHANGE_I32, Reg32>(e, i);
   }
 };
 struct ATOMIC_COMPARE_EXCHANGE_I64
     : Sequence<ATOMIC_COMPARE_EXCHANGE_I64,
                I<OPCODE_ATOMIC_COMPARE_EXCHANGE, I8Op, I64Op, I64Op, I64Op>> {
   static void Emit(X64Emitter& e, const EmitArgType& i) {
-    e.mov(e.rax, i.src2);
-    if (xe::memory::allocation_granularity() > 0x1000) {
-      // Emulate the 4 KB physical address offset in 0xE0000000+ when can't do
-      // it via memory mapping.
-      e.mov(e.ecx, i.src1.reg().cvt32());
-      e.cmp(i.src1.reg().cvt32(), e.GetContextReg().cvt32());
-      Xbyak::Label& backtous = e.NewCachedLabel();
-
-      Xbyak::Label& fixup_label =
-          e.AddToTail([&backtous](X64Emitter& e, Xbyak::Label& our_tail_label) {
-            e.L(our_tail_label);
-
-            Do0x1000Add(e, e.ecx);
-
-            e.jmp(backtous, e.T_NEAR);
-          });
-      e.jae(fixup_label, e.T_NEAR);
-      e.L(backtous);
-    } else {
-      e.mov(e.ecx, i.src1.reg().cvt32());
-    }
-    e.lock();
-    e.cmpxchg(e.qword[e.GetMembaseReg() + e.rcx], i.src3);
-    e.sete(i.dest);
+    EmitAtomicCompareExchangeXX<ATOMIC_COMPARE_EXCHANGE_I64, Reg64>(e, i);
   }
 };
 EMITTER_OPCODE_TABLE(OPCODE_ATOMIC_COMPARE_EXCHANGE,
@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compile_statistics.h"
+
+#include <cstring>
+
+#include "xenia/base/clock.h"
+
+namespace xe {
+namespace cpu {
+
+namespace {
+
+double TicksToMilliseconds(uint64_t ticks) {
+  return double(ticks) * 1000.0 / double(Clock::QueryHostTickFrequency());
+}
+
+}  // namespace
+
+CompilePassStatistics& CompileStatistics::GetPass(const char* name) {
+  // The pipeline has only a dozen passes, and the same pass type may be added
+  // multiple times, in which case its statistics are summed.
+  for (CompilePassStatistics& pass : passes) {
+    if (pass.name == name || !std::strcmp(pass.name, name)) {
+      return pass;
+    }
+  }
+  CompilePassStatistics& pass = passes.emplace_back();
+  pass.name = name;
+  return pass;
+}
+
+void CompileStatistics::Merge(const CompileStatistics& other) {
+  function_count += other.function_count;
+  failed_function_count += other.failed_function_count;
+  guest_instruction_count += other.guest_instruction_count;
+  hir_instruction_count += other.hir_instruction_count;
+  machine_code_bytes += other.machine_code_bytes;
+  scan_host_ticks += other.scan_host_ticks;
+  emit_host_ticks += other.emit_host_ticks;
+  compile_host_ticks += other.compile_host_ticks;
+  assemble_host_ticks += other.assemble_host_ticks;
+  for (const CompilePassStatistics& other_pass : other.passes) {
+    CompilePassStatistics& pass = GetPass(other_pass.name);
+    pass.run_count += other_pass.run_count;
+    pass.host_ticks += other_pass.host_ticks;
+    pass.instructions_in += other_pass.instructions_in;
+    pass.instructions_out += other_pass.instructions_out;
+    pass.blocks_out += other_pass.blocks_out;
+    pass.values_out += other_pass.values_out;
+  }
+}
+
+void CompileStatistics::AppendJson(StringBuffer* buffer) const {
+  buffer->AppendFormat(
+      "{{\"functions\": {}, \"failed_functions\": {}, "
+      "\"guest_instructions\": {}, \"hir_instructions\": {}, "
+      "\"machine_code_bytes\": {}, \"scan_ms\": {:.3f}, \"emit_ms\": {:.3f}, "
+      "\"compile_ms\": {:.3f}, \"assemble_ms\": {:.3f}, \"passes\": [",
+      function_count, failed_function_count, guest_instruction_count,
+      hir_instruction_count, machine_code_bytes,
+      TicksToMilliseconds(scan_host_ticks),
+      TicksToMilliseconds(emit_host_ticks),
+      TicksToMilliseconds(compile_host_ticks),
+      TicksToMilliseconds(assemble_host_ticks));
+  for (size_t i = 0; i < passes.size(); ++i) {
+    const CompilePassStatistics& pass = passes[i];
+    buffer->AppendFormat(
+        "{}\n    {{\"name\": \"{}\", \"runs\": {}, \"ms\": {:.3f}, "
+        "\"instructions_in\": {}, \"instructions_out\": {}, "
+        "\"blocks_out\": {}, \"values_out\": {}}}",
+        i ? "," : "", pass.name, pass.run_count,
+        TicksToMilliseconds(pass.host_ticks), pass.instructions_in,
+        pass.instructions_out, pass.blocks_out, pass.values_out);
+  }
+  buffer->Append("]}");
+}
+
+}  // namespace cpu
+}  // namespace xe
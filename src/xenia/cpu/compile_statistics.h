@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILE_STATISTICS_H_
+#define XENIA_CPU_COMPILE_STATISTICS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "xenia/base/string_buffer.h"
+
+namespace xe {
+namespace cpu {
+
+// Timing and IR size of one compiler pass, summed over all the times it ran.
+struct CompilePassStatistics {
+  // Must be a string with static storage duration, usually CompilerPass::name.
+  const char* name = nullptr;
+  uint64_t run_count = 0;
+  uint64_t host_ticks = 0;
+  uint64_t instructions_in = 0;
+  uint64_t instructions_out = 0;
+  uint64_t blocks_out = 0;
+  uint64_t values_out = 0;
+};
+
+// Statistics of translating guest functions, either a single function or the
+// sum for a whole module.
+struct CompileStatistics {
+  uint64_t function_count = 0;
+  uint64_t failed_function_count = 0;
+  uint64_t guest_instruction_count = 0;
+  // HIR emitted by the frontend, before any passes.
+  uint64_t hir_instruction_count = 0;
+  uint64_t machine_code_bytes = 0;
+  uint64_t scan_host_ticks = 0;
+  uint64_t emit_host_ticks = 0;
+  uint64_t compile_host_ticks = 0;
+  uint64_t assemble_host_ticks = 0;
+  // In the order the passes were first run.
+  std::vector<CompilePassStatistics> passes;
+
+  CompilePassStatistics& GetPass(const char* name);
+
+  void Merge(const CompileStatistics& other);
+
+  // Appends a JSON object with the statistics, with times in milliseconds.
+  void AppendJson(StringBuffer* buffer) const;
+};
+
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILE_STATISTICS_H_
@@ -9,6 +9,7 @@
 
 #include "xenia/cpu/compiler/compiler.h"
 
+#include "xenia/base/clock.h"
 #include "xenia/base/profiling.h"
 #include "xenia/cpu/compiler/compiler_pass.h"
 
@@ -16,6 +17,49 @@ namespace xe {
 namespace cpu {
 namespace compiler {
 
+namespace {
+
+// Adds the number of blocks, instructions and the values they define.
+void CountHIR(hir::HIRBuilder* builder, uint64_t* block_count,
+              uint64_t* instruction_count, uint64_t* value_count) {
+  for (auto block = builder->first_block(); block; block = block->next) {
+    ++*block_count;
+    for (auto instr = block->instr_head; instr; instr = instr->next) {
+      ++*instruction_count;
+      if (instr->dest) {
+        ++*value_count;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+Compiler::PassMeasurement::PassMeasurement(Compiler* compiler,
+                                           const CompilerPass* pass,
+                                           hir::HIRBuilder* builder)
+    : builder_(builder) {
+  if (!compiler->statistics_) {
+    return;
+  }
+  pass_statistics_ = &compiler->statistics_->GetPass(pass->name());
+  uint64_t block_count = 0, value_count = 0;
+  CountHIR(builder, &block_count, &pass_statistics_->instructions_in,
+           &value_count);
+  // Counting is excluded from the time of the pass itself.
+  start_ticks_ = Clock::QueryHostTickCount();
+}
+
+Compiler::PassMeasurement::~PassMeasurement() {
+  if (!pass_statistics_) {
+    return;
+  }
+  pass_statistics_->host_ticks += Clock::QueryHostTickCount() - start_ticks_;
+  ++pass_statistics_->run_count;
+  CountHIR(builder_, &pass_statistics_->blocks_out,
+           &pass_statistics_->instructions_out, &pass_statistics_->values_out);
+}
+
 Compiler::Compiler(Processor* processor) : processor_(processor) {}
 
 Compiler::~Compiler() { Reset(); }
@@ -27,18 +71,34 @@ void Compiler::AddPass(std::unique_ptr<CompilerPass> pass) {
 
 void Compiler::Reset() {}
 
-bool Compiler::Compile(xe::cpu::hir::HIRBuilder* builder) {
+bool Compiler::Compile(xe::cpu::hir::HIRBuilder* builder,
+                       CompileStatistics* statistics) {
+  statistics_ = statistics;
+  uint64_t start_ticks = 0;
+  if (statistics) {
+    uint64_t block_count = 0, value_count = 0;
+    CountHIR(builder, &block_count, &statistics->hir_instruction_count,
+             &value_count);
+    start_ticks = Clock::QueryHostTickCount();
+  }
+  bool result = true;
   // TODO(benvanik): sophisticated stuff. Run passes in parallel, run until they
   //                 stop changing things, etc.
   for (size_t i = 0; i < passes_.size(); ++i) {
     auto& pass = passes_[i];
     scratch_arena_.Reset();
+    PassMeasurement measurement(this, pass.get(), builder);
     if (!pass->Run(builder)) {
-      return false;
+      result = false;
+      break;
     }
   }
+  if (statistics) {
+    statistics->compile_host_ticks += Clock::QueryHostTickCount() - start_ticks;
+  }
+  statistics_ = nullptr;
 
-  return true;
+  return result;
 }
 
 }  // namespace compiler
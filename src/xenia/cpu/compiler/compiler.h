@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "xenia/base/arena.h"
+#include "xenia/cpu/compile_statistics.h"
 #include "xenia/cpu/hir/hir_builder.h"
 
 namespace xe {
@@ -40,11 +41,29 @@ class Compiler {
 
   void Reset();
 
-  bool Compile(hir::HIRBuilder* builder);
+  // If statistics is not null, the timing and the IR size of every pass are
+  // added to it.
+  bool Compile(hir::HIRBuilder* builder,
+               CompileStatistics* statistics = nullptr);
+
+  // Adds a run of a pass to the statistics of the current Compile, if they're
+  // being gathered. Also used by passes running other passes.
+  class PassMeasurement {
+   public:
+    PassMeasurement(Compiler* compiler, const CompilerPass* pass,
+                    hir::HIRBuilder* builder);
+    ~PassMeasurement();
+
+   private:
+    CompilePassStatistics* pass_statistics_ = nullptr;
+    hir::HIRBuilder* builder_;
+    uint64_t start_ticks_ = 0;
+  };
 
  private:
   Processor* processor_;
   Arena scratch_arena_;
+  CompileStatistics* statistics_ = nullptr;
 
   std::vector<std::unique_ptr<CompilerPass>> passes_;
 };
@@ -53,6 +53,7 @@ bool ConditionalGroupPass::Run(HIRBuilder* builder) {
     for (size_t i = 0; i < passes_.size(); ++i) {
       scratch_arena()->Reset();
       auto& pass = passes_[i];
+      Compiler::PassMeasurement measurement(compiler_, pass.get(), builder);
       auto subpass = dynamic_cast<ConditionalGroupSubpass*>(pass.get());
       if (!subpass) {
         if (!pass->Run(builder)) {
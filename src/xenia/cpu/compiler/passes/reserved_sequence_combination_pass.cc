@@ -0,0 +1,286 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/compiler/passes/reserved_sequence_combination_pass.h"
+
+#include <algorithm>
+
+#include "xenia/base/profiling.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// TODO(benvanik): remove when enums redefined.
+using namespace xe::cpu::hir;
+
+using xe::cpu::hir::Block;
+using xe::cpu::hir::HIRBuilder;
+using xe::cpu::hir::Instr;
+using xe::cpu::hir::Value;
+
+namespace {
+
+// Address computations are short (ra + rb at most), the new value of an
+// exchange may be loaded, truncated and swapped.
+constexpr uint32_t kMaxAddressDepth = 4;
+constexpr uint32_t kMaxHoistDepth = 8;
+
+// Next instruction on the path from a reserved load to its store, which may
+// continue into the following blocks if they can only be entered by falling
+// through.
+Instr* NextOnPath(Instr* i) {
+  if (i->next) {
+    return i->next;
+  }
+  Block* block = i->block->next;
+  while (block && !block->label_head) {
+    if (block->instr_head) {
+      return block->instr_head;
+    }
+    block = block->next;
+  }
+  return nullptr;
+}
+
+// Whether the context range may be written between the two instructions (also
+// if |to| is not reachable from |from| at all).
+bool IsContextStoredBetween(Instr* from, Instr* to, size_t offset,
+                            size_t size) {
+  for (Instr* i = NextOnPath(from); i; i = NextOnPath(i)) {
+    if (i == to) {
+      return false;
+    }
+    if (i->opcode == &OPCODE_STORE_CONTEXT_info) {
+      size_t store_offset = i->src1.offset;
+      size_t store_size = GetTypeSize(i->src2.value->type);
+      if (store_offset < offset + size && offset < store_offset + store_size) {
+        return true;
+      }
+    }
+  }
+  return true;
+}
+
+Value* SkipAssigns(Value* value) {
+  while (value->def && value->def->opcode == &OPCODE_ASSIGN_info) {
+    value = value->def->src1.value;
+  }
+  return value;
+}
+
+// Integer operations with only value operands and no side effects.
+bool IsPureOpcode(const OpcodeInfo* opcode) {
+  return opcode == &OPCODE_ASSIGN_info || opcode == &OPCODE_ADD_info ||
+         opcode == &OPCODE_SUB_info || opcode == &OPCODE_AND_info ||
+         opcode == &OPCODE_OR_info || opcode == &OPCODE_XOR_info ||
+         opcode == &OPCODE_NOT_info || opcode == &OPCODE_ZERO_EXTEND_info ||
+         opcode == &OPCODE_SIGN_EXTEND_info ||
+         opcode == &OPCODE_TRUNCATE_info || opcode == &OPCODE_BYTE_SWAP_info;
+}
+
+bool IsBefore(Instr* i, Instr* other) {
+  for (; i; i = i->next) {
+    if (i == other) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+ReservedSequenceCombinationPass::ReservedSequenceCombinationPass()
+    : CompilerPass() {}
+
+ReservedSequenceCombinationPass::~ReservedSequenceCombinationPass() = default;
+
+bool ReservedSequenceCombinationPass::Run(HIRBuilder* builder) {
+  // Look for each reserved load the matching store, see
+  // CombineReservedSequence for what they become.
+  auto block = builder->first_block();
+  while (block) {
+    auto i = block->instr_head;
+    while (i) {
+      if (i->opcode == &OPCODE_RESERVED_LOAD_info) {
+        CombineReservedSequence(builder, i);
+      }
+      i = i->next;
+    }
+    block = block->next;
+  }
+  return true;
+}
+
+void ReservedSequenceCombinationPass::CombineReservedSequence(
+    HIRBuilder* builder, Instr* load) {
+  // Exchange, when the stored value doesn't depend on the loaded one:
+  //   v1.i32 = reserved_load v0
+  //   ...
+  //   v3.i8 = reserved_store v0, v2.i32
+  // becomes (with the computation of v2 moved above):
+  //   v1.i32 = atomic_exchange v0, v2.i32
+  //   v3.i8 = assign 1
+  //
+  // Any other read-modify-write (add, and, or, compare-exchange and so on,
+  // also with an early exit between the load and the store):
+  //   v1.i32 = reserved_load v0
+  //   v2.i32 = f(v1.i32)
+  //   v3.i8 = reserved_store v0, v2.i32
+  // becomes:
+  //   v1.i32 = load v0
+  //   v2.i32 = f(v1.i32)
+  //   v3.i8 = atomic_compare_exchange v0, v1.i32, v2.i32
+  //
+  // Guest memory is big-endian, so arithmetic can't be done with a single
+  // lock xadd, but the guest retry loop around the compare-exchange is cheaper
+  // than taking and releasing a reservation in the bitmap on every attempt.
+  Instr* store = FindReservedStore(load);
+  if (!store) {
+    return;
+  }
+  Value* address = load->src1.value;
+  Value* store_address = store->src1.value;
+  Value* new_value = store->src2.value;
+  if (new_value->type != load->dest->type ||
+      !IsSameAddress(address, store_address, kMaxAddressDepth)) {
+    return;
+  }
+
+  hoisted_.clear();
+  if (store->block == load->block &&
+      CollectHoistable(new_value, load, kMaxHoistDepth)) {
+    // Move the computation in the original order to keep dependencies valid.
+    for (Instr* i = load->next; i != store;) {
+      Instr* next = i->next;
+      if (std::find(hoisted_.begin(), hoisted_.end(), i) != hoisted_.end()) {
+        i->MoveBefore(load);
+      }
+      i = next;
+    }
+    load->Replace(&OPCODE_ATOMIC_EXCHANGE_info, 0);
+    load->set_src1(address);
+    load->set_src2(new_value);
+    store->Replace(&OPCODE_ASSIGN_info, 0);
+    store->set_src1(builder->LoadConstantInt8(1));
+    return;
+  }
+
+  load->Replace(&OPCODE_LOAD_info, 0);
+  load->set_src1(address);
+  Value* expected = load->dest;
+  if (store->block != load->block) {
+    // Values don't live across blocks.
+    Value* slot = builder->AllocLocal(expected->type);
+    builder->StoreLocal(slot, expected);
+    builder->last_instr()->MoveBefore(load->next);
+    expected = builder->LoadLocal(slot);
+    builder->last_instr()->MoveBefore(store);
+  }
+  store->Replace(&OPCODE_ATOMIC_COMPARE_EXCHANGE_info, 0);
+  store->set_src1(store_address);
+  store->set_src2(expected);
+  store->set_src3(new_value);
+}
+
+Instr* ReservedSequenceCombinationPass::FindReservedStore(Instr* load) {
+  for (Instr* i = NextOnPath(load); i; i = NextOnPath(i)) {
+    if (i->opcode == &OPCODE_RESERVED_STORE_info) {
+      return i;
+    }
+    if ((i->opcode == &OPCODE_BRANCH_TRUE_info ||
+         i->opcode == &OPCODE_BRANCH_FALSE_info) &&
+        i == load->block->instr_tail) {
+      // Leaving without storing, such as on a compare-exchange mismatch, just
+      // doesn't write anything.
+      continue;
+    }
+    if (i->opcode->flags &
+        (OPCODE_FLAG_MEMORY | OPCODE_FLAG_VOLATILE | OPCODE_FLAG_BRANCH)) {
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+bool ReservedSequenceCombinationPass::IsSameAddress(Value* a, Value* b,
+                                                    uint32_t depth) {
+  // |a| is computed for the load, so it comes first.
+  a = SkipAssigns(a);
+  b = SkipAssigns(b);
+  if (a == b) {
+    return true;
+  }
+  if (a->type != b->type) {
+    return false;
+  }
+  if (a->IsConstant() || b->IsConstant()) {
+    return a->IsConstant() && b->IsConstant() && a->IsConstantEQ(b);
+  }
+  Instr* a_def = a->def;
+  Instr* b_def = b->def;
+  if (!depth || !a_def || !b_def || a_def->opcode != b_def->opcode ||
+      a_def->flags != b_def->flags) {
+    return false;
+  }
+  if (a_def->opcode == &OPCODE_LOAD_CONTEXT_info) {
+    // Reloaded after the memory barrier of the load.
+    return a_def->src1.offset == b_def->src1.offset &&
+           !IsContextStoredBetween(a_def, b_def, a_def->src1.offset,
+                                   GetTypeSize(a->type));
+  }
+  if (!IsPureOpcode(a_def->opcode) ||
+      !IsSameAddress(a_def->src1.value, b_def->src1.value, depth - 1)) {
+    return false;
+  }
+  if (!a_def->src2.value || !b_def->src2.value) {
+    return a_def->src2.value == b_def->src2.value;
+  }
+  return IsSameAddress(a_def->src2.value, b_def->src2.value, depth - 1);
+}
+
+bool ReservedSequenceCombinationPass::CollectHoistable(Value* value,
+                                                       Instr* load,
+                                                       uint32_t depth) {
+  if (value->IsConstant()) {
+    return true;
+  }
+  Instr* def = value->def;
+  if (!def || def == load || def->block != load->block) {
+    return false;
+  }
+  if (IsBefore(def, load)) {
+    return true;
+  }
+  if (!depth) {
+    return false;
+  }
+  if (def->opcode == &OPCODE_LOAD_CONTEXT_info) {
+    if (IsContextStoredBetween(load, def, def->src1.offset,
+                               GetTypeSize(value->type))) {
+      return false;
+    }
+  } else if (IsPureOpcode(def->opcode)) {
+    if (!CollectHoistable(def->src1.value, load, depth - 1) ||
+        (def->src2.value &&
+         !CollectHoistable(def->src2.value, load, depth - 1))) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  hoisted_.push_back(def);
+  return true;
+}
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
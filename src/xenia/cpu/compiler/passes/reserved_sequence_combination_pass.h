@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_COMPILER_PASSES_RESERVED_SEQUENCE_COMBINATION_PASS_H_
+#define XENIA_CPU_COMPILER_PASSES_RESERVED_SEQUENCE_COMBINATION_PASS_H_
+
+#include <vector>
+
+#include "xenia/cpu/compiler/compiler_pass.h"
+
+namespace xe {
+namespace cpu {
+namespace compiler {
+namespace passes {
+
+// Replaces lwarx/stwcx. (RESERVED_LOAD/RESERVED_STORE) pairs on the same
+// address, with nothing touching memory in between, with host atomics that
+// don't need the reservation bitmap and its helper calls.
+class ReservedSequenceCombinationPass : public CompilerPass {
+ public:
+  ReservedSequenceCombinationPass();
+  ~ReservedSequenceCombinationPass() override;
+
+  const char* name() const override {
+    return "ReservedSequenceCombinationPass";
+  }
+
+  bool Run(hir::HIRBuilder* builder) override;
+
+ private:
+  void CombineReservedSequence(hir::HIRBuilder* builder, hir::Instr* load);
+  hir::Instr* FindReservedStore(hir::Instr* load);
+  bool IsSameAddress(hir::Value* a, hir::Value* b, uint32_t depth);
+  bool CollectHoistable(hir::Value* value, hir::Instr* load, uint32_t depth);
+
+  std::vector<hir::Instr*> hoisted_;
+};
+
+}  // namespace passes
+}  // namespace compiler
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_COMPILER_PASSES_RESERVED_SEQUENCE_COMBINATION_PASS_H_
@@ -0,0 +1,171 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/crt_routines.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xenia/base/mutex.h"
+#include "xenia/cpu/ppc/ppc_context.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/memory.h"
+
+namespace xe {
+namespace cpu {
+
+namespace {
+
+// Whether [address, address + length) is within a single heap, so the host
+// can access it directly. Otherwise, the range may be in an MMIO region, or
+// span heaps with different host mappings, so the guest code must do the
+// accesses.
+bool IsGuestRangeDirectlyAccessible(ppc::PPCContext* ppc_context,
+                                    uint32_t address, uint32_t length) {
+  const BaseHeap* heap = ppc_context->processor->memory()->LookupHeap(address);
+  return heap &&
+         uint64_t(address - heap->heap_base()) + length <= heap->heap_size();
+}
+
+// Lets the watches of physical memory (such as GPU resources) know the range
+// is about to be overwritten, as host writes to it don't go through the
+// access violation handler or the deferred tracking of guest writes. Returns
+// false if the range can't be written by the host (see
+// IsGuestRangeDirectlyAccessible).
+bool PrepareGuestWrite(ppc::PPCContext* ppc_context, uint32_t address,
+                       uint32_t length) {
+  if (!IsGuestRangeDirectlyAccessible(ppc_context, address, length)) {
+    return false;
+  }
+  Memory* memory = ppc_context->processor->memory();
+  if (memory->LookupHeap(address)->heap_type() == HeapType::kGuestPhysical) {
+    memory->TriggerPhysicalMemoryCallbacks(
+        xe::global_critical_region::AcquireDirect(), address, length, true,
+        false);
+  }
+  return true;
+}
+
+// void* memcpy(void* dest, const void* src, size_t count)
+// Overlapping ranges are copied forward like by the guest routine, so
+// titles relying on that (such as to fill memory with a repeating pattern)
+// get the same result.
+void CrtMemcpy(ppc::PPCContext* ppc_context, kernel::KernelState*) {
+  uint32_t dest = static_cast<uint32_t>(ppc_context->r[3]);
+  uint32_t src = static_cast<uint32_t>(ppc_context->r[4]);
+  uint32_t count = static_cast<uint32_t>(ppc_context->r[5]);
+  if (count) {
+    if (!IsGuestRangeDirectlyAccessible(ppc_context, src, count) ||
+        !PrepareGuestWrite(ppc_context, dest, count)) {
+      ppc_context->scratch = 0;
+      return;
+    }
+    auto dest_ptr = ppc_context->TranslateVirtual(dest);
+    auto src_ptr = ppc_context->TranslateVirtual(src);
+    uint32_t distance = dest - src;
+    if (dest > src && distance < count) {
+      // Every source chunk of |distance| bytes has already been written by the
+      // previous chunk when it's read, like with a byte-by-byte copy.
+      for (uint32_t offset = 0; offset < count; offset += distance) {
+        std::memcpy(dest_ptr + offset, src_ptr + offset,
+                    std::min(distance, count - offset));
+      }
+    } else {
+      std::memmove(dest_ptr, src_ptr, count);
+    }
+  }
+  // r3 is already the destination.
+  ppc_context->scratch = 1;
+}
+
+// void* memmove(void* dest, const void* src, size_t count)
+void CrtMemmove(ppc::PPCContext* ppc_context, kernel::KernelState*) {
+  uint32_t dest = static_cast<uint32_t>(ppc_context->r[3]);
+  uint32_t src = static_cast<uint32_t>(ppc_context->r[4]);
+  uint32_t count = static_cast<uint32_t>(ppc_context->r[5]);
+  if (count) {
+    if (!IsGuestRangeDirectlyAccessible(ppc_context, src, count) ||
+        !PrepareGuestWrite(ppc_context, dest, count)) {
+      ppc_context->scratch = 0;
+      return;
+    }
+    std::memmove(ppc_context->TranslateVirtual(dest),
+                 ppc_context->TranslateVirtual(src), count);
+  }
+  // r3 is already the destination.
+  ppc_context->scratch = 1;
+}
+
+// void* memset(void* dest, int c, size_t count)
+void CrtMemset(ppc::PPCContext* ppc_context, kernel::KernelState*) {
+  uint32_t dest = static_cast<uint32_t>(ppc_context->r[3]);
+  uint8_t value = static_cast<uint8_t>(ppc_context->r[4]);
+  uint32_t count = static_cast<uint32_t>(ppc_context->r[5]);
+  if (count) {
+    if (!PrepareGuestWrite(ppc_context, dest, count)) {
+      ppc_context->scratch = 0;
+      return;
+    }
+    std::memset(ppc_context->TranslateVirtual(dest), value, count);
+  }
+  ppc_context->scratch = 1;
+}
+
+// size_t strlen(const char* str)
+void CrtStrlen(ppc::PPCContext* ppc_context, kernel::KernelState*) {
+  uint32_t str = static_cast<uint32_t>(ppc_context->r[3]);
+  const BaseHeap* heap = ppc_context->processor->memory()->LookupHeap(str);
+  if (!heap) {
+    ppc_context->scratch = 0;
+    return;
+  }
+  // Don't read past the end of the heap.
+  size_t max_length = size_t(heap->heap_base()) + heap->heap_size() - str;
+  size_t length =
+      strnlen(ppc_context->TranslateVirtual<const char*>(str), max_length);
+  if (length >= max_length) {
+    ppc_context->scratch = 0;
+    return;
+  }
+  ppc_context->r[3] = length;
+  ppc_context->scratch = 1;
+}
+
+struct CrtRoutine {
+  const char* name;
+  GuestFunction::ExternHandler handler;
+};
+
+// XMemCpy and XMemSet variants only differ in the alignment they require and
+// in the cache hints, which don't matter on the host.
+const CrtRoutine kCrtRoutines[] = {
+    {"memcpy", CrtMemcpy},
+    {"memmove", CrtMemmove},
+    {"XMemCpy", CrtMemcpy},
+    {"XMemCpy128", CrtMemcpy},
+    {"XMemCpyStreaming", CrtMemcpy},
+    {"memset", CrtMemset},
+    {"XMemSet", CrtMemset},
+    {"XMemSet128", CrtMemset},
+    {"strlen", CrtStrlen},
+};
+
+}  // namespace
+
+GuestFunction::ExternHandler GetCrtRoutineHandler(std::string_view name) {
+  for (const CrtRoutine& routine : kCrtRoutines) {
+    if (name == routine.name) {
+      return routine.handler;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,34 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_CRT_ROUTINES_H_
+#define XENIA_CPU_CRT_ROUTINES_H_
+
+#include <string_view>
+
+#include "xenia/cpu/function.h"
+
+namespace xe {
+namespace cpu {
+
+// Host implementations of C runtime routines statically linked into titles
+// (memcpy, memset, strlen, XMemCpy and the like), bound in place of the guest
+// code with GuestFunction::SetupExtern. They take the arguments and return the
+// result in the guest registers like the guest routines, and trigger the
+// physical memory write watches for the written ranges. They set
+// PPCContext::scratch to 1 if they've done the work, or to 0 if the guest code
+// must be executed instead (for ranges in MMIO regions or spanning multiple
+// heaps, for instance).
+// Returns nullptr if there's no host implementation for the symbol name.
+GuestFunction::ExternHandler GetCrtRoutineHandler(std::string_view name);
+
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_CRT_ROUTINES_H_
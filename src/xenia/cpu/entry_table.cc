@@ -9,6 +9,7 @@
 
 #include "xenia/cpu/entry_table.h"
 
+#include "xenia/base/assert.h"
 #include "xenia/base/profiling.h"
 #include "xenia/base/threading.h"
 
@@ -18,7 +19,7 @@ namespace cpu {
 EntryTable::EntryTable() = default;
 
 EntryTable::~EntryTable() {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(lock_);
   for (auto it : map_.Values()) {
     Entry* entry = it;
     delete entry;
@@ -26,15 +27,15 @@ EntryTable::~EntryTable() {
 }
 
 Entry* EntryTable::Get(uint32_t address) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(lock_);
   uint32_t idx = map_.IndexForKey(address);
   if (idx == map_.size() || *map_.KeyAt(idx) != address) {
     return nullptr;
   }
   Entry* entry = *map_.ValueAt(idx);
   if (entry) {
-    // TODO(benvanik): wait if needed?
-    if (entry->status != Entry::STATUS_READY) {
+    // Not waiting for compilation, this is just a query.
+    if (entry->status.load(std::memory_order_acquire) != Entry::STATUS_READY) {
       entry = nullptr;
     }
   }
@@ -45,46 +46,49 @@ Entry::Status EntryTable::GetOrCreate(uint32_t address, Entry** out_entry) {
   // TODO(benvanik): replace with a map with wait-free for find.
   // https://github.com/facebook/folly/blob/master/folly/AtomicHashMap.h
 
-  auto global_lock = global_critical_region_.Acquire();
+  std::unique_lock<xe_mutex> lock(lock_);
 
   uint32_t idx = map_.IndexForKey(address);
 
   Entry* entry = idx != map_.size() && *map_.KeyAt(idx) == address
                      ? *map_.ValueAt(idx)
                      : nullptr;
-  Entry::Status status;
-  if (entry) {
-    // If we aren't ready yet spin and wait.
-    if (entry->status == Entry::STATUS_COMPILING) {
-      // chrispy: i think this is dead code, if we are compiling we're holding
-      // the global lock, arent we? so we wouldnt be executing here
-      // Still compiling, so spin.
-      do {
-        global_lock.unlock();
-        // TODO(benvanik): sleep for less time?
-        xe::threading::Sleep(std::chrono::microseconds(10));
-        global_lock.lock();
-      } while (entry->status == Entry::STATUS_COMPILING);
-    }
-    status = entry->status;
-  } else {
+  if (!entry) {
     // Create and return for initialization.
     entry = new Entry();
     entry->address = address;
     entry->end_address = 0;
-    entry->status = Entry::STATUS_COMPILING;
+    entry->status.store(Entry::STATUS_COMPILING, std::memory_order_relaxed);
     entry->function = 0;
     map_.InsertAt(address, entry, idx);
-    // map_[address] = entry;
-    status = Entry::STATUS_NEW;
+    lock.unlock();
+    *out_entry = entry;
+    return Entry::STATUS_NEW;
+  }
+  lock.unlock();
+
+  // Entries are never freed while the table is alive, so waiting for another
+  // thread to finish compiling can be done without the lock.
+  uint32_t status;
+  while ((status = entry->status.load(std::memory_order_acquire)) ==
+         Entry::STATUS_COMPILING) {
+    xe::threading::WaitOnAddress(&entry->status, Entry::STATUS_COMPILING);
   }
-  global_lock.unlock();
   *out_entry = entry;
-  return status;
+  return Entry::Status(status);
+}
+
+void EntryTable::FinishCompiling(Entry* entry, Entry::Status status) {
+  assert_true(status == Entry::STATUS_READY || status == Entry::STATUS_FAILED);
+  assert_true(entry->status.load(std::memory_order_relaxed) ==
+              Entry::STATUS_COMPILING);
+  // Release the function and the end address to the waiting threads.
+  entry->status.store(status, std::memory_order_release);
+  xe::threading::WakeAllOnAddress(&entry->status);
 }
 
 void EntryTable::Delete(uint32_t address) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(lock_);
   // doesnt this leak memory by not deleting the entry?
   uint32_t idx = map_.IndexForKey(address);
   if (idx != map_.size() && *map_.KeyAt(idx) == address) {
@@ -93,14 +97,15 @@ void EntryTable::Delete(uint32_t address) {
 }
 
 std::vector<Function*> EntryTable::FindWithAddress(uint32_t address) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(lock_);
   std::vector<Function*> fns;
   for (auto& it : map_.Values()) {
     Entry* entry = it;
-    if (address >= entry->address && address <= entry->end_address) {
-      if (entry->status == Entry::STATUS_READY) {
-        fns.push_back(entry->function);
-      }
+    // The end address is only valid once the entry is ready.
+    if (address >= entry->address &&
+        entry->status.load(std::memory_order_acquire) == Entry::STATUS_READY &&
+        address <= entry->end_address) {
+      fns.push_back(entry->function);
     }
   }
   return fns;
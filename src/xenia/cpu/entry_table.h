@@ -10,6 +10,7 @@
 #ifndef XENIA_CPU_ENTRY_TABLE_H_
 #define XENIA_CPU_ENTRY_TABLE_H_
 
+#include <atomic>
 #include <unordered_map>
 #include <vector>
 
@@ -21,7 +22,7 @@ namespace cpu {
 class Function;
 
 typedef struct Entry_t {
-  typedef enum {
+  typedef enum : uint32_t {
     STATUS_NEW = 0,
     STATUS_COMPILING,
     STATUS_READY,
@@ -30,7 +31,9 @@ typedef struct Entry_t {
 
   uint32_t address;
   uint32_t end_address;
-  Status status;
+  // Threads resolving an entry that is being compiled block on this value.
+  // Only changed from STATUS_COMPILING by EntryTable::FinishCompiling.
+  std::atomic<uint32_t> status;
   Function* function;
 } Entry;
 
@@ -40,13 +43,21 @@ class EntryTable {
   ~EntryTable();
 
   Entry* Get(uint32_t address);
+  // Returns STATUS_NEW if the entry has been created, in which case the caller
+  // must compile the function and call FinishCompiling. If another thread is
+  // compiling the function, waits for it to finish.
   Entry::Status GetOrCreate(uint32_t address, Entry** out_entry);
+  // Publishes the function and end address of an entry returned as STATUS_NEW
+  // with the final status, waking up the threads waiting for it.
+  void FinishCompiling(Entry* entry, Entry::Status status);
   void Delete(uint32_t address);
 
   std::vector<Function*> FindWithAddress(uint32_t address);
 
  private:
-  xe::global_critical_region global_critical_region_;
+  // Only guards the map itself - compilation happens without holding any lock,
+  // and not under the global critical region as guest threads need it.
+  xe_mutex lock_;
   // TODO(benvanik): replace with a better data structure.
   xe::split_map<uint32_t, Entry*> map_;
   // std::unordered_map<uint32_t, Entry*> map_;
@@ -0,0 +1,192 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xenia/base/clock.h"
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/platform.h"
+#include "xenia/cpu/compile_statistics.h"
+#include "xenia/cpu/ppc/ppc_frontend.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/cpu/raw_module.h"
+#include "xenia/memory.h"
+
+#if XE_ARCH_AMD64
+#include "xenia/cpu/backend/x64/x64_backend.h"
+#endif  // XE_ARCH
+
+DEFINE_path(jit_bench_corpus_path, "src/xenia/cpu/ppc/testing/bin/",
+            "Directory with the .bin guest code files and the .map symbol "
+            "files listing the functions in them, such as the built PPC test "
+            "corpus.",
+            "CPU");
+DEFINE_int32(jit_bench_iterations, 8,
+             "Number of times to translate every function in the corpus.",
+             "CPU");
+
+namespace xe {
+namespace cpu {
+
+namespace {
+
+// Spread the modules over the 64 KB page range of the guest address space.
+constexpr uint32_t kModuleBaseAddress = 0x82000000;
+constexpr uint32_t kModuleAlignment = 0x10000;
+
+double TicksToSeconds(uint64_t ticks) {
+  return double(ticks) / double(Clock::QueryHostTickFrequency());
+}
+
+// Appends the addresses of the functions in an `nm` symbol map, with lines
+// like "0000000000000000 t test_add1".
+bool ReadFunctionMap(const std::filesystem::path& map_path,
+                     uint32_t base_address, std::vector<uint32_t>& addresses) {
+  FILE* file = filesystem::OpenFile(map_path, "r");
+  if (!file) {
+    return false;
+  }
+  char line_buffer[BUFSIZ];
+  while (fgets(line_buffer, sizeof(line_buffer), file)) {
+    char* type = std::strstr(line_buffer, " t ");
+    if (!type) {
+      type = std::strstr(line_buffer, " T ");
+    }
+    if (!type || type == line_buffer) {
+      continue;
+    }
+    addresses.push_back(base_address +
+                        uint32_t(std::strtoul(line_buffer, nullptr, 16)));
+  }
+  fclose(file);
+  return true;
+}
+
+std::unique_ptr<backend::Backend> CreateBackend() {
+#if XE_ARCH_AMD64
+  return std::make_unique<backend::x64::X64Backend>();
+#else
+  return nullptr;
+#endif  // XE_ARCH
+}
+
+}  // namespace
+
+int jit_bench_main(const std::vector<std::string>& args) {
+  auto memory = std::make_unique<Memory>();
+  if (!memory->Initialize()) {
+    XELOGE("Failed to initialize the guest memory");
+    return 1;
+  }
+  auto processor = std::make_unique<Processor>(memory.get(), nullptr);
+  if (!processor->Setup(CreateBackend())) {
+    XELOGE("Failed to set up the processor - no JIT backend for the host?");
+    return 1;
+  }
+  processor->EnableCompileStatistics();
+
+  // Load every .bin with a .map next to it as a separate module.
+  std::vector<uint32_t> function_addresses;
+  uint32_t base_address = kModuleBaseAddress;
+  for (const auto& file_info :
+       filesystem::ListFiles(cvars::jit_bench_corpus_path)) {
+    if (file_info.name.extension() != ".bin") {
+      continue;
+    }
+    std::filesystem::path bin_path =
+        cvars::jit_bench_corpus_path / file_info.name;
+    std::filesystem::path map_path = bin_path;
+    map_path.replace_extension(".map");
+    if (!std::filesystem::exists(map_path)) {
+      continue;
+    }
+    auto module = std::make_unique<RawModule>(processor.get());
+    if (!module->LoadFile(base_address, bin_path) ||
+        !ReadFunctionMap(map_path, base_address, function_addresses)) {
+      XELOGE("Failed to load {}", xe::path_to_utf8(bin_path));
+      return 1;
+    }
+    processor->AddModule(std::move(module));
+    base_address += xe::align(uint32_t(file_info.total_size), kModuleAlignment);
+  }
+  if (function_addresses.empty()) {
+    XELOGE("No functions found in {}",
+           xe::path_to_utf8(cvars::jit_bench_corpus_path));
+    return 1;
+  }
+
+  // The first iteration declares and translates the functions like the guest
+  // calling them would, the rest retranslate the same functions.
+  std::vector<GuestFunction*> functions;
+  functions.reserve(function_addresses.size());
+  uint32_t iterations = uint32_t(std::max(cvars::jit_bench_iterations, 1));
+  uint64_t start_ticks = Clock::QueryHostTickCount();
+  for (uint32_t address : function_addresses) {
+    Function* function = processor->ResolveFunction(address);
+    if (function && function->is_guest()) {
+      functions.push_back(static_cast<GuestFunction*>(function));
+    }
+  }
+  for (uint32_t i = 1; i < iterations; ++i) {
+    for (GuestFunction* function : functions) {
+      processor->frontend()->DefineFunction(function,
+                                            processor->debug_info_flags());
+    }
+  }
+  double seconds = TicksToSeconds(Clock::QueryHostTickCount() - start_ticks);
+
+  CompileStatistics total;
+  for (const auto& module_statistics : processor->GetCompileStatistics()) {
+    total.Merge(module_statistics.second);
+  }
+  XELOGI("{} functions ({} failed) in {:.3f} s: {:.0f} functions/s, {:.0f} "
+         "guest instructions/s",
+         total.function_count, total.failed_function_count, seconds,
+         total.function_count / seconds,
+         total.guest_instruction_count / seconds);
+  XELOGI("HIR emitted: {} instructions, machine code: {} bytes",
+         total.hir_instruction_count, total.machine_code_bytes);
+  XELOGI(
+      "Scan {:.3f} ms, emit {:.3f} ms, compile {:.3f} ms, assemble {:.3f} ms",
+      TicksToSeconds(total.scan_host_ticks) * 1000.0,
+      TicksToSeconds(total.emit_host_ticks) * 1000.0,
+      TicksToSeconds(total.compile_host_ticks) * 1000.0,
+      TicksToSeconds(total.assemble_host_ticks) * 1000.0);
+  std::sort(total.passes.begin(), total.passes.end(),
+            [](const CompilePassStatistics& a, const CompilePassStatistics& b) {
+              return a.host_ticks > b.host_ticks;
+            });
+  for (const CompilePassStatistics& pass : total.passes) {
+    XELOGI("  {}: {:.3f} ms in {} runs, {} -> {} instructions", pass.name,
+           TicksToSeconds(pass.host_ticks) * 1000.0, pass.run_count,
+           pass.instructions_in, pass.instructions_out);
+  }
+
+  // The JSON is written to compile_statistics_path, if set, on destruction.
+  processor.reset();
+  memory.reset();
+  return total.failed_function_count ? 1 : 0;
+}
+
+}  // namespace cpu
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-cpu-jit-bench", xe::cpu::jit_bench_main,
+                      "[corpus directory]", "jit_bench_corpus_path");
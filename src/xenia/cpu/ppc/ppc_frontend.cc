@@ -57,23 +57,29 @@ Memory* PPCFrontend::memory() const { return processor_->memory(); }
 // Checks the state of the global lock and sets scratch to the current MSR
 // value.
 void CheckGlobalLock(PPCContext* ppc_context, void* arg0, void* arg1) {
-  auto global_mutex = reinterpret_cast<xe_global_mutex*>(arg0);
+  auto global_mutex = reinterpret_cast<global_mutex_type*>(arg0);
   auto global_lock_count = reinterpret_cast<int32_t*>(arg1);
-  std::lock_guard<xe_global_mutex> lock(*global_mutex);
+#if XE_ENABLE_GLOBAL_LOCK_PROFILING == 1
+  global_mutex_type::SetNextSite(XE_GLOBAL_LOCK_SITE_CURRENT());
+#endif  // XE_ENABLE_GLOBAL_LOCK_PROFILING
+  std::lock_guard<global_mutex_type> lock(*global_mutex);
   ppc_context->scratch = *global_lock_count ? 0 : 0x8000;
 }
 
 // Enters the global lock. Safe to recursion.
 void EnterGlobalLock(PPCContext* ppc_context, void* arg0, void* arg1) {
-  auto global_mutex = reinterpret_cast<xe_global_mutex*>(arg0);
+  auto global_mutex = reinterpret_cast<global_mutex_type*>(arg0);
   auto global_lock_count = reinterpret_cast<int32_t*>(arg1);
+#if XE_ENABLE_GLOBAL_LOCK_PROFILING == 1
+  global_mutex_type::SetNextSite(XE_GLOBAL_LOCK_SITE_CURRENT());
+#endif  // XE_ENABLE_GLOBAL_LOCK_PROFILING
   global_mutex->lock();
   xe::atomic_inc(global_lock_count);
 }
 
 // Leaves the global lock. Safe to recursion.
 void LeaveGlobalLock(PPCContext* ppc_context, void* arg0, void* arg1) {
-  auto global_mutex = reinterpret_cast<xe_global_mutex*>(arg0);
+  auto global_mutex = reinterpret_cast<global_mutex_type*>(arg0);
   auto global_lock_count = reinterpret_cast<int32_t*>(arg1);
   auto new_lock_count = xe::atomic_dec(global_lock_count);
   assert_true(new_lock_count >= 0);
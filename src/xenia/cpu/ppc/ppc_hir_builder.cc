@@ -117,6 +117,17 @@ bool PPCHIRBuilder::Emit(GuestFunction* function, uint32_t flags) {
   // Always mark entry with label.
   label_list_[0] = NewLabel();
 
+  if (function_->behavior() == Function::Behavior::kExtern &&
+      function_->extern_handler() && !function_->export_data()) {
+    // A guest routine replaced with a host implementation (see
+    // XexModule::BindCrtRoutines) - call it, and if it can't handle the
+    // arguments, execute the guest code (its entry label is marked below, so
+    // branches to the entry don't call the host implementation again).
+    SourceOffset(start_address_);
+    CallExtern(function_);
+    ReturnTrue(LoadContext(offsetof(PPCContext, scratch), INT64_TYPE));
+  }
+
   uint32_t start_address = function_->address();
   uint32_t end_address = function_->end_address();
   for (uint32_t address = start_address, offset = 0; address <= end_address;
@@ -11,6 +11,7 @@
 
 #include "xenia/base/assert.h"
 #include "xenia/base/byte_order.h"
+#include "xenia/base/clock.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/memory.h"
 #include "xenia/base/profiling.h"
@@ -27,6 +28,11 @@
 
 DEFINE_bool(dump_translated_hir_functions, false, "dumps translated hir",
             "CPU");
+DEFINE_bool(combine_reserved_sequences, true,
+            "Replace lwarx/stwcx. sequences on the same address with host "
+            "atomic exchange and compare-exchange instead of taking a "
+            "reservation.",
+            "CPU");
 
 namespace xe {
 namespace cpu {
@@ -67,6 +73,15 @@ PPCTranslator::PPCTranslator(PPCFrontend* frontend) : frontend_(frontend) {
   if (validate) sap->AddPass(std::make_unique<passes::ValidationPass>());
   compiler_->AddPass(std::move(sap));
 
+  // Needs the addresses simplified to match loads with stores, and must come
+  // before load/store swaps are combined.
+  if (cvars::combine_reserved_sequences) {
+    compiler_->AddPass(
+        std::make_unique<passes::ReservedSequenceCombinationPass>());
+    if (validate)
+      compiler_->AddPass(std::make_unique<passes::ValidationPass>());
+  }
+
   if (backend->machine_info()->supports_extended_load_store) {
     // Backend supports the advanced LOAD/STORE instructions.
     // These will save us a lot of HIR opcodes.
@@ -152,6 +167,25 @@ void PPCTranslator::DumpHIR(GuestFunction* function, PPCHIRBuilder* builder) {
 }
 bool PPCTranslator::Translate(GuestFunction* function,
                               uint32_t debug_info_flags) {
+  Processor* processor = frontend_->processor();
+  if (!processor->is_gathering_compile_statistics()) {
+    return TranslateInternal(function, debug_info_flags, nullptr);
+  }
+  CompileStatistics statistics;
+  bool result = TranslateInternal(function, debug_info_flags, &statistics);
+  statistics.function_count = 1;
+  if (result) {
+    statistics.machine_code_bytes = function->machine_code_length();
+  } else {
+    statistics.failed_function_count = 1;
+  }
+  processor->AddCompileStatistics(function->module(), statistics);
+  return result;
+}
+
+bool PPCTranslator::TranslateInternal(GuestFunction* function,
+                                      uint32_t debug_info_flags,
+                                      CompileStatistics* statistics) {
   SCOPE_profile_cpu_f("cpu");
   HirBuilderScope hir_build_scope{builder_.get()};
   // Reset() all caching when we leave.
@@ -182,9 +216,16 @@ bool PPCTranslator::Translate(GuestFunction* function,
   }
 
   // Scan the function to find its extents and gather debug data.
+  uint64_t scan_start_ticks = statistics ? Clock::QueryHostTickCount() : 0;
   if (!scanner_->Scan(function, debug_info.get())) {
     return false;
   }
+  if (statistics) {
+    statistics->scan_host_ticks =
+        Clock::QueryHostTickCount() - scan_start_ticks;
+    statistics->guest_instruction_count =
+        (function->end_address() - function->address()) / 4 + 1;
+  }
 
   // Setup trace data, if needed.
   if (debug_info_flags & DebugInfoFlags::kDebugInfoTraceFunctions) {
@@ -219,9 +260,14 @@ bool PPCTranslator::Translate(GuestFunction* function,
   if (debug_info) {
     emit_flags |= PPCHIRBuilder::EMIT_DEBUG_COMMENTS;
   }
+  uint64_t emit_start_ticks = statistics ? Clock::QueryHostTickCount() : 0;
   if (!builder_->Emit(function, emit_flags)) {
     return false;
   }
+  if (statistics) {
+    statistics->emit_host_ticks =
+        Clock::QueryHostTickCount() - emit_start_ticks;
+  }
 
   // Stash raw HIR.
   if (debug_info_flags & DebugInfoFlags::kDebugInfoDisasmRawHir) {
@@ -231,7 +277,7 @@ bool PPCTranslator::Translate(GuestFunction* function,
   }
 
   // Compile/optimize/etc.
-  if (!compiler_->Compile(builder_.get())) {
+  if (!compiler_->Compile(builder_.get(), statistics)) {
     return false;
   }
 
@@ -245,10 +291,15 @@ bool PPCTranslator::Translate(GuestFunction* function,
   DumpHIR(function, builder_.get());
 
   // Assemble to backend machine code.
+  uint64_t assemble_start_ticks = statistics ? Clock::QueryHostTickCount() : 0;
   if (!assembler_->Assemble(function, builder_.get(), debug_info_flags,
                             std::move(debug_info))) {
     return false;
   }
+  if (statistics) {
+    statistics->assemble_host_ticks =
+        Clock::QueryHostTickCount() - assemble_start_ticks;
+  }
 
   return true;
 }
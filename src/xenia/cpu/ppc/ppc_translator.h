@@ -35,6 +35,9 @@ class PPCTranslator {
   void Reset();
 
  private:
+  // Statistics may be null if they're not being gathered.
+  bool TranslateInternal(GuestFunction* function, uint32_t debug_info_flags,
+                         CompileStatistics* statistics);
   void DumpSource(GuestFunction* function, StringBuffer* string_buffer);
 
   PPCFrontend* frontend_;
@@ -0,0 +1,82 @@
+test_reserved_exchange:
+  #_ MEMORY_IN 10001000 11 22 33 44 aa bb cc dd
+  #_ REGISTER_IN r3 0x10001000
+  #_ REGISTER_IN r5 0x55667788
+reserved_exchange_retry:
+  lwarx r4, 0, r3
+  stwcx. r5, 0, r3
+  bne reserved_exchange_retry
+  blr
+  #_ REGISTER_OUT r3 0x10001000
+  #_ REGISTER_OUT r4 0x11223344
+  #_ REGISTER_OUT r5 0x55667788
+  #_ MEMORY_OUT 10001000 55 66 77 88 aa bb cc dd
+
+test_reserved_cas_match:
+  #_ MEMORY_IN 10001000 00 00 00 05 aa bb cc dd
+  #_ REGISTER_IN r3 0x10001000
+  #_ REGISTER_IN r5 5
+  #_ REGISTER_IN r6 9
+reserved_cas_match_retry:
+  lwarx r4, 0, r3
+  cmpw r4, r5
+  bne reserved_cas_match_done
+  stwcx. r6, 0, r3
+  bne reserved_cas_match_retry
+reserved_cas_match_done:
+  blr
+  #_ REGISTER_OUT r3 0x10001000
+  #_ REGISTER_OUT r4 5
+  #_ MEMORY_OUT 10001000 00 00 00 09 aa bb cc dd
+
+test_reserved_cas_mismatch:
+  #_ MEMORY_IN 10001000 00 00 00 07 aa bb cc dd
+  #_ REGISTER_IN r3 0x10001000
+  #_ REGISTER_IN r5 5
+  #_ REGISTER_IN r6 9
+reserved_cas_mismatch_retry:
+  lwarx r4, 0, r3
+  cmpw r4, r5
+  bne reserved_cas_mismatch_done
+  stwcx. r6, 0, r3
+  bne reserved_cas_mismatch_retry
+reserved_cas_mismatch_done:
+  blr
+  #_ REGISTER_OUT r3 0x10001000
+  #_ REGISTER_OUT r4 7
+  #_ MEMORY_OUT 10001000 00 00 00 07 aa bb cc dd
+
+test_reserved_add:
+  #_ MEMORY_IN 10001000 00 00 00 ff aa bb cc dd
+  #_ REGISTER_IN r3 0x10001000
+  #_ REGISTER_IN r5 0x101
+reserved_add_retry:
+  lwarx r4, 0, r3
+  add r7, r4, r5
+  stwcx. r7, 0, r3
+  bne reserved_add_retry
+  blr
+  #_ REGISTER_OUT r3 0x10001000
+  #_ REGISTER_OUT r4 0xff
+  #_ REGISTER_OUT r7 0x200
+  #_ MEMORY_OUT 10001000 00 00 02 00 aa bb cc dd
+
+test_reserved_store_between:
+  # A store between lwarx and stwcx. must keep the sequence a real
+  # reservation rather than being combined into a host atomic.
+  #_ MEMORY_IN 10001000 11 22 33 44 aa bb cc dd
+  #_ REGISTER_IN r3 0x10001000
+  #_ REGISTER_IN r5 0x01020304
+  #_ REGISTER_IN r6 0x55667788
+  li r12, 0
+  lwarx r4, 0, r3
+  stw r5, 4(r3)
+  stwcx. r6, 0, r3
+  bne reserved_store_between_failed
+  li r12, 1
+reserved_store_between_failed:
+  blr
+  #_ REGISTER_OUT r3 0x10001000
+  #_ REGISTER_OUT r4 0x11223344
+  #_ REGISTER_OUT r12 1
+  #_ MEMORY_OUT 10001000 55 66 77 88 01 02 03 04
@@ -21,6 +21,32 @@ project("xenia-cpu")
   local_platform_files("hir")
   local_platform_files("ppc")
 
+group("src")
+project("xenia-cpu-jit-bench")
+  uuid("8d2c5e41-96a7-4f0b-b3e8-1c7a4f9d2e60")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "capstone", -- cpu-backend-x64
+    "fmt",
+    "mspack",
+    "imgui",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-base",
+    "xenia-kernel",
+    "xenia-patcher",
+  })
+  files({
+    "jit_bench_main.cc",
+    "../base/console_app_main_"..platform_suffix..".cc",
+  })
+  filter("architecture:x86_64")
+    links({
+      "xenia-cpu-backend-x64",
+    })
+  filter({})
+
 include("testing")
 include("ppc/testing")
 filter({"configurations:Release", "platforms:Windows"})
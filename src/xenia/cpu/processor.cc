@@ -16,6 +16,7 @@
 #include "xenia/base/cvar.h"
 #include "xenia/base/debugging.h"
 #include "xenia/base/exception_handler.h"
+#include "xenia/base/filesystem.h"
 #include "xenia/base/literals.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/memory.h"
@@ -48,6 +49,11 @@ DEFINE_path(trace_function_data_path, "", "File to write trace data to.",
             "CPU");
 DEFINE_bool(break_on_start, false, "Break into the debugger on startup.",
             "CPU");
+DEFINE_path(compile_statistics_path, "",
+            "File to write the JSON per-module statistics of translating guest "
+            "functions, including the time and the HIR size of each compiler "
+            "pass, to on shutdown.",
+            "CPU");
 
 namespace xe {
 namespace kernel {
@@ -83,9 +89,15 @@ class BuiltinModule : public Module {
 };
 
 Processor::Processor(xe::Memory* memory, ExportResolver* export_resolver)
-    : memory_(memory), export_resolver_(export_resolver) {}
+    : memory_(memory), export_resolver_(export_resolver) {
+  gathering_compile_statistics_ = !cvars::compile_statistics_path.empty();
+}
 
 Processor::~Processor() {
+  if (!cvars::compile_statistics_path.empty()) {
+    WriteCompileStatistics(cvars::compile_statistics_path);
+  }
+
   {
     auto global_lock = global_critical_region_.Acquire();
     modules_.clear();
@@ -169,6 +181,53 @@ void Processor::PreLaunch() {
   }
 }
 
+void Processor::AddCompileStatistics(Module* module,
+                                     const CompileStatistics& statistics) {
+  std::lock_guard<xe_mutex> lock(compile_statistics_mutex_);
+  compile_statistics_[module->name()].Merge(statistics);
+}
+
+std::map<std::string, CompileStatistics> Processor::GetCompileStatistics() {
+  std::lock_guard<xe_mutex> lock(compile_statistics_mutex_);
+  return compile_statistics_;
+}
+
+bool Processor::WriteCompileStatistics(const std::filesystem::path& path) {
+  CompileStatistics total;
+  StringBuffer buffer;
+  buffer.Append("{\"modules\": {");
+  bool first_module = true;
+  for (const auto& module_statistics : GetCompileStatistics()) {
+    buffer.Append(first_module ? "\n  \"" : ",\n  \"");
+    first_module = false;
+    for (char c : module_statistics.first) {
+      if (c == '"' || c == '\\') {
+        buffer.Append('\\');
+      }
+      buffer.Append(c);
+    }
+    buffer.Append("\": ");
+    module_statistics.second.AppendJson(&buffer);
+    total.Merge(module_statistics.second);
+  }
+  buffer.Append("},\n\"total\": ");
+  total.AppendJson(&buffer);
+  buffer.Append("}\n");
+
+  FILE* file = xe::filesystem::OpenFile(path, "wb");
+  if (!file) {
+    XELOGE("Failed to open {} for writing the compile statistics",
+           xe::path_to_utf8(path));
+    return false;
+  }
+  std::string_view json = buffer.to_string_view();
+  fwrite(json.data(), 1, json.size(), file);
+  fclose(file);
+  XELOGI("Wrote the statistics of translating {} functions to {}",
+         total.function_count, xe::path_to_utf8(path));
+  return true;
+}
+
 bool Processor::AddModule(std::unique_ptr<Module> module) {
   auto global_lock = global_critical_region_.Acquire();
   modules_.push_back(std::move(module));
@@ -208,7 +267,8 @@ Module* Processor::GetModule(const std::string_view name) {
 
 std::vector<Module*> Processor::GetModules() {
   auto global_lock = global_critical_region_.Acquire();
-  std::vector<Module*> clone(modules_.size());
+  std::vector<Module*> clone;
+  clone.reserve(modules_.size());
   for (const auto& module : modules_) {
     clone.push_back(module.get());
   }
@@ -259,12 +319,12 @@ Function* Processor::ResolveFunction(uint32_t address) {
     auto function = LookupFunction(address);
 
     if (!function) {
-      entry->status = Entry::STATUS_FAILED;
+      entry_table_.FinishCompiling(entry, Entry::STATUS_FAILED);
       return nullptr;
     }
 
     if (!DemandFunction(function)) {
-      entry->status = Entry::STATUS_FAILED;
+      entry_table_.FinishCompiling(entry, Entry::STATUS_FAILED);
       return nullptr;
     }
     // only add it to the list of resolved functions if resolving succeeded
@@ -280,7 +340,8 @@ Function* Processor::ResolveFunction(uint32_t address) {
 
     entry->function = function;
     entry->end_address = function->end_address();
-    status = entry->status = Entry::STATUS_READY;
+    status = Entry::STATUS_READY;
+    entry_table_.FinishCompiling(entry, status);
   }
   if (status == Entry::STATUS_READY) {
     // Ready to use.
@@ -19,6 +19,7 @@
 #include "xenia/base/mapped_memory.h"
 #include "xenia/base/mutex.h"
 #include "xenia/cpu/backend/backend.h"
+#include "xenia/cpu/compile_statistics.h"
 #include "xenia/cpu/debug_listener.h"
 #include "xenia/cpu/entry_table.h"
 #include "xenia/cpu/export_resolver.h"
@@ -96,10 +97,23 @@ class Processor {
     debug_listener_handler_ = std::move(handler);
   }
 
+  uint32_t debug_info_flags() const { return debug_info_flags_; }
   void set_debug_info_flags(uint32_t debug_info_flags) {
     debug_info_flags_ = debug_info_flags;
   }
 
+  // Whether translated guest functions report their CompileStatistics. Enabled
+  // by the compile_statistics_path cvar or by EnableCompileStatistics.
+  bool is_gathering_compile_statistics() const {
+    return gathering_compile_statistics_;
+  }
+  void EnableCompileStatistics() { gathering_compile_statistics_ = true; }
+  void AddCompileStatistics(Module* module,
+                            const CompileStatistics& statistics);
+  // Sums for every module that functions were translated in, by module name.
+  std::map<std::string, CompileStatistics> GetCompileStatistics();
+  bool WriteCompileStatistics(const std::filesystem::path& path);
+
   bool AddModule(std::unique_ptr<Module> module);
   void RemoveModule(const std::string_view name);
   Module* GetModule(const std::string_view name);
@@ -261,6 +275,10 @@ class Processor {
   std::filesystem::path functions_trace_path_;
   std::unique_ptr<ChunkedMappedMemoryWriter> functions_trace_file_;
 
+  bool gathering_compile_statistics_ = false;
+  xe_mutex compile_statistics_mutex_;
+  std::map<std::string, CompileStatistics> compile_statistics_;
+
   std::unique_ptr<ppc::PPCFrontend> frontend_;
   std::unique_ptr<backend::Backend> backend_;
   ExportResolver* export_resolver_ = nullptr;
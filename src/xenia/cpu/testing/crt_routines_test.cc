@@ -0,0 +1,223 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "xenia/cpu/crt_routines.h"
+#include "xenia/cpu/ppc/ppc_context.h"
+#include "xenia/cpu/processor.h"
+#include "xenia/memory.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+using namespace xe;
+using namespace xe::cpu;
+using xe::cpu::ppc::PPCContext;
+
+namespace {
+
+// Calls the host CRT routine implementations directly with a guest context.
+class CrtRoutineTest {
+ public:
+  CrtRoutineTest() {
+    memory_ = std::make_unique<Memory>();
+    memory_->Initialize();
+    processor_ = std::make_unique<Processor>(memory_.get(), nullptr);
+    context_ = std::make_unique<PPCContext>();
+    std::memset(context_.get(), 0, sizeof(PPCContext));
+    context_->processor = processor_.get();
+    context_->virtual_membase = memory_->virtual_membase();
+    context_->physical_membase = memory_->physical_membase();
+  }
+
+  ~CrtRoutineTest() {
+    context_.reset();
+    processor_.reset();
+    memory_.reset();
+  }
+
+  Memory* memory() const { return memory_.get(); }
+
+  uint32_t Alloc(uint32_t size, bool physical = false) {
+    uint32_t address = memory_->SystemHeapAlloc(
+        size, 0x20, physical ? kSystemHeapPhysical : kSystemHeapVirtual);
+    REQUIRE(address != 0);
+    return address;
+  }
+
+  uint8_t* Translate(uint32_t address) const {
+    return memory_->TranslateVirtual(address);
+  }
+
+  // Returns whether the host implementation has done the work, rather than
+  // requesting the guest code to be executed.
+  bool Call(const char* name, uint32_t r3, uint32_t r4, uint32_t r5) {
+    GuestFunction::ExternHandler handler = GetCrtRoutineHandler(name);
+    REQUIRE(handler != nullptr);
+    context_->r[3] = r3;
+    context_->r[4] = r4;
+    context_->r[5] = r5;
+    context_->scratch = UINT64_MAX;
+    handler(context_.get(), nullptr);
+    REQUIRE(context_->scratch <= 1);
+    return context_->scratch != 0;
+  }
+
+  uint64_t r3() const { return context_->r[3]; }
+
+ private:
+  std::unique_ptr<Memory> memory_;
+  std::unique_ptr<Processor> processor_;
+  std::unique_ptr<PPCContext> context_;
+};
+
+void FillSequence(uint8_t* ptr, uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    ptr[i] = uint8_t(i + 1);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("CRT_MEMCPY", "[crt]") {
+  CrtRoutineTest test;
+  uint32_t buffer = test.Alloc(256);
+  uint8_t* ptr = test.Translate(buffer);
+
+  SECTION("Disjoint") {
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("memcpy", buffer + 128, buffer, 64));
+    REQUIRE(test.r3() == buffer + 128);
+    REQUIRE(std::memcmp(ptr + 128, ptr, 64) == 0);
+  }
+
+  SECTION("Overlapping, destination before source") {
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("memcpy", buffer, buffer + 3, 61));
+    for (uint32_t i = 0; i < 61; ++i) {
+      REQUIRE(ptr[i] == uint8_t(i + 4));
+    }
+  }
+
+  SECTION("Overlapping, destination after source") {
+    // Copied forward, so the first bytes of the source are repeated.
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("memcpy", buffer + 1, buffer, 63));
+    for (uint32_t i = 0; i < 64; ++i) {
+      REQUIRE(ptr[i] == 1);
+    }
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("XMemCpy", buffer + 3, buffer, 61));
+    for (uint32_t i = 0; i < 64; ++i) {
+      REQUIRE(ptr[i] == uint8_t(i % 3 + 1));
+    }
+  }
+
+  SECTION("Zero count") {
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("memcpy", buffer + 1, buffer, 0));
+    REQUIRE(ptr[1] == 2);
+  }
+}
+
+TEST_CASE("CRT_MEMMOVE", "[crt]") {
+  CrtRoutineTest test;
+  uint32_t buffer = test.Alloc(256);
+  uint8_t* ptr = test.Translate(buffer);
+
+  SECTION("Overlapping, destination before source") {
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("memmove", buffer, buffer + 3, 61));
+    REQUIRE(test.r3() == buffer);
+    for (uint32_t i = 0; i < 61; ++i) {
+      REQUIRE(ptr[i] == uint8_t(i + 4));
+    }
+  }
+
+  SECTION("Overlapping, destination after source") {
+    FillSequence(ptr, 64);
+    REQUIRE(test.Call("memmove", buffer + 3, buffer, 61));
+    REQUIRE(test.r3() == buffer + 3);
+    for (uint32_t i = 0; i < 3; ++i) {
+      REQUIRE(ptr[i] == uint8_t(i + 1));
+    }
+    for (uint32_t i = 0; i < 61; ++i) {
+      REQUIRE(ptr[3 + i] == uint8_t(i + 1));
+    }
+  }
+}
+
+TEST_CASE("CRT_MEMSET", "[crt]") {
+  CrtRoutineTest test;
+  uint32_t buffer = test.Alloc(256);
+  uint8_t* ptr = test.Translate(buffer);
+  FillSequence(ptr, 64);
+  // Only the low byte of the value is used.
+  REQUIRE(test.Call("memset", buffer + 8, 0x1A5, 32));
+  REQUIRE(test.r3() == buffer + 8);
+  for (uint32_t i = 0; i < 64; ++i) {
+    REQUIRE(ptr[i] == ((i >= 8 && i < 40) ? 0xA5 : uint8_t(i + 1)));
+  }
+}
+
+TEST_CASE("CRT_PHYSICAL_DESTINATION", "[crt]") {
+  CrtRoutineTest test;
+  uint32_t source = test.Alloc(256);
+  uint32_t dest = test.Alloc(4096, true);
+  uint32_t dest_physical = test.memory()->GetPhysicalAddress(dest);
+  REQUIRE(dest_physical != UINT32_MAX);
+
+  std::pair<uint32_t, uint32_t> invalidated(UINT32_MAX, 0);
+  void* callback_handle =
+      test.memory()->RegisterPhysicalMemoryInvalidationCallback(
+          [](void* context_ptr, uint32_t physical_address_start,
+             uint32_t length, bool exact_range) {
+            *reinterpret_cast<std::pair<uint32_t, uint32_t>*>(context_ptr) =
+                std::make_pair(physical_address_start, length);
+            return std::make_pair(uint32_t(0), UINT32_MAX);
+          },
+          &invalidated);
+
+  // Host writes must notify the physical memory watches.
+  test.memory()->EnablePhysicalMemoryAccessCallbacks(dest_physical, 4096,
+                                                     true, false);
+  FillSequence(test.Translate(source), 64);
+  REQUIRE(test.Call("memcpy", dest + 16, source, 64));
+  REQUIRE(std::memcmp(test.Translate(dest + 16), test.Translate(source), 64) ==
+          0);
+  REQUIRE(invalidated.first <= dest_physical + 16);
+  REQUIRE(invalidated.first + invalidated.second >= dest_physical + 16 + 64);
+
+  invalidated = std::make_pair(UINT32_MAX, 0);
+  test.memory()->EnablePhysicalMemoryAccessCallbacks(dest_physical, 4096,
+                                                     true, false);
+  REQUIRE(test.Call("memset", dest, 0x5A, 4096));
+  for (uint32_t i = 0; i < 4096; ++i) {
+    REQUIRE(test.Translate(dest)[i] == 0x5A);
+  }
+  REQUIRE(invalidated.first <= dest_physical);
+  REQUIRE(invalidated.first + invalidated.second >= dest_physical + 4096);
+
+  test.memory()->UnregisterPhysicalMemoryInvalidationCallback(callback_handle);
+}
+
+TEST_CASE("CRT_GUEST_FALLBACK", "[crt]") {
+  CrtRoutineTest test;
+  uint32_t buffer = test.Alloc(256);
+
+  // Ranges not within one heap (MMIO, or crossing the end of a heap) must be
+  // left to the guest code.
+  REQUIRE_FALSE(test.Call("memset", 0x7FC80000, 0, 16));
+  REQUIRE_FALSE(test.Call("memcpy", 0x7FC80000, buffer, 16));
+  REQUIRE_FALSE(test.Call("memcpy", buffer, 0x7FC80000, 16));
+  REQUIRE_FALSE(test.Call("memmove", 0x7EFFFFF0, buffer, 32));
+  REQUIRE_FALSE(test.Call("memset", 0x3FFFFFF0, 0, 32));
+}
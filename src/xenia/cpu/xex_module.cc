@@ -10,6 +10,9 @@
 #include "xenia/cpu/xex_module.h"
 
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
 
 #include "third_party/fmt/include/fmt/format.h"
 
@@ -18,8 +21,10 @@
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/base/xxhash.h"
 
 #include "xenia/cpu/cpu_flags.h"
+#include "xenia/cpu/crt_routines.h"
 #include "xenia/cpu/export_resolver.h"
 #include "xenia/cpu/lzx.h"
 #include "xenia/cpu/processor.h"
@@ -48,6 +53,19 @@ DEFINE_bool(
     "finding/stress testing with the JIT",
     "CPU");
 
+DEFINE_bool(native_crt_routines, true,
+            "Replace C runtime routines statically linked into the title, such "
+            "as memcpy, memset and strlen, with host implementations. They "
+            "are recognized by their names in the module map or by the "
+            "signatures in native_crt_routine_signatures_path.",
+            "CPU");
+DEFINE_path(native_crt_routine_signatures_path, "",
+            "File with signatures of C runtime routines, with lines of the "
+            "routine name, its length in instructions and the 64-bit hash of "
+            "its code in hexadecimal. Signatures of the routines named in the "
+            "module map are logged in this format.",
+            "CPU");
+
 DECLARE_bool(allow_plugins);
 
 static const uint8_t xe_xex2_retail_key[16] = {
@@ -1131,6 +1149,8 @@ void XexModule::Precompile() {
     return;
   }
 
+  BindCrtRoutines();
+
   info_cache_.Init(this);
   PrecompileDiscoveredFunctions();
 }
@@ -1598,6 +1618,117 @@ std::vector<uint32_t> XexModule::PreanalyzeCode() {
   delete[] funcstart_candstack2;
   return result;
 }
+void XexModule::BindCrtRoutines() {
+  if (!cvars::native_crt_routines) {
+    return;
+  }
+
+  // Function lengths from the exception directory, which has an entry for
+  // every non-leaf and most leaf functions.
+  std::unordered_map<uint32_t, uint32_t> pdata_lengths;
+  auto pdata = GetPESection(".pdata");
+  if (pdata) {
+    auto pdata_base = memory()->TranslateVirtual<xe::be<uint32_t>*>(
+        pdata->address);
+    for (uint32_t i = 0; i < pdata->raw_size / 8; ++i) {
+      uint32_t address = pdata_base[i * 2];
+      if (!address) {
+        break;
+      }
+      // Bits 8:29 of the second word are the length in instructions.
+      uint32_t length = (pdata_base[i * 2 + 1] >> 8) & 0x3FFFFF;
+      if (length && ContainsAddress(address) &&
+          ContainsAddress(address + length * 4 - 1)) {
+        pdata_lengths.emplace(address, length);
+      }
+    }
+  }
+  auto hash_code = [this](uint32_t address, uint32_t length) {
+    return XXH3_64bits(memory()->TranslateVirtual(address), length * 4);
+  };
+
+  uint32_t bound_count = 0;
+  auto bind = [this, &bound_count](Function* function, const std::string& name,
+                                   GuestFunction::ExternHandler handler) {
+    if (!function || !function->is_guest() ||
+        function->status() == Symbol::Status::kDefined ||
+        function->behavior() != Function::Behavior::kDefault) {
+      return;
+    }
+    if (function->name().empty()) {
+      function->set_name(name);
+    }
+    static_cast<GuestFunction*>(function)->SetupExtern(handler);
+    XELOGI("Replaced {} at {:08X} with a native implementation", name,
+           function->address());
+    ++bound_count;
+  };
+
+  // Routines named in the module map.
+  if (cvars::load_module_map.size()) {
+    std::vector<std::pair<Function*, GuestFunction::ExternHandler>> named;
+    ForEachFunction([&named](Function* function) {
+      auto handler = GetCrtRoutineHandler(function->name());
+      if (handler) {
+        named.emplace_back(function, handler);
+      }
+    });
+    for (const auto& [function, handler] : named) {
+      auto length_it = pdata_lengths.find(function->address());
+      if (length_it != pdata_lengths.end()) {
+        XELOGI("Native CRT routine signature: {} {} {:016X}", function->name(),
+               length_it->second,
+               hash_code(function->address(), length_it->second));
+      }
+      bind(function, function->name(), handler);
+    }
+  }
+
+  // Routines recognized by the hash of their code.
+  if (!cvars::native_crt_routine_signatures_path.empty() &&
+      !pdata_lengths.empty()) {
+    std::ifstream signatures_file(cvars::native_crt_routine_signatures_path);
+    // Keyed by the hash, as it's what's looked up for every function.
+    std::unordered_multimap<uint64_t, std::pair<std::string, uint32_t>>
+        signatures;
+    std::string line;
+    std::istringstream line_stream;
+    while (std::getline(signatures_file, line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      line_stream.clear();
+      line_stream.str(line);
+      std::string name;
+      uint32_t length = 0;
+      uint64_t hash = 0;
+      line_stream >> name >> std::dec >> length >> std::hex >> hash;
+      if (line_stream.fail() || !GetCrtRoutineHandler(name)) {
+        XELOGW("Invalid native CRT routine signature: {}", line);
+        continue;
+      }
+      signatures.emplace(hash, std::make_pair(std::move(name), length));
+    }
+    if (!signatures.empty()) {
+      for (const auto& [address, length] : pdata_lengths) {
+        auto range = signatures.equal_range(hash_code(address, length));
+        for (auto it = range.first; it != range.second; ++it) {
+          if (it->second.second == length) {
+            bind(processor_->LookupFunction(this, address), it->second.first,
+                 GetCrtRoutineHandler(it->second.first));
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  if (bound_count) {
+    XELOGI("Replaced {} C runtime routines in {} with native implementations",
+           bound_count, name_);
+  }
+}
+
 bool XexModule::FindSaveRest() {
   // Special stack save/restore functions.
   // http://research.microsoft.com/en-us/um/redmond/projects/invisible/src/crt/md/ppc/xxx.s.htm
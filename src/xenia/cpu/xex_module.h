@@ -254,6 +254,8 @@ class XexModule : public xe::cpu::Module {
   bool SetupLibraryImports(const std::string_view name,
                            const xex2_import_library* library);
   bool FindSaveRest();
+  // Replaces recognized C runtime routines with host implementations.
+  void BindCrtRoutines();
 
   Processor* processor_ = nullptr;
   kernel::KernelState* kernel_state_ = nullptr;
@@ -9,12 +9,15 @@
 
 #include "xenia/gpu/command_processor.h"
 
+#include <algorithm>
 #include <cinttypes>
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/byte_stream.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/memory.h"
 #include "xenia/base/profiling.h"
 #include "xenia/gpu/gpu_flags.h"
 #include "xenia/gpu/graphics_system.h"
@@ -73,8 +76,10 @@ CommandProcessor::CommandProcessor(GraphicsSystem* graphics_system,
       trace_writer_(graphics_system->memory()->physical_membase()),
       worker_running_(true),
       write_ptr_index_event_(xe::threading::Event::CreateAutoResetEvent(false)),
-      write_ptr_index_(0) {
+      write_ptr_index_(0),
+      wait_reg_mem_event_(xe::threading::Event::CreateAutoResetEvent(false)) {
   assert_not_null(write_ptr_index_event_);
+  assert_not_null(wait_reg_mem_event_);
 }
 
 CommandProcessor::~CommandProcessor() = default;
@@ -99,6 +104,10 @@ bool CommandProcessor::Initialize() {
     }
   }
 
+  wait_reg_mem_invalidation_callback_handle_ =
+      memory_->RegisterPhysicalMemoryInvalidationCallback(
+          WaitRegMemInvalidationCallbackThunk, this);
+
   worker_running_ = true;
   worker_thread_ =
       kernel::object_ref<kernel::XHostThread>(new kernel::XHostThread(
@@ -119,8 +128,15 @@ void CommandProcessor::Shutdown() {
 
   worker_running_ = false;
   write_ptr_index_event_->Set();
+  wait_reg_mem_event_->Set();
   worker_thread_->Wait(0, 0, 0, nullptr);
   worker_thread_.reset();
+
+  if (wait_reg_mem_invalidation_callback_handle_) {
+    memory_->UnregisterPhysicalMemoryInvalidationCallback(
+        wait_reg_mem_invalidation_callback_handle_);
+    wait_reg_mem_invalidation_callback_handle_ = nullptr;
+  }
 }
 
 void CommandProcessor::InitializeShaderStorage(
@@ -268,6 +284,10 @@ void CommandProcessor::WorkerThreadMain() {
     }
     assert_true(read_ptr_index_ != write_ptr_index);
 
+    // Make the guest writes done before the submission visible if they are
+    // tracked in batches rather than by write-protection.
+    memory_->ReportPhysicalMemoryWrites();
+
     // Execute. Note that we handle wraparound transparently.
     read_ptr_index_ = ExecutePrimaryBuffer(read_ptr_index_, write_ptr_index);
 
@@ -626,19 +646,36 @@ void CommandProcessor::WriteRegister(uint32_t index, uint32_t value) {
 void CommandProcessor::WriteRegistersFromMem(uint32_t start_index,
                                              uint32_t* base,
                                              uint32_t num_registers) {
-  for (uint32_t i = 0; i < num_registers; ++i) {
-    uint32_t data = xe::load_and_swap<uint32_t>(base + i);
-    this->WriteRegister(start_index + i, data);
+  // Swap in batches with the vectorized copy, but still write the registers one
+  // by one, as the side effects of a write may depend on the preceding ones.
+  uint32_t values[64];
+  for (uint32_t i = 0; i < num_registers; i += uint32_t(xe::countof(values))) {
+    uint32_t batch_count =
+        std::min(num_registers - i, uint32_t(xe::countof(values)));
+    xe::copy_and_swap_32_unaligned(values, base + i, batch_count);
+    for (uint32_t j = 0; j < batch_count; ++j) {
+      this->WriteRegister(start_index + i + j, values[j]);
+    }
   }
 }
 
 void CommandProcessor::WriteRegisterRangeFromRing(xe::RingBuffer* ring,
                                                   uint32_t base,
                                                   uint32_t num_registers) {
-  for (uint32_t i = 0; i < num_registers; ++i) {
-    uint32_t data = ring->ReadAndSwap<uint32_t>();
-    WriteRegister(base + i, data);
+  RingBuffer::ReadRange range =
+      ring->BeginRead(num_registers * sizeof(uint32_t));
+  uint32_t num_regs_firstrange =
+      static_cast<uint32_t>(range.first_length / sizeof(uint32_t));
+  WriteRegistersFromMem(
+      base, reinterpret_cast<uint32_t*>(const_cast<uint8_t*>(range.first)),
+      num_regs_firstrange);
+  if (range.second) {
+    WriteRegistersFromMem(
+        base + num_regs_firstrange,
+        reinterpret_cast<uint32_t*>(const_cast<uint8_t*>(range.second)),
+        num_registers - num_regs_firstrange);
   }
+  ring->EndRead(range);
 }
 
 void CommandProcessor::WriteALURangeFromRing(xe::RingBuffer* ring,
@@ -752,6 +789,40 @@ void CommandProcessor::PrepareForWait() { trace_writer_.Flush(); }
 
 void CommandProcessor::ReturnFromWait() {}
 
+void CommandProcessor::ArmWaitRegMemWatch(bool is_memory, uint32_t address) {
+  if (is_memory) {
+    wait_reg_mem_address_.store(address, std::memory_order_relaxed);
+    // Takes the global critical region, so once this returns, a guest write
+    // that hasn't landed yet will fault and invoke the callback, and one that
+    // has is visible to the following read of the value.
+    memory_->EnablePhysicalMemoryAccessCallbacks(address, sizeof(uint32_t),
+                                                 true, false);
+  } else {
+    wait_reg_mem_register_.store(address, std::memory_order_relaxed);
+  }
+}
+
+void CommandProcessor::DisarmWaitRegMemWatch() {
+  wait_reg_mem_address_.store(UINT32_MAX, std::memory_order_relaxed);
+  wait_reg_mem_register_.store(UINT32_MAX, std::memory_order_relaxed);
+}
+
+std::pair<uint32_t, uint32_t>
+CommandProcessor::WaitRegMemInvalidationCallbackThunk(
+    void* context_ptr, uint32_t physical_address_start, uint32_t length,
+    bool exact_range) {
+  auto command_processor = reinterpret_cast<CommandProcessor*>(context_ptr);
+  uint32_t address =
+      command_processor->wait_reg_mem_address_.load(std::memory_order_relaxed);
+  // Invoked before the faulting write is actually performed, but the waiter
+  // rearms the watch before rereading, so the write will either be seen or
+  // fault again.
+  if (address != UINT32_MAX && address - physical_address_start < length) {
+    command_processor->wait_reg_mem_event_->Set();
+  }
+  return std::make_pair(uint32_t(0), UINT32_MAX);
+}
+
 void CommandProcessor::InitializeTrace() {
   // Write the initial register values, to be loaded directly into the
   // RegisterFile since all registers, including those that may have side
@@ -137,6 +137,14 @@ class CommandProcessor {
 
   void UpdateWritePointer(uint32_t value);
 
+  // Called when the CPU writes a register through MMIO, to wake up
+  // PM4_WAIT_REG_MEM if it's polling that register.
+  void NotifyRegisterWrittenByCpu(uint32_t index) {
+    if (wait_reg_mem_register_.load(std::memory_order_relaxed) == index) {
+      wait_reg_mem_event_->Set();
+    }
+  }
+
   void LogRegisterSet(uint32_t register_index, uint32_t value);
   void LogRegisterSets(uint32_t base_register_index, const uint32_t* values,
                        uint32_t n_values);
@@ -225,6 +233,16 @@ class CommandProcessor {
   virtual void PrepareForWait();
   virtual void ReturnFromWait();
 
+  // Makes writes to the physical memory page containing the address (or, if
+  // is_memory is false, CPU writes to the register) signal
+  // wait_reg_mem_event_. Memory watches are one-shot, so this must be called
+  // again after every wakeup, before rechecking the value.
+  void ArmWaitRegMemWatch(bool is_memory, uint32_t address);
+  void DisarmWaitRegMemWatch();
+  static std::pair<uint32_t, uint32_t> WaitRegMemInvalidationCallbackThunk(
+      void* context_ptr, uint32_t physical_address_start, uint32_t length,
+      bool exact_range);
+
   virtual void OnPrimaryBufferEnd() {}
 
 #include "pm4_command_processor_declare.h"
@@ -286,6 +304,18 @@ class CommandProcessor {
   std::unique_ptr<xe::threading::Event> write_ptr_index_event_;
   std::atomic<uint32_t> write_ptr_index_;
 
+  // PM4_WAIT_REG_MEM wakeup on CPU writes (wait_reg_mem_event_driven).
+  // Iterations to spin before blocking, adjusted depending on whether recent
+  // waits were satisfied while spinning.
+  static constexpr uint32_t kWaitRegMemSpinCountMin = 16;
+  static constexpr uint32_t kWaitRegMemSpinCountMax = 4096;
+  uint32_t wait_reg_mem_spin_count_ = 256;
+  std::unique_ptr<xe::threading::Event> wait_reg_mem_event_;
+  void* wait_reg_mem_invalidation_callback_handle_ = nullptr;
+  // Physical address and register index being polled, UINT32_MAX if none.
+  std::atomic<uint32_t> wait_reg_mem_address_{UINT32_MAX};
+  std::atomic<uint32_t> wait_reg_mem_register_{UINT32_MAX};
+
   uint64_t bin_select_ = 0xFFFFFFFFull;
   uint64_t bin_mask_ = 0xFFFFFFFFull;
 
@@ -3363,6 +3363,8 @@ bool D3D12CommandProcessor::BeginSubmission(bool is_guest_command) {
       }
     }
 
+    shared_memory_->BeginFrame();
+
     primitive_processor_->BeginFrame();
 
     texture_cache_->BeginFrame();
@@ -48,6 +48,13 @@ DEFINE_bool(
     "some games draw rectangles (for their UI, for instance) without clipping, "
     "but with a proper scissor rectangle.",
     "GPU");
+DEFINE_bool(
+    execute_unclipped_draw_vs_on_cpu_jit, false,
+    "For execute_unclipped_draw_vs_on_cpu, compile the vertex shader to x86-64 "
+    "code processing multiple vertices at once, instead of interpreting it for "
+    "every vertex, if the shader only uses the features supported by the "
+    "compiler.",
+    "GPU");
 
 namespace xe {
 namespace gpu {
@@ -168,52 +175,26 @@ uint32_t DrawExtentEstimator::EstimateVertexMaxY(const Shader& vertex_shader) {
 
   float max_y = -FLT_MAX;
 
-  shader_interpreter_.SetShader(vertex_shader);
+  bool use_jit = cvars::execute_unclipped_draw_vs_on_cpu_jit &&
+                 vertex_shader_jit_.Prepare(vertex_shader);
+  if (!use_jit) {
+    shader_interpreter_.SetShader(vertex_shader);
+  }
 
   PositionYExportSink position_y_export_sink;
   shader_interpreter_.SetExportSink(&position_y_export_sink);
-  for (uint32_t i = 0; i < vgt_draw_initiator.num_indices; ++i) {
-    uint32_t vertex_index;
-    if (vgt_draw_initiator.source_select == xenos::SourceSelect::kDMA) {
-      if (i < vgt_dma_size.num_words) {
-        if (vgt_draw_initiator.index_size == xenos::IndexFormat::kInt16) {
-          vertex_index = index_buffer_16[i];
-        } else {
-          vertex_index = index_buffer_32[i];
-        }
-        // The Xenos only uses 24 bits of the index (reset_indx is 24-bit).
-        vertex_index = xenos::GpuSwap(vertex_index, index_endian) & 0xFFFFFF;
-      } else {
-        vertex_index = 0;
-      }
-      if (pa_su_sc_mode_cntl.multi_prim_ib_ena && vertex_index == reset_index) {
-        continue;
-      }
-    } else {
-      assert_true(vgt_draw_initiator.source_select ==
-                  xenos::SourceSelect::kAutoIndex);
-      vertex_index = i;
-    }
-    vertex_index =
-        std::min(max_index,
-                 std::max(min_index, (vertex_index + index_offset) & 0xFFFFFF));
-
-    position_y_export_sink.Reset();
-
-    shader_interpreter_.temp_registers()[0] = float(vertex_index);
-    shader_interpreter_.Execute();
-
+  auto accumulate_vertex_max_y = [&]() {
     if (position_y_export_sink.vertex_kill().has_value() &&
         (position_y_export_sink.vertex_kill().value() & ~(UINT32_C(1) << 31))) {
-      continue;
+      return;
     }
     if (!position_y_export_sink.position_y().has_value()) {
-      continue;
+      return;
     }
     float vertex_y = position_y_export_sink.position_y().value();
     if (!pa_cl_vte_cntl.vtx_xy_fmt) {
       if (!position_y_export_sink.position_w().has_value()) {
-        continue;
+        return;
       }
       vertex_y /= position_y_export_sink.position_w().value();
     }
@@ -243,6 +224,63 @@ uint32_t DrawExtentEstimator::EstimateVertexMaxY(const Shader& vertex_shader) {
     // std::max is `a < b ? b : a`, thus in case of NaN, the first argument is
     // always returned - max_y, which is initialized to a normalized value.
     max_y = std::max(max_y, vertex_y);
+  };
+
+  uint32_t jit_vertex_indices[VertexShaderJit::kLaneCount];
+  uint32_t jit_vertex_count = 0;
+  auto execute_jit_vertices = [&]() {
+    vertex_shader_jit_.Execute(jit_vertex_indices, jit_vertex_count);
+    for (uint32_t i = 0; i < jit_vertex_count; ++i) {
+      position_y_export_sink.Reset();
+      vertex_shader_jit_.ReplayExports(i, position_y_export_sink);
+      accumulate_vertex_max_y();
+    }
+    jit_vertex_count = 0;
+  };
+
+  for (uint32_t i = 0; i < vgt_draw_initiator.num_indices; ++i) {
+    uint32_t vertex_index;
+    if (vgt_draw_initiator.source_select == xenos::SourceSelect::kDMA) {
+      if (i < vgt_dma_size.num_words) {
+        if (vgt_draw_initiator.index_size == xenos::IndexFormat::kInt16) {
+          vertex_index = index_buffer_16[i];
+        } else {
+          vertex_index = index_buffer_32[i];
+        }
+        // The Xenos only uses 24 bits of the index (reset_indx is 24-bit).
+        vertex_index = xenos::GpuSwap(vertex_index, index_endian) & 0xFFFFFF;
+      } else {
+        vertex_index = 0;
+      }
+      if (pa_su_sc_mode_cntl.multi_prim_ib_ena && vertex_index == reset_index) {
+        continue;
+      }
+    } else {
+      assert_true(vgt_draw_initiator.source_select ==
+                  xenos::SourceSelect::kAutoIndex);
+      vertex_index = i;
+    }
+    vertex_index =
+        std::min(max_index,
+                 std::max(min_index, (vertex_index + index_offset) & 0xFFFFFF));
+
+    if (use_jit) {
+      jit_vertex_indices[jit_vertex_count++] = vertex_index;
+      if (jit_vertex_count >= VertexShaderJit::kLaneCount) {
+        execute_jit_vertices();
+      }
+      continue;
+    }
+
+    position_y_export_sink.Reset();
+
+    shader_interpreter_.temp_registers()[0] = float(vertex_index);
+    shader_interpreter_.Execute();
+
+    accumulate_vertex_max_y();
+  }
+  if (jit_vertex_count) {
+    execute_jit_vertices();
   }
   shader_interpreter_.SetExportSink(nullptr);
 
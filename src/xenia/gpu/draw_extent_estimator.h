@@ -17,6 +17,7 @@
 #include "xenia/gpu/shader.h"
 #include "xenia/gpu/shader_interpreter.h"
 #include "xenia/gpu/trace_writer.h"
+#include "xenia/gpu/vertex_shader_jit.h"
 #include "xenia/memory.h"
 
 namespace xe {
@@ -29,8 +30,10 @@ class DrawExtentEstimator {
       : register_file_(register_file),
         memory_(memory),
         trace_writer_(trace_writer),
-        shader_interpreter_(register_file, memory) {
+        shader_interpreter_(register_file, memory),
+        vertex_shader_jit_(register_file, memory) {
     shader_interpreter_.SetTraceWriter(trace_writer);
+    vertex_shader_jit_.SetTraceWriter(trace_writer);
   }
 
   // The shader must have its ucode analyzed.
@@ -68,6 +71,7 @@ class DrawExtentEstimator {
   TraceWriter* trace_writer_;
 
   ShaderInterpreter shader_interpreter_;
+  VertexShaderJit vertex_shader_jit_;
 };
 
 }  // namespace gpu
@@ -20,6 +20,16 @@ DEFINE_path(
 
 DEFINE_bool(vsync, true, "Enable VSYNC.", "GPU");
 
+DEFINE_bool(
+    wait_reg_mem_event_driven, false,
+    "Make PM4_WAIT_REG_MEM wake up when the polled guest memory page or "
+    "register is written by the CPU, after a short adaptive spin, instead of "
+    "sleeping for the whole interval requested by the packet. Only affects "
+    "waits with VSYNC enabled - writes not done by the guest CPU can't be "
+    "detected, so without VSYNC, the wait still busy-waits, and with it, "
+    "sleeps for no longer than the packet requests.",
+    "GPU");
+
 DEFINE_uint64(framerate_limit, 60,
               "Maximum frames per second. 0 = Unlimited frames.\n"
               "Defaults to 60, when set to 0, and VSYNC is enabled.",
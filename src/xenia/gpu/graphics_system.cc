@@ -280,6 +280,7 @@ void GraphicsSystem::WriteRegister(uint32_t addr, uint32_t value) {
 
   assert_true(r < RegisterFile::kRegisterCount);
   this->register_file()->values[r] = value;
+  command_processor_->NotifyRegisterWrittenByCpu(r);
 }
 
 void GraphicsSystem::InitializeRingBuffer(uint32_t ptr, uint32_t size_log2) {
@@ -37,6 +37,11 @@ bool ExecutePacketType3_INDIRECT_BUFFER(uint32_t packet,
 XE_NOINLINE
 bool ExecutePacketType3_WAIT_REG_MEM(uint32_t packet,
                                      uint32_t count) XE_RESTRICT;
+// PM4_WAIT_REG_MEM loop with the wait_reg_mem_event_driven behavior.
+XE_NOINLINE
+bool WaitRegMemEventDriven(const volatile uint32_t& value_ref, bool is_memory,
+                           uint32_t poll_reg_addr, uint32_t ref, uint32_t mask,
+                           uint32_t wait_info, uint32_t wait) XE_RESTRICT;
 XE_NOINLINE
 bool ExecutePacketType3_REG_RMW(uint32_t packet, uint32_t count) XE_RESTRICT;
 
@@ -646,6 +646,7 @@ bool COMMAND_PROCESSOR::ExecutePacketType3_XE_SWAP(uint32_t packet,
   SCOPE_profile_cpu_f("gpu");
 
   Profiler::Flip();
+  Timeline::MarkFrame();
 
   // Xenia-specific VdSwap hook.
   // VdSwap will post this to tell us we need to swap the screen/fire an
@@ -714,6 +715,17 @@ bool COMMAND_PROCESSOR::ExecutePacketType3_WAIT_REG_MEM(
                       poll_reg_addr & ~uint32_t(0x3)))
                 : register_file_->values[poll_reg_addr];
 
+  if (cvars::wait_reg_mem_event_driven) {
+    if (!COMMAND_PROCESSOR::WaitRegMemEventDriven(
+            value_ref, is_memory, poll_reg_addr, ref, mask, wait_info, wait)) {
+      return false;
+    }
+    // The guest may have been producing data for the following commands until
+    // signaling.
+    memory_->ReportPhysicalMemoryWrites();
+    return true;
+  }
+
   bool matched = false;
 
   do {
@@ -752,6 +764,84 @@ bool COMMAND_PROCESSOR::ExecutePacketType3_WAIT_REG_MEM(
     }
   } while (!matched);
 
+  memory_->ReportPhysicalMemoryWrites();
+  return true;
+}
+
+XE_NOINLINE
+bool COMMAND_PROCESSOR::WaitRegMemEventDriven(
+    const volatile uint32_t& value_ref, bool is_memory, uint32_t poll_reg_addr,
+    uint32_t ref, uint32_t mask, uint32_t wait_info,
+    uint32_t wait) XE_RESTRICT {
+  uint32_t watch_address = is_memory
+                               ? poll_reg_addr & ~uint32_t(0x3) & 0x1FFFFFFF
+                               : poll_reg_addr;
+  // Not every write to the location can be caught (such as ones from host
+  // code writing to physical memory directly, or any if guest writes are
+  // tracked without faults), so only block where the original loop would
+  // sleep anyway, and never for longer than it would. Otherwise, keep spinning
+  // like the original loop does.
+  bool can_block = cvars::vsync && wait >= 0x100;
+  std::chrono::milliseconds block_timeout(wait / 0x100);
+  uint32_t spin_count = wait_reg_mem_spin_count_;
+  uint32_t spins = 0;
+  bool armed = false;
+  bool blocked = false;
+  while (true) {
+    uint32_t value = value_ref;
+    if (is_memory) {
+      trace_writer_.WriteMemoryRead(CpuToGpu(poll_reg_addr & ~uint32_t(0x3)),
+                                    sizeof(uint32_t));
+      value = xenos::GpuSwap(value,
+                             static_cast<xenos::Endian>(poll_reg_addr & 0x3));
+    } else if (poll_reg_addr == XE_GPU_REG_COHER_STATUS_HOST) {
+      MakeCoherent();
+      value = value_ref;
+    }
+    if (MatchValueAndRef(value & mask, ref, wait_info)) {
+      break;
+    }
+    if (!can_block) {
+      if (!worker_running_) {
+        // Short-circuited exit.
+        return false;
+      }
+      xe::threading::MaybeYield();
+      continue;
+    }
+    if (spins < spin_count) {
+      ++spins;
+      xe::threading::MaybeYield();
+      continue;
+    }
+    if (!armed) {
+      // Recheck the value after arming so a write between the read above and
+      // arming isn't missed.
+      ArmWaitRegMemWatch(is_memory, watch_address);
+      armed = true;
+      continue;
+    }
+    PrepareForWait();
+    xe::threading::Wait(wait_reg_mem_event_.get(), false, block_timeout);
+    ReturnFromWait();
+    blocked = true;
+    if (!worker_running_) {
+      // Short-circuited exit.
+      DisarmWaitRegMemWatch();
+      return false;
+    }
+    // Memory watches are one-shot.
+    armed = !is_memory;
+  }
+  if (armed || blocked) {
+    DisarmWaitRegMemWatch();
+  }
+  // Spin longer next time if the spin was enough, otherwise stop wasting time
+  // on spinning for waits that end up being satisfied by a wakeup anyway.
+  wait_reg_mem_spin_count_ =
+      blocked ? std::max(spin_count >> 1, kWaitRegMemSpinCountMin)
+              : std::min(std::max(spin_count, spins << 1),
+                         kWaitRegMemSpinCountMax);
   return true;
 }
 XE_NOINLINE
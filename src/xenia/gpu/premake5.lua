@@ -19,6 +19,12 @@ project("xenia-gpu")
     project_root.."/third_party/Vulkan-Headers/include",
   })
   local_platform_files()
+  filter("files:vertex_shader_jit.cc")
+    defines({
+      "XBYAK_NO_OP_NAMES",
+      "XBYAK_ENABLE_OMITTED_OPERAND",
+    })
+  filter({})
 
 group("src")
 project("xenia-gpu-shader-compiler")
@@ -53,3 +59,43 @@ project("xenia-gpu-shader-compiler")
         "1>scratch/stdout-shader-compiler.txt",
       })
     end
+
+group("src")
+project("xenia-gpu-vertex-shader-jit-bench")
+  uuid("3b6e1d0c-7f25-4a8e-9c41-52d7e8a6f0b9")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "xenia-apu",
+    "xenia-apu-nop",
+    "xenia-base",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-gpu",
+    "xenia-hid",
+    "xenia-hid-nop",
+    "xenia-kernel",
+    "xenia-ui",
+    "xenia-vfs",
+    "xenia-patcher",
+  })
+  links({
+    "aes_128",
+    "capstone",
+    "dxbc",
+    "fmt",
+    "glslang-spirv",
+    "imgui",
+    "libavcodec",
+    "libavutil",
+    "mspack",
+    "snappy",
+    "xxhash",
+  })
+  includedirs({
+    project_root.."/third_party/Vulkan-Headers/include",
+  })
+  files({
+    "vertex_shader_jit_bench_main.cc",
+    "../base/console_app_main_"..platform_suffix..".cc",
+  })
@@ -52,6 +52,12 @@ DEFINE_string(
     "[vertex or unspecified, linedomaincp, linedomainpatch, triangledomaincp, "
     "triangledomainpatch, quaddomaincp, quaddomainpatch].",
     "GPU");
+DEFINE_string(
+    shader_output_spirv_optimization, "none",
+    "SPIRV-Tools pass recipe to run on SPIR-V output, requires the VULKAN_SDK "
+    "environment variable: [none, performance, size]. Instruction counts "
+    "before and after the optimization are logged.",
+    "GPU");
 DEFINE_bool(shader_output_bindless_resources, false,
             "Output host shader with bindless resources used.", "GPU");
 DEFINE_bool(
@@ -190,6 +196,42 @@ int shader_compiler_main(const std::vector<std::string>& args) {
   const void* source_data = translation->translated_binary().data();
   size_t source_data_size = translation->translated_binary().size();
 
+  std::vector<uint32_t> spirv_optimized;
+  if ((cvars::shader_output_type == "spirv" ||
+       cvars::shader_output_type == "spirvtext") &&
+      (cvars::shader_output_spirv_optimization == "performance" ||
+       cvars::shader_output_spirv_optimization == "size")) {
+    ui::vulkan::SpirvToolsContext spirv_tools_context;
+    if (spirv_tools_context.Initialize(spirv_features.spirv_version) &&
+        spirv_tools_context.IsOptimizerAvailable()) {
+      const uint32_t* spirv_words =
+          reinterpret_cast<const uint32_t*>(source_data);
+      size_t spirv_word_count = source_data_size / sizeof(uint32_t);
+      spv_result_t optimization_result = spirv_tools_context.Optimize(
+          spirv_words, spirv_word_count,
+          cvars::shader_output_spirv_optimization == "size", spirv_optimized);
+      if (optimization_result == SPV_SUCCESS) {
+        XELOGI(
+            "SPIR-V optimized ({}): {} instructions, {} bytes before; {} "
+            "instructions, {} bytes after",
+            cvars::shader_output_spirv_optimization,
+            ui::vulkan::SpirvToolsContext::CountInstructions(spirv_words,
+                                                             spirv_word_count),
+            source_data_size,
+            ui::vulkan::SpirvToolsContext::CountInstructions(
+                spirv_optimized.data(), spirv_optimized.size()),
+            spirv_optimized.size() * sizeof(uint32_t));
+        source_data = spirv_optimized.data();
+        source_data_size = spirv_optimized.size() * sizeof(uint32_t);
+      } else {
+        XELOGE("Failed to optimize SPIR-V (error {}), writing unoptimized",
+               int32_t(optimization_result));
+      }
+    } else {
+      XELOGE("SPIRV-Tools optimizer is not available, writing unoptimized");
+    }
+  }
+
   std::string spirv_disasm;
   if (cvars::shader_output_type == "spirvtext") {
     std::ostringstream spirv_disasm_stream;
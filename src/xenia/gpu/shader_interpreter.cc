@@ -984,31 +984,17 @@ void ShaderInterpreter::StoreFetchResult(uint32_t dest, bool is_dest_relative,
   }
 }
 
-void ShaderInterpreter::ExecuteVertexFetchInstruction(
-    ucode::VertexFetchInstruction instr) {
+void ShaderInterpreter::FetchVertex(
+    const Memory& memory, TraceWriter* trace_writer,
+    ucode::VertexFetchInstruction instr,
+    const xenos::xe_gpu_vertex_fetch_t& fetch_constant,
+    uint32_t address_dwords, float* result) {
   // FIXME(Triang3l): Bit scan loops over components cause a link-time
   // optimization internal error in Visual Studio 2019, mainly in the format
   // unpacking. Using loops with up to 4 iterations here instead.
 
-  if (!instr.is_mini_fetch()) {
-    state_.vfetch_full_last = instr;
-  }
-
-  xenos::xe_gpu_vertex_fetch_t fetch_constant = register_file_.GetVertexFetch(
-      state_.vfetch_full_last.fetch_constant_index());
-
-  if (!instr.is_mini_fetch()) {
-    // Get the part of the address that depends on vfetch_full data.
-    uint32_t vertex_index = uint32_t(std::floor(
-        GetTempRegister(instr.src(),
-                        instr.is_src_relative())[instr.src_swizzle()] +
-        (instr.is_index_rounded() ? 0.5f : 0.0f)));
-    state_.vfetch_address_dwords =
-        instr.stride() * vertex_index + fetch_constant.address;
-  }
-
   // TODO(Triang3l): Find the default values for unused components.
-  float result[4] = {};
+  std::memset(result, 0, sizeof(float) * 4);
   uint32_t dest_swizzle = instr.dest_swizzle();
   uint32_t used_result_components = 0b0000;
   for (uint32_t i = 0; i < 4; ++i) {
@@ -1022,10 +1008,10 @@ void ShaderInterpreter::ExecuteVertexFetchInstruction(
   if (needed_dwords) {
     uint32_t data[4] = {};
     const uint32_t* memory_dwords =
-        reinterpret_cast<const uint32_t*>(memory_.physical_membase());
+        reinterpret_cast<const uint32_t*>(memory.physical_membase());
     uint32_t buffer_end_dwords = fetch_constant.address + fetch_constant.size;
     uint32_t dword_0_address_dwords =
-        uint32_t(int32_t(state_.vfetch_address_dwords) + instr.offset());
+        uint32_t(int32_t(address_dwords) + instr.offset());
     for (uint32_t i = 0; i < 4; ++i) {
       if (!(needed_dwords & (UINT32_C(1) << i))) {
         continue;
@@ -1034,8 +1020,8 @@ void ShaderInterpreter::ExecuteVertexFetchInstruction(
       uint32_t dword_address_dwords = dword_0_address_dwords + i;
       if (dword_address_dwords >= fetch_constant.address &&
           dword_address_dwords < buffer_end_dwords) {
-        if (trace_writer_) {
-          trace_writer_->WriteMemoryRead(
+        if (trace_writer) {
+          trace_writer->WriteMemoryRead(
               sizeof(uint32_t) * dword_address_dwords, sizeof(uint32_t));
         }
         dword_value = xenos::GpuSwap(memory_dwords[dword_address_dwords],
@@ -1214,6 +1200,30 @@ void ShaderInterpreter::ExecuteVertexFetchInstruction(
       result[i] *= exp_adjust_factor;
     }
   }
+}
+
+void ShaderInterpreter::ExecuteVertexFetchInstruction(
+    ucode::VertexFetchInstruction instr) {
+  if (!instr.is_mini_fetch()) {
+    state_.vfetch_full_last = instr;
+  }
+
+  xenos::xe_gpu_vertex_fetch_t fetch_constant = register_file_.GetVertexFetch(
+      state_.vfetch_full_last.fetch_constant_index());
+
+  if (!instr.is_mini_fetch()) {
+    // Get the part of the address that depends on vfetch_full data.
+    uint32_t vertex_index = uint32_t(std::floor(
+        GetTempRegister(instr.src(),
+                        instr.is_src_relative())[instr.src_swizzle()] +
+        (instr.is_index_rounded() ? 0.5f : 0.0f)));
+    state_.vfetch_address_dwords =
+        instr.stride() * vertex_index + fetch_constant.address;
+  }
+
+  float result[4];
+  FetchVertex(memory_, trace_writer_, instr, fetch_constant,
+              state_.vfetch_address_dwords, result);
 
   StoreFetchResult(instr.dest(), instr.is_dest_relative(), instr.dest_swizzle(),
                    result);
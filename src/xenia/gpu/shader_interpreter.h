@@ -69,6 +69,15 @@ class ShaderInterpreter {
 
   void Execute();
 
+  // Loads the vertex data for the fetch instruction from the address
+  // calculated from the index and the last full fetch, and converts it to
+  // floating-point, including the exponent adjustment. The components not used
+  // in the destination swizzle are zero. Shared with the VertexShaderJit.
+  static void FetchVertex(const Memory& memory, TraceWriter* trace_writer,
+                          ucode::VertexFetchInstruction instr,
+                          const xenos::xe_gpu_vertex_fetch_t& fetch_constant,
+                          uint32_t address_dwords, float* result);
+
  private:
   struct State {
     ucode::VertexFetchInstruction vfetch_full_last;
@@ -13,8 +13,18 @@
 
 #include "xenia/base/assert.h"
 #include "xenia/base/bit_range.h"
+#include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/profiling.h"
+#include "xenia/base/xxhash.h"
+
+DEFINE_bool(
+    gpu_skip_unchanged_uploads, false,
+    "Hash the guest memory uploaded to the GPU, and when the CPU writes to it, "
+    "skip reuploading of the pages and reloading of the textures whose "
+    "contents haven't actually changed (some games rewrite the same data every "
+    "frame). Costs hashing of all the uploaded data.",
+    "GPU");
 
 namespace xe {
 namespace gpu {
@@ -51,6 +61,11 @@ void SharedMemory::InitializeCommon() {
   memory_invalidation_callback_handle_ =
       memory_.RegisterPhysicalMemoryInvalidationCallback(
           MemoryInvalidationCallbackThunk, this);
+
+  if (cvars::gpu_skip_unchanged_uploads) {
+    page_content_hashes_.resize(kBufferSize >> page_size_log2_);
+    page_content_hashes_valid_.resize(num_system_page_flags_entries);
+  }
 }
 
 void SharedMemory::InitializeSparseHostGpuMemory(uint32_t granularity_log2) {
@@ -100,6 +115,10 @@ void SharedMemory::ShutdownCommon() {
   host_gpu_memory_sparse_allocated_.clear();
   host_gpu_memory_sparse_allocated_.shrink_to_fit();
   host_gpu_memory_sparse_granularity_log2_ = UINT32_MAX;
+  page_content_hashes_.clear();
+  page_content_hashes_.shrink_to_fit();
+  page_content_hashes_valid_.clear();
+  page_content_hashes_valid_.shrink_to_fit();
   memory::DeallocFixed(system_page_flags_valid_, 0,
                        memory::DeallocationType::kRelease);
   system_page_flags_valid_ = nullptr;
@@ -126,6 +145,16 @@ void SharedMemory::ClearCache() {
   }
   watch_range_pools_.clear();
   SetSystemPageBlocksValidWithGpuDataWritten();
+  ResetPageContentHashes(0, (kBufferSize - 1) >> page_size_log2_);
+}
+
+void SharedMemory::BeginFrame() {
+  if (page_content_hashes_.empty()) {
+    return;
+  }
+  COUNT_profile_set("gpu/shared_memory/unchanged_upload_skipped_kb",
+                    unchanged_upload_skipped_bytes_ >> 10);
+  unchanged_upload_skipped_bytes_ = 0;
 }
 
 void SharedMemory::SetSystemPageBlocksValidWithGpuDataWritten() {
@@ -296,6 +325,9 @@ void SharedMemory::RangeWrittenByGpu(uint32_t start, uint32_t length,
   // the texture.
   FireWatches(page_first, page_last, true);
 
+  // The GPU buffer doesn't contain a copy of the guest memory anymore.
+  ResetPageContentHashes(page_first, page_last);
+
   // Mark the range as valid (so pages are not reuploaded until modified by the
   // CPU) and watch it so the CPU can reuse it and this will be caught.
   MakeRangeValid(start, length, true, is_resolve);
@@ -431,9 +463,110 @@ bool SharedMemory::RequestRange(uint32_t start, uint32_t length,
     return true;
   }
 
+  if (!page_content_hashes_.empty()) {
+    return UploadChangedRanges(uploads, current_upload_range);
+  }
   return UploadRanges(uploads, current_upload_range);
 }
 
+bool SharedMemory::GetRangeContentHash(uint32_t start, uint32_t length,
+                                       uint64_t& hash_out) const {
+  if (page_content_hashes_.empty() || !length || start >= kBufferSize) {
+    return false;
+  }
+  length = std::min(length, kBufferSize - start);
+  uint32_t page_first = start >> page_size_log2_;
+  uint32_t page_last = (start + length - 1) >> page_size_log2_;
+  for (uint32_t i = page_first; i <= page_last; ++i) {
+    if (!(page_content_hashes_valid_[i >> 6] & (uint64_t(1) << (i & 63)))) {
+      return false;
+    }
+  }
+  hash_out = XXH3_64bits(&page_content_hashes_[page_first],
+                         sizeof(uint64_t) * (page_last - page_first + 1));
+  return true;
+}
+
+bool SharedMemory::UploadChangedRanges(
+    const std::pair<uint32_t, uint32_t>* upload_page_ranges,
+    uint32_t num_upload_ranges) {
+  // Like in UploadRanges, start watching the pages before reading them, so if
+  // they're modified while being hashed or copied, the invalidation won't be
+  // missed.
+  for (uint32_t i = 0; i < num_upload_ranges; ++i) {
+    MakeRangeValid(upload_page_ranges[i].first << page_size_log2_,
+                   upload_page_ranges[i].second << page_size_log2_, false,
+                   false);
+  }
+
+  uint32_t page_size = uint32_t(1) << page_size_log2_;
+  changed_upload_ranges_.clear();
+  for (uint32_t i = 0; i < num_upload_ranges; ++i) {
+    uint32_t range_page_first = upload_page_ranges[i].first;
+    uint32_t range_page_count = upload_page_ranges[i].second;
+    // Let UploadRanges handle inaccessible memory.
+    if (memory().GetPhysicalHeap()->QueryRangeAccess(
+            range_page_first << page_size_log2_,
+            ((range_page_first + range_page_count) << page_size_log2_) - 1) ==
+        xe::memory::PageAccess::kNoAccess) {
+      ResetPageContentHashes(range_page_first,
+                             range_page_first + range_page_count - 1);
+      changed_upload_ranges_.push_back(upload_page_ranges[i]);
+      continue;
+    }
+    for (uint32_t page = range_page_first;
+         page < range_page_first + range_page_count; ++page) {
+      uint64_t hash = XXH3_64bits(
+          memory().TranslatePhysical(page << page_size_log2_), page_size);
+      uint64_t page_bit = uint64_t(1) << (page & 63);
+      uint64_t& hashes_valid = page_content_hashes_valid_[page >> 6];
+      if ((hashes_valid & page_bit) && page_content_hashes_[page] == hash) {
+        unchanged_upload_skipped_bytes_ += page_size;
+        continue;
+      }
+      page_content_hashes_[page] = hash;
+      hashes_valid |= page_bit;
+      if (!changed_upload_ranges_.empty() &&
+          changed_upload_ranges_.back().first +
+                  changed_upload_ranges_.back().second ==
+              page) {
+        ++changed_upload_ranges_.back().second;
+      } else {
+        changed_upload_ranges_.emplace_back(page, 1);
+      }
+    }
+  }
+  if (changed_upload_ranges_.empty()) {
+    return true;
+  }
+
+  bool uploaded = UploadRanges(changed_upload_ranges_.data(),
+                               uint32_t(changed_upload_ranges_.size()));
+
+  // If a page was modified after hashing, or couldn't be uploaded, the hash
+  // doesn't necessarily describe what's in the GPU buffer.
+  auto global_lock = global_critical_region_.Acquire();
+  for (const std::pair<uint32_t, uint32_t>& range : changed_upload_ranges_) {
+    for (uint32_t page = range.first; page < range.first + range.second;
+         ++page) {
+      uint64_t page_bit = uint64_t(1) << (page & 63);
+      if (!uploaded || !(system_page_flags_valid_[page >> 6] & page_bit)) {
+        page_content_hashes_valid_[page >> 6] &= ~page_bit;
+      }
+    }
+  }
+  return uploaded;
+}
+
+void SharedMemory::ResetPageContentHashes(uint32_t page_first,
+                                          uint32_t page_last) {
+  if (page_content_hashes_valid_.empty()) {
+    return;
+  }
+  xe::bit_range::ClearRange(page_content_hashes_valid_.data(), page_first,
+                            page_last - page_first + 1);
+}
+
 template <typename T>
 XE_FORCEINLINE XE_NOALIAS static T mod_shift_left(T value, uint32_t by) {
 #if XE_ARCH_AMD64 == 1
@@ -609,6 +742,9 @@ void SharedMemory::PrepareForTraceDownload() {
   assert_true(trace_download_ranges_.empty());
   assert_zero(trace_download_page_count_);
 
+  // Uploads are written to the trace, so they must not be skipped.
+  ResetPageContentHashes(0, (kBufferSize - 1) >> page_size_log2_);
+
   // Invalidate the entire memory CPU->GPU memory copy so all the history
   // doesn't have to be written into every frame trace, and collect the list of
   // ranges with data modified on the GPU.
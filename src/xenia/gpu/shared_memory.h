@@ -27,6 +27,8 @@ class SharedMemory {
   // Call in the implementation-specific ClearCache.
   virtual void ClearCache();
   virtual void SetSystemPageBlocksValidWithGpuDataWritten();
+  // Publishes the statistics of the previous frame.
+  void BeginFrame();
 
   typedef void (*GlobalWatchCallback)(
       const global_unique_lock_type& global_lock, void* context,
@@ -74,6 +76,15 @@ class SharedMemory {
   bool RequestRange(uint32_t start, uint32_t length,
                     bool* any_data_resolved_out = nullptr);
 
+  // If hashing of the uploaded data is enabled, returns a hash of the contents
+  // of the pages in the range in the GPU buffer, which must have been requested
+  // - so, for instance, a texture loaded from the range doesn't need to be
+  // reloaded if the guest has rewritten its data with the same values. Returns
+  // false if the contents of any page in the range is not known, such as if
+  // it has been written by the GPU.
+  bool GetRangeContentHash(uint32_t start, uint32_t length,
+                           uint64_t& hash_out) const;
+
   void TryFindUploadRange(const uint32_t& block_first,
                           const uint32_t& block_last,
                           const uint32_t& page_first, const uint32_t& page_last,
@@ -174,6 +185,21 @@ class SharedMemory {
   uint32_t page_size_log2_;
 
   bool EnsureHostGpuMemoryAllocated(uint32_t start, uint32_t length);
+
+  // Hashes the pages to be uploaded, and uploads only those whose contents is
+  // different than in the GPU buffer.
+  bool UploadChangedRanges(
+      const std::pair<uint32_t, uint32_t>* upload_page_ranges,
+      uint32_t num_upload_ranges);
+  void ResetPageContentHashes(uint32_t page_first, uint32_t page_last);
+  // If gpu_skip_unchanged_uploads is enabled, XXH3 hashes of each page in the
+  // GPU buffer, and whether each hash is known to match the contents of the
+  // buffer. Accessed only by the GPU emulation thread, thus not protected by
+  // the global critical region.
+  std::vector<uint64_t> page_content_hashes_;
+  std::vector<uint64_t> page_content_hashes_valid_;
+  std::vector<std::pair<uint32_t, uint32_t>> changed_upload_ranges_;
+  uint64_t unchanged_upload_skipped_bytes_ = 0;
   uint32_t host_gpu_memory_sparse_granularity_log2_ = UINT32_MAX;
   std::vector<uint64_t> host_gpu_memory_sparse_allocated_;
   uint32_t host_gpu_memory_sparse_allocations_ = 0;
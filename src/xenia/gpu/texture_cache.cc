@@ -255,6 +255,10 @@ void TextureCache::BeginFrame() {
   // sure bindings are reset so a new attempt will surely be made if the texture
   // is requested again.
   ResetTextureBindings();
+
+  COUNT_profile_set("gpu/texture_cache/unchanged_load_skipped_kb",
+                    unchanged_load_skipped_bytes_ >> 10);
+  unchanged_load_skipped_bytes_ = 0;
 }
 
 void TextureCache::MarkRangeAsResolved(uint32_t start_unscaled,
@@ -563,6 +567,17 @@ void TextureCache::Texture::WatchCallback(
   }
 }
 
+bool TextureCache::Texture::UpdateContentHash(bool is_mip, bool hash_known,
+                                              uint64_t hash) {
+  uint64_t& content_hash = is_mip ? mips_content_hash_ : base_content_hash_;
+  bool& content_hash_known =
+      is_mip ? mips_content_hash_known_ : base_content_hash_known_;
+  bool unchanged = hash_known && content_hash_known && content_hash == hash;
+  content_hash = hash;
+  content_hash_known = hash_known;
+  return unchanged;
+}
+
 void TextureCache::WatchCallback(const global_unique_lock_type& global_lock,
                                  void* context, void* data, uint64_t argument,
                                  bool invalidated_by_gpu) {
@@ -733,9 +748,12 @@ void TextureCache::LoadTexturesData(Texture** textures, uint32_t n_textures) {
     }
 
     // Actually load the texture data.
-    if (!LoadTextureDataFromResidentMemoryImpl(
-            texture, (index_base_outdated & (1ULL << i)) != 0,
-            (index_mips_outdated & (1ULL << i)) != 0)) {
+    bool load_base = (index_base_outdated & (1ULL << i)) != 0;
+    bool load_mips = (index_mips_outdated & (1ULL << i)) != 0;
+    SkipUnchangedTextureDataLoad(texture, load_base, load_mips);
+    if ((load_base || load_mips) &&
+        !LoadTextureDataFromResidentMemoryImpl(texture, load_base, load_mips)) {
+      texture.ResetContentHashes();
       continue;
     }
 
@@ -829,8 +847,11 @@ bool TextureCache::LoadTextureData(Texture& texture) {
   }
 
   // Actually load the texture data.
-  if (!LoadTextureDataFromResidentMemoryImpl(texture, base_outdated,
-                                             mips_outdated)) {
+  bool load_base = base_outdated, load_mips = mips_outdated;
+  SkipUnchangedTextureDataLoad(texture, load_base, load_mips);
+  if ((load_base || load_mips) &&
+      !LoadTextureDataFromResidentMemoryImpl(texture, load_base, load_mips)) {
+    texture.ResetContentHashes();
     return false;
   }
 
@@ -853,6 +874,35 @@ bool TextureCache::LoadTextureData(Texture& texture) {
   return true;
 }
 
+void TextureCache::SkipUnchangedTextureDataLoad(Texture& texture,
+                                                bool& load_base,
+                                                bool& load_mips) {
+  TextureKey texture_key = texture.key();
+  // Scaled resolve textures are not loaded from the shared memory.
+  if (texture_key.scaled_resolve) {
+    return;
+  }
+  uint64_t hash = 0;
+  if (load_base) {
+    bool hash_known = shared_memory().GetRangeContentHash(
+        texture_key.base_page << 12,
+        xe::align(texture.GetGuestBaseSize(), UINT32_C(16)), hash);
+    if (texture.UpdateContentHash(false, hash_known, hash)) {
+      load_base = false;
+      unchanged_load_skipped_bytes_ += texture.GetGuestBaseSize();
+    }
+  }
+  if (load_mips) {
+    bool hash_known = shared_memory().GetRangeContentHash(
+        texture_key.mip_page << 12,
+        xe::align(texture.GetGuestMipsSize(), UINT32_C(16)), hash);
+    if (texture.UpdateContentHash(true, hash_known, hash)) {
+      load_mips = false;
+      unchanged_load_skipped_bytes_ += texture.GetGuestMipsSize();
+    }
+  }
+}
+
 void TextureCache::BindingInfoFromFetchConstant(
     const xenos::xe_gpu_texture_fetch_t& fetch, TextureKey& key_out,
     uint8_t* swizzled_signs_out) {
@@ -267,6 +267,15 @@ class TextureCache {
 
     void WatchCallback(const global_unique_lock_type& global_lock, bool is_mip);
 
+    // Replaces the hash of the shared memory data the base or the mips are
+    // loaded from, returning whether the new hash is known and the same as the
+    // previous one, so reloading can be skipped.
+    bool UpdateContentHash(bool is_mip, bool hash_known, uint64_t hash);
+    void ResetContentHashes() {
+      base_content_hash_known_ = false;
+      mips_content_hash_known_ = false;
+    }
+
     // For LRU caching - updates the last usage frame and moves the texture to
     // the end of the usage queue. Must be called any time the texture is
     // referenced by any GPU work in the implementation to make sure it's not
@@ -314,6 +323,12 @@ class TextureCache {
     // Watch handles for the memory ranges.
     SharedMemory::WatchHandle base_watch_handle_ = nullptr;
     SharedMemory::WatchHandle mips_watch_handle_ = nullptr;
+
+    // SharedMemory::GetRangeContentHash of the loaded data, if known.
+    uint64_t base_content_hash_ = 0;
+    uint64_t mips_content_hash_ = 0;
+    bool base_content_hash_known_ = false;
+    bool mips_content_hash_known_ = false;
   };
 
   // Rules of data access in load shaders:
@@ -570,6 +585,11 @@ class TextureCache {
   }
   bool LoadTextureData(Texture& texture);
   void LoadTexturesData(Texture** textures, uint32_t n_textures);
+  // Drops loading of the outdated base or mips if the shared memory pages they
+  // are loaded from, requested before this, have been rewritten by the guest
+  // with the same data.
+  void SkipUnchangedTextureDataLoad(Texture& texture, bool& load_base,
+                                    bool& load_mips);
   // Writes the texture data (for base, mips or both - but not neither) from the
   // shared memory or the scaled resolve memory. The shared memory management is
   // done outside this function, the implementation just needs to load the data
@@ -648,6 +668,9 @@ class TextureCache {
 
   uint64_t textures_total_host_memory_usage_ = 0;
 
+  // For the per-frame statistics of gpu_skip_unchanged_uploads.
+  uint64_t unchanged_load_skipped_bytes_ = 0;
+
   Texture* texture_used_first_ = nullptr;
   Texture* texture_used_last_ = nullptr;
 
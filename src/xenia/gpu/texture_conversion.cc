@@ -37,7 +37,7 @@ void CopySwapBlock(xenos::Endian endian, void* output, const void* input,
       break;
     case xenos::Endian::k16in32:  // Swap high and low 16 bits within a 32 bit
                                   // word
-      xe::copy_and_swap_16_in_32_unaligned(output, input, length);
+      xe::copy_and_swap_16_in_32_unaligned(output, input, length / 4);
       break;
     default:
     case xenos::Endian::kNone:
@@ -0,0 +1,1139 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/gpu/vertex_shader_jit.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/platform.h"
+#include "xenia/gpu/ucode.h"
+#include "xenia/gpu/xenos.h"
+
+#if XE_ARCH_AMD64
+#include "third_party/xbyak/xbyak/xbyak.h"
+#include "third_party/xbyak/xbyak/xbyak_util.h"
+#endif  // XE_ARCH_AMD64
+
+namespace xe {
+namespace gpu {
+
+struct alignas(32) VertexShaderJit::Context {
+  // Only the non-relative temporary registers, which are addressed with 6 bits
+  // in the instructions, are accessible.
+  static constexpr uint32_t kTempRegisterCount = 64;
+  static constexpr uint32_t kExportRegisterCount = 64;
+  // Non-relative float constants, also addressed with 8 bits.
+  static constexpr uint32_t kFloatConstantCount = 256;
+
+  // Every component is a vector of the values for all the lanes.
+  alignas(32) float temps[kTempRegisterCount][4][kLaneCount];
+  alignas(32) float exports[kExportRegisterCount][4][kLaneCount];
+  alignas(32) float float_constants[kFloatConstantCount][4][kLaneCount];
+  alignas(32) float vector_operands[3][4][kLaneCount];
+  alignas(32) float scalar_operands[2][kLaneCount];
+  alignas(32) float previous_scalar[kLaneCount];
+
+  // Constants for the generated code.
+  alignas(32) uint32_t sign_mask[kLaneCount];
+  alignas(32) uint32_t absolute_mask[kLaneCount];
+  alignas(32) uint32_t exponent_mask[kLaneCount];
+  alignas(32) float one[kLaneCount];
+  alignas(32) float infinity[kLaneCount];
+  alignas(32) float negative_infinity[kLaneCount];
+  alignas(32) float flt_max[kLaneCount];
+  alignas(32) float negative_flt_max[kLaneCount];
+
+  // Control flow is uniform across the lanes, thus the masks are too.
+  uint32_t export_masks[kExportRegisterCount];
+  uint32_t bool_constants[8];
+
+  ucode::VertexFetchInstruction vfetch_full_last;
+  uint32_t vfetch_address_dwords[kLaneCount];
+
+  uint32_t vertex_count;
+  VertexShaderJit* jit;
+  const Program* program;
+};
+
+#if XE_ARCH_AMD64
+
+class VertexShaderJit::Emitter : public Xbyak::CodeGenerator {
+ public:
+  Emitter() : Xbyak::CodeGenerator(kInitialCodeSize, Xbyak::AutoGrow) {}
+
+  // Returns false if the shader uses features not supported by the compiler.
+  bool EmitShader(const Shader& shader, Program& program);
+
+ private:
+  static constexpr size_t kInitialCodeSize = 16384;
+  // Shadow space for the helper calls on Windows, keeping the stack aligned
+  // after pushing rbx.
+  static constexpr uint32_t kStackSize = 32;
+
+  // vcmpps predicates - ordered and quiet, like the C++ comparisons, except for
+  // not-equal which is true for NaN.
+  static constexpr uint8_t kCompareEq = 0x00;
+  static constexpr uint8_t kCompareNeq = 0x04;
+  static constexpr uint8_t kCompareLt = 0x11;
+  static constexpr uint8_t kCompareLe = 0x12;
+  // vroundps modes, with the precision exception suppressed.
+  static constexpr uint8_t kRoundFloor = 0b1001;
+  static constexpr uint8_t kRoundTrunc = 0b1011;
+
+  static constexpr size_t TempOffset(uint32_t index, uint32_t component) {
+    return offsetof(Context, temps) +
+           sizeof(float) * kLaneCount * (4 * index + component);
+  }
+  static constexpr size_t ExportOffset(uint32_t index, uint32_t component) {
+    return offsetof(Context, exports) +
+           sizeof(float) * kLaneCount * (4 * index + component);
+  }
+  static constexpr size_t FloatConstantOffset(uint32_t index,
+                                              uint32_t component) {
+    return offsetof(Context, float_constants) +
+           sizeof(float) * kLaneCount * (4 * index + component);
+  }
+  static constexpr size_t VectorOperandOffset(uint32_t operand,
+                                              uint32_t component) {
+    return offsetof(Context, vector_operands) +
+           sizeof(float) * kLaneCount * (4 * operand + component);
+  }
+  static constexpr size_t ScalarOperandOffset(uint32_t operand) {
+    return offsetof(Context, scalar_operands) +
+           sizeof(float) * kLaneCount * operand;
+  }
+
+  Xbyak::Address Field(size_t offset) {
+    return yword[rbx + uint32_t(offset)];
+  }
+
+  static bool IsVectorOpcodeSupported(ucode::AluVectorOpcode opcode);
+  static bool IsScalarOpcodeSupported(ucode::AluScalarOpcode opcode);
+
+  bool EmitExec(const ucode::ControlFlowExecInstruction& cf_exec,
+                Program& program);
+  bool EmitFetchInstruction(const ucode::FetchInstruction& instr,
+                            Program& program);
+  bool EmitAluInstruction(const ucode::AluInstruction& instr,
+                          Program& program);
+
+  // Loads an operand component, flushing denormals and applying the modifiers
+  // like the interpreter does, into the operand storage in the context.
+  void EmitLoadOperand(size_t dest_offset, size_t source_offset, bool absolute,
+                       bool negate);
+  size_t UseFloatConstant(uint32_t index, uint32_t component,
+                          Program& program);
+
+  // The following write the result to ymm0, using ymm1...ymm3 as temporaries.
+  // Direct3D 9 multiplication (0 or denormal * anything = +0).
+  void EmitMulZero(const Xbyak::Address& a, const Xbyak::Address& b);
+  // a >= b ? a : b.
+  void EmitMax(const Xbyak::Address& a, const Xbyak::Address& b);
+  // a < b ? a : b.
+  void EmitMin(const Xbyak::Address& a, const Xbyak::Address& b);
+  // float(a <predicate> b).
+  void EmitSet(const Xbyak::Address& a, const Xbyak::Address& b,
+               uint8_t predicate);
+  // float(a <predicate> 0).
+  void EmitSetZero(const Xbyak::Address& a, uint8_t predicate);
+  // a - floor(a).
+  void EmitFrc(const Xbyak::Address& a);
+  // Replaces infinities in ymm0 with the largest finite values.
+  void EmitClampInfinityToMax();
+  // Replaces infinities in ymm0 with zeros of the same sign.
+  void EmitClampInfinityToZero();
+  // Saturates ymm0, returning 0 for NaN, like xe::saturate.
+  void EmitSaturate();
+
+  void EmitCall(const void* function, uint32_t argument);
+
+  const uint32_t* ucode_ = nullptr;
+  size_t ucode_dword_count_ = 0;
+  Xbyak::Label exit_label_;
+};
+
+#endif  // XE_ARCH_AMD64
+
+struct VertexShaderJit::Program {
+#if XE_ARCH_AMD64
+  std::unique_ptr<Emitter> emitter;
+#endif  // XE_ARCH_AMD64
+  void (*function)(Context* context) = nullptr;
+  // Non-relative float constants to load from the register file.
+  std::vector<uint32_t> float_constants;
+  std::vector<ucode::VertexFetchInstruction> vertex_fetches;
+  // Allocations are control flow instructions, and with only conditional
+  // execs, they're the same for all vertices.
+  std::vector<std::pair<ucode::AllocType, uint32_t>> allocs;
+};
+
+#if XE_ARCH_AMD64
+
+bool VertexShaderJit::Emitter::EmitShader(const Shader& shader,
+                                          Program& program) {
+  ucode_ = shader.ucode_dwords();
+  ucode_dword_count_ = shader.ucode_dword_count();
+
+#if XE_PLATFORM_WIN32
+  const Xbyak::Reg64& context_arg = rcx;
+#else
+  const Xbyak::Reg64& context_arg = rdi;
+#endif  // XE_PLATFORM_WIN32
+  push(rbx);
+  sub(rsp, kStackSize);
+  mov(rbx, context_arg);
+
+  bool shader_ended = false;
+  for (uint32_t cf_index = 0; !shader_ended; ++cf_index) {
+    // Without jumps, the control flow is linear - if the end of the ucode is
+    // reached without an unconditional exec_end, the shader is malformed.
+    if (3 * (cf_index >> 1) + 3 > ucode_dword_count_) {
+      return false;
+    }
+    const uint32_t* cf_pair = &ucode_[3 * (cf_index >> 1)];
+    ucode::ControlFlowInstruction cf_instr;
+    if (cf_index & 1) {
+      cf_instr.dword_0 = (cf_pair[1] >> 16) | (cf_pair[2] << 16);
+      cf_instr.dword_1 = cf_pair[2] >> 16;
+    } else {
+      cf_instr.dword_0 = cf_pair[0];
+      cf_instr.dword_1 = cf_pair[1] & 0xFFFF;
+    }
+
+    ucode::ControlFlowOpcode cf_opcode = cf_instr.opcode();
+    switch (cf_opcode) {
+      case ucode::ControlFlowOpcode::kNop:
+      case ucode::ControlFlowOpcode::kMarkVsFetchDone:
+        break;
+
+      case ucode::ControlFlowOpcode::kExec:
+      case ucode::ControlFlowOpcode::kExecEnd: {
+        if (!EmitExec(
+                *reinterpret_cast<const ucode::ControlFlowExecInstruction*>(
+                    &cf_instr),
+                program)) {
+          return false;
+        }
+        shader_ended = cf_opcode == ucode::ControlFlowOpcode::kExecEnd;
+      } break;
+
+      case ucode::ControlFlowOpcode::kCondExec:
+      case ucode::ControlFlowOpcode::kCondExecEnd:
+      case ucode::ControlFlowOpcode::kCondExecPredClean:
+      case ucode::ControlFlowOpcode::kCondExecPredCleanEnd: {
+        const ucode::ControlFlowCondExecInstruction& cf_cond_exec =
+            *reinterpret_cast<const ucode::ControlFlowCondExecInstruction*>(
+                &cf_instr);
+        uint32_t bool_address = cf_cond_exec.bool_address();
+        Xbyak::Label skip_label;
+        test(dword[rbx + uint32_t(offsetof(Context, bool_constants) +
+                                  sizeof(uint32_t) * (bool_address >> 5))],
+             UINT32_C(1) << (bool_address & 31));
+        if (cf_cond_exec.condition()) {
+          jz(skip_label, T_NEAR);
+        } else {
+          jnz(skip_label, T_NEAR);
+        }
+        if (!EmitExec(
+                *reinterpret_cast<const ucode::ControlFlowExecInstruction*>(
+                    &cf_instr),
+                program)) {
+          return false;
+        }
+        if (ucode::DoesControlFlowOpcodeEndShader(cf_opcode)) {
+          jmp(exit_label_, T_NEAR);
+        }
+        L(skip_label);
+      } break;
+
+      case ucode::ControlFlowOpcode::kAlloc: {
+        const ucode::ControlFlowAllocInstruction& cf_alloc =
+            *reinterpret_cast<const ucode::ControlFlowAllocInstruction*>(
+                &cf_instr);
+        program.allocs.emplace_back(cf_alloc.alloc_type(), cf_alloc.size());
+      } break;
+
+      default:
+        // Predication, loops, calls and jumps.
+        return false;
+    }
+  }
+
+  L(exit_label_);
+  vzeroupper();
+  add(rsp, kStackSize);
+  pop(rbx);
+  ret();
+  return true;
+}
+
+bool VertexShaderJit::Emitter::EmitExec(
+    const ucode::ControlFlowExecInstruction& cf_exec, Program& program) {
+  for (uint32_t exec_index = 0; exec_index < cf_exec.count(); ++exec_index) {
+    size_t instruction_offset = 3 * (cf_exec.address() + exec_index);
+    if (instruction_offset + 3 > ucode_dword_count_) {
+      return false;
+    }
+    const uint32_t* exec_instruction = &ucode_[instruction_offset];
+    if ((cf_exec.sequence() >> (exec_index << 1)) & 0b01) {
+      if (!EmitFetchInstruction(
+              *reinterpret_cast<const ucode::FetchInstruction*>(
+                  exec_instruction),
+              program)) {
+        return false;
+      }
+    } else {
+      if (!EmitAluInstruction(
+              *reinterpret_cast<const ucode::AluInstruction*>(
+                  exec_instruction),
+              program)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool VertexShaderJit::Emitter::EmitFetchInstruction(
+    const ucode::FetchInstruction& instr, Program& program) {
+  if (instr.is_predicated() || instr.is_dest_relative()) {
+    return false;
+  }
+  if (instr.opcode() == ucode::FetchOpcode::kVertexFetch) {
+    const ucode::VertexFetchInstruction& vertex_fetch = instr.vertex_fetch();
+    if (!vertex_fetch.is_mini_fetch() && vertex_fetch.is_src_relative()) {
+      return false;
+    }
+    uint32_t fetch_index = uint32_t(program.vertex_fetches.size());
+    program.vertex_fetches.push_back(vertex_fetch);
+    EmitCall(reinterpret_cast<const void*>(&VertexFetchThunk), fetch_index);
+    return true;
+  }
+  // Texture fetching is not supported, like in the interpreter, the result is
+  // zero.
+  vxorps(ymm0, ymm0, ymm0);
+  vmovaps(ymm1, Field(offsetof(Context, one)));
+  for (uint32_t i = 0; i < 4; ++i) {
+    switch (
+        ucode::GetFetchDestinationComponentSwizzle(instr.dest_swizzle(), i)) {
+      case ucode::FetchDestinationSwizzle::kKeep:
+        break;
+      case ucode::FetchDestinationSwizzle::k1:
+        vmovaps(Field(TempOffset(instr.dest(), i)), ymm1);
+        break;
+      default:
+        vmovaps(Field(TempOffset(instr.dest(), i)), ymm0);
+        break;
+    }
+  }
+  return true;
+}
+
+bool VertexShaderJit::Emitter::IsVectorOpcodeSupported(
+    ucode::AluVectorOpcode opcode) {
+  switch (opcode) {
+    case ucode::AluVectorOpcode::kAdd:
+    case ucode::AluVectorOpcode::kMul:
+    case ucode::AluVectorOpcode::kMax:
+    case ucode::AluVectorOpcode::kMin:
+    case ucode::AluVectorOpcode::kSeq:
+    case ucode::AluVectorOpcode::kSgt:
+    case ucode::AluVectorOpcode::kSge:
+    case ucode::AluVectorOpcode::kSne:
+    case ucode::AluVectorOpcode::kFrc:
+    case ucode::AluVectorOpcode::kTrunc:
+    case ucode::AluVectorOpcode::kFloor:
+    case ucode::AluVectorOpcode::kMad:
+    case ucode::AluVectorOpcode::kCndEq:
+    case ucode::AluVectorOpcode::kCndGe:
+    case ucode::AluVectorOpcode::kCndGt:
+    case ucode::AluVectorOpcode::kDp4:
+    case ucode::AluVectorOpcode::kDp3:
+    case ucode::AluVectorOpcode::kDp2Add:
+    case ucode::AluVectorOpcode::kDst:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool VertexShaderJit::Emitter::IsScalarOpcodeSupported(
+    ucode::AluScalarOpcode opcode) {
+  switch (opcode) {
+    case ucode::AluScalarOpcode::kAdds:
+    case ucode::AluScalarOpcode::kAddsPrev:
+    case ucode::AluScalarOpcode::kMuls:
+    case ucode::AluScalarOpcode::kMulsPrev:
+    case ucode::AluScalarOpcode::kMaxs:
+    case ucode::AluScalarOpcode::kMins:
+    case ucode::AluScalarOpcode::kSeqs:
+    case ucode::AluScalarOpcode::kSgts:
+    case ucode::AluScalarOpcode::kSges:
+    case ucode::AluScalarOpcode::kSnes:
+    case ucode::AluScalarOpcode::kFrcs:
+    case ucode::AluScalarOpcode::kTruncs:
+    case ucode::AluScalarOpcode::kFloors:
+    case ucode::AluScalarOpcode::kRcpc:
+    case ucode::AluScalarOpcode::kRcpf:
+    case ucode::AluScalarOpcode::kRcp:
+    case ucode::AluScalarOpcode::kRsqc:
+    case ucode::AluScalarOpcode::kRsqf:
+    case ucode::AluScalarOpcode::kRsq:
+    case ucode::AluScalarOpcode::kSubs:
+    case ucode::AluScalarOpcode::kSubsPrev:
+    case ucode::AluScalarOpcode::kMulsc0:
+    case ucode::AluScalarOpcode::kMulsc1:
+    case ucode::AluScalarOpcode::kAddsc0:
+    case ucode::AluScalarOpcode::kAddsc1:
+    case ucode::AluScalarOpcode::kSubsc0:
+    case ucode::AluScalarOpcode::kSubsc1:
+    case ucode::AluScalarOpcode::kSqrt:
+    case ucode::AluScalarOpcode::kRetainPrev:
+      return true;
+    default:
+      // Transcendental functions are not reproducible exactly with SIMD, and
+      // predicate and address register changes are not supported.
+      return false;
+  }
+}
+
+bool VertexShaderJit::Emitter::EmitAluInstruction(
+    const ucode::AluInstruction& instr, Program& program) {
+  if (instr.is_predicated()) {
+    return false;
+  }
+
+  ucode::AluVectorOpcode vector_opcode = instr.vector_opcode();
+  const ucode::AluVectorOpcodeInfo& vector_opcode_info =
+      ucode::GetAluVectorOpcodeInfo(vector_opcode);
+  uint32_t vector_result_write_mask = instr.GetVectorOpResultWriteMask();
+  bool vector_executed =
+      vector_result_write_mask || vector_opcode_info.changed_state;
+  ucode::AluScalarOpcode scalar_opcode = instr.scalar_opcode();
+  const ucode::AluScalarOpcodeInfo& scalar_opcode_info =
+      ucode::GetAluScalarOpcodeInfo(scalar_opcode);
+  uint32_t scalar_result_write_mask = instr.GetScalarOpResultWriteMask();
+
+  // Check everything before emitting anything.
+  if (vector_executed && !IsVectorOpcodeSupported(vector_opcode)) {
+    return false;
+  }
+  if (!IsScalarOpcodeSupported(scalar_opcode)) {
+    return false;
+  }
+  if (vector_executed) {
+    for (uint32_t i = 0; i < 3; ++i) {
+      if (!vector_opcode_info.operand_components_used[i]) {
+        continue;
+      }
+      if (instr.src_is_temp(1 + i)
+              ? ucode::AluInstruction::is_src_temp_relative(
+                    instr.src_reg(1 + i))
+              : instr.src_const_is_addressed(1 + i)) {
+        return false;
+      }
+    }
+  }
+  switch (scalar_opcode_info.operand_count) {
+    case 1:
+      if (instr.src_is_temp(3)
+              ? ucode::AluInstruction::is_src_temp_relative(instr.src_reg(3))
+              : instr.src_const_is_addressed(3)) {
+        return false;
+      }
+      break;
+    case 2:
+      if (instr.src_const_is_addressed(3)) {
+        return false;
+      }
+      break;
+  }
+  if (!instr.is_export() &&
+      ((vector_result_write_mask && instr.is_vector_dest_relative()) ||
+       (scalar_result_write_mask && instr.is_scalar_dest_relative()))) {
+    return false;
+  }
+
+  // Load the vector operands.
+  if (vector_executed) {
+    for (uint32_t i = 0; i < 3; ++i) {
+      uint32_t components_used = vector_opcode_info.operand_components_used[i];
+      if (!components_used) {
+        continue;
+      }
+      uint32_t src_register = instr.src_reg(1 + i);
+      bool src_is_temp = instr.src_is_temp(1 + i);
+      bool src_absolute =
+          src_is_temp &&
+          ucode::AluInstruction::is_src_temp_value_absolute(src_register);
+      uint32_t src_swizzle = instr.src_swizzle(1 + i);
+      for (uint32_t j = 0; j < 4; ++j) {
+        if (!(components_used & (UINT32_C(1) << j))) {
+          continue;
+        }
+        uint32_t component =
+            ucode::AluInstruction::GetSwizzledComponentIndex(src_swizzle, j);
+        size_t source_offset =
+            src_is_temp
+                ? TempOffset(ucode::AluInstruction::src_temp_reg(src_register),
+                             component)
+                : UseFloatConstant(src_register, component, program);
+        EmitLoadOperand(VectorOperandOffset(i, j), source_offset, src_absolute,
+                        instr.src_negate(1 + i));
+      }
+    }
+  }
+
+  // Load the scalar operands.
+  uint32_t scalar_src_swizzle = instr.src_swizzle(3);
+  switch (scalar_opcode_info.operand_count) {
+    case 1: {
+      // r#/c#.w or r#/c#.wx.
+      uint32_t src_register = instr.src_reg(3);
+      bool src_is_temp = instr.src_is_temp(3);
+      bool src_absolute =
+          src_is_temp &&
+          ucode::AluInstruction::is_src_temp_value_absolute(src_register);
+      uint32_t component_count =
+          scalar_opcode_info.single_operand_is_two_component ? 2 : 1;
+      for (uint32_t i = 0; i < component_count; ++i) {
+        uint32_t component = ucode::AluInstruction::GetSwizzledComponentIndex(
+            scalar_src_swizzle, (3 + i) & 3);
+        size_t source_offset =
+            src_is_temp
+                ? TempOffset(ucode::AluInstruction::src_temp_reg(src_register),
+                             component)
+                : UseFloatConstant(src_register, component, program);
+        EmitLoadOperand(ScalarOperandOffset(i), source_offset, src_absolute,
+                        instr.src_negate(3));
+      }
+    } break;
+    case 2: {
+      // c#.w and r#.x. Like in the interpreter, the absolute value modifier is
+      // not applied.
+      EmitLoadOperand(
+          ScalarOperandOffset(0),
+          UseFloatConstant(instr.src_reg(3),
+                           ucode::AluInstruction::GetSwizzledComponentIndex(
+                               scalar_src_swizzle, 3),
+                           program),
+          false, instr.src_negate(3));
+      EmitLoadOperand(
+          ScalarOperandOffset(1),
+          TempOffset(instr.scalar_const_reg_op_src_temp_reg(),
+                     ucode::AluInstruction::GetSwizzledComponentIndex(
+                         scalar_src_swizzle, 0)),
+          false, instr.src_negate(3));
+    } break;
+  }
+
+  uint32_t vector_dest = instr.vector_dest();
+  auto vector_dest_offset = [&instr, vector_dest](uint32_t component) {
+    return instr.is_export() ? ExportOffset(vector_dest, component)
+                             : TempOffset(vector_dest, component);
+  };
+
+  // Vector operation.
+  if (vector_result_write_mask) {
+    auto a = [this](uint32_t component) {
+      return Field(VectorOperandOffset(0, component));
+    };
+    auto b = [this](uint32_t component) {
+      return Field(VectorOperandOffset(1, component));
+    };
+    auto c = [this](uint32_t component) {
+      return Field(VectorOperandOffset(2, component));
+    };
+    bool replicate_result_x = vector_opcode == ucode::AluVectorOpcode::kDp4 ||
+                              vector_opcode == ucode::AluVectorOpcode::kDp3 ||
+                              vector_opcode == ucode::AluVectorOpcode::kDp2Add;
+    if (replicate_result_x) {
+      // Doing the addition even for zero operands because +0 + -0 must be +0.
+      uint32_t component_count =
+          vector_opcode == ucode::AluVectorOpcode::kDp4
+              ? 4
+              : (vector_opcode == ucode::AluVectorOpcode::kDp3 ? 3 : 2);
+      vxorps(ymm4, ymm4, ymm4);
+      for (uint32_t i = 0; i < component_count; ++i) {
+        EmitMulZero(a(i), b(i));
+        vaddps(ymm4, ymm4, ymm0);
+      }
+      if (vector_opcode == ucode::AluVectorOpcode::kDp2Add) {
+        vaddps(ymm4, ymm4, c(0));
+      }
+      vmovaps(ymm0, ymm4);
+      if (instr.vector_clamp()) {
+        EmitSaturate();
+      }
+      for (uint32_t i = 0; i < 4; ++i) {
+        if (vector_result_write_mask & (UINT32_C(1) << i)) {
+          vmovaps(Field(vector_dest_offset(i)), ymm0);
+        }
+      }
+    } else {
+      for (uint32_t i = 0; i < 4; ++i) {
+        if (!(vector_result_write_mask & (UINT32_C(1) << i))) {
+          continue;
+        }
+        switch (vector_opcode) {
+          case ucode::AluVectorOpcode::kAdd:
+            vmovaps(ymm0, a(i));
+            vaddps(ymm0, ymm0, b(i));
+            break;
+          case ucode::AluVectorOpcode::kMul:
+            EmitMulZero(a(i), b(i));
+            break;
+          case ucode::AluVectorOpcode::kMax:
+            EmitMax(a(i), b(i));
+            break;
+          case ucode::AluVectorOpcode::kMin:
+            EmitMin(a(i), b(i));
+            break;
+          case ucode::AluVectorOpcode::kSeq:
+            EmitSet(a(i), b(i), kCompareEq);
+            break;
+          case ucode::AluVectorOpcode::kSgt:
+            // b < a.
+            EmitSet(b(i), a(i), kCompareLt);
+            break;
+          case ucode::AluVectorOpcode::kSge:
+            // b <= a.
+            EmitSet(b(i), a(i), kCompareLe);
+            break;
+          case ucode::AluVectorOpcode::kSne:
+            EmitSet(a(i), b(i), kCompareNeq);
+            break;
+          case ucode::AluVectorOpcode::kFrc:
+            EmitFrc(a(i));
+            break;
+          case ucode::AluVectorOpcode::kTrunc:
+            vroundps(ymm0, a(i), kRoundTrunc);
+            break;
+          case ucode::AluVectorOpcode::kFloor:
+            vroundps(ymm0, a(i), kRoundFloor);
+            break;
+          case ucode::AluVectorOpcode::kMad:
+            // Doing the addition rather than conditional assignment even for
+            // zero operands because +0 + -0 must be +0.
+            EmitMulZero(a(i), b(i));
+            vaddps(ymm0, ymm0, c(i));
+            break;
+          case ucode::AluVectorOpcode::kCndEq:
+          case ucode::AluVectorOpcode::kCndGe:
+          case ucode::AluVectorOpcode::kCndGt:
+            vxorps(ymm1, ymm1, ymm1);
+            if (vector_opcode == ucode::AluVectorOpcode::kCndEq) {
+              vcmpps(ymm1, ymm1, a(i), kCompareEq);
+            } else {
+              // 0 <= a or 0 < a.
+              vcmpps(ymm1, ymm1, a(i),
+                     vector_opcode == ucode::AluVectorOpcode::kCndGe
+                         ? kCompareLe
+                         : kCompareLt);
+            }
+            vmovaps(ymm0, c(i));
+            vblendvps(ymm0, ymm0, b(i), ymm1);
+            break;
+          case ucode::AluVectorOpcode::kDst:
+            switch (i) {
+              case 0:
+                vmovaps(ymm0, Field(offsetof(Context, one)));
+                break;
+              case 1:
+                EmitMulZero(a(1), b(1));
+                break;
+              case 2:
+                vmovaps(ymm0, a(2));
+                break;
+              case 3:
+                vmovaps(ymm0, b(3));
+                break;
+            }
+            break;
+          default:
+            assert_unhandled_case(vector_opcode);
+            break;
+        }
+        if (instr.vector_clamp()) {
+          EmitSaturate();
+        }
+        vmovaps(Field(vector_dest_offset(i)), ymm0);
+      }
+    }
+  }
+
+  // Scalar operation.
+  Xbyak::Address s0 = Field(ScalarOperandOffset(0));
+  Xbyak::Address s1 = Field(ScalarOperandOffset(1));
+  Xbyak::Address previous_scalar = Field(offsetof(Context, previous_scalar));
+  switch (scalar_opcode) {
+    case ucode::AluScalarOpcode::kAdds:
+    case ucode::AluScalarOpcode::kAddsc0:
+    case ucode::AluScalarOpcode::kAddsc1:
+      vmovaps(ymm0, s0);
+      vaddps(ymm0, ymm0, s1);
+      break;
+    case ucode::AluScalarOpcode::kAddsPrev:
+      vmovaps(ymm0, s0);
+      vaddps(ymm0, ymm0, previous_scalar);
+      break;
+    case ucode::AluScalarOpcode::kMuls:
+    case ucode::AluScalarOpcode::kMulsc0:
+    case ucode::AluScalarOpcode::kMulsc1:
+      EmitMulZero(s0, s1);
+      break;
+    case ucode::AluScalarOpcode::kMulsPrev:
+      EmitMulZero(s0, previous_scalar);
+      break;
+    case ucode::AluScalarOpcode::kMaxs:
+      EmitMax(s0, s1);
+      break;
+    case ucode::AluScalarOpcode::kMins:
+      EmitMin(s0, s1);
+      break;
+    case ucode::AluScalarOpcode::kSeqs:
+      EmitSetZero(s0, kCompareEq);
+      break;
+    case ucode::AluScalarOpcode::kSgts:
+      EmitSetZero(s0, kCompareLt);
+      break;
+    case ucode::AluScalarOpcode::kSges:
+      EmitSetZero(s0, kCompareLe);
+      break;
+    case ucode::AluScalarOpcode::kSnes:
+      EmitSetZero(s0, kCompareNeq);
+      break;
+    case ucode::AluScalarOpcode::kFrcs:
+      EmitFrc(s0);
+      break;
+    case ucode::AluScalarOpcode::kTruncs:
+      vroundps(ymm0, s0, kRoundTrunc);
+      break;
+    case ucode::AluScalarOpcode::kFloors:
+      vroundps(ymm0, s0, kRoundFloor);
+      break;
+    case ucode::AluScalarOpcode::kRcpc:
+    case ucode::AluScalarOpcode::kRcpf:
+    case ucode::AluScalarOpcode::kRcp:
+      vmovaps(ymm0, Field(offsetof(Context, one)));
+      vdivps(ymm0, ymm0, s0);
+      if (scalar_opcode == ucode::AluScalarOpcode::kRcpc) {
+        EmitClampInfinityToMax();
+      } else if (scalar_opcode == ucode::AluScalarOpcode::kRcpf) {
+        EmitClampInfinityToZero();
+      }
+      break;
+    case ucode::AluScalarOpcode::kRsqc:
+    case ucode::AluScalarOpcode::kRsqf:
+    case ucode::AluScalarOpcode::kRsq:
+      vsqrtps(ymm1, s0);
+      vmovaps(ymm0, Field(offsetof(Context, one)));
+      vdivps(ymm0, ymm0, ymm1);
+      if (scalar_opcode == ucode::AluScalarOpcode::kRsqc) {
+        EmitClampInfinityToMax();
+      } else if (scalar_opcode == ucode::AluScalarOpcode::kRsqf) {
+        EmitClampInfinityToZero();
+      }
+      break;
+    case ucode::AluScalarOpcode::kSubs:
+    case ucode::AluScalarOpcode::kSubsc0:
+    case ucode::AluScalarOpcode::kSubsc1:
+      vmovaps(ymm0, s0);
+      vsubps(ymm0, ymm0, s1);
+      break;
+    case ucode::AluScalarOpcode::kSubsPrev:
+      vmovaps(ymm0, s0);
+      vsubps(ymm0, ymm0, previous_scalar);
+      break;
+    case ucode::AluScalarOpcode::kSqrt:
+      vsqrtps(ymm0, s0);
+      break;
+    case ucode::AluScalarOpcode::kRetainPrev:
+      break;
+    default:
+      assert_unhandled_case(scalar_opcode);
+      break;
+  }
+  bool scalar_result_needed = scalar_result_write_mask != 0;
+  if (scalar_opcode == ucode::AluScalarOpcode::kRetainPrev) {
+    if (scalar_result_needed) {
+      vmovaps(ymm0, previous_scalar);
+    }
+  } else {
+    vmovaps(previous_scalar, ymm0);
+  }
+  if (scalar_result_needed) {
+    if (instr.scalar_clamp()) {
+      EmitSaturate();
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (!(scalar_result_write_mask & (UINT32_C(1) << i))) {
+        continue;
+      }
+      vmovaps(Field(instr.is_export()
+                        ? ExportOffset(vector_dest, i)
+                        : TempOffset(instr.scalar_dest(), i)),
+              ymm0);
+    }
+  }
+
+  if (instr.is_export()) {
+    uint32_t constant_0_mask = instr.GetConstant0WriteMask();
+    uint32_t constant_1_mask = instr.GetConstant1WriteMask();
+    if (constant_0_mask | constant_1_mask) {
+      vxorps(ymm0, ymm0, ymm0);
+      vmovaps(ymm1, Field(offsetof(Context, one)));
+      for (uint32_t i = 0; i < 4; ++i) {
+        uint32_t component_bit = UINT32_C(1) << i;
+        if (constant_1_mask & component_bit) {
+          vmovaps(Field(ExportOffset(vector_dest, i)), ymm1);
+        } else if (constant_0_mask & component_bit) {
+          vmovaps(Field(ExportOffset(vector_dest, i)), ymm0);
+        }
+      }
+    }
+    uint32_t export_mask = vector_result_write_mask |
+                           scalar_result_write_mask | constant_0_mask |
+                           constant_1_mask;
+    if (export_mask) {
+      or_(dword[rbx + uint32_t(offsetof(Context, export_masks) +
+                               sizeof(uint32_t) * vector_dest)],
+          export_mask);
+    }
+  }
+
+  return true;
+}
+
+void VertexShaderJit::Emitter::EmitLoadOperand(size_t dest_offset,
+                                               size_t source_offset,
+                                               bool absolute, bool negate) {
+  vmovaps(ymm0, Field(source_offset));
+  // Flush denormals, keeping the sign.
+  vandps(ymm1, ymm0, Field(offsetof(Context, exponent_mask)));
+  vxorps(ymm2, ymm2, ymm2);
+  vcmpps(ymm1, ymm1, ymm2, kCompareNeq);
+  vorps(ymm1, ymm1, Field(offsetof(Context, sign_mask)));
+  vandps(ymm0, ymm0, ymm1);
+  if (absolute) {
+    vandps(ymm0, ymm0, Field(offsetof(Context, absolute_mask)));
+  }
+  if (negate) {
+    vxorps(ymm0, ymm0, Field(offsetof(Context, sign_mask)));
+  }
+  vmovaps(Field(dest_offset), ymm0);
+}
+
+size_t VertexShaderJit::Emitter::UseFloatConstant(uint32_t index,
+                                                  uint32_t component,
+                                                  Program& program) {
+  assert_true(index < Context::kFloatConstantCount);
+  if (std::find(program.float_constants.cbegin(),
+                program.float_constants.cend(),
+                index) == program.float_constants.cend()) {
+    program.float_constants.push_back(index);
+  }
+  return FloatConstantOffset(index, component);
+}
+
+void VertexShaderJit::Emitter::EmitMulZero(const Xbyak::Address& a,
+                                           const Xbyak::Address& b) {
+  vmovaps(ymm1, a);
+  vmovaps(ymm2, b);
+  vxorps(ymm3, ymm3, ymm3);
+  vcmpps(ymm0, ymm1, ymm3, kCompareNeq);
+  vcmpps(ymm3, ymm2, ymm3, kCompareNeq);
+  vandps(ymm0, ymm0, ymm3);
+  vmulps(ymm1, ymm1, ymm2);
+  vandps(ymm0, ymm0, ymm1);
+}
+
+void VertexShaderJit::Emitter::EmitMax(const Xbyak::Address& a,
+                                       const Xbyak::Address& b) {
+  // maxps returns the second operand if the values are equal, and for +0 and
+  // -0 the first one must be returned.
+  vmovaps(ymm0, a);
+  vmovaps(ymm1, b);
+  vcmpps(ymm2, ymm1, ymm0, kCompareLe);
+  vblendvps(ymm0, ymm1, ymm0, ymm2);
+}
+
+void VertexShaderJit::Emitter::EmitMin(const Xbyak::Address& a,
+                                       const Xbyak::Address& b) {
+  // minps is exactly a < b ? a : b.
+  vmovaps(ymm0, a);
+  vminps(ymm0, ymm0, b);
+}
+
+void VertexShaderJit::Emitter::EmitSet(const Xbyak::Address& a,
+                                       const Xbyak::Address& b,
+                                       uint8_t predicate) {
+  vmovaps(ymm0, a);
+  vcmpps(ymm0, ymm0, b, predicate);
+  vandps(ymm0, ymm0, Field(offsetof(Context, one)));
+}
+
+void VertexShaderJit::Emitter::EmitSetZero(const Xbyak::Address& a,
+                                           uint8_t predicate) {
+  // For the ordered relations, the operands are swapped (0 < a for a > 0).
+  vxorps(ymm0, ymm0, ymm0);
+  vcmpps(ymm0, ymm0, a, predicate);
+  vandps(ymm0, ymm0, Field(offsetof(Context, one)));
+}
+
+void VertexShaderJit::Emitter::EmitFrc(const Xbyak::Address& a) {
+  vmovaps(ymm1, a);
+  vroundps(ymm0, ymm1, kRoundFloor);
+  vsubps(ymm0, ymm1, ymm0);
+}
+
+void VertexShaderJit::Emitter::EmitClampInfinityToMax() {
+  vcmpps(ymm1, ymm0, Field(offsetof(Context, infinity)), kCompareEq);
+  vblendvps(ymm0, ymm0, Field(offsetof(Context, flt_max)), ymm1);
+  vcmpps(ymm1, ymm0, Field(offsetof(Context, negative_infinity)),
+         kCompareEq);
+  vblendvps(ymm0, ymm0, Field(offsetof(Context, negative_flt_max)), ymm1);
+}
+
+void VertexShaderJit::Emitter::EmitClampInfinityToZero() {
+  vandps(ymm1, ymm0, Field(offsetof(Context, absolute_mask)));
+  vcmpps(ymm1, ymm1, Field(offsetof(Context, infinity)), kCompareEq);
+  vandps(ymm2, ymm0, Field(offsetof(Context, sign_mask)));
+  vblendvps(ymm0, ymm0, ymm2, ymm1);
+}
+
+void VertexShaderJit::Emitter::EmitSaturate() {
+  // maxps and minps return the second operand for NaN, and are exactly
+  // a > b ? a : b and a < b ? a : b, like in xe::clamp_float.
+  vxorps(ymm1, ymm1, ymm1);
+  vmaxps(ymm0, ymm0, ymm1);
+  vminps(ymm0, ymm0, Field(offsetof(Context, one)));
+}
+
+void VertexShaderJit::Emitter::EmitCall(const void* function,
+                                        uint32_t argument) {
+#if XE_PLATFORM_WIN32
+  const Xbyak::Reg64& arg0 = rcx;
+  const Xbyak::Reg32& arg1 = edx;
+#else
+  const Xbyak::Reg64& arg0 = rdi;
+  const Xbyak::Reg32& arg1 = esi;
+#endif  // XE_PLATFORM_WIN32
+  // Avoid the AVX to SSE transition penalty in the callee.
+  vzeroupper();
+  mov(arg0, rbx);
+  mov(arg1, argument);
+  mov(rax, reinterpret_cast<uint64_t>(function));
+  call(rax);
+}
+
+#endif  // XE_ARCH_AMD64
+
+VertexShaderJit::VertexShaderJit(const RegisterFile& register_file,
+                                 const Memory& memory)
+    : register_file_(register_file),
+      memory_(memory),
+      context_(std::make_unique<Context>()) {
+  Context& context = *context_;
+  for (uint32_t i = 0; i < kLaneCount; ++i) {
+    context.sign_mask[i] = UINT32_C(0x80000000);
+    context.absolute_mask[i] = UINT32_C(0x7FFFFFFF);
+    context.exponent_mask[i] = UINT32_C(0x7F800000);
+    context.one[i] = 1.0f;
+    context.infinity[i] = INFINITY;
+    context.negative_infinity[i] = -INFINITY;
+    context.flt_max[i] = FLT_MAX;
+    context.negative_flt_max[i] = -FLT_MAX;
+  }
+  context.jit = this;
+}
+
+VertexShaderJit::~VertexShaderJit() = default;
+
+bool VertexShaderJit::IsSupported() {
+#if XE_ARCH_AMD64
+  static const bool is_supported =
+      Xbyak::util::Cpu().has(Xbyak::util::Cpu::tAVX);
+  return is_supported;
+#else
+  return false;
+#endif  // XE_ARCH_AMD64
+}
+
+bool VertexShaderJit::Prepare(const Shader& shader) {
+  current_program_ = nullptr;
+  if (!IsSupported()) {
+    return false;
+  }
+  assert_true(shader.type() == xenos::ShaderType::kVertex);
+  if (!ShaderInterpreter::CanInterpretShader(shader)) {
+    return false;
+  }
+
+  auto program_it = programs_.find(shader.ucode_data_hash());
+  if (program_it == programs_.end()) {
+    std::unique_ptr<Program> program;
+#if XE_ARCH_AMD64
+    program = std::make_unique<Program>();
+    program->emitter = std::make_unique<Emitter>();
+    bool emitted;
+    try {
+      emitted = program->emitter->EmitShader(shader, *program);
+      if (emitted) {
+        program->emitter->ready();
+      }
+    } catch (const Xbyak::Error& error) {
+      XELOGE("VertexShaderJit: Failed to emit shader {:016X}: {}",
+             shader.ucode_data_hash(), error.what());
+      emitted = false;
+    }
+    if (emitted) {
+      program->function =
+          program->emitter->getCode<void (*)(Context* context)>();
+    } else {
+      program.reset();
+    }
+#endif  // XE_ARCH_AMD64
+    program_it =
+        programs_.emplace(shader.ucode_data_hash(), std::move(program)).first;
+  }
+  if (!program_it->second) {
+    return false;
+  }
+  const Program& program = *program_it->second;
+
+  Context& context = *context_;
+  std::memcpy(context.bool_constants,
+              &register_file_[XE_GPU_REG_SHADER_CONSTANT_BOOL_000_031],
+              sizeof(context.bool_constants));
+  auto base_and_size_minus_1 =
+      register_file_.Get<reg::SQ_VS_CONST>(XE_GPU_REG_SQ_VS_CONST);
+  for (uint32_t index : program.float_constants) {
+    // Same bounds as in ShaderInterpreter::GetFloatConstant.
+    float value[4] = {};
+    if (index <= base_and_size_minus_1.size &&
+        index + base_and_size_minus_1.base < 512) {
+      std::memcpy(value,
+                  &register_file_[XE_GPU_REG_SHADER_CONSTANT_000_X +
+                                  4 * (index + base_and_size_minus_1.base)],
+                  sizeof(value));
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+      std::fill_n(context.float_constants[index][i], kLaneCount, value[i]);
+    }
+  }
+
+  current_program_ = &program;
+  return true;
+}
+
+void VertexShaderJit::Execute(const uint32_t* vertex_indices,
+                              uint32_t vertex_count) {
+  assert_not_null(current_program_);
+  assert_true(vertex_count && vertex_count <= kLaneCount);
+  Context& context = *context_;
+  // Fill the unused lanes with the last vertex so they do the same work.
+  for (uint32_t i = 0; i < kLaneCount; ++i) {
+    context.temps[0][0][i] =
+        float(vertex_indices[std::min(i, vertex_count - 1)]);
+  }
+  std::memset(context.previous_scalar, 0, sizeof(context.previous_scalar));
+  std::memset(context.export_masks, 0, sizeof(context.export_masks));
+  std::memset(&context.vfetch_full_last, 0, sizeof(context.vfetch_full_last));
+  std::memset(context.vfetch_address_dwords, 0,
+              sizeof(context.vfetch_address_dwords));
+  context.vertex_count = vertex_count;
+  context.program = current_program_;
+  current_program_->function(&context);
+  executed_vertex_count_ = vertex_count;
+}
+
+void VertexShaderJit::ReplayExports(uint32_t lane,
+                                    ShaderInterpreter::ExportSink& sink) const {
+  assert_not_null(current_program_);
+  assert_true(lane < executed_vertex_count_);
+  for (const auto& alloc : current_program_->allocs) {
+    sink.AllocExport(alloc.first, alloc.second);
+  }
+  const Context& context = *context_;
+  for (uint32_t i = 0; i < Context::kExportRegisterCount; ++i) {
+    uint32_t export_mask = context.export_masks[i];
+    if (!export_mask) {
+      continue;
+    }
+    float value[4];
+    for (uint32_t j = 0; j < 4; ++j) {
+      value[j] = context.exports[i][j][lane];
+    }
+    sink.Export(ucode::ExportRegister(i), value, export_mask);
+  }
+}
+
+void VertexShaderJit::VertexFetchThunk(Context* context,
+                                       uint32_t fetch_index) {
+  const VertexShaderJit& jit = *context->jit;
+  ucode::VertexFetchInstruction instr =
+      context->program->vertex_fetches[fetch_index];
+
+  if (!instr.is_mini_fetch()) {
+    context->vfetch_full_last = instr;
+  }
+
+  xenos::xe_gpu_vertex_fetch_t fetch_constant =
+      jit.register_file_.GetVertexFetch(
+          context->vfetch_full_last.fetch_constant_index());
+
+  float(*dest)[kLaneCount] = context->temps[instr.dest()];
+  uint32_t dest_swizzle = instr.dest_swizzle();
+  for (uint32_t lane = 0; lane < context->vertex_count; ++lane) {
+    if (!instr.is_mini_fetch()) {
+      // Get the part of the address that depends on vfetch_full data.
+      uint32_t vertex_index = uint32_t(
+          std::floor(context->temps[instr.src()][instr.src_swizzle()][lane] +
+                     (instr.is_index_rounded() ? 0.5f : 0.0f)));
+      context->vfetch_address_dwords[lane] =
+          instr.stride() * vertex_index + fetch_constant.address;
+    }
+    float result[4];
+    ShaderInterpreter::FetchVertex(
+        jit.memory_, jit.trace_writer_, instr, fetch_constant,
+        context->vfetch_address_dwords[lane], result);
+    for (uint32_t i = 0; i < 4; ++i) {
+      ucode::FetchDestinationSwizzle component_swizzle =
+          ucode::GetFetchDestinationComponentSwizzle(dest_swizzle, i);
+      switch (component_swizzle) {
+        case ucode::FetchDestinationSwizzle::kX:
+        case ucode::FetchDestinationSwizzle::kY:
+        case ucode::FetchDestinationSwizzle::kZ:
+        case ucode::FetchDestinationSwizzle::kW:
+          dest[i][lane] = result[uint32_t(component_swizzle)];
+          break;
+        case ucode::FetchDestinationSwizzle::k1:
+          dest[i][lane] = 1.0f;
+          break;
+        case ucode::FetchDestinationSwizzle::kKeep:
+          break;
+        default:
+          dest[i][lane] = 0.0f;
+          break;
+      }
+    }
+  }
+}
+
+}  // namespace gpu
+}  // namespace xe
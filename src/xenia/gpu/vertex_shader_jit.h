@@ -0,0 +1,91 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_GPU_VERTEX_SHADER_JIT_H_
+#define XENIA_GPU_VERTEX_SHADER_JIT_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "xenia/gpu/register_file.h"
+#include "xenia/gpu/shader.h"
+#include "xenia/gpu/shader_interpreter.h"
+#include "xenia/gpu/trace_writer.h"
+#include "xenia/memory.h"
+
+namespace xe {
+namespace gpu {
+
+// Compiles Xenos vertex shaders to x86-64 code executing kLaneCount vertices at
+// once, with every component of every register stored as an AVX vector of the
+// values for all the lanes. This is an alternative to the ShaderInterpreter for
+// running vertex shaders on the CPU for many vertices (for
+// execute_unclipped_draw_vs_on_cpu), producing the same results.
+//
+// Only a subset of shaders is supported - with uniform control flow (bool
+// constant conditionals, but no loops, calls, jumps or predication), without
+// relative addressing, and without operations whose results can't be
+// reproduced exactly with SIMD instructions, such as the transcendental ones.
+// If Prepare returns false, the ShaderInterpreter must be used for the draw.
+//
+// Compiled shaders are cached by the ucode hash for the lifetime of the object.
+class VertexShaderJit {
+ public:
+  static constexpr uint32_t kLaneCount = 8;
+
+  VertexShaderJit(const RegisterFile& register_file, const Memory& memory);
+  ~VertexShaderJit();
+
+  // Whether the host CPU can execute the generated code.
+  static bool IsSupported();
+
+  void SetTraceWriter(TraceWriter* new_trace_writer) {
+    trace_writer_ = new_trace_writer;
+  }
+
+  // Compiles the shader or takes it from the cache, and loads the bool and the
+  // float constants it uses from the register file. The constants are
+  // snapshotted, so this must be called for every draw.
+  bool Prepare(const Shader& shader);
+
+  // Executes the prepared shader for up to kLaneCount vertices. The exports of
+  // each of the vertices can then be retrieved using ReplayExports.
+  void Execute(const uint32_t* vertex_indices, uint32_t vertex_count);
+
+  // Passes the allocations, and then the final values of the export registers
+  // written for a vertex from the last Execute, to the sink. Unlike in the
+  // interpreter, the exports are not reported in the order of execution, and
+  // multiple exports to the same register are merged.
+  void ReplayExports(uint32_t lane, ShaderInterpreter::ExportSink& sink) const;
+
+ private:
+  struct Context;
+  struct Program;
+  class Emitter;
+
+  static void VertexFetchThunk(Context* context, uint32_t fetch_index);
+
+  const RegisterFile& register_file_;
+  const Memory& memory_;
+
+  TraceWriter* trace_writer_ = nullptr;
+
+  // Failed compilations are cached as nullptr.
+  std::unordered_map<uint64_t, std::unique_ptr<Program>> programs_;
+  const Program* current_program_ = nullptr;
+
+  std::unique_ptr<Context> context_;
+  uint32_t executed_vertex_count_ = 0;
+};
+
+}  // namespace gpu
+}  // namespace xe
+
+#endif  // XENIA_GPU_VERTEX_SHADER_JIT_H_
@@ -0,0 +1,241 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xenia/base/byte_order.h"
+#include "xenia/base/clock.h"
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/string_buffer.h"
+#include "xenia/base/xxhash.h"
+#include "xenia/gpu/register_file.h"
+#include "xenia/gpu/registers.h"
+#include "xenia/gpu/shader.h"
+#include "xenia/gpu/shader_interpreter.h"
+#include "xenia/gpu/vertex_shader_jit.h"
+#include "xenia/gpu/xenos.h"
+#include "xenia/memory.h"
+
+DEFINE_path(shader_input, "", "Input vertex shader binary file path.", "GPU");
+DEFINE_bool(
+    shader_input_little_endian, false,
+    "Whether the input shader binary is little-endian (from an Arm device with "
+    "the Qualcomm Adreno 200, for instance).",
+    "GPU");
+DEFINE_int32(bench_vertex_count, 1 << 20,
+             "Number of vertices to execute the shader for with each engine.",
+             "GPU");
+
+namespace xe {
+namespace gpu {
+
+namespace {
+
+// Accumulates the final position of every vertex so the results of the
+// interpreter and the JIT can be compared.
+class PositionChecksumExportSink : public ShaderInterpreter::ExportSink {
+ public:
+  void Export(ucode::ExportRegister export_register, const float* value,
+              uint32_t value_mask) override {
+    if (export_register != ucode::ExportRegister::kVSPosition) {
+      return;
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (value_mask & (UINT32_C(1) << i)) {
+        std::memcpy(&position_[i], &value[i], sizeof(uint32_t));
+      }
+    }
+  }
+
+  void EndVertex() {
+    for (uint32_t i = 0; i < 4; ++i) {
+      checksum_ = (checksum_ ^ position_[i]) * UINT64_C(0x100000001B3);
+      position_[i] = 0;
+    }
+  }
+
+  uint64_t checksum() const { return checksum_; }
+
+ private:
+  uint32_t position_[4] = {};
+  uint64_t checksum_ = UINT64_C(0xCBF29CE484222325);
+};
+
+double TicksToSeconds(uint64_t ticks) {
+  return double(ticks) / double(Clock::QueryHostTickFrequency());
+}
+
+// Vertex indices are repeated so all of them can be fetched from one buffer
+// with the largest possible stride.
+constexpr uint32_t kVertexBufferVertexCount = 1024;
+constexpr uint32_t kVertexBufferMaxStrideDwords = 255;
+constexpr uint32_t kVertexBufferSizeDwords =
+    kVertexBufferVertexCount * kVertexBufferMaxStrideDwords;
+
+// Deterministic finite non-zero values, so the results don't depend on the
+// run, but also aren't trivially the same for every vertex or constant.
+class BenchDataGenerator {
+ public:
+  float Next() {
+    state_ = state_ * UINT32_C(1664525) + UINT32_C(1013904223);
+    // -4 to 4 excluding 0, in steps of 1/64.
+    int32_t value = int32_t((state_ >> 16) % 512) - 256;
+    return float(value >= 0 ? value + 1 : value) * (1.0f / 64.0f);
+  }
+
+ private:
+  uint32_t state_ = 1;
+};
+
+}  // namespace
+
+int vertex_shader_jit_bench_main(const std::vector<std::string>& args) {
+  auto input_file = filesystem::OpenFile(cvars::shader_input, "rb");
+  if (!input_file) {
+    XELOGE("Unable to open input file: {}",
+           xe::path_to_utf8(cvars::shader_input));
+    return 1;
+  }
+  size_t input_file_size = std::filesystem::file_size(cvars::shader_input);
+  std::vector<uint32_t> ucode_dwords(input_file_size / 4);
+  size_t ucode_dwords_read =
+      fread(ucode_dwords.data(), 4, ucode_dwords.size(), input_file);
+  fclose(input_file);
+  if (ucode_dwords.empty() || ucode_dwords_read != ucode_dwords.size()) {
+    XELOGE("Unable to read input file: {}",
+           xe::path_to_utf8(cvars::shader_input));
+    return 1;
+  }
+
+  auto shader = std::make_unique<Shader>(
+      xenos::ShaderType::kVertex,
+      XXH3_64bits(ucode_dwords.data(), ucode_dwords.size() * sizeof(uint32_t)),
+      ucode_dwords.data(), ucode_dwords.size(),
+      cvars::shader_input_little_endian ? std::endian::little
+                                        : std::endian::big);
+  StringBuffer ucode_disasm_buffer;
+  shader->AnalyzeUcode(ucode_disasm_buffer);
+  if (!ShaderInterpreter::CanInterpretShader(*shader)) {
+    XELOGE("The shader can't be executed on the CPU.");
+    return 1;
+  }
+
+  auto memory = std::make_unique<Memory>();
+  if (!memory->Initialize()) {
+    XELOGE("Failed to initialize the guest memory.");
+    return 1;
+  }
+  auto register_file = std::make_unique<RegisterFile>();
+  std::memset(register_file->values, 0, sizeof(register_file->values));
+  reg::SQ_VS_CONST sq_vs_const = {};
+  sq_vs_const.size = 255;
+  (*register_file)[XE_GPU_REG_SQ_VS_CONST] = sq_vs_const.value;
+  BenchDataGenerator data_generator;
+  for (uint32_t i = 0; i < 256 * 4; ++i) {
+    float value = data_generator.Next();
+    std::memcpy(&register_file->values[XE_GPU_REG_SHADER_CONSTANT_000_X + i],
+                &value, sizeof(uint32_t));
+  }
+  // All the vertex fetch constants refer to the same buffer with non-zero
+  // data.
+  uint32_t vertex_buffer_ptr = memory->SystemHeapAlloc(
+      sizeof(uint32_t) * kVertexBufferSizeDwords, 256, kSystemHeapPhysical);
+  if (!vertex_buffer_ptr) {
+    XELOGE("Failed to allocate the vertex buffer.");
+    return 1;
+  }
+  auto vertex_buffer = memory->TranslateVirtual<uint32_t*>(vertex_buffer_ptr);
+  for (uint32_t i = 0; i < kVertexBufferSizeDwords; ++i) {
+    float value = data_generator.Next();
+    uint32_t value_bits;
+    std::memcpy(&value_bits, &value, sizeof(uint32_t));
+    vertex_buffer[i] = xe::byte_swap(value_bits);
+  }
+  xenos::xe_gpu_vertex_fetch_t vertex_fetch = {};
+  vertex_fetch.type = xenos::FetchConstantType::kVertex;
+  vertex_fetch.address = memory->GetPhysicalAddress(vertex_buffer_ptr) >> 2;
+  vertex_fetch.endian = xenos::Endian::k8in32;
+  vertex_fetch.size = kVertexBufferSizeDwords;
+  for (uint32_t i = 0; i < 96; ++i) {
+    std::memcpy(&register_file->values[XE_GPU_REG_SHADER_CONSTANT_FETCH_00_0 +
+                                       2 * i],
+                &vertex_fetch, sizeof(vertex_fetch));
+  }
+
+  uint32_t vertex_count = uint32_t(std::max(cvars::bench_vertex_count, 1));
+
+  ShaderInterpreter interpreter(*register_file, *memory);
+  interpreter.SetShader(*shader);
+  PositionChecksumExportSink interpreter_sink;
+  interpreter.SetExportSink(&interpreter_sink);
+  uint64_t interpreter_start = Clock::QueryHostTickCount();
+  for (uint32_t i = 0; i < vertex_count; ++i) {
+    interpreter.temp_registers()[0] = float(i % kVertexBufferVertexCount);
+    interpreter.Execute();
+    interpreter_sink.EndVertex();
+  }
+  double interpreter_seconds =
+      TicksToSeconds(Clock::QueryHostTickCount() - interpreter_start);
+  XELOGI("Interpreter: {:.0f} vertices/s", vertex_count / interpreter_seconds);
+
+  if (!VertexShaderJit::IsSupported()) {
+    XELOGI("JIT: not supported on the host CPU");
+    return 0;
+  }
+  VertexShaderJit jit(*register_file, *memory);
+  uint64_t compile_start = Clock::QueryHostTickCount();
+  if (!jit.Prepare(*shader)) {
+    XELOGI("JIT: the shader uses features not supported by the compiler");
+    return 0;
+  }
+  XELOGI("JIT: compiled in {:.3f} ms",
+         TicksToSeconds(Clock::QueryHostTickCount() - compile_start) * 1000.0);
+  PositionChecksumExportSink jit_sink;
+  uint32_t vertex_indices[VertexShaderJit::kLaneCount];
+  uint64_t jit_start = Clock::QueryHostTickCount();
+  for (uint32_t i = 0; i < vertex_count; i += VertexShaderJit::kLaneCount) {
+    uint32_t lane_count =
+        std::min(vertex_count - i, VertexShaderJit::kLaneCount);
+    for (uint32_t j = 0; j < lane_count; ++j) {
+      vertex_indices[j] = (i + j) % kVertexBufferVertexCount;
+    }
+    jit.Execute(vertex_indices, lane_count);
+    for (uint32_t j = 0; j < lane_count; ++j) {
+      jit.ReplayExports(j, jit_sink);
+      jit_sink.EndVertex();
+    }
+  }
+  double jit_seconds = TicksToSeconds(Clock::QueryHostTickCount() - jit_start);
+  XELOGI("JIT: {:.0f} vertices/s ({:.2f}x)", vertex_count / jit_seconds,
+         interpreter_seconds / jit_seconds);
+
+  if (jit_sink.checksum() != interpreter_sink.checksum()) {
+    XELOGE("Position checksum mismatch: interpreter {:016X}, JIT {:016X}",
+           interpreter_sink.checksum(), jit_sink.checksum());
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace gpu
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-gpu-vertex-shader-jit-bench",
+                      xe::gpu::vertex_shader_jit_bench_main, "shader.vs",
+                      "shader_input");
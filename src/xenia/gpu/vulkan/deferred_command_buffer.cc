@@ -240,6 +240,11 @@ void DeferredCommandBuffer::Execute(VkCommandBuffer command_buffer) {
         dfn.vkCmdSetBlendConstants(command_buffer, args.blend_constants);
       } break;
 
+      case Command::kVkSetCullMode: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetCullMode(command_buffer, VkCullModeFlags(args.value));
+      } break;
+
       case Command::kVkSetDepthBias: {
         auto& args = *reinterpret_cast<const ArgsVkSetDepthBias*>(stream);
         dfn.vkCmdSetDepthBias(command_buffer, args.depth_bias_constant_factor,
@@ -247,6 +252,32 @@ void DeferredCommandBuffer::Execute(VkCommandBuffer command_buffer) {
                               args.depth_bias_slope_factor);
       } break;
 
+      case Command::kVkSetDepthCompareOp: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetDepthCompareOp(command_buffer, VkCompareOp(args.value));
+      } break;
+
+      case Command::kVkSetDepthTestEnable: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetDepthTestEnable(command_buffer, VkBool32(args.value));
+      } break;
+
+      case Command::kVkSetDepthWriteEnable: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetDepthWriteEnable(command_buffer, VkBool32(args.value));
+      } break;
+
+      case Command::kVkSetFrontFace: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetFrontFace(command_buffer, VkFrontFace(args.value));
+      } break;
+
+      case Command::kVkSetPrimitiveRestartEnable: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetPrimitiveRestartEnable(command_buffer,
+                                           VkBool32(args.value));
+      } break;
+
       case Command::kVkSetScissor: {
         auto& args = *reinterpret_cast<const ArgsVkSetScissor*>(stream);
         dfn.vkCmdSetScissor(
@@ -263,6 +294,13 @@ void DeferredCommandBuffer::Execute(VkCommandBuffer command_buffer) {
                                        args.mask_reference);
       } break;
 
+      case Command::kVkSetStencilOp: {
+        auto& args = *reinterpret_cast<const ArgsVkSetStencilOp*>(stream);
+        dfn.vkCmdSetStencilOp(command_buffer, args.face_mask, args.fail_op,
+                              args.pass_op, args.depth_fail_op,
+                              args.compare_op);
+      } break;
+
       case Command::kVkSetStencilReference: {
         auto& args =
             *reinterpret_cast<const ArgsSetStencilMaskReference*>(stream);
@@ -270,6 +308,11 @@ void DeferredCommandBuffer::Execute(VkCommandBuffer command_buffer) {
                                      args.mask_reference);
       } break;
 
+      case Command::kVkSetStencilTestEnable: {
+        auto& args = *reinterpret_cast<const ArgsSetDynamicStateValue*>(stream);
+        dfn.vkCmdSetStencilTestEnable(command_buffer, VkBool32(args.value));
+      } break;
+
       case Command::kVkSetStencilWriteMask: {
         auto& args =
             *reinterpret_cast<const ArgsSetStencilMaskReference*>(stream);
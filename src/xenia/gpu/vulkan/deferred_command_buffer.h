@@ -294,6 +294,12 @@ class DeferredCommandBuffer {
     std::memcpy(args.blend_constants, blend_constants, sizeof(float) * 4);
   }
 
+  void CmdVkSetCullMode(VkCullModeFlags cull_mode) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(WriteCommand(
+        Command::kVkSetCullMode, sizeof(ArgsSetDynamicStateValue)));
+    args.value = cull_mode;
+  }
+
   void CmdVkSetDepthBias(float depth_bias_constant_factor,
                          float depth_bias_clamp,
                          float depth_bias_slope_factor) {
@@ -304,6 +310,37 @@ class DeferredCommandBuffer {
     args.depth_bias_slope_factor = depth_bias_slope_factor;
   }
 
+  void CmdVkSetDepthCompareOp(VkCompareOp depth_compare_op) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(WriteCommand(
+        Command::kVkSetDepthCompareOp, sizeof(ArgsSetDynamicStateValue)));
+    args.value = uint32_t(depth_compare_op);
+  }
+
+  void CmdVkSetDepthTestEnable(VkBool32 depth_test_enable) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(WriteCommand(
+        Command::kVkSetDepthTestEnable, sizeof(ArgsSetDynamicStateValue)));
+    args.value = depth_test_enable;
+  }
+
+  void CmdVkSetDepthWriteEnable(VkBool32 depth_write_enable) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(WriteCommand(
+        Command::kVkSetDepthWriteEnable, sizeof(ArgsSetDynamicStateValue)));
+    args.value = depth_write_enable;
+  }
+
+  void CmdVkSetFrontFace(VkFrontFace front_face) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(WriteCommand(
+        Command::kVkSetFrontFace, sizeof(ArgsSetDynamicStateValue)));
+    args.value = uint32_t(front_face);
+  }
+
+  void CmdVkSetPrimitiveRestartEnable(VkBool32 primitive_restart_enable) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(
+        WriteCommand(Command::kVkSetPrimitiveRestartEnable,
+                     sizeof(ArgsSetDynamicStateValue)));
+    args.value = primitive_restart_enable;
+  }
+
   void CmdVkSetScissor(uint32_t first_scissor, uint32_t scissor_count,
                        const VkRect2D* scissors) {
     const size_t header_size =
@@ -327,6 +364,18 @@ class DeferredCommandBuffer {
     args.mask_reference = compare_mask;
   }
 
+  void CmdVkSetStencilOp(VkStencilFaceFlags face_mask, VkStencilOp fail_op,
+                        VkStencilOp pass_op, VkStencilOp depth_fail_op,
+                        VkCompareOp compare_op) {
+    auto& args = *reinterpret_cast<ArgsVkSetStencilOp*>(
+        WriteCommand(Command::kVkSetStencilOp, sizeof(ArgsVkSetStencilOp)));
+    args.face_mask = face_mask;
+    args.fail_op = fail_op;
+    args.pass_op = pass_op;
+    args.depth_fail_op = depth_fail_op;
+    args.compare_op = compare_op;
+  }
+
   void CmdVkSetStencilReference(VkStencilFaceFlags face_mask,
                                 uint32_t reference) {
     auto& args = *reinterpret_cast<ArgsSetStencilMaskReference*>(WriteCommand(
@@ -335,6 +384,12 @@ class DeferredCommandBuffer {
     args.mask_reference = reference;
   }
 
+  void CmdVkSetStencilTestEnable(VkBool32 stencil_test_enable) {
+    auto& args = *reinterpret_cast<ArgsSetDynamicStateValue*>(WriteCommand(
+        Command::kVkSetStencilTestEnable, sizeof(ArgsSetDynamicStateValue)));
+    args.value = stencil_test_enable;
+  }
+
   void CmdVkSetStencilWriteMask(VkStencilFaceFlags face_mask,
                                 uint32_t write_mask) {
     auto& args = *reinterpret_cast<ArgsSetStencilMaskReference*>(WriteCommand(
@@ -375,10 +430,18 @@ class DeferredCommandBuffer {
     kVkPipelineBarrier,
     kVkPushConstants,
     kVkSetBlendConstants,
+    kVkSetCullMode,
     kVkSetDepthBias,
+    kVkSetDepthCompareOp,
+    kVkSetDepthTestEnable,
+    kVkSetDepthWriteEnable,
+    kVkSetFrontFace,
+    kVkSetPrimitiveRestartEnable,
     kVkSetScissor,
     kVkSetStencilCompareMask,
+    kVkSetStencilOp,
     kVkSetStencilReference,
+    kVkSetStencilTestEnable,
     kVkSetStencilWriteMask,
     kVkSetViewport,
   };
@@ -523,11 +586,25 @@ class DeferredCommandBuffer {
     static_assert(alignof(VkRect2D) <= alignof(uintmax_t));
   };
 
+  // For the extended dynamic state commands taking a single enum, flags or
+  // boolean value.
+  struct ArgsSetDynamicStateValue {
+    uint32_t value;
+  };
+
   struct ArgsSetStencilMaskReference {
     VkStencilFaceFlags face_mask;
     uint32_t mask_reference;
   };
 
+  struct ArgsVkSetStencilOp {
+    VkStencilFaceFlags face_mask;
+    VkStencilOp fail_op;
+    VkStencilOp pass_op;
+    VkStencilOp depth_fail_op;
+    VkCompareOp compare_op;
+  };
+
   struct ArgsVkSetViewport {
     uint32_t first_viewport;
     uint32_t viewport_count;
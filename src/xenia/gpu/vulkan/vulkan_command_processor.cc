@@ -21,6 +21,7 @@
 #include "xenia/base/byte_order.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
+#include "xenia/base/memory.h"
 #include "xenia/base/profiling.h"
 #include "xenia/gpu/draw_util.h"
 #include "xenia/gpu/gpu_flags.h"
@@ -100,6 +101,12 @@ void VulkanCommandProcessor::ClearCaches() {
   cache_clear_requested_ = true;
 }
 
+void VulkanCommandProcessor::InitializeShaderStorage(
+    const std::filesystem::path& cache_root, uint32_t title_id, bool blocking) {
+  CommandProcessor::InitializeShaderStorage(cache_root, title_id, blocking);
+  pipeline_cache_->InitializeShaderStorage(cache_root, title_id, blocking);
+}
+
 void VulkanCommandProcessor::TracePlaybackWroteMemory(uint32_t base_ptr,
                                                       uint32_t length) {
   shared_memory_->MemoryInvalidationCallback(base_ptr, length, true);
@@ -1232,9 +1239,14 @@ void VulkanCommandProcessor::WriteRegister(uint32_t index, uint32_t value) {
 void VulkanCommandProcessor::WriteRegistersFromMem(uint32_t start_index,
                                                    uint32_t* base,
                                                    uint32_t num_registers) {
-  for (uint32_t i = 0; i < num_registers; ++i) {
-    uint32_t data = xe::load_and_swap<uint32_t>(base + i);
-    VulkanCommandProcessor::WriteRegister(start_index + i, data);
+  uint32_t values[64];
+  for (uint32_t i = 0; i < num_registers; i += uint32_t(xe::countof(values))) {
+    uint32_t batch_count =
+        std::min(num_registers - i, uint32_t(xe::countof(values)));
+    xe::copy_and_swap_32_unaligned(values, base + i, batch_count);
+    for (uint32_t j = 0; j < batch_count; ++j) {
+      VulkanCommandProcessor::WriteRegister(start_index + i + j, values[j]);
+    }
   }
 }
 void VulkanCommandProcessor::SparseBindBuffer(
@@ -2100,6 +2112,16 @@ void VulkanCommandProcessor::BindExternalGraphicsPipeline(
     dynamic_stencil_reference_front_update_needed_ = true;
     dynamic_stencil_reference_back_update_needed_ = true;
   }
+  // External pipelines don't use the extended dynamic state.
+  dynamic_cull_mode_update_needed_ = true;
+  dynamic_front_face_update_needed_ = true;
+  dynamic_depth_test_enable_update_needed_ = true;
+  dynamic_depth_write_enable_update_needed_ = true;
+  dynamic_depth_compare_op_update_needed_ = true;
+  dynamic_stencil_test_enable_update_needed_ = true;
+  dynamic_stencil_op_front_update_needed_ = true;
+  dynamic_stencil_op_back_update_needed_ = true;
+  dynamic_primitive_restart_enable_update_needed_ = true;
   if (current_external_graphics_pipeline_ == pipeline) {
     return;
   }
@@ -2480,6 +2502,7 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
 
   // Update dynamic graphics pipeline state.
   UpdateDynamicState(viewport_info, primitive_polygonal,
+                     primitive_processing_result.host_primitive_reset_enabled,
                      normalized_depth_control);
 
   auto vgt_draw_initiator = regs.Get<reg::VGT_DRAW_INITIATOR>();
@@ -2779,6 +2802,8 @@ void VulkanCommandProcessor::CheckSubmissionFenceAndDeviceLoss(
 
   texture_cache_->CompletedSubmissionUpdated(submission_completed_);
 
+  pipeline_cache_->CompletedSubmissionUpdated();
+
   // Destroy objects scheduled for destruction.
   while (!destroy_framebuffers_.empty()) {
     const auto& destroy_pair = destroy_framebuffers_.front();
@@ -2868,6 +2893,15 @@ bool VulkanCommandProcessor::BeginSubmission(bool is_guest_command) {
     dynamic_stencil_write_mask_back_update_needed_ = true;
     dynamic_stencil_reference_front_update_needed_ = true;
     dynamic_stencil_reference_back_update_needed_ = true;
+    dynamic_cull_mode_update_needed_ = true;
+    dynamic_front_face_update_needed_ = true;
+    dynamic_depth_test_enable_update_needed_ = true;
+    dynamic_depth_write_enable_update_needed_ = true;
+    dynamic_depth_compare_op_update_needed_ = true;
+    dynamic_stencil_test_enable_update_needed_ = true;
+    dynamic_stencil_op_front_update_needed_ = true;
+    dynamic_stencil_op_back_update_needed_ = true;
+    dynamic_primitive_restart_enable_update_needed_ = true;
     current_render_pass_ = VK_NULL_HANDLE;
     current_framebuffer_ = nullptr;
     current_guest_graphics_pipeline_ = VK_NULL_HANDLE;
@@ -2946,6 +2980,8 @@ bool VulkanCommandProcessor::BeginSubmission(bool is_guest_command) {
       texture_transient_descriptor_sets_used_.pop_front();
     }
 
+    shared_memory_->BeginFrame();
+
     primitive_processor_->BeginFrame();
 
     texture_cache_->BeginFrame();
@@ -3275,7 +3311,7 @@ void VulkanCommandProcessor::DestroyScratchBuffer() {
 
 void VulkanCommandProcessor::UpdateDynamicState(
     const draw_util::ViewportInfo& viewport_info, bool primitive_polygonal,
-    reg::RB_DEPTHCONTROL normalized_depth_control) {
+    bool primitive_restart, reg::RB_DEPTHCONTROL normalized_depth_control) {
 #if XE_UI_VULKAN_FINE_GRAINED_DRAW_SCOPES
   SCOPE_profile_cpu_f("gpu");
 #endif  // XE_UI_VULKAN_FINE_GRAINED_DRAW_SCOPES
@@ -3489,8 +3525,157 @@ void VulkanCommandProcessor::UpdateDynamicState(
     }
   }
 
-  // TODO(Triang3l): VK_EXT_extended_dynamic_state and
-  // VK_EXT_extended_dynamic_state2.
+  // Extended dynamic state, with the same values as written to the pipeline
+  // description by VulkanPipelineCache when the state is static.
+  if (pipeline_cache_->IsExtendedDynamicStateUsed()) {
+    // Culling and the front face.
+    VkCullModeFlags cull_mode = VK_CULL_MODE_NONE;
+    VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    if (primitive_polygonal) {
+      auto pa_su_sc_mode_cntl = regs.Get<reg::PA_SU_SC_MODE_CNTL>();
+      if (pa_su_sc_mode_cntl.cull_front) {
+        cull_mode |= VK_CULL_MODE_FRONT_BIT;
+      }
+      if (pa_su_sc_mode_cntl.cull_back) {
+        cull_mode |= VK_CULL_MODE_BACK_BIT;
+      }
+      if (pa_su_sc_mode_cntl.face) {
+        front_face = VK_FRONT_FACE_CLOCKWISE;
+      }
+    }
+    dynamic_cull_mode_update_needed_ |= dynamic_cull_mode_ != cull_mode;
+    dynamic_cull_mode_ = cull_mode;
+    if (dynamic_cull_mode_update_needed_) {
+      deferred_command_buffer_.CmdVkSetCullMode(dynamic_cull_mode_);
+      dynamic_cull_mode_update_needed_ = false;
+    }
+    dynamic_front_face_update_needed_ |= dynamic_front_face_ != front_face;
+    dynamic_front_face_ = front_face;
+    if (dynamic_front_face_update_needed_) {
+      deferred_command_buffer_.CmdVkSetFrontFace(dynamic_front_face_);
+      dynamic_front_face_update_needed_ = false;
+    }
+
+    // Depth / stencil, only used with host render targets.
+    if (render_target_cache_->GetPath() ==
+        RenderTargetCache::Path::kHostRenderTargets) {
+      bool depth_stencil_used =
+          (render_target_cache_->last_update_render_pass_key()
+               .depth_and_color_used &
+           1) != 0;
+      bool depth_write_enable = false;
+      xenos::CompareFunction depth_compare_op = xenos::CompareFunction::kAlways;
+      bool stencil_test_enable = false;
+      if (depth_stencil_used) {
+        if (normalized_depth_control.z_enable) {
+          depth_write_enable = normalized_depth_control.z_write_enable;
+          depth_compare_op = normalized_depth_control.zfunc;
+        }
+        stencil_test_enable = normalized_depth_control.stencil_enable;
+      }
+      bool depth_test_enable =
+          depth_write_enable ||
+          depth_compare_op != xenos::CompareFunction::kAlways;
+      dynamic_depth_test_enable_update_needed_ |=
+          dynamic_depth_test_enable_ != depth_test_enable;
+      dynamic_depth_test_enable_ = depth_test_enable;
+      if (dynamic_depth_test_enable_update_needed_) {
+        deferred_command_buffer_.CmdVkSetDepthTestEnable(
+            dynamic_depth_test_enable_ ? VK_TRUE : VK_FALSE);
+        dynamic_depth_test_enable_update_needed_ = false;
+      }
+      dynamic_depth_write_enable_update_needed_ |=
+          dynamic_depth_write_enable_ != depth_write_enable;
+      dynamic_depth_write_enable_ = depth_write_enable;
+      if (dynamic_depth_write_enable_update_needed_) {
+        deferred_command_buffer_.CmdVkSetDepthWriteEnable(
+            dynamic_depth_write_enable_ ? VK_TRUE : VK_FALSE);
+        dynamic_depth_write_enable_update_needed_ = false;
+      }
+      // Like the stencil masks, changing the compare and stencil operations
+      // only when they're actually needed, but they must still be set in the
+      // command buffer before any draw.
+      if (depth_test_enable) {
+        dynamic_depth_compare_op_update_needed_ |=
+            dynamic_depth_compare_op_ != depth_compare_op;
+        dynamic_depth_compare_op_ = depth_compare_op;
+      }
+      if (dynamic_depth_compare_op_update_needed_) {
+        deferred_command_buffer_.CmdVkSetDepthCompareOp(
+            VkCompareOp(uint32_t(VK_COMPARE_OP_NEVER) +
+                        uint32_t(dynamic_depth_compare_op_)));
+        dynamic_depth_compare_op_update_needed_ = false;
+      }
+      dynamic_stencil_test_enable_update_needed_ |=
+          dynamic_stencil_test_enable_ != stencil_test_enable;
+      dynamic_stencil_test_enable_ = stencil_test_enable;
+      if (dynamic_stencil_test_enable_update_needed_) {
+        deferred_command_buffer_.CmdVkSetStencilTestEnable(
+            dynamic_stencil_test_enable_ ? VK_TRUE : VK_FALSE);
+        dynamic_stencil_test_enable_update_needed_ = false;
+      }
+      if (stencil_test_enable) {
+        uint32_t stencil_op_front =
+            uint32_t(normalized_depth_control.stencilfail) |
+            (uint32_t(normalized_depth_control.stencilzpass) << 3) |
+            (uint32_t(normalized_depth_control.stencilzfail) << 6) |
+            (uint32_t(normalized_depth_control.stencilfunc) << 9);
+        uint32_t stencil_op_back = stencil_op_front;
+        if (primitive_polygonal && normalized_depth_control.backface_enable) {
+          stencil_op_back =
+              uint32_t(normalized_depth_control.stencilfail_bf) |
+              (uint32_t(normalized_depth_control.stencilzpass_bf) << 3) |
+              (uint32_t(normalized_depth_control.stencilzfail_bf) << 6) |
+              (uint32_t(normalized_depth_control.stencilfunc_bf) << 9);
+        }
+        dynamic_stencil_op_front_update_needed_ |=
+            dynamic_stencil_op_front_ != stencil_op_front;
+        dynamic_stencil_op_front_ = stencil_op_front;
+        dynamic_stencil_op_back_update_needed_ |=
+            dynamic_stencil_op_back_ != stencil_op_back;
+        dynamic_stencil_op_back_ = stencil_op_back;
+      }
+      auto set_stencil_op = [this](VkStencilFaceFlags face_mask,
+                                   uint32_t stencil_op) {
+        deferred_command_buffer_.CmdVkSetStencilOp(
+            face_mask,
+            VkStencilOp(uint32_t(VK_STENCIL_OP_KEEP) + (stencil_op & 7)),
+            VkStencilOp(uint32_t(VK_STENCIL_OP_KEEP) + ((stencil_op >> 3) & 7)),
+            VkStencilOp(uint32_t(VK_STENCIL_OP_KEEP) + ((stencil_op >> 6) & 7)),
+            VkCompareOp(uint32_t(VK_COMPARE_OP_NEVER) +
+                        ((stencil_op >> 9) & 7)));
+      };
+      if (dynamic_stencil_op_front_update_needed_ ||
+          dynamic_stencil_op_back_update_needed_) {
+        if (dynamic_stencil_op_front_ == dynamic_stencil_op_back_) {
+          set_stencil_op(VK_STENCIL_FACE_FRONT_AND_BACK,
+                         dynamic_stencil_op_front_);
+        } else {
+          if (dynamic_stencil_op_front_update_needed_) {
+            set_stencil_op(VK_STENCIL_FACE_FRONT_BIT,
+                           dynamic_stencil_op_front_);
+          }
+          if (dynamic_stencil_op_back_update_needed_) {
+            set_stencil_op(VK_STENCIL_FACE_BACK_BIT, dynamic_stencil_op_back_);
+          }
+        }
+        dynamic_stencil_op_front_update_needed_ = false;
+        dynamic_stencil_op_back_update_needed_ = false;
+      }
+    }
+  }
+
+  // Primitive restart.
+  if (pipeline_cache_->IsExtendedDynamicState2Used()) {
+    dynamic_primitive_restart_enable_update_needed_ |=
+        dynamic_primitive_restart_enable_ != primitive_restart;
+    dynamic_primitive_restart_enable_ = primitive_restart;
+    if (dynamic_primitive_restart_enable_update_needed_) {
+      deferred_command_buffer_.CmdVkSetPrimitiveRestartEnable(
+          dynamic_primitive_restart_enable_ ? VK_TRUE : VK_FALSE);
+      dynamic_primitive_restart_enable_update_needed_ = false;
+    }
+  }
 }
 
 void VulkanCommandProcessor::UpdateSystemConstantValues(
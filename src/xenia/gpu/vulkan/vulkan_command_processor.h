@@ -143,6 +143,9 @@ class VulkanCommandProcessor final : public CommandProcessor {
 
   void ClearCaches() override;
 
+  void InitializeShaderStorage(const std::filesystem::path& cache_root,
+                               uint32_t title_id, bool blocking) override;
+
   void TracePlaybackWroteMemory(uint32_t base_ptr, uint32_t length) override;
 
   void RestoreEdramSnapshot(const void* snapshot) override;
@@ -442,7 +445,7 @@ class VulkanCommandProcessor final : public CommandProcessor {
   void DestroyScratchBuffer();
 
   void UpdateDynamicState(const draw_util::ViewportInfo& viewport_info,
-                          bool primitive_polygonal,
+                          bool primitive_polygonal, bool primitive_restart,
                           reg::RB_DEPTHCONTROL normalized_depth_control);
   void UpdateSystemConstantValues(
       bool primitive_polygonal,
@@ -688,6 +691,32 @@ class VulkanCommandProcessor final : public CommandProcessor {
   bool dynamic_stencil_write_mask_back_update_needed_;
   bool dynamic_stencil_reference_front_update_needed_;
   bool dynamic_stencil_reference_back_update_needed_;
+  // Extended dynamic state, used if VulkanPipelineCache doesn't store it in the
+  // pipeline descriptions. Guest pipelines never have this state static, while
+  // external pipelines always do, so it's always invalidated when binding an
+  // external pipeline. Stencil operations are packed as 3-bit xenos::StencilOp
+  // fail, pass, depth fail operations and the xenos::CompareFunction.
+  VkCullModeFlags dynamic_cull_mode_ = VK_CULL_MODE_NONE;
+  VkFrontFace dynamic_front_face_ = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  bool dynamic_depth_test_enable_ = false;
+  bool dynamic_depth_write_enable_ = false;
+  xenos::CompareFunction dynamic_depth_compare_op_ =
+      xenos::CompareFunction::kAlways;
+  bool dynamic_stencil_test_enable_ = false;
+  uint32_t dynamic_stencil_op_front_ = uint32_t(xenos::CompareFunction::kAlways)
+                                       << 9;
+  uint32_t dynamic_stencil_op_back_ = uint32_t(xenos::CompareFunction::kAlways)
+                                      << 9;
+  bool dynamic_primitive_restart_enable_ = false;
+  bool dynamic_cull_mode_update_needed_;
+  bool dynamic_front_face_update_needed_;
+  bool dynamic_depth_test_enable_update_needed_;
+  bool dynamic_depth_write_enable_update_needed_;
+  bool dynamic_depth_compare_op_update_needed_;
+  bool dynamic_stencil_test_enable_update_needed_;
+  bool dynamic_stencil_op_front_update_needed_;
+  bool dynamic_stencil_op_back_update_needed_;
+  bool dynamic_primitive_restart_enable_update_needed_;
 
   // Currently used samplers.
   std::vector<std::pair<VulkanTextureCache::SamplerParameters, VkSampler>>
@@ -12,13 +12,21 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/clock.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/profiling.h"
@@ -34,6 +42,48 @@
 #include "xenia/gpu/xenos.h"
 #include "xenia/ui/vulkan/vulkan_util.h"
 
+DEFINE_string(
+    vulkan_spirv_optimization, "none",
+    "Optimize the SPIR-V translated from guest shaders with SPIRV-Tools from "
+    "the Vulkan SDK (located via the VULKAN_SDK environment variable) on a "
+    "background thread.\n"
+    "Use: [none, performance, size]\n"
+    " none: Use the translator output directly.\n"
+    " performance: Run the SPIRV-Tools performance pass recipe.\n"
+    " size: Run the SPIRV-Tools size pass recipe.\n"
+    "Until the optimization of a shader is complete, the unoptimized shader is "
+    "used - pipelines created before that are not recreated. With "
+    "vulkan_graphics_pipeline_library, this also applies to the pipeline "
+    "libraries, so pipelines linked later from a library created before the "
+    "optimization still use the unoptimized shader. Results, as well as "
+    "failures, are stored in the shader storage for the SPIRV-Tools version "
+    "used, and reused on subsequent launches.",
+    "Vulkan");
+
+DEFINE_bool(
+    vulkan_extended_dynamic_state, true,
+    "Use VK_EXT_extended_dynamic_state and VK_EXT_extended_dynamic_state2 if "
+    "available to set culling, depth / stencil and primitive restart state "
+    "dynamically instead of creating separate pipelines for every combination "
+    "of their values.",
+    "Vulkan");
+
+DEFINE_bool(
+    vulkan_graphics_pipeline_library, true,
+    "Create guest graphics pipelines by linking separately created and reused "
+    "vertex input, pre-rasterization, fragment shader and fragment output "
+    "state libraries if VK_EXT_graphics_pipeline_library with fast linking is "
+    "supported (it's also exposed by some software implementations, such as "
+    "lavapipe), reducing stalls when new combinations of shaders and state "
+    "are drawn.",
+    "Vulkan");
+DEFINE_bool(
+    vulkan_graphics_pipeline_library_optimized_link, true,
+    "When creating pipelines from libraries, also create link-time-optimized "
+    "versions of them on a background thread, replacing the quickly linked "
+    "pipelines when ready.",
+    "Vulkan");
+
 namespace xe {
 namespace gpu {
 namespace vulkan {
@@ -58,12 +108,63 @@ bool VulkanPipelineCache::Initialize() {
       render_target_cache_.GetPath() ==
       RenderTargetCache::Path::kPixelShaderInterlock;
 
+  const ui::vulkan::VulkanProvider::DeviceInfo& device_info =
+      provider.device_info();
+  extended_dynamic_state_used_ =
+      cvars::vulkan_extended_dynamic_state && device_info.extendedDynamicState;
+  extended_dynamic_state2_used_ =
+      cvars::vulkan_extended_dynamic_state && device_info.extendedDynamicState2;
+
+  // Without fast linking, linking the libraries may take as long as creating
+  // a monolithic pipeline, and the optimized link would then compile each
+  // pipeline twice.
+  graphics_pipeline_library_used_ =
+      cvars::vulkan_graphics_pipeline_library &&
+      device_info.graphicsPipelineLibrary &&
+      device_info.graphicsPipelineLibraryFastLinking;
+  if (graphics_pipeline_library_used_ &&
+      cvars::vulkan_graphics_pipeline_library_optimized_link) {
+    optimized_link_shutdown_ = false;
+    optimized_link_thread_ = xe::threading::Thread::Create(
+        {}, [this]() { OptimizedLinkThread(); });
+    assert_not_null(optimized_link_thread_);
+    optimized_link_thread_->set_name("Vulkan Pipeline Optimized Link");
+  }
+
+  SpirvShaderTranslator::Features translator_features(device_info);
   shader_translator_ = std::make_unique<SpirvShaderTranslator>(
-      SpirvShaderTranslator::Features(provider.device_info()),
+      translator_features,
       render_target_cache_.msaa_2x_attachments_supported(),
       render_target_cache_.msaa_2x_no_attachments_supported(),
       edram_fragment_shader_interlock);
 
+  spirv_optimization_ = SpirvOptimization::kNone;
+  if (cvars::vulkan_spirv_optimization == "performance") {
+    spirv_optimization_ = SpirvOptimization::kPerformance;
+  } else if (cvars::vulkan_spirv_optimization == "size") {
+    spirv_optimization_ = SpirvOptimization::kSize;
+  } else if (!cvars::vulkan_spirv_optimization.empty() &&
+             cvars::vulkan_spirv_optimization != "none") {
+    XELOGW("VulkanPipelineCache: Unknown SPIR-V optimization recipe \"{}\"",
+           cvars::vulkan_spirv_optimization);
+  }
+  if (spirv_optimization_ != SpirvOptimization::kNone) {
+    if (spirv_tools_context_.Initialize(translator_features.spirv_version) &&
+        spirv_tools_context_.IsOptimizerAvailable()) {
+      spirv_optimization_shutdown_ = false;
+      spirv_optimization_thread_ = xe::threading::Thread::Create(
+          {}, [this]() { SpirvOptimizationThread(); });
+      assert_not_null(spirv_optimization_thread_);
+      spirv_optimization_thread_->set_name("Vulkan SPIR-V Optimization");
+    } else {
+      XELOGW(
+          "VulkanPipelineCache: SPIRV-Tools optimizer is not available, "
+          "translated shaders will not be optimized");
+      spirv_tools_context_.Shutdown();
+      spirv_optimization_ = SpirvOptimization::kNone;
+    }
+  }
+
   if (edram_fragment_shader_interlock) {
     std::vector<uint8_t> depth_only_fragment_shader_code =
         shader_translator_->CreateDepthOnlyFragmentShader();
@@ -90,6 +191,56 @@ void VulkanPipelineCache::Shutdown() {
   const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
   VkDevice device = provider.device();
 
+  // Stop the optimization thread before destroying the translations it may be
+  // referencing.
+  if (spirv_optimization_thread_) {
+    {
+      std::lock_guard<xe_mutex> lock(spirv_optimization_lock_);
+      spirv_optimization_shutdown_ = true;
+    }
+    spirv_optimization_cond_.notify_one();
+    xe::threading::Wait(spirv_optimization_thread_.get(), false);
+    spirv_optimization_thread_.reset();
+    if (spirv_optimization_shaders_optimized_ ||
+        spirv_optimization_shaders_loaded_) {
+      XELOGI(
+          "VulkanPipelineCache: Optimized {} shaders ({} SPIR-V instructions "
+          "before, {} after), loaded {} optimized shaders from the storage",
+          spirv_optimization_shaders_optimized_,
+          spirv_optimization_instructions_before_,
+          spirv_optimization_instructions_after_,
+          spirv_optimization_shaders_loaded_);
+    }
+  }
+  spirv_optimization_queue_.clear();
+  spirv_optimization_completed_.clear();
+  spirv_optimization_instructions_before_ = 0;
+  spirv_optimization_instructions_after_ = 0;
+  spirv_optimization_shaders_optimized_ = 0;
+  spirv_optimization_shaders_loaded_ = 0;
+  spirv_tools_context_.Shutdown();
+  spirv_optimization_ = SpirvOptimization::kNone;
+
+  LogPipelineStatistics();
+
+  // Stop the optimized link thread before destroying the pipelines and the
+  // libraries it may be using.
+  if (optimized_link_thread_) {
+    {
+      std::lock_guard<xe_mutex> lock(optimized_link_lock_);
+      optimized_link_shutdown_ = true;
+    }
+    optimized_link_cond_.notify_one();
+    xe::threading::Wait(optimized_link_thread_.get(), false);
+    optimized_link_thread_.reset();
+  }
+  optimized_link_queue_.clear();
+  for (const OptimizedLinkRequest& optimized_link : optimized_link_completed_) {
+    dfn.vkDestroyPipeline(device, optimized_link.optimized_pipeline, nullptr);
+  }
+  optimized_link_completed_.clear();
+  optimized_link_completed_set_.store(false, std::memory_order_relaxed);
+
   // Destroy all pipelines.
   last_pipeline_ = nullptr;
   for (const auto& pipeline_pair : pipelines_) {
@@ -98,6 +249,16 @@ void VulkanPipelineCache::Shutdown() {
     }
   }
   pipelines_.clear();
+  for (const auto& destroy_pair : destroy_fast_linked_pipelines_) {
+    dfn.vkDestroyPipeline(device, destroy_pair.second, nullptr);
+  }
+  destroy_fast_linked_pipelines_.clear();
+  for (const auto& pipeline_library_pair : pipeline_libraries_) {
+    if (pipeline_library_pair.second != VK_NULL_HANDLE) {
+      dfn.vkDestroyPipeline(device, pipeline_library_pair.second, nullptr);
+    }
+  }
+  pipeline_libraries_.clear();
 
   // Destroy all internal shaders.
   ui::vulkan::util::DestroyAndNullHandle(dfn.vkDestroyShaderModule, device,
@@ -121,6 +282,43 @@ void VulkanPipelineCache::Shutdown() {
   shader_translator_.reset();
 }
 
+void VulkanPipelineCache::InitializeShaderStorage(
+    const std::filesystem::path& cache_root, uint32_t title_id, bool blocking) {
+  if (title_id != statistics_title_id_) {
+    LogPipelineStatistics();
+    statistics_title_id_ = title_id;
+  }
+
+  spirv_optimization_storage_root_.clear();
+  if (spirv_optimization_ == SpirvOptimization::kNone) {
+    return;
+  }
+  // Optimized SPIR-V depends on the SPIRV-Tools version, so it's not placed in
+  // the shareable storage, and is stored separately for each version. It
+  // doesn't depend on the title, so shared between all titles.
+  const char* spirv_tools_version = spirv_tools_context_.GetVersionDetails();
+  if (!spirv_tools_version) {
+    XELOGW(
+        "VulkanPipelineCache: The SPIRV-Tools version is unknown, optimized "
+        "shaders will not be stored");
+    return;
+  }
+  std::filesystem::path storage_root =
+      cache_root / "shaders" / "local" / "vulkan_spirv_optimized" /
+      fmt::format("{:016X}", XXH3_64bits(spirv_tools_version,
+                                         std::strlen(spirv_tools_version)));
+  if (!std::filesystem::exists(storage_root)) {
+    if (!std::filesystem::create_directories(storage_root)) {
+      XELOGE(
+          "VulkanPipelineCache: Failed to create the optimized SPIR-V storage "
+          "directory, optimized shaders will not be stored: {}",
+          xe::path_to_utf8(storage_root));
+      return;
+    }
+  }
+  spirv_optimization_storage_root_ = std::move(storage_root);
+}
+
 VulkanShader* VulkanPipelineCache::LoadShader(xenos::ShaderType shader_type,
                                               const uint32_t* host_address,
                                               uint32_t dword_count) {
@@ -284,6 +482,9 @@ bool VulkanPipelineCache::ConfigurePipeline(
           description)) {
     return false;
   }
+  if (optimized_link_completed_set_.load(std::memory_order_relaxed)) {
+    ApplyCompletedOptimizedLinks();
+  }
   if (last_pipeline_ && last_pipeline_->first == description) {
     pipeline_out = last_pipeline_->second.pipeline;
     pipeline_layout_out = last_pipeline_->second.pipeline_layout;
@@ -298,6 +499,7 @@ bool VulkanPipelineCache::ConfigurePipeline(
   }
 
   // Create the pipeline if not the latest and not already existing.
+  ApplyCompletedSpirvOptimizations();
   const PipelineLayoutProvider* pipeline_layout =
       command_processor_.GetPipelineLayout(
           pixel_shader
@@ -369,6 +571,77 @@ bool VulkanPipelineCache::TranslateAnalyzedShader(
            shader.ucode_data_hash());
     return false;
   }
+
+  // Use the optimized SPIR-V from the storage if it has already been created
+  // in a previous session, or request the optimization in the background.
+  if (spirv_optimization_ != SpirvOptimization::kNone &&
+      translation.shader_module() == VK_NULL_HANDLE) {
+    const std::vector<uint8_t>& unoptimized = translation.translated_binary();
+    uint64_t unoptimized_hash =
+        XXH3_64bits(unoptimized.data(), unoptimized.size());
+    std::filesystem::path storage_path =
+        GetOptimizedSpirvStoragePath(unoptimized_hash);
+    bool optimized_loaded = false;
+    bool optimization_failed_before = false;
+    if (!storage_path.empty()) {
+      std::filesystem::path failed_path = storage_path;
+      failed_path.replace_extension(".failed");
+      std::error_code error_code;
+      optimization_failed_before =
+          std::filesystem::exists(failed_path, error_code);
+    }
+    if (!storage_path.empty() && !optimization_failed_before) {
+      FILE* file = xe::filesystem::OpenFile(storage_path, "rb");
+      if (file) {
+        std::vector<uint32_t> optimized;
+        if (!std::fseek(file, 0, SEEK_END)) {
+          long file_size = std::ftell(file);
+          if (file_size > 0 && !(file_size % sizeof(uint32_t))) {
+            optimized.resize(size_t(file_size) / sizeof(uint32_t));
+            std::fseek(file, 0, SEEK_SET);
+            if (std::fread(optimized.data(), sizeof(uint32_t),
+                           optimized.size(), file) != optimized.size()) {
+              optimized.clear();
+            }
+          }
+        }
+        std::fclose(file);
+        // The file may be damaged or written by a different version of the
+        // optimizer, and invalid SPIR-V must not be passed to the driver.
+        std::string validation_error;
+        if (!optimized.empty() && optimized[0] == spv::MagicNumber &&
+            spirv_tools_context_.Validate(optimized.data(), optimized.size(),
+                                          &validation_error) == SPV_SUCCESS &&
+            translation.ReplaceShaderModule(optimized.data(),
+                                            optimized.size())) {
+          optimized_loaded = true;
+          ++spirv_optimization_shaders_loaded_;
+        } else {
+          XELOGW(
+              "VulkanPipelineCache: Discarding the invalid stored optimized "
+              "SPIR-V {:016X}{}{}",
+              unoptimized_hash, validation_error.empty() ? "" : ": ",
+              validation_error);
+          std::error_code error_code;
+          std::filesystem::remove(storage_path, error_code);
+        }
+      }
+    }
+    if (!optimized_loaded && !optimization_failed_before) {
+      SpirvOptimizationRequest request;
+      request.translation = &translation;
+      request.unoptimized_hash = unoptimized_hash;
+      request.spirv.resize(unoptimized.size() / sizeof(uint32_t));
+      std::memcpy(request.spirv.data(), unoptimized.data(),
+                  request.spirv.size() * sizeof(uint32_t));
+      request.storage_path = std::move(storage_path);
+      {
+        std::lock_guard<xe_mutex> lock(spirv_optimization_lock_);
+        spirv_optimization_queue_.push_back(std::move(request));
+      }
+      spirv_optimization_cond_.notify_one();
+    }
+  }
   if (translation.GetOrCreateShaderModule() == VK_NULL_HANDLE) {
     return false;
   }
@@ -569,6 +842,7 @@ bool VulkanPipelineCache::GetCurrentStateDescription(
   description_out.geometry_shader = geometry_shader;
   description_out.primitive_topology = primitive_topology;
   description_out.primitive_restart =
+      !extended_dynamic_state2_used_ &&
       primitive_processing_result.host_primitive_reset_enabled;
 
   description_out.depth_clamp_enable =
@@ -585,8 +859,10 @@ bool VulkanPipelineCache::GetCurrentStateDescription(
     // highest) based on which faces are not culled.
     bool cull_front = pa_su_sc_mode_cntl.cull_front;
     bool cull_back = pa_su_sc_mode_cntl.cull_back;
-    description_out.cull_front = cull_front;
-    description_out.cull_back = cull_back;
+    if (!extended_dynamic_state_used_) {
+      description_out.cull_front = cull_front;
+      description_out.cull_back = cull_back;
+    }
     if (device_info.fillModeNonSolid) {
       xenos::PolygonType polygon_type = xenos::PolygonType::kTriangles;
       if (!cull_front) {
@@ -621,14 +897,17 @@ bool VulkanPipelineCache::GetCurrentStateDescription(
     } else {
       description_out.polygon_mode = PipelinePolygonMode::kFill;
     }
-    description_out.front_face_clockwise = pa_su_sc_mode_cntl.face != 0;
+    if (!extended_dynamic_state_used_) {
+      description_out.front_face_clockwise = pa_su_sc_mode_cntl.face != 0;
+    }
   } else {
     description_out.polygon_mode = PipelinePolygonMode::kFill;
   }
 
   if (render_target_cache_.GetPath() ==
       RenderTargetCache::Path::kHostRenderTargets) {
-    if (render_pass_key.depth_and_color_used & 1) {
+    if (!extended_dynamic_state_used_ &&
+        (render_pass_key.depth_and_color_used & 1)) {
       if (normalized_depth_control.z_enable) {
         description_out.depth_write_enable =
             normalized_depth_control.z_write_enable;
@@ -2228,7 +2507,7 @@ bool VulkanPipelineCache::EnsurePipelineCreated(
     }
   }
 
-  std::array<VkDynamicState, 7> dynamic_states;
+  std::array<VkDynamicState, 15> dynamic_states;
   VkPipelineDynamicStateCreateInfo dynamic_state;
   dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
   dynamic_state.pNext = nullptr;
@@ -2253,6 +2532,28 @@ bool VulkanPipelineCache::EnsurePipelineCreated(
     dynamic_states[dynamic_state.dynamicStateCount++] =
         VK_DYNAMIC_STATE_STENCIL_REFERENCE;
   }
+  if (extended_dynamic_state_used_) {
+    dynamic_states[dynamic_state.dynamicStateCount++] =
+        VK_DYNAMIC_STATE_CULL_MODE;
+    dynamic_states[dynamic_state.dynamicStateCount++] =
+        VK_DYNAMIC_STATE_FRONT_FACE;
+    if (!edram_fragment_shader_interlock) {
+      dynamic_states[dynamic_state.dynamicStateCount++] =
+          VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE;
+      dynamic_states[dynamic_state.dynamicStateCount++] =
+          VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE;
+      dynamic_states[dynamic_state.dynamicStateCount++] =
+          VK_DYNAMIC_STATE_DEPTH_COMPARE_OP;
+      dynamic_states[dynamic_state.dynamicStateCount++] =
+          VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE;
+      dynamic_states[dynamic_state.dynamicStateCount++] =
+          VK_DYNAMIC_STATE_STENCIL_OP;
+    }
+  }
+  if (extended_dynamic_state2_used_) {
+    dynamic_states[dynamic_state.dynamicStateCount++] =
+        VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE;
+  }
 
   VkGraphicsPipelineCreateInfo pipeline_create_info;
   pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -2278,10 +2579,56 @@ bool VulkanPipelineCache::EnsurePipelineCreated(
 
   const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
   VkDevice device = provider.device();
-  VkPipeline pipeline;
-  if (dfn.vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1,
-                                    &pipeline_create_info, nullptr,
-                                    &pipeline) != VK_SUCCESS) {
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  uint64_t creation_start_ticks = Clock::QueryHostTickCount();
+  if (graphics_pipeline_library_used_) {
+    // Fast-link the pipeline from the state subset libraries, reusing the ones
+    // already created for other pipelines, falling back to creating a
+    // complete pipeline if any of the libraries couldn't be created.
+    std::array<VkPipeline, size_t(PipelineLibraryPart::kCount)> libraries;
+    bool libraries_available = true;
+    for (size_t i = 0; i < libraries.size(); ++i) {
+      libraries[i] = GetPipelineLibrary(
+          PipelineLibraryPart(i), description,
+          creation_arguments.pipeline->second.pipeline_layout,
+          pipeline_create_info);
+      if (libraries[i] == VK_NULL_HANDLE) {
+        libraries_available = false;
+        break;
+      }
+    }
+    if (libraries_available) {
+      pipeline = LinkPipelineLibraries(libraries, pipeline_create_info.layout,
+                                       pipeline_create_info.renderPass, false);
+      if (pipeline != VK_NULL_HANDLE) {
+        ++statistics_pipelines_fast_linked_;
+        if (optimized_link_thread_) {
+          OptimizedLinkRequest optimized_link;
+          optimized_link.pipeline = creation_arguments.pipeline;
+          optimized_link.libraries = libraries;
+          optimized_link.pipeline_layout = pipeline_create_info.layout;
+          optimized_link.render_pass = pipeline_create_info.renderPass;
+          optimized_link.optimized_pipeline = VK_NULL_HANDLE;
+          {
+            std::lock_guard<xe_mutex> lock(optimized_link_lock_);
+            optimized_link_queue_.push_back(optimized_link);
+          }
+          optimized_link_cond_.notify_one();
+        }
+      }
+    }
+  }
+  VkResult creation_result = VK_SUCCESS;
+  if (pipeline == VK_NULL_HANDLE) {
+    creation_result = dfn.vkCreateGraphicsPipelines(
+        device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &pipeline);
+  }
+  uint64_t creation_ticks = Clock::QueryHostTickCount() - creation_start_ticks;
+  ++statistics_pipelines_created_;
+  statistics_pipeline_creation_ticks_ += creation_ticks;
+  statistics_pipeline_creation_max_ticks_ =
+      std::max(statistics_pipeline_creation_max_ticks_, creation_ticks);
+  if (creation_result != VK_SUCCESS) {
     // TODO(Triang3l): Move these error messages outside.
     /* if (creation_arguments.pixel_shader) {
       XELOGE(
@@ -2298,6 +2645,393 @@ bool VulkanPipelineCache::EnsurePipelineCreated(
   return true;
 }
 
+VkPipeline VulkanPipelineCache::GetPipelineLibrary(
+    PipelineLibraryPart part, const PipelineDescription& description,
+    const PipelineLayoutProvider* pipeline_layout_provider,
+    const VkGraphicsPipelineCreateInfo& pipeline_create_info) {
+  PipelineLibraryDescription library_description;
+  library_description.part = part;
+  PipelineDescription& library_state = library_description.description;
+  VkGraphicsPipelineLibraryFlagsEXT library_flags;
+  switch (part) {
+    case PipelineLibraryPart::kVertexInput:
+      library_flags =
+          VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+      library_state.primitive_topology = description.primitive_topology;
+      library_state.primitive_restart = description.primitive_restart;
+      break;
+    case PipelineLibraryPart::kPreRasterization:
+      library_flags =
+          VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+      library_description.pipeline_layout =
+          uint64_t(uintptr_t(pipeline_layout_provider));
+      library_state.vertex_shader_hash = description.vertex_shader_hash;
+      library_state.vertex_shader_modification =
+          description.vertex_shader_modification;
+      // The geometry shader depends on the pixel shader modification too.
+      library_state.pixel_shader_modification =
+          description.pixel_shader_modification;
+      library_state.render_pass_key = description.render_pass_key;
+      library_state.geometry_shader = description.geometry_shader;
+      library_state.depth_clamp_enable = description.depth_clamp_enable;
+      library_state.polygon_mode = description.polygon_mode;
+      library_state.cull_front = description.cull_front;
+      library_state.cull_back = description.cull_back;
+      library_state.front_face_clockwise = description.front_face_clockwise;
+      break;
+    case PipelineLibraryPart::kFragmentShader:
+      library_flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+      library_description.pipeline_layout =
+          uint64_t(uintptr_t(pipeline_layout_provider));
+      library_state.pixel_shader_hash = description.pixel_shader_hash;
+      library_state.pixel_shader_modification =
+          description.pixel_shader_modification;
+      library_state.render_pass_key = description.render_pass_key;
+      library_state.depth_write_enable = description.depth_write_enable;
+      library_state.depth_compare_op = description.depth_compare_op;
+      library_state.stencil_test_enable = description.stencil_test_enable;
+      library_state.stencil_front_fail_op = description.stencil_front_fail_op;
+      library_state.stencil_front_pass_op = description.stencil_front_pass_op;
+      library_state.stencil_front_depth_fail_op =
+          description.stencil_front_depth_fail_op;
+      library_state.stencil_front_compare_op =
+          description.stencil_front_compare_op;
+      library_state.stencil_back_fail_op = description.stencil_back_fail_op;
+      library_state.stencil_back_pass_op = description.stencil_back_pass_op;
+      library_state.stencil_back_depth_fail_op =
+          description.stencil_back_depth_fail_op;
+      library_state.stencil_back_compare_op =
+          description.stencil_back_compare_op;
+      break;
+    case PipelineLibraryPart::kFragmentOutput:
+      library_flags =
+          VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+      library_state.render_pass_key = description.render_pass_key;
+      std::memcpy(library_state.render_targets, description.render_targets,
+                  sizeof(library_state.render_targets));
+      break;
+    default:
+      assert_unhandled_case(part);
+      return VK_NULL_HANDLE;
+  }
+
+  auto it = pipeline_libraries_.find(library_description);
+  if (it != pipeline_libraries_.end()) {
+    return it->second;
+  }
+
+  VkGraphicsPipelineLibraryCreateInfoEXT library_create_info;
+  library_create_info.sType =
+      VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+  library_create_info.pNext = nullptr;
+  library_create_info.flags = library_flags;
+
+  VkGraphicsPipelineCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  create_info.pNext = &library_create_info;
+  create_info.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+  if (optimized_link_thread_) {
+    create_info.flags |=
+        VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+  }
+  // Dynamic state not related to the subset is ignored.
+  create_info.pDynamicState = pipeline_create_info.pDynamicState;
+  create_info.basePipelineHandle = VK_NULL_HANDLE;
+  create_info.basePipelineIndex = -1;
+  std::array<VkPipelineShaderStageCreateInfo, 3> shader_stages;
+  create_info.pStages = shader_stages.data();
+  switch (part) {
+    case PipelineLibraryPart::kVertexInput:
+      create_info.pVertexInputState = pipeline_create_info.pVertexInputState;
+      create_info.pInputAssemblyState =
+          pipeline_create_info.pInputAssemblyState;
+      break;
+    case PipelineLibraryPart::kPreRasterization:
+      for (uint32_t i = 0; i < pipeline_create_info.stageCount; ++i) {
+        const VkPipelineShaderStageCreateInfo& shader_stage =
+            pipeline_create_info.pStages[i];
+        if (shader_stage.stage != VK_SHADER_STAGE_FRAGMENT_BIT) {
+          shader_stages[create_info.stageCount++] = shader_stage;
+        }
+      }
+      create_info.pTessellationState = pipeline_create_info.pTessellationState;
+      create_info.pViewportState = pipeline_create_info.pViewportState;
+      create_info.pRasterizationState =
+          pipeline_create_info.pRasterizationState;
+      create_info.layout = pipeline_create_info.layout;
+      create_info.renderPass = pipeline_create_info.renderPass;
+      create_info.subpass = pipeline_create_info.subpass;
+      break;
+    case PipelineLibraryPart::kFragmentShader:
+      for (uint32_t i = 0; i < pipeline_create_info.stageCount; ++i) {
+        const VkPipelineShaderStageCreateInfo& shader_stage =
+            pipeline_create_info.pStages[i];
+        if (shader_stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+          shader_stages[create_info.stageCount++] = shader_stage;
+        }
+      }
+      create_info.pMultisampleState = pipeline_create_info.pMultisampleState;
+      create_info.pDepthStencilState = pipeline_create_info.pDepthStencilState;
+      create_info.layout = pipeline_create_info.layout;
+      create_info.renderPass = pipeline_create_info.renderPass;
+      create_info.subpass = pipeline_create_info.subpass;
+      break;
+    case PipelineLibraryPart::kFragmentOutput:
+      create_info.pMultisampleState = pipeline_create_info.pMultisampleState;
+      create_info.pColorBlendState = pipeline_create_info.pColorBlendState;
+      create_info.renderPass = pipeline_create_info.renderPass;
+      create_info.subpass = pipeline_create_info.subpass;
+      break;
+    default:
+      break;
+  }
+
+  const ui::vulkan::VulkanProvider& provider =
+      command_processor_.GetVulkanProvider();
+  VkPipeline library;
+  if (provider.dfn().vkCreateGraphicsPipelines(
+          provider.device(), VK_NULL_HANDLE, 1, &create_info, nullptr,
+          &library) != VK_SUCCESS) {
+    XELOGE("VulkanPipelineCache: Failed to create a pipeline library");
+    library = VK_NULL_HANDLE;
+  } else {
+    ++statistics_pipeline_libraries_created_;
+  }
+  pipeline_libraries_.emplace(library_description, library);
+  return library;
+}
+
+VkPipeline VulkanPipelineCache::LinkPipelineLibraries(
+    const std::array<VkPipeline, size_t(PipelineLibraryPart::kCount)>&
+        libraries,
+    VkPipelineLayout pipeline_layout, VkRenderPass render_pass,
+    bool link_time_optimization) const {
+  VkPipelineLibraryCreateInfoKHR library_create_info;
+  library_create_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+  library_create_info.pNext = nullptr;
+  library_create_info.libraryCount = uint32_t(libraries.size());
+  library_create_info.pLibraries = libraries.data();
+
+  VkGraphicsPipelineCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  create_info.pNext = &library_create_info;
+  if (link_time_optimization) {
+    create_info.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+  }
+  create_info.layout = pipeline_layout;
+  create_info.renderPass = render_pass;
+  create_info.subpass = 0;
+  create_info.basePipelineHandle = VK_NULL_HANDLE;
+  create_info.basePipelineIndex = -1;
+
+  const ui::vulkan::VulkanProvider& provider =
+      command_processor_.GetVulkanProvider();
+  VkPipeline pipeline;
+  if (provider.dfn().vkCreateGraphicsPipelines(
+          provider.device(), VK_NULL_HANDLE, 1, &create_info, nullptr,
+          &pipeline) != VK_SUCCESS) {
+    return VK_NULL_HANDLE;
+  }
+  return pipeline;
+}
+
+void VulkanPipelineCache::ApplyCompletedOptimizedLinks() {
+  std::vector<OptimizedLinkRequest> completed;
+  {
+    std::lock_guard<xe_mutex> lock(optimized_link_lock_);
+    completed.swap(optimized_link_completed_);
+    optimized_link_completed_set_.store(false, std::memory_order_relaxed);
+  }
+  for (const OptimizedLinkRequest& optimized_link : completed) {
+    // The fast-linked pipeline may still be used in the current submission and
+    // the ones in flight, but not after this, as the command processor rebinds
+    // the pipeline when the handle is different.
+    Pipeline& pipeline = optimized_link.pipeline->second;
+    destroy_fast_linked_pipelines_.emplace_back(
+        command_processor_.GetCurrentSubmission(), pipeline.pipeline);
+    pipeline.pipeline = optimized_link.optimized_pipeline;
+  }
+}
+
+void VulkanPipelineCache::CompletedSubmissionUpdated() {
+  const ui::vulkan::VulkanProvider& provider =
+      command_processor_.GetVulkanProvider();
+  const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
+  VkDevice device = provider.device();
+  uint64_t completed_submission = command_processor_.GetCompletedSubmission();
+  while (!destroy_fast_linked_pipelines_.empty()) {
+    const auto& destroy_pair = destroy_fast_linked_pipelines_.front();
+    if (destroy_pair.first > completed_submission) {
+      break;
+    }
+    dfn.vkDestroyPipeline(device, destroy_pair.second, nullptr);
+    destroy_fast_linked_pipelines_.pop_front();
+  }
+}
+
+void VulkanPipelineCache::OptimizedLinkThread() {
+  while (true) {
+    OptimizedLinkRequest optimized_link;
+    {
+      std::unique_lock<xe_mutex> lock(optimized_link_lock_);
+      while (!optimized_link_shutdown_ && optimized_link_queue_.empty()) {
+        optimized_link_cond_.wait(lock);
+      }
+      if (optimized_link_shutdown_) {
+        return;
+      }
+      optimized_link = optimized_link_queue_.front();
+      optimized_link_queue_.pop_front();
+    }
+
+    optimized_link.optimized_pipeline = LinkPipelineLibraries(
+        optimized_link.libraries, optimized_link.pipeline_layout,
+        optimized_link.render_pass, true);
+    if (optimized_link.optimized_pipeline == VK_NULL_HANDLE) {
+      // Keep using the fast-linked pipeline.
+      continue;
+    }
+
+    {
+      std::lock_guard<xe_mutex> lock(optimized_link_lock_);
+      optimized_link_completed_.push_back(optimized_link);
+      optimized_link_completed_set_.store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+void VulkanPipelineCache::LogPipelineStatistics() {
+  if (statistics_pipelines_created_) {
+    uint64_t tick_frequency = Clock::QueryHostTickFrequency();
+    XELOGI(
+        "VulkanPipelineCache: Title {:08X}: created {} pipelines in {} ms "
+        "(longest {} ms), extended dynamic state {}, extended dynamic state 2 "
+        "{}, {} pipelines fast-linked from {} new libraries",
+        statistics_title_id_, statistics_pipelines_created_,
+        statistics_pipeline_creation_ticks_ * 1000 / tick_frequency,
+        statistics_pipeline_creation_max_ticks_ * 1000 / tick_frequency,
+        extended_dynamic_state_used_ ? "used" : "not used",
+        extended_dynamic_state2_used_ ? "used" : "not used",
+        statistics_pipelines_fast_linked_,
+        statistics_pipeline_libraries_created_);
+  }
+  statistics_pipelines_created_ = 0;
+  statistics_pipelines_fast_linked_ = 0;
+  statistics_pipeline_libraries_created_ = 0;
+  statistics_pipeline_creation_ticks_ = 0;
+  statistics_pipeline_creation_max_ticks_ = 0;
+}
+
+std::filesystem::path VulkanPipelineCache::GetOptimizedSpirvStoragePath(
+    uint64_t unoptimized_hash) const {
+  if (spirv_optimization_storage_root_.empty()) {
+    return std::filesystem::path();
+  }
+  return spirv_optimization_storage_root_ /
+         fmt::format("{:016X}.{}.spv", unoptimized_hash,
+                     spirv_optimization_ == SpirvOptimization::kSize
+                         ? "size"
+                         : "performance");
+}
+
+void VulkanPipelineCache::ApplyCompletedSpirvOptimizations() {
+  if (spirv_optimization_ == SpirvOptimization::kNone) {
+    return;
+  }
+  std::vector<SpirvOptimizationRequest> completed;
+  {
+    std::lock_guard<xe_mutex> lock(spirv_optimization_lock_);
+    if (spirv_optimization_completed_.empty()) {
+      return;
+    }
+    completed.swap(spirv_optimization_completed_);
+  }
+  for (const SpirvOptimizationRequest& result : completed) {
+    result.translation->ReplaceShaderModule(result.spirv.data(),
+                                            result.spirv.size());
+  }
+}
+
+void VulkanPipelineCache::SpirvOptimizationThread() {
+  bool for_size = spirv_optimization_ == SpirvOptimization::kSize;
+  while (true) {
+    SpirvOptimizationRequest request;
+    {
+      std::unique_lock<xe_mutex> lock(spirv_optimization_lock_);
+      while (!spirv_optimization_shutdown_ &&
+             spirv_optimization_queue_.empty()) {
+        spirv_optimization_cond_.wait(lock);
+      }
+      if (spirv_optimization_shutdown_) {
+        return;
+      }
+      request = std::move(spirv_optimization_queue_.front());
+      spirv_optimization_queue_.pop_front();
+    }
+
+    std::vector<uint32_t> optimized;
+    spv_result_t result = spirv_tools_context_.Optimize(
+        request.spirv.data(), request.spirv.size(), for_size, optimized);
+    if (result != SPV_SUCCESS || optimized.empty()) {
+      XELOGW(
+          "VulkanPipelineCache: Failed to optimize SPIR-V {:016X} (error {}), "
+          "keeping the unoptimized shader",
+          request.unoptimized_hash, int32_t(result));
+      if (!request.storage_path.empty()) {
+        // Don't retry on every launch with the same SPIRV-Tools version.
+        std::filesystem::path failed_path = request.storage_path;
+        failed_path.replace_extension(".failed");
+        FILE* file = xe::filesystem::OpenFile(failed_path, "wb");
+        if (file) {
+          std::fclose(file);
+        }
+      }
+      continue;
+    }
+    size_t instructions_before =
+        ui::vulkan::SpirvToolsContext::CountInstructions(request.spirv.data(),
+                                                         request.spirv.size());
+    size_t instructions_after =
+        ui::vulkan::SpirvToolsContext::CountInstructions(optimized.data(),
+                                                         optimized.size());
+
+    if (!request.storage_path.empty()) {
+      // Write to a temporary file renamed when complete, so a file truncated
+      // by a crash or a full disk never ends up at the storage path.
+      std::filesystem::path temp_path = request.storage_path;
+      temp_path += ".tmp";
+      FILE* file = xe::filesystem::OpenFile(temp_path, "wb");
+      if (file) {
+        bool written = std::fwrite(optimized.data(), sizeof(uint32_t),
+                                   optimized.size(),
+                                   file) == optimized.size();
+        written = !std::fclose(file) && written;
+        std::error_code error_code;
+        if (written) {
+          std::filesystem::rename(temp_path, request.storage_path, error_code);
+        }
+        if (!written || error_code) {
+          XELOGW(
+              "VulkanPipelineCache: Failed to store the optimized SPIR-V "
+              "{:016X}",
+              request.unoptimized_hash);
+          std::filesystem::remove(temp_path, error_code);
+        }
+      }
+    }
+
+    request.spirv = std::move(optimized);
+    {
+      std::lock_guard<xe_mutex> lock(spirv_optimization_lock_);
+      spirv_optimization_instructions_before_ += instructions_before;
+      spirv_optimization_instructions_after_ += instructions_after;
+      ++spirv_optimization_shaders_optimized_;
+      spirv_optimization_completed_.push_back(std::move(request));
+    }
+  }
+}
+
 }  // namespace vulkan
 }  // namespace gpu
 }  // namespace xe
@@ -10,15 +10,23 @@
 #ifndef XENIA_GPU_VULKAN_VULKAN_PIPELINE_STATE_CACHE_H_
 #define XENIA_GPU_VULKAN_VULKAN_PIPELINE_STATE_CACHE_H_
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <deque>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "xenia/base/hash.h"
+#include "xenia/base/mutex.h"
 #include "xenia/base/platform.h"
+#include "xenia/base/threading.h"
 #include "xenia/base/xxhash.h"
 #include "xenia/gpu/primitive_processor.h"
 #include "xenia/gpu/register_file.h"
@@ -27,6 +35,7 @@
 #include "xenia/gpu/vulkan/vulkan_render_target_cache.h"
 #include "xenia/gpu/vulkan/vulkan_shader.h"
 #include "xenia/gpu/xenos.h"
+#include "xenia/ui/vulkan/spirv_tools_context.h"
 #include "xenia/ui/vulkan/vulkan_provider.h"
 
 namespace xe {
@@ -59,6 +68,26 @@ class VulkanPipelineCache {
   bool Initialize();
   void Shutdown();
 
+  // Destroys the replaced fast-linked pipelines not used by the submissions
+  // still in flight anymore.
+  void CompletedSubmissionUpdated();
+
+  void InitializeShaderStorage(const std::filesystem::path& cache_root,
+                               uint32_t title_id, bool blocking);
+
+  // Whether the cull mode, the front face, and, with host render targets, the
+  // depth / stencil state are set dynamically via
+  // VK_EXT_extended_dynamic_state rather than being parts of pipeline
+  // descriptions.
+  bool IsExtendedDynamicStateUsed() const {
+    return extended_dynamic_state_used_;
+  }
+  // Whether primitive restart is set dynamically via
+  // VK_EXT_extended_dynamic_state2.
+  bool IsExtendedDynamicState2Used() const {
+    return extended_dynamic_state2_used_;
+  }
+
   VulkanShader* LoadShader(xenos::ShaderType shader_type,
                            const uint32_t* host_address, uint32_t dword_count);
   // Analyze shader microcode on the translator thread.
@@ -209,6 +238,54 @@ class VulkanPipelineCache {
         : pipeline_layout(pipeline_layout_provider) {}
   };
 
+  // VK_EXT_graphics_pipeline_library state subsets.
+  enum class PipelineLibraryPart : uint32_t {
+    kVertexInput,
+    kPreRasterization,
+    kFragmentShader,
+    kFragmentOutput,
+
+    kCount,
+  };
+
+  // A pipeline description with only the fields involved in the state subset
+  // of the library, so libraries are shared between pipelines that differ only
+  // in other state.
+  XEPACKEDSTRUCT(PipelineLibraryDescription, {
+    PipelineDescription description;
+    uint64_t pipeline_layout;
+    PipelineLibraryPart part;
+
+    PipelineLibraryDescription() { Reset(); }
+    PipelineLibraryDescription(const PipelineLibraryDescription& description) {
+      std::memcpy(this, &description, sizeof(*this));
+    }
+    PipelineLibraryDescription& operator=(
+        const PipelineLibraryDescription& description) {
+      std::memcpy(this, &description, sizeof(*this));
+      return *this;
+    }
+    bool operator==(const PipelineLibraryDescription& description) const {
+      return std::memcmp(this, &description, sizeof(*this)) == 0;
+    }
+    void Reset() { std::memset(this, 0, sizeof(*this)); }
+    uint64_t GetHash() const { return XXH3_64bits(this, sizeof(*this)); }
+    struct Hasher {
+      size_t operator()(const PipelineLibraryDescription& description) const {
+        return size_t(description.GetHash());
+      }
+    };
+  });
+
+  struct OptimizedLinkRequest {
+    std::pair<const PipelineDescription, Pipeline>* pipeline;
+    std::array<VkPipeline, size_t(PipelineLibraryPart::kCount)> libraries;
+    VkPipelineLayout pipeline_layout;
+    VkRenderPass render_pass;
+    // VK_NULL_HANDLE in the request, the optimized pipeline in the result.
+    VkPipeline optimized_pipeline;
+  };
+
   // Description that can be passed from the command processor thread to the
   // creation threads, with everything needed from caches pre-looked-up.
   struct PipelineCreationArguments {
@@ -246,10 +323,35 @@ class VulkanPipelineCache {
     }
   };
 
+  enum class SpirvOptimization {
+    kNone,
+    kPerformance,
+    kSize,
+  };
+
+  struct SpirvOptimizationRequest {
+    VulkanShader::VulkanTranslation* translation;
+    uint64_t unoptimized_hash;
+    // Unoptimized in the request, optimized in the result.
+    std::vector<uint32_t> spirv;
+    // Empty if the shader storage is not initialized.
+    std::filesystem::path storage_path;
+  };
+
   // Can be called from multiple threads.
   bool TranslateAnalyzedShader(SpirvShaderTranslator& translator,
                                VulkanShader::VulkanTranslation& translation);
 
+  // Path of the optimized SPIR-V in the shader storage, or an empty path if the
+  // storage is not initialized.
+  std::filesystem::path GetOptimizedSpirvStoragePath(
+      uint64_t unoptimized_hash) const;
+  // Switches translations to optimized shader modules that the optimization
+  // thread has produced since the last call. Must be called on the command
+  // processor thread.
+  void ApplyCompletedSpirvOptimizations();
+  void SpirvOptimizationThread();
+
   void WritePipelineRenderTargetDescription(
       reg::RB_BLENDCONTROL blend_control, uint32_t write_mask,
       PipelineRenderTarget& render_target_out) const;
@@ -262,6 +364,10 @@ class VulkanPipelineCache {
       VulkanRenderTargetCache::RenderPassKey render_pass_key,
       PipelineDescription& description_out) const;
 
+  // Logs the number of pipelines created for the current title and the time
+  // spent creating them, and resets the counters.
+  void LogPipelineStatistics();
+
   // Whether the pipeline for the given description is supported by the device.
   bool ArePipelineRequirementsMet(const PipelineDescription& description) const;
 
@@ -278,16 +384,64 @@ class VulkanPipelineCache {
   bool EnsurePipelineCreated(
       const PipelineCreationArguments& creation_arguments);
 
+  // Returns the library for the state subset of the pipeline description,
+  // creating it using the relevant parts of the full pipeline creation info if
+  // needed. Returns VK_NULL_HANDLE in case of a failure.
+  VkPipeline GetPipelineLibrary(
+      PipelineLibraryPart part, const PipelineDescription& description,
+      const PipelineLayoutProvider* pipeline_layout_provider,
+      const VkGraphicsPipelineCreateInfo& pipeline_create_info);
+  // Links the state subset libraries into a complete pipeline, either quickly
+  // or with link-time optimization. Can be called from any thread.
+  VkPipeline LinkPipelineLibraries(
+      const std::array<VkPipeline, size_t(PipelineLibraryPart::kCount)>&
+          libraries,
+      VkPipelineLayout pipeline_layout, VkRenderPass render_pass,
+      bool link_time_optimization) const;
+  // Switches pipelines to the link-time-optimized versions that the optimized
+  // link thread has created since the last call. Must be called on the command
+  // processor thread.
+  void ApplyCompletedOptimizedLinks();
+  void OptimizedLinkThread();
+
   VulkanCommandProcessor& command_processor_;
   const RegisterFile& register_file_;
   VulkanRenderTargetCache& render_target_cache_;
   VkShaderStageFlags guest_shader_vertex_stages_;
 
+  bool extended_dynamic_state_used_ = false;
+  bool extended_dynamic_state2_used_ = false;
+  bool graphics_pipeline_library_used_ = false;
+
   // Temporary storage for AnalyzeUcode calls on the processor thread.
   StringBuffer ucode_disasm_buffer_;
   // Reusable shader translator on the command processor thread.
   std::unique_ptr<SpirvShaderTranslator> shader_translator_;
 
+  // Background optimization of the translated SPIR-V. Until the optimized
+  // module is ready, the unoptimized one is used, so translation never waits
+  // for the optimizer.
+  SpirvOptimization spirv_optimization_ = SpirvOptimization::kNone;
+  ui::vulkan::SpirvToolsContext spirv_tools_context_;
+  // Directory for the optimized SPIR-V, keyed by the unoptimized SPIR-V hash,
+  // so the optimization is performed only once across launches. Empty if the
+  // shader storage is not initialized.
+  std::filesystem::path spirv_optimization_storage_root_;
+  std::unique_ptr<xe::threading::Thread> spirv_optimization_thread_;
+  xe_mutex spirv_optimization_lock_;
+  std::condition_variable_any spirv_optimization_cond_;
+  // Protected with spirv_optimization_lock_, notify_one
+  // spirv_optimization_cond_ when adding requests or requesting shutdown.
+  std::deque<SpirvOptimizationRequest> spirv_optimization_queue_;
+  bool spirv_optimization_shutdown_ = false;
+  // Protected with spirv_optimization_lock_.
+  std::vector<SpirvOptimizationRequest> spirv_optimization_completed_;
+  uint64_t spirv_optimization_instructions_before_ = 0;
+  uint64_t spirv_optimization_instructions_after_ = 0;
+  uint32_t spirv_optimization_shaders_optimized_ = 0;
+  // Only accessed on the command processor thread.
+  uint32_t spirv_optimization_shaders_loaded_ = 0;
+
   struct LayoutUID {
     size_t uid;
     size_t vector_span_offset;
@@ -321,6 +475,39 @@ class VulkanPipelineCache {
   std::unordered_map<PipelineDescription, Pipeline, PipelineDescription::Hasher>
       pipelines_;
 
+  // VK_EXT_graphics_pipeline_library state subset libraries. Stores
+  // VK_NULL_HANDLE if failed to create.
+  std::unordered_map<PipelineLibraryDescription, VkPipeline,
+                     PipelineLibraryDescription::Hasher>
+      pipeline_libraries_;
+
+  // Background creation of link-time-optimized pipelines replacing the
+  // fast-linked ones.
+  std::unique_ptr<xe::threading::Thread> optimized_link_thread_;
+  xe_mutex optimized_link_lock_;
+  std::condition_variable_any optimized_link_cond_;
+  // Protected with optimized_link_lock_, notify_one optimized_link_cond_ when
+  // adding requests or requesting shutdown.
+  std::deque<OptimizedLinkRequest> optimized_link_queue_;
+  bool optimized_link_shutdown_ = false;
+  // Protected with optimized_link_lock_, with optimized_link_completed_set_
+  // checked on the command processor thread without locking for each pipeline
+  // configuration.
+  std::vector<OptimizedLinkRequest> optimized_link_completed_;
+  std::atomic<bool> optimized_link_completed_set_{false};
+  // Fast-linked pipelines replaced with the link-time-optimized ones, with
+  // the last submission that may have used them, on the command processor
+  // thread.
+  std::deque<std::pair<uint64_t, VkPipeline>> destroy_fast_linked_pipelines_;
+
+  // Pipeline creation statistics for the current title.
+  uint32_t statistics_title_id_ = 0;
+  uint32_t statistics_pipelines_created_ = 0;
+  uint32_t statistics_pipelines_fast_linked_ = 0;
+  uint32_t statistics_pipeline_libraries_created_ = 0;
+  uint64_t statistics_pipeline_creation_ticks_ = 0;
+  uint64_t statistics_pipeline_creation_max_ticks_ = 0;
+
   // Previously used pipeline, to avoid lookups if the state wasn't changed.
   const std::pair<const PipelineDescription, Pipeline>* last_pipeline_ =
       nullptr;
@@ -34,26 +34,56 @@ VkShaderModule VulkanShader::VulkanTranslation::GetOrCreateShaderModule() {
   if (shader_module_ != VK_NULL_HANDLE) {
     return shader_module_;
   }
+  shader_module_ = CreateShaderModule(
+      reinterpret_cast<const uint32_t*>(translated_binary().data()),
+      translated_binary().size());
+  if (shader_module_ == VK_NULL_HANDLE) {
+    MakeInvalid();
+  }
+  return shader_module_;
+}
+
+bool VulkanShader::VulkanTranslation::ReplaceShaderModule(
+    const uint32_t* code, size_t code_dword_count) {
+  if (!is_valid()) {
+    return false;
+  }
+  VkShaderModule new_shader_module =
+      CreateShaderModule(code, code_dword_count * sizeof(uint32_t));
+  if (new_shader_module == VK_NULL_HANDLE) {
+    return false;
+  }
+  if (shader_module_ != VK_NULL_HANDLE) {
+    const ui::vulkan::VulkanProvider& provider =
+        static_cast<const VulkanShader&>(shader()).provider_;
+    provider.dfn().vkDestroyShaderModule(provider.device(), shader_module_,
+                                         nullptr);
+  }
+  shader_module_ = new_shader_module;
+  return true;
+}
+
+VkShaderModule VulkanShader::VulkanTranslation::CreateShaderModule(
+    const uint32_t* code, size_t code_size_bytes) const {
   const ui::vulkan::VulkanProvider& provider =
       static_cast<const VulkanShader&>(shader()).provider_;
   VkShaderModuleCreateInfo shader_module_create_info;
   shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
   shader_module_create_info.pNext = nullptr;
   shader_module_create_info.flags = 0;
-  shader_module_create_info.codeSize = translated_binary().size();
-  shader_module_create_info.pCode =
-      reinterpret_cast<const uint32_t*>(translated_binary().data());
+  shader_module_create_info.codeSize = code_size_bytes;
+  shader_module_create_info.pCode = code;
+  VkShaderModule shader_module;
   if (provider.dfn().vkCreateShaderModule(provider.device(),
                                           &shader_module_create_info, nullptr,
-                                          &shader_module_) != VK_SUCCESS) {
+                                          &shader_module) != VK_SUCCESS) {
     XELOGE(
         "VulkanShader::VulkanTranslation: Failed to create a Vulkan shader "
         "module for shader {:016X} modification {:016X}",
         shader().ucode_data_hash(), modification());
-    MakeInvalid();
     return VK_NULL_HANDLE;
   }
-  return shader_module_;
+  return shader_module;
 }
 
 VulkanShader::VulkanShader(const ui::vulkan::VulkanProvider& provider,
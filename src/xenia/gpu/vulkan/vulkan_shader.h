@@ -30,8 +30,16 @@ class VulkanShader : public SpirvShader {
 
     VkShaderModule GetOrCreateShaderModule();
     VkShaderModule shader_module() const { return shader_module_; }
+    // Switches to a different binary (such as an optimized version of the
+    // translated SPIR-V) for pipelines created from now on - existing
+    // pipelines are not affected by the module being destroyed. Keeps the
+    // current module if creation fails.
+    bool ReplaceShaderModule(const uint32_t* code, size_t code_dword_count);
 
    private:
+    VkShaderModule CreateShaderModule(const uint32_t* code,
+                                      size_t code_size_bytes) const;
+
     VkShaderModule shader_module_ = VK_NULL_HANDLE;
   };
 
@@ -46,6 +46,11 @@ class InputDriver {
     is_active_callback_ = is_active_callback;
   }
 
+  void set_poll_index_callback(
+      std::function<uint32_t()> poll_index_callback) {
+    poll_index_callback_ = poll_index_callback;
+  }
+
  protected:
   explicit InputDriver(xe::ui::Window* window, size_t window_z_order)
       : window_(window), window_z_order_(window_z_order) {}
@@ -57,10 +62,17 @@ class InputDriver {
     return !is_active_callback_ || is_active_callback_();
   }
 
+  // Index of the current input request from the guest, counted by the
+  // InputSystem.
+  uint32_t poll_index() const {
+    return poll_index_callback_ ? poll_index_callback_() : 0;
+  }
+
  private:
   xe::ui::Window* window_;
   size_t window_z_order_;
   std::function<bool()> is_active_callback_ = nullptr;
+  std::function<uint32_t()> poll_index_callback_ = nullptr;
 };
 
 }  // namespace hid
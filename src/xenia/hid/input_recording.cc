@@ -0,0 +1,177 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/hid/input_recording.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+
+namespace xe {
+namespace hid {
+
+namespace {
+
+constexpr uint32_t kRecordingMagic = 0x524E4958;  // 'XINR'
+constexpr uint32_t kRecordingVersion = 2;
+
+// Followed by data_size bytes of the structure for the type.
+struct RecordedEventHeader {
+  uint32_t poll_index;
+  InputRecordingEventType type;
+  uint8_t user_index;
+  uint16_t data_size;
+  X_RESULT result;
+};
+static_assert_size(RecordedEventHeader, 12);
+
+size_t GetLastEventIndex(uint32_t user_index) {
+  return std::min(user_index, uint32_t(4));
+}
+
+}  // namespace
+
+InputRecorder::~InputRecorder() {
+  if (file_) {
+    fclose(file_);
+  }
+}
+
+bool InputRecorder::Open(const std::filesystem::path& path) {
+  std::lock_guard<xe_mutex> lock(mutex_);
+  file_ = xe::filesystem::OpenFile(path, "wb");
+  if (!file_) {
+    XELOGE("Failed to open input recording {} for writing",
+           xe::path_to_utf8(path));
+    return false;
+  }
+  const uint32_t header[] = {kRecordingMagic, kRecordingVersion};
+  fwrite(header, sizeof(header), 1, file_);
+  XELOGI("Recording input to {}", xe::path_to_utf8(path));
+  return true;
+}
+
+void InputRecorder::RecordCapabilities(
+    uint32_t poll_index, uint32_t user_index, X_RESULT result,
+    const X_INPUT_CAPABILITIES* capabilities) {
+  Record(poll_index, InputRecordingEventType::kCapabilities, user_index, result,
+         capabilities, sizeof(*capabilities),
+         &last_capabilities_[GetLastEventIndex(user_index)]);
+}
+
+void InputRecorder::RecordState(uint32_t poll_index, uint32_t user_index,
+                                X_RESULT result, const X_INPUT_STATE* state) {
+  Record(poll_index, InputRecordingEventType::kState, user_index, result, state,
+         sizeof(*state), &last_states_[GetLastEventIndex(user_index)]);
+}
+
+void InputRecorder::RecordKeystroke(uint32_t poll_index,
+                                    uint32_t user_index,
+                                    const X_INPUT_KEYSTROKE* keystroke) {
+  Record(poll_index, InputRecordingEventType::kKeystroke, user_index,
+         X_ERROR_SUCCESS, keystroke, sizeof(*keystroke), nullptr);
+}
+
+void InputRecorder::Record(uint32_t poll_index, InputRecordingEventType type,
+                           uint32_t user_index, X_RESULT result,
+                           const void* data, size_t data_size,
+                           LastEvent* last_event) {
+  // The data is only meaningful on success, and the guest may pass no buffer
+  // when only checking whether a controller is connected.
+  if (result != X_ERROR_SUCCESS || !data) {
+    data = nullptr;
+    data_size = 0;
+  }
+  std::lock_guard<xe_mutex> lock(mutex_);
+  if (!file_) {
+    return;
+  }
+  if (last_event) {
+    if (last_event->valid && last_event->result == result &&
+        (!data_size ||
+         !std::memcmp(last_event->data.data(), data, data_size))) {
+      return;
+    }
+    last_event->valid = true;
+    last_event->result = result;
+    if (data_size) {
+      std::memcpy(last_event->data.data(), data, data_size);
+    }
+  }
+  RecordedEventHeader header;
+  header.poll_index = poll_index;
+  header.type = type;
+  header.user_index = uint8_t(user_index);
+  header.data_size = uint16_t(data_size);
+  header.result = result;
+  fwrite(&header, sizeof(header), 1, file_);
+  if (data_size) {
+    fwrite(data, data_size, 1, file_);
+  }
+}
+
+bool ReadInputRecording(const std::filesystem::path& path,
+                        std::vector<InputRecordingEvent>& events) {
+  FILE* file = xe::filesystem::OpenFile(path, "rb");
+  if (!file) {
+    XELOGE("Failed to open input recording {}", xe::path_to_utf8(path));
+    return false;
+  }
+  uint32_t file_header[2];
+  if (fread(file_header, sizeof(file_header), 1, file) != 1 ||
+      file_header[0] != kRecordingMagic ||
+      file_header[1] != kRecordingVersion) {
+    XELOGE("{} is not a supported input recording", xe::path_to_utf8(path));
+    fclose(file);
+    return false;
+  }
+  RecordedEventHeader header;
+  while (fread(&header, sizeof(header), 1, file) == 1) {
+    InputRecordingEvent event = {};
+    event.poll_index = header.poll_index;
+    event.type = header.type;
+    event.user_index = header.user_index;
+    event.result = header.result;
+    void* data;
+    size_t data_size;
+    switch (header.type) {
+      case InputRecordingEventType::kCapabilities:
+        data = &event.capabilities;
+        data_size = sizeof(event.capabilities);
+        break;
+      case InputRecordingEventType::kState:
+        data = &event.state;
+        data_size = sizeof(event.state);
+        break;
+      case InputRecordingEventType::kKeystroke:
+        data = &event.keystroke;
+        data_size = sizeof(event.keystroke);
+        break;
+      default:
+        data = nullptr;
+        data_size = 0;
+    }
+    if (!data || (header.data_size && header.data_size != data_size) ||
+        (header.data_size && fread(data, data_size, 1, file) != 1)) {
+      // Likely the end of a recording that wasn't closed cleanly.
+      XELOGW("Input recording {} is truncated after {} events",
+             xe::path_to_utf8(path), events.size());
+      break;
+    }
+    events.push_back(event);
+  }
+  fclose(file);
+  return true;
+}
+
+}  // namespace hid
+}  // namespace xe
@@ -0,0 +1,91 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_HID_INPUT_RECORDING_H_
+#define XENIA_HID_INPUT_RECORDING_H_
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+#include "xenia/hid/input.h"
+#include "xenia/xbox.h"
+
+namespace xe {
+namespace hid {
+
+// Input recordings are a list of what the input drivers returned to the
+// guest, keyed by the index of the guest's input request (capabilities, state
+// or keystroke) since the start of the emulation, so a gameplay segment can be
+// replayed. Unlike vblanks, which depend on the host's timing, the requests
+// are made by the guest code itself, though if multiple guest threads request
+// input, their order may still differ between runs. States and capabilities
+// are only stored when they change, keystrokes are stored whenever one is
+// returned.
+enum class InputRecordingEventType : uint8_t {
+  kCapabilities,
+  kState,
+  kKeystroke,
+};
+
+struct InputRecordingEvent {
+  uint32_t poll_index;
+  InputRecordingEventType type;
+  // As requested by the guest, may be XUSER_INDEX_ANY for keystrokes.
+  uint8_t user_index;
+  X_RESULT result;
+  // Only the one for the type is valid, and only if the result is success.
+  X_INPUT_CAPABILITIES capabilities;
+  X_INPUT_STATE state;
+  X_INPUT_KEYSTROKE keystroke;
+};
+
+class InputRecorder {
+ public:
+  ~InputRecorder();
+
+  bool Open(const std::filesystem::path& path);
+
+  void RecordCapabilities(uint32_t poll_index, uint32_t user_index,
+                          X_RESULT result,
+                          const X_INPUT_CAPABILITIES* capabilities);
+  void RecordState(uint32_t poll_index, uint32_t user_index, X_RESULT result,
+                   const X_INPUT_STATE* state);
+  void RecordKeystroke(uint32_t poll_index, uint32_t user_index,
+                       const X_INPUT_KEYSTROKE* keystroke);
+
+ private:
+  // Last stored result and data for each type and user, to skip repeats.
+  struct LastEvent {
+    bool valid = false;
+    X_RESULT result;
+    std::array<uint8_t, sizeof(X_INPUT_CAPABILITIES)> data;
+  };
+
+  void Record(uint32_t poll_index, InputRecordingEventType type,
+              uint32_t user_index, X_RESULT result, const void* data,
+              size_t data_size, LastEvent* last_event);
+
+  xe_mutex mutex_;
+  FILE* file_ = nullptr;
+  // Indexed by the user index, with the last one for XUSER_INDEX_ANY.
+  std::array<LastEvent, 5> last_capabilities_;
+  std::array<LastEvent, 5> last_states_;
+};
+
+bool ReadInputRecording(const std::filesystem::path& path,
+                        std::vector<InputRecordingEvent>& events);
+
+}  // namespace hid
+}  // namespace xe
+
+#endif  // XENIA_HID_INPUT_RECORDING_H_
@@ -14,6 +14,7 @@
 #include "xenia/base/profiling.h"
 #include "xenia/hid/hid_flags.h"
 #include "xenia/hid/input_driver.h"
+#include "xenia/hid/input_recording.h"
 
 namespace xe {
 namespace hid {
@@ -27,13 +28,28 @@ DEFINE_double(
     right_stick_deadzone_percentage, 0.0,
     "Defines deadzone level for right stick. Allowed range [0.0-1.0].", "HID");
 
+DEFINE_path(
+    hid_record_path, "",
+    "Records the input returned to the guest, keyed by the index of the "
+    "guest's input request, to the file, for replaying with --hid=replay.",
+    "HID");
+
 InputSystem::InputSystem(xe::ui::Window* window) : window_(window) {}
 
 InputSystem::~InputSystem() = default;
 
-X_STATUS InputSystem::Setup() { return X_STATUS_SUCCESS; }
+X_STATUS InputSystem::Setup() {
+  if (!cvars::hid_record_path.empty()) {
+    recorder_ = std::make_unique<InputRecorder>();
+    if (!recorder_->Open(cvars::hid_record_path)) {
+      recorder_.reset();
+    }
+  }
+  return X_STATUS_SUCCESS;
+}
 
 void InputSystem::AddDriver(std::unique_ptr<InputDriver> driver) {
+  driver->set_poll_index_callback([this]() { return poll_index_.load(); });
   drivers_.push_back(std::move(driver));
 }
 
@@ -67,6 +83,7 @@ void InputSystem::UpdateUsedSlot(InputDriver* driver, uint8_t slot,
 X_RESULT InputSystem::GetCapabilities(uint32_t user_index, uint32_t flags,
                                       X_INPUT_CAPABILITIES* out_caps) {
   SCOPE_profile_cpu_f("hid");
+  uint32_t poll_index = BeginPoll();
 
   bool any_connected = false;
   for (auto& driver : drivers_) {
@@ -76,15 +93,24 @@ X_RESULT InputSystem::GetCapabilities(uint32_t user_index, uint32_t flags,
     }
     if (result == X_ERROR_SUCCESS) {
       UpdateUsedSlot(driver.get(), user_index, any_connected);
+      if (recorder_) {
+        recorder_->RecordCapabilities(poll_index, user_index, result, out_caps);
+      }
       return result;
     }
   }
   UpdateUsedSlot(nullptr, user_index, any_connected);
-  return any_connected ? X_ERROR_EMPTY : X_ERROR_DEVICE_NOT_CONNECTED;
+  X_RESULT result =
+      any_connected ? X_ERROR_EMPTY : X_ERROR_DEVICE_NOT_CONNECTED;
+  if (recorder_) {
+    recorder_->RecordCapabilities(poll_index, user_index, result, nullptr);
+  }
+  return result;
 }
 
 X_RESULT InputSystem::GetState(uint32_t user_index, X_INPUT_STATE* out_state) {
   SCOPE_profile_cpu_f("hid");
+  uint32_t poll_index = BeginPoll();
 
   bool any_connected = false;
   for (auto& driver : drivers_) {
@@ -94,12 +120,21 @@ X_RESULT InputSystem::GetState(uint32_t user_index, X_INPUT_STATE* out_state) {
     }
     if (result == X_ERROR_SUCCESS) {
       UpdateUsedSlot(driver.get(), user_index, any_connected);
+      // Recorded before the adjustments so they're redone on replay.
+      if (recorder_) {
+        recorder_->RecordState(poll_index, user_index, result, out_state);
+      }
       AdjustDeadzoneLevels(user_index, &out_state->gamepad);
       return result;
     }
   }
   UpdateUsedSlot(nullptr, user_index, any_connected);
-  return any_connected ? X_ERROR_EMPTY : X_ERROR_DEVICE_NOT_CONNECTED;
+  X_RESULT result =
+      any_connected ? X_ERROR_EMPTY : X_ERROR_DEVICE_NOT_CONNECTED;
+  if (recorder_) {
+    recorder_->RecordState(poll_index, user_index, result, nullptr);
+  }
+  return result;
 }
 
 X_RESULT InputSystem::SetState(uint32_t user_index,
@@ -124,6 +159,7 @@ X_RESULT InputSystem::SetState(uint32_t user_index,
 X_RESULT InputSystem::GetKeystroke(uint32_t user_index, uint32_t flags,
                                    X_INPUT_KEYSTROKE* out_keystroke) {
   SCOPE_profile_cpu_f("hid");
+  uint32_t poll_index = BeginPoll();
 
   bool any_connected = false;
   for (auto& driver : drivers_) {
@@ -133,6 +169,9 @@ X_RESULT InputSystem::GetKeystroke(uint32_t user_index, uint32_t flags,
     }
     if (result == X_ERROR_SUCCESS || result == X_ERROR_EMPTY) {
       UpdateUsedSlot(driver.get(), user_index, any_connected);
+      if (recorder_ && result == X_ERROR_SUCCESS) {
+        recorder_->RecordKeystroke(poll_index, user_index, out_keystroke);
+      }
       return result;
     }
   }
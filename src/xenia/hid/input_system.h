@@ -10,12 +10,14 @@
 #ifndef XENIA_HID_INPUT_SYSTEM_H_
 #define XENIA_HID_INPUT_SYSTEM_H_
 
+#include <atomic>
 #include <bitset>
 #include <memory>
 #include <vector>
 #include "xenia/base/mutex.h"
 #include "xenia/hid/input.h"
 #include "xenia/hid/input_driver.h"
+#include "xenia/hid/input_recording.h"
 #include "xenia/xbox.h"
 
 namespace xe {
@@ -65,10 +67,15 @@ class InputSystem {
   void UpdateUsedSlot(InputDriver* driver, uint8_t slot, bool connected);
   void AdjustDeadzoneLevels(const uint8_t slot, X_INPUT_GAMEPAD* gamepad);
   X_INPUT_VIBRATION ModifyVibrationLevel(X_INPUT_VIBRATION* vibration);
+  // Starts an input request from the guest, returning its index, by which the
+  // input is recorded and replayed.
+  uint32_t BeginPoll() { return ++poll_index_; }
 
   xe::ui::Window* window_ = nullptr;
 
   std::vector<std::unique_ptr<InputDriver>> drivers_;
+  std::atomic<uint32_t> poll_index_{0};
+  std::unique_ptr<InputRecorder> recorder_;
 
   std::bitset<max_allowed_controllers> connected_slots = {};
   std::array<std::pair<joystick_value, joystick_value>, max_allowed_controllers>
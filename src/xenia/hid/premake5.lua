@@ -62,3 +62,5 @@ project("xenia-hid-demo")
       "xenia-hid-winkey",
       "xenia-hid-xinput",
     })
+
+include("testing")
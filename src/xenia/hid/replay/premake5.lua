@@ -0,0 +1,15 @@
+project_root = "../../../.."
+include(project_root.."/tools/build")
+
+group("src")
+project("xenia-hid-replay")
+  uuid("4f3c1a6e-9d2b-4e57-b8a0-2c6d5e7f9b13")
+  kind("StaticLib")
+  language("C++")
+  links({
+    "xenia-base",
+    "xenia-hid",
+  })
+  defines({
+  })
+  local_platform_files()
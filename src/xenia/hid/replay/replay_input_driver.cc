@@ -0,0 +1,141 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/hid/replay/replay_input_driver.h"
+
+#include <algorithm>
+
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+
+DEFINE_path(hid_replay_path, "",
+            "Input recording to replay with --hid=replay, created with "
+            "--hid_record_path.",
+            "HID");
+
+namespace xe {
+namespace hid {
+namespace replay {
+
+ReplayInputDriver::ReplayInputDriver(xe::ui::Window* window,
+                                     size_t window_z_order)
+    : InputDriver(window, window_z_order) {}
+
+ReplayInputDriver::~ReplayInputDriver() = default;
+
+X_STATUS ReplayInputDriver::Setup() {
+  if (cvars::hid_replay_path.empty()) {
+    XELOGE("Input replay requires --hid_replay_path");
+    return X_STATUS_UNSUCCESSFUL;
+  }
+  if (!ReadInputRecording(cvars::hid_replay_path, events_)) {
+    return X_STATUS_UNSUCCESSFUL;
+  }
+  XELOGI("Replaying {} input events from {}", events_.size(),
+         xe::path_to_utf8(cvars::hid_replay_path));
+  return X_STATUS_SUCCESS;
+}
+
+size_t ReplayInputDriver::GetUserStateIndex(uint32_t user_index) {
+  return std::min(size_t(user_index), kUserCount - 1);
+}
+
+void ReplayInputDriver::Advance() {
+  if (next_event_ >= events_.size()) {
+    return;
+  }
+  uint32_t current_poll_index = poll_index();
+  while (next_event_ < events_.size() &&
+         events_[next_event_].poll_index <= current_poll_index) {
+    const InputRecordingEvent& event = events_[next_event_++];
+    UserState& user = users_[GetUserStateIndex(event.user_index)];
+    switch (event.type) {
+      case InputRecordingEventType::kCapabilities:
+        user.capabilities_result = event.result;
+        user.capabilities = event.capabilities;
+        break;
+      case InputRecordingEventType::kState:
+        user.state_result = event.result;
+        user.state = event.state;
+        break;
+      case InputRecordingEventType::kKeystroke:
+        user.keystrokes.push_back(event.keystroke);
+        break;
+    }
+  }
+  if (next_event_ >= events_.size()) {
+    XELOGI("Input replay finished at input request {}", current_poll_index);
+  }
+}
+
+bool ReplayInputDriver::IsConnected(size_t user_state_index) const {
+  if (user_state_index < kUserCount - 1) {
+    return users_[user_state_index].state_result !=
+           X_ERROR_DEVICE_NOT_CONNECTED;
+  }
+  return std::any_of(users_.cbegin(), users_.cend() - 1,
+                     [](const UserState& user) {
+                       return user.state_result !=
+                              X_ERROR_DEVICE_NOT_CONNECTED;
+                     });
+}
+
+X_RESULT ReplayInputDriver::GetCapabilities(uint32_t user_index,
+                                            uint32_t flags,
+                                            X_INPUT_CAPABILITIES* out_caps) {
+  std::lock_guard<xe_mutex> lock(mutex_);
+  Advance();
+  const UserState& user = users_[GetUserStateIndex(user_index)];
+  if (user.capabilities_result == X_ERROR_SUCCESS && out_caps) {
+    *out_caps = user.capabilities;
+  }
+  return user.capabilities_result;
+}
+
+X_RESULT ReplayInputDriver::GetState(uint32_t user_index,
+                                     X_INPUT_STATE* out_state) {
+  std::lock_guard<xe_mutex> lock(mutex_);
+  Advance();
+  const UserState& user = users_[GetUserStateIndex(user_index)];
+  if (user.state_result == X_ERROR_SUCCESS && out_state) {
+    *out_state = user.state;
+  }
+  return user.state_result;
+}
+
+X_RESULT ReplayInputDriver::SetState(uint32_t user_index,
+                                     X_INPUT_VIBRATION* vibration) {
+  std::lock_guard<xe_mutex> lock(mutex_);
+  Advance();
+  return IsConnected(GetUserStateIndex(user_index))
+             ? X_ERROR_SUCCESS
+             : X_ERROR_DEVICE_NOT_CONNECTED;
+}
+
+X_RESULT ReplayInputDriver::GetKeystroke(uint32_t user_index, uint32_t flags,
+                                         X_INPUT_KEYSTROKE* out_keystroke) {
+  std::lock_guard<xe_mutex> lock(mutex_);
+  Advance();
+  size_t user_state_index = GetUserStateIndex(user_index);
+  UserState& user = users_[user_state_index];
+  if (user.keystrokes.empty()) {
+    return IsConnected(user_state_index) ? X_ERROR_EMPTY
+                                         : X_ERROR_DEVICE_NOT_CONNECTED;
+  }
+  if (out_keystroke) {
+    *out_keystroke = user.keystrokes.front();
+  }
+  user.keystrokes.pop_front();
+  return X_ERROR_SUCCESS;
+}
+
+}  // namespace replay
+}  // namespace hid
+}  // namespace xe
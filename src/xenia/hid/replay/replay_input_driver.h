@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_HID_REPLAY_REPLAY_INPUT_DRIVER_H_
+#define XENIA_HID_REPLAY_REPLAY_INPUT_DRIVER_H_
+
+#include <array>
+#include <deque>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+#include "xenia/hid/input_driver.h"
+#include "xenia/hid/input_recording.h"
+
+namespace xe {
+namespace hid {
+namespace replay {
+
+// Returns the input recorded with --hid_record_path for the same guest input
+// requests, so the same gameplay segment can be rerun without a controller or
+// the window being focused. This only replaces the input - the emulator still
+// runs with its window and presents as usual, there's no headless mode.
+class ReplayInputDriver final : public InputDriver {
+ public:
+  explicit ReplayInputDriver(xe::ui::Window* window, size_t window_z_order);
+  ~ReplayInputDriver() override;
+
+  X_STATUS Setup() override;
+
+  X_RESULT GetCapabilities(uint32_t user_index, uint32_t flags,
+                           X_INPUT_CAPABILITIES* out_caps) override;
+  X_RESULT GetState(uint32_t user_index, X_INPUT_STATE* out_state) override;
+  X_RESULT SetState(uint32_t user_index, X_INPUT_VIBRATION* vibration) override;
+  X_RESULT GetKeystroke(uint32_t user_index, uint32_t flags,
+                        X_INPUT_KEYSTROKE* out_keystroke) override;
+
+ private:
+  // The users, followed by XUSER_INDEX_ANY for keystrokes.
+  static constexpr size_t kUserCount = 5;
+
+  struct UserState {
+    X_RESULT capabilities_result = X_ERROR_DEVICE_NOT_CONNECTED;
+    X_INPUT_CAPABILITIES capabilities = {};
+    X_RESULT state_result = X_ERROR_DEVICE_NOT_CONNECTED;
+    X_INPUT_STATE state = {};
+    std::deque<X_INPUT_KEYSTROKE> keystrokes;
+  };
+
+  static size_t GetUserStateIndex(uint32_t user_index);
+  // Applies the events up to the current input request. The mutex must be
+  // locked.
+  void Advance();
+  bool IsConnected(size_t user_state_index) const;
+
+  xe_mutex mutex_;
+  std::vector<InputRecordingEvent> events_;
+  size_t next_event_ = 0;
+  std::array<UserState, kUserCount> users_;
+};
+
+}  // namespace replay
+}  // namespace hid
+}  // namespace xe
+
+#endif  // XENIA_HID_REPLAY_REPLAY_INPUT_DRIVER_H_
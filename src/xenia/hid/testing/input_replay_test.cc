@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "xenia/base/cvar.h"
+#include "xenia/hid/input_recording.h"
+#include "xenia/hid/input_system.h"
+#include "xenia/hid/replay/replay_input_driver.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+DECLARE_path(hid_record_path);
+DECLARE_path(hid_replay_path);
+
+namespace xe::hid::test {
+
+// Returns what the test sets, like a single controller for the first user.
+class ScriptedInputDriver final : public InputDriver {
+ public:
+  ScriptedInputDriver() : InputDriver(nullptr, 0) {}
+
+  X_STATUS Setup() override { return X_STATUS_SUCCESS; }
+
+  X_RESULT GetCapabilities(uint32_t user_index, uint32_t flags,
+                           X_INPUT_CAPABILITIES* out_caps) override {
+    if (!IsUser(user_index)) {
+      return X_ERROR_DEVICE_NOT_CONNECTED;
+    }
+    if (out_caps) {
+      std::memset(out_caps, 0, sizeof(*out_caps));
+      out_caps->type = 0x01;
+      out_caps->sub_type = 0x01;
+      out_caps->gamepad.thumb_lx = INT16_MAX;
+      out_caps->gamepad.thumb_ly = INT16_MAX;
+      out_caps->gamepad.thumb_rx = INT16_MAX;
+      out_caps->gamepad.thumb_ry = INT16_MAX;
+    }
+    return X_ERROR_SUCCESS;
+  }
+
+  X_RESULT GetState(uint32_t user_index, X_INPUT_STATE* out_state) override {
+    if (!IsUser(user_index)) {
+      return X_ERROR_DEVICE_NOT_CONNECTED;
+    }
+    if (out_state) {
+      *out_state = state;
+    }
+    return X_ERROR_SUCCESS;
+  }
+
+  X_RESULT SetState(uint32_t user_index,
+                    X_INPUT_VIBRATION* vibration) override {
+    return IsUser(user_index) ? X_ERROR_SUCCESS : X_ERROR_DEVICE_NOT_CONNECTED;
+  }
+
+  X_RESULT GetKeystroke(uint32_t user_index, uint32_t flags,
+                        X_INPUT_KEYSTROKE* out_keystroke) override {
+    if (!IsUser(user_index)) {
+      return X_ERROR_DEVICE_NOT_CONNECTED;
+    }
+    if (keystrokes.empty()) {
+      return X_ERROR_EMPTY;
+    }
+    if (out_keystroke) {
+      *out_keystroke = keystrokes.front();
+    }
+    keystrokes.pop_front();
+    return X_ERROR_SUCCESS;
+  }
+
+  bool connected = true;
+  X_INPUT_STATE state = {};
+  std::deque<X_INPUT_KEYSTROKE> keystrokes;
+
+ private:
+  // 0xFF is XUSER_INDEX_ANY.
+  bool IsUser(uint32_t user_index) const {
+    return connected && (user_index == 0 || user_index == 0xFF);
+  }
+};
+
+struct PollResult {
+  X_RESULT result;
+  // Whichever structure was requested, zeroed before the request.
+  uint8_t data[sizeof(X_INPUT_CAPABILITIES)];
+
+  bool operator==(const PollResult& other) const {
+    return result == other.result &&
+           !std::memcmp(data, other.data, sizeof(data));
+  }
+};
+
+// Makes the same requests as a guest would, changing the input of the
+// scripted driver (if recording) along the way.
+std::vector<PollResult> RunPolls(InputSystem& input_system,
+                                 ScriptedInputDriver* driver) {
+  std::vector<PollResult> results;
+  for (uint32_t i = 0; i < 32; ++i) {
+    if (driver) {
+      switch (i) {
+        case 4:
+          driver->state.packet_number = i;
+          driver->state.gamepad.buttons = 0x1000;
+          break;
+        case 6: {
+          X_INPUT_KEYSTROKE keystroke = {};
+          keystroke.virtual_key = 0x5800;
+          keystroke.flags = 0x0001;
+          driver->keystrokes.push_back(keystroke);
+          keystroke.flags = 0x0002;
+          driver->keystrokes.push_back(keystroke);
+          break;
+        }
+        case 8:
+          driver->state.packet_number = i;
+          driver->state.gamepad.thumb_lx = 12000;
+          break;
+        case 12:
+          driver->state.packet_number = i;
+          driver->state.gamepad.buttons = 0;
+          break;
+        case 16:
+          driver->connected = false;
+          break;
+        case 20:
+          driver->connected = true;
+          break;
+      }
+    }
+    PollResult result = {};
+    if (!(i & 7)) {
+      result.result = input_system.GetCapabilities(
+          0, 0, reinterpret_cast<X_INPUT_CAPABILITIES*>(result.data));
+      results.push_back(result);
+      result = {};
+    }
+    result.result = input_system.GetState(
+        0, reinterpret_cast<X_INPUT_STATE*>(result.data));
+    results.push_back(result);
+    if (!(i & 1)) {
+      result = {};
+      result.result = input_system.GetKeystroke(
+          0xFF, 0, reinterpret_cast<X_INPUT_KEYSTROKE*>(result.data));
+      results.push_back(result);
+    }
+  }
+  return results;
+}
+
+TEST_CASE("Input record and replay", "[hid]") {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "xenia_input_replay_test.bin";
+  std::filesystem::remove(path);
+
+  std::vector<PollResult> recorded_results;
+  {
+    cvars::hid_record_path = path;
+    InputSystem input_system(nullptr);
+    REQUIRE(XSUCCEEDED(input_system.Setup()));
+    cvars::hid_record_path.clear();
+    auto driver = std::make_unique<ScriptedInputDriver>();
+    ScriptedInputDriver* driver_ptr = driver.get();
+    input_system.AddDriver(std::move(driver));
+    recorded_results = RunPolls(input_system, driver_ptr);
+  }
+
+  SECTION("Only changes stored") {
+    std::vector<InputRecordingEvent> events;
+    REQUIRE(ReadInputRecording(path, events));
+    size_t state_count = 0, keystroke_count = 0;
+    for (const InputRecordingEvent& event : events) {
+      if (event.type == InputRecordingEventType::kState) {
+        ++state_count;
+      } else if (event.type == InputRecordingEventType::kKeystroke) {
+        ++keystroke_count;
+      }
+    }
+    // Connected, pressed, moved, released, disconnected, reconnected.
+    REQUIRE(state_count == 6);
+    REQUIRE(keystroke_count == 2);
+  }
+
+  SECTION("Replayed") {
+    cvars::hid_replay_path = path;
+    auto driver = std::make_unique<replay::ReplayInputDriver>(nullptr, 0);
+    REQUIRE(XSUCCEEDED(driver->Setup()));
+    cvars::hid_replay_path.clear();
+    InputSystem input_system(nullptr);
+    REQUIRE(XSUCCEEDED(input_system.Setup()));
+    input_system.AddDriver(std::move(driver));
+    std::vector<PollResult> replayed_results = RunPolls(input_system, nullptr);
+    REQUIRE(replayed_results.size() == recorded_results.size());
+    for (size_t i = 0; i < recorded_results.size(); ++i) {
+      INFO("Request " << i);
+      REQUIRE(replayed_results[i] == recorded_results[i]);
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+
+}  // namespace xe::hid::test
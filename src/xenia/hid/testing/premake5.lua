@@ -0,0 +1,11 @@
+project_root = "../../../.."
+include(project_root.."/tools/build")
+
+test_suite("xenia-hid-tests", project_root, ".", {
+  links = {
+    "fmt",
+    "xenia-base",
+    "xenia-hid",
+    "xenia-hid-replay",
+  },
+})
@@ -40,6 +40,21 @@ DEFINE_uint32(max_signed_profiles, 4,
 
 DEFINE_uint32(kernel_build_version, 1888, "Define current kernel version",
               "Kernel");
+DEFINE_uint32(deferred_overlapped_threads, 4,
+              "Number of threads completing asynchronous (overlapped) kernel "
+              "and XAM operations, so independent operations don't wait for "
+              "each other.",
+              "Kernel");
+DEFINE_uint32(
+    ke_timestamp_bundle_update_period, 1,
+    "Period in milliseconds of the host timer updating the times in the "
+    "guest-visible KeTimeStampBundle, or 0 to disable the timer. The bundle is "
+    "also updated whenever a guest thread queries the time through the kernel "
+    "or returns from a wait, so longer periods reduce the host wakeups while "
+    "keeping the times exact at those points. However, guest code polling the "
+    "bundle without calling into the kernel will see the times advance only "
+    "with the timer.",
+    "Kernel");
 
 namespace xe {
 namespace kernel {
@@ -56,8 +71,8 @@ KernelState* kernel_state() { return shared_kernel_state_; }
 KernelState::KernelState(Emulator* emulator)
     : emulator_(emulator),
       memory_(emulator->memory()),
-      dispatch_thread_running_(false),
       dpc_list_(emulator->memory()),
+      deferred_work_scheduler_(this),
       kernel_trampoline_group_(emulator->processor()->backend()) {
   assert_null(shared_kernel_state_);
   shared_kernel_state_ = this;
@@ -94,11 +109,7 @@ KernelState::KernelState(Emulator* emulator)
 KernelState::~KernelState() {
   SetExecutableModule(nullptr);
 
-  if (dispatch_thread_running_) {
-    dispatch_thread_running_ = false;
-    dispatch_cond_.notify_all();
-    dispatch_thread_->Wait(0, 0, 0, nullptr);
-  }
+  deferred_work_scheduler_.Shutdown();
 
   executable_module_.reset();
   user_modules_.clear();
@@ -386,38 +397,11 @@ void KernelState::SetExecutableModule(object_ref<UserModule> module) {
         variable_ptr, executable_module_->path(),
         xboxkrnl::XboxkrnlModule::kExLoadedImageNameSize);
   }
-  // Spin up deferred dispatch worker.
+  // Spin up deferred dispatch workers.
   // TODO(benvanik): move someplace more appropriate (out of ctor, but around
   // here).
-  if (!dispatch_thread_running_) {
-    dispatch_thread_running_ = true;
-    dispatch_thread_ = object_ref<XHostThread>(new XHostThread(
-        this, 128 * 1024, 0,
-        [this]() {
-          // As we run guest callbacks the debugger must be able to suspend us.
-          dispatch_thread_->set_can_debugger_suspend(true);
-
-          auto global_lock = global_critical_region_.AcquireDeferred();
-          while (dispatch_thread_running_) {
-            global_lock.lock();
-            if (dispatch_queue_.empty()) {
-              dispatch_cond_.wait(global_lock);
-              if (!dispatch_thread_running_) {
-                global_lock.unlock();
-                break;
-              }
-            }
-            auto fn = std::move(dispatch_queue_.front());
-            dispatch_queue_.pop_front();
-            global_lock.unlock();
-
-            fn();
-          }
-          return 0;
-        },
-        GetSystemProcess()));  // don't think an equivalent exists on real hw
-    dispatch_thread_->set_name("Kernel Dispatch");
-    dispatch_thread_->Create();
+  if (!deferred_work_scheduler_.is_running()) {
+    deferred_work_scheduler_.Start(cvars::deferred_overlapped_threads);
   }
 }
 
@@ -861,22 +845,20 @@ void KernelState::CompleteOverlappedDeferredEx(
       ev.get<XEvent>()->Reset();
     }
   }
-  auto global_lock = global_critical_region_.Acquire();
-  dispatch_queue_.push_back([this, completion_callback, overlapped_ptr,
-                             pre_callback, post_callback]() {
-    if (pre_callback) {
-      pre_callback();
-    }
-    xe::threading::Sleep(
-        std::chrono::milliseconds(kDeferredOverlappedDelayMillis));
-    uint32_t extended_error, length;
-    auto result = completion_callback(extended_error, length);
-    CompleteOverlappedEx(overlapped_ptr, result, extended_error, length);
-    if (post_callback) {
-      post_callback();
-    }
-  });
-  dispatch_cond_.notify_all();
+  // The delay is tracked by the scheduler's timer wheel rather than by
+  // sleeping in a worker, so concurrent operations are delayed in parallel.
+  deferred_work_scheduler_.Schedule(
+      std::move(pre_callback),
+      std::chrono::milliseconds(kDeferredOverlappedDelayMillis),
+      [this, completion_callback = std::move(completion_callback),
+       overlapped_ptr, post_callback = std::move(post_callback)]() {
+        uint32_t extended_error, length;
+        auto result = completion_callback(extended_error, length);
+        CompleteOverlappedEx(overlapped_ptr, result, extended_error, length);
+        if (post_callback) {
+          post_callback();
+        }
+      });
 }
 
 bool KernelState::Save(ByteStream* stream) {
@@ -949,12 +931,34 @@ bool KernelState::Save(ByteStream* stream) {
   return true;
 }
 
-// this only gets triggered once per ms at most, so fields other than tick count
-// will probably not be updated in a timely manner for guest code that uses them
-void KernelState::UpdateKeTimestampBundle() {
+void KernelState::UpdateKeTimestampBundle(bool force) {
+  if (!ke_timestamp_bundle_ptr_) {
+    return;
+  }
+  // The guest clock, not the host one, as it may be scaled.
+  uint32_t uptime_ms = Clock::QueryGuestUptimeMillis();
+  if (force) {
+    ke_timestamp_bundle_update_uptime_ms_.store(uptime_ms,
+                                                std::memory_order_relaxed);
+  } else {
+    // Waits usually return more often than the tick count changes - skip
+    // without locking if the guest tick count hasn't changed since the last
+    // update, and only let one of the threads waking up at the same time
+    // update it.
+    uint32_t last_update_uptime_ms =
+        ke_timestamp_bundle_update_uptime_ms_.load(std::memory_order_relaxed);
+    if (uptime_ms == last_update_uptime_ms ||
+        !ke_timestamp_bundle_update_uptime_ms_.compare_exchange_strong(
+            last_update_uptime_ms, uptime_ms, std::memory_order_relaxed)) {
+      return;
+    }
+  }
   X_TIME_STAMP_BUNDLE* lpKeTimeStampBundle =
       memory_->TranslateVirtual<X_TIME_STAMP_BUNDLE*>(ke_timestamp_bundle_ptr_);
-  uint32_t uptime_ms = Clock::QueryGuestUptimeMillis();
+  // Serialize the updates that weren't skipped so the times never go
+  // backwards.
+  std::lock_guard<xe_mutex> lock(ke_timestamp_bundle_lock_);
+  uptime_ms = Clock::QueryGuestUptimeMillis();
   xe::store_and_swap<uint64_t>(&lpKeTimeStampBundle->interrupt_time,
                                Clock::QueryGuestInterruptTime());
   xe::store_and_swap<uint64_t>(&lpKeTimeStampBundle->system_time,
@@ -986,15 +990,19 @@ uint32_t KernelState::CreateKeTimestampBundle() {
   xe::store_and_swap<uint64_t>(&lpKeTimeStampBundle->system_time,
                                Clock::QueryGuestSystemTime());
 
-  xe::store_and_swap<uint32_t>(&lpKeTimeStampBundle->tick_count,
-                               Clock::QueryGuestUptimeMillis());
+  uint32_t uptime_ms = Clock::QueryGuestUptimeMillis();
+  xe::store_and_swap<uint32_t>(&lpKeTimeStampBundle->tick_count, uptime_ms);
 
   xe::store_and_swap<uint32_t>(&lpKeTimeStampBundle->padding, 0);
 
-  timestamp_timer_ = xe::threading::HighResolutionTimer::CreateRepeating(
-      std::chrono::milliseconds(1),
-      [this]() { this->UpdateKeTimestampBundle(); });
+  ke_timestamp_bundle_update_uptime_ms_.store(uptime_ms,
+                                              std::memory_order_relaxed);
   ke_timestamp_bundle_ptr_ = pKeTimeStampBundle;
+  if (cvars::ke_timestamp_bundle_update_period) {
+    timestamp_timer_ = xe::threading::HighResolutionTimer::CreateRepeating(
+        std::chrono::milliseconds(cvars::ke_timestamp_bundle_update_period),
+        [this]() { this->UpdateKeTimestampBundle(false); });
+  }
   return pKeTimeStampBundle;
 }
 
@@ -12,7 +12,6 @@
 
 #include <atomic>
 #include <bitset>
-#include <condition_variable>
 #include <functional>
 #include <list>
 #include <memory>
@@ -24,6 +23,7 @@
 #include "xenia/base/mutex.h"
 #include "xenia/cpu/backend/backend.h"
 #include "xenia/cpu/export_resolver.h"
+#include "xenia/kernel/util/deferred_work_scheduler.h"
 #include "xenia/kernel/util/kernel_fwd.h"
 #include "xenia/kernel/util/native_list.h"
 #include "xenia/kernel/util/object_table.h"
@@ -331,7 +331,10 @@ class KernelState {
   XE_NOINLINE
   XE_COLD
   uint32_t CreateKeTimestampBundle();
-  void UpdateKeTimestampBundle();
+  // Writes the current times to the bundle if it has been created. Can be
+  // called from any thread. Unless forced, skipped without locking if the
+  // bundle has been updated less than a millisecond ago.
+  void UpdateKeTimestampBundle(bool force);
 
   void BeginDPCImpersonation(cpu::ppc::PPCContext* context,
                              DPCImpersonationScope& scope);
@@ -375,15 +378,16 @@ class KernelState {
   std::vector<TerminateNotification> terminate_notifications_;
   uint32_t kernel_guest_globals_ = 0;
 
-  std::atomic<bool> dispatch_thread_running_;
-  object_ref<XHostThread> dispatch_thread_;
   // Must be guarded by the global critical region.
   util::NativeList dpc_list_;
-  std::condition_variable_any dispatch_cond_;
-  std::list<std::function<void()>> dispatch_queue_;
+  util::DeferredWorkScheduler deferred_work_scheduler_;
 
   BitMap tls_bitmap_;
   uint32_t ke_timestamp_bundle_ptr_ = 0;
+  // Guest tick count of the last update of the bundle, updates that aren't
+  // forced are skipped until it changes.
+  std::atomic<uint32_t> ke_timestamp_bundle_update_uptime_ms_{0};
+  xe_mutex ke_timestamp_bundle_lock_;
   std::unique_ptr<xe::threading::HighResolutionTimer> timestamp_timer_;
   cpu::backend::GuestTrampolineGroup kernel_trampoline_group_;
   // fixed address referenced by dashboards. Data is currently unknown
@@ -0,0 +1,151 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "xenia/kernel/util/timer_wheel.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::kernel::test {
+
+struct TestNode {
+  TestNode* next = nullptr;
+  uint32_t wheel_rounds = 0;
+  uint32_t id = 0;
+};
+
+using TestWheel = util::TimerWheel<TestNode, 8>;
+
+// Returns the tick at which each node became due, or UINT64_MAX if it didn't
+// within tick_count ticks.
+std::vector<uint64_t> AdvanceWheel(TestWheel& wheel,
+                                   std::vector<TestNode>& nodes,
+                                   uint64_t tick_count) {
+  std::vector<uint64_t> due_ticks(nodes.size(), UINT64_MAX);
+  for (uint64_t i = 0; i < tick_count; ++i) {
+    wheel.Advance([&wheel, &due_ticks](TestNode* node) {
+      REQUIRE(due_ticks[node->id] == UINT64_MAX);
+      due_ticks[node->id] = wheel.current_tick();
+    });
+  }
+  return due_ticks;
+}
+
+TEST_CASE("Timer wheel tick count", "[kernel]") {
+  using namespace std::chrono_literals;
+  // At least the delay, with the current tick counted as partially over.
+  REQUIRE(TestWheel::GetTickCount(0ms, 10ms) == 1);
+  REQUIRE(TestWheel::GetTickCount(-5ms, 10ms) == 1);
+  REQUIRE(TestWheel::GetTickCount(1ms, 10ms) == 2);
+  REQUIRE(TestWheel::GetTickCount(10ms, 10ms) == 2);
+  REQUIRE(TestWheel::GetTickCount(11ms, 10ms) == 3);
+  REQUIRE(TestWheel::GetTickCount(1000ms, 10ms) == 101);
+}
+
+TEST_CASE("Timer wheel position", "[kernel]") {
+  SECTION("Within one revolution") {
+    TestWheel::Position position = TestWheel::GetPosition(0, 1);
+    REQUIRE(position.slot == 1);
+    REQUIRE(position.rounds == 0);
+    position = TestWheel::GetPosition(5, 3);
+    REQUIRE(position.slot == 0);
+    REQUIRE(position.rounds == 0);
+    // Exactly one revolution ends in the current slot, but without skipping
+    // it once, as it's reached again only after the full revolution.
+    position = TestWheel::GetPosition(5, 8);
+    REQUIRE(position.slot == 5);
+    REQUIRE(position.rounds == 0);
+  }
+
+  SECTION("Multiple revolutions") {
+    TestWheel::Position position = TestWheel::GetPosition(5, 9);
+    REQUIRE(position.slot == 6);
+    REQUIRE(position.rounds == 1);
+    position = TestWheel::GetPosition(5, 16);
+    REQUIRE(position.slot == 5);
+    REQUIRE(position.rounds == 1);
+    position = TestWheel::GetPosition(5, 17);
+    REQUIRE(position.slot == 6);
+    REQUIRE(position.rounds == 2);
+    position = TestWheel::GetPosition(UINT64_MAX - 2, 4);
+    REQUIRE(position.slot == (uint64_t(UINT64_MAX - 2) + 4) % 8);
+  }
+}
+
+TEST_CASE("Timer wheel advance", "[kernel]") {
+  TestWheel wheel;
+  wheel.SkipTo(5);
+  REQUIRE(wheel.current_tick() == 5);
+  const uint64_t tick_counts[] = {1, 3, 8, 9, 16, 17, 30};
+  std::vector<TestNode> nodes(std::size(tick_counts));
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].id = i;
+    wheel.Insert(&nodes[i], tick_counts[i]);
+  }
+  REQUIRE(wheel.size() == nodes.size());
+
+  std::vector<uint64_t> due_ticks = AdvanceWheel(wheel, nodes, 30);
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    INFO("Tick count " << tick_counts[i]);
+    REQUIRE(due_ticks[i] == 5 + tick_counts[i]);
+    REQUIRE(!nodes[i].next);
+  }
+  REQUIRE(wheel.empty());
+
+  SECTION("Skipped while empty") {
+    wheel.SkipTo(100);
+    REQUIRE(wheel.current_tick() == 100);
+    // Never moved backwards.
+    wheel.SkipTo(50);
+    REQUIRE(wheel.current_tick() == 100);
+    wheel.Insert(&nodes[0], 2);
+    due_ticks = AdvanceWheel(wheel, nodes, 2);
+    REQUIRE(due_ticks[0] == 102);
+  }
+}
+
+TEST_CASE("Timer wheel cancellation", "[kernel]") {
+  // Pending nodes are dropped on shutdown without becoming due.
+  TestWheel wheel;
+  std::vector<TestNode> nodes(4);
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].id = i;
+    wheel.Insert(&nodes[i], 1 + i * 5);
+  }
+  std::vector<uint64_t> due_ticks = AdvanceWheel(wheel, nodes, 1);
+  REQUIRE(due_ticks[0] == 1);
+  REQUIRE(wheel.size() == 3);
+
+  std::vector<uint32_t> removed_ids;
+  wheel.Clear(
+      [&removed_ids](TestNode* node) { removed_ids.push_back(node->id); });
+  REQUIRE(removed_ids.size() == 3);
+  REQUIRE(std::find(removed_ids.cbegin(), removed_ids.cend(), 0) ==
+          removed_ids.cend());
+  REQUIRE(wheel.empty());
+  for (const TestNode& node : nodes) {
+    REQUIRE(!node.next);
+  }
+
+  // Nothing becomes due afterwards, and the wheel is usable again.
+  due_ticks = AdvanceWheel(wheel, nodes, 32);
+  for (uint64_t due_tick : due_ticks) {
+    REQUIRE(due_tick == UINT64_MAX);
+  }
+  wheel.Insert(&nodes[1], 1);
+  due_ticks = AdvanceWheel(wheel, nodes, 1);
+  REQUIRE(due_ticks[1] == wheel.current_tick());
+}
+
+}  // namespace xe::kernel::test
@@ -0,0 +1,230 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/kernel/util/deferred_work_scheduler.h"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/assert.h"
+#include "xenia/kernel/kernel_state.h"
+#include "xenia/kernel/xthread.h"
+
+namespace xe {
+namespace kernel {
+namespace util {
+
+DeferredWorkScheduler::DeferredWorkScheduler(KernelState* kernel_state)
+    : kernel_state_(kernel_state) {}
+
+DeferredWorkScheduler::~DeferredWorkScheduler() { Shutdown(); }
+
+void DeferredWorkScheduler::Start(uint32_t worker_count) {
+  {
+    std::lock_guard<xe_mutex> lock(lock_);
+    if (running_) {
+      return;
+    }
+    running_ = true;
+    wheel_start_time_ = std::chrono::steady_clock::now();
+    wheel_ = {};
+  }
+
+  timer_thread_ =
+      xe::threading::Thread::Create({}, [this]() { TimerThread(); });
+  assert_not_null(timer_thread_);
+  timer_thread_->set_name("Kernel Deferred Work Timer");
+
+  worker_count = std::max(worker_count, uint32_t(1));
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    auto worker_thread = object_ref<XHostThread>(new XHostThread(
+        kernel_state_, 128 * 1024, 0,
+        [this]() {
+          WorkerThread();
+          return 0;
+        },
+        kernel_state_->GetSystemProcess()));
+    // As we run guest callbacks the debugger must be able to suspend us.
+    worker_thread->set_can_debugger_suspend(true);
+    worker_thread->set_name(fmt::format("Kernel Deferred Work {}", i));
+    worker_thread->Create();
+    worker_threads_.push_back(std::move(worker_thread));
+  }
+}
+
+void DeferredWorkScheduler::Shutdown() {
+  {
+    std::lock_guard<xe_mutex> lock(lock_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  worker_cond_.notify_all();
+  timer_cond_.notify_all();
+
+  for (object_ref<XHostThread>& worker_thread : worker_threads_) {
+    worker_thread->Wait(0, 0, 0, nullptr);
+  }
+  worker_threads_.clear();
+  if (timer_thread_) {
+    xe::threading::Wait(timer_thread_.get(), false);
+    timer_thread_.reset();
+  }
+
+  // Drop the pending tasks.
+  std::lock_guard<xe_mutex> lock(lock_);
+  while (ready_head_) {
+    Node* node = ready_head_;
+    ready_head_ = node->next;
+    FreeNode(node);
+  }
+  ready_tail_ = nullptr;
+  wheel_.Clear([this](Node* node) { FreeNode(node); });
+}
+
+void DeferredWorkScheduler::Schedule(Callback immediate_callback,
+                                     std::chrono::milliseconds delay,
+                                     Callback delayed_callback) {
+  {
+    std::lock_guard<xe_mutex> lock(lock_);
+    Node* node = AllocateNode();
+    node->immediate_callback = std::move(immediate_callback);
+    node->delayed_callback = std::move(delayed_callback);
+    node->delay = delay;
+    node->immediate_done = !node->immediate_callback;
+    if (!node->immediate_done || delay.count() <= 0) {
+      PushReady(node);
+    } else {
+      InsertTimed(node);
+      timer_cond_.notify_one();
+      return;
+    }
+  }
+  worker_cond_.notify_one();
+}
+
+DeferredWorkScheduler::Node* DeferredWorkScheduler::AllocateNode() {
+  if (!free_nodes_) {
+    auto chunk = std::make_unique<Node[]>(kNodeChunkSize);
+    for (uint32_t i = 0; i < kNodeChunkSize; ++i) {
+      chunk[i].next = free_nodes_;
+      free_nodes_ = &chunk[i];
+    }
+    node_chunks_.push_back(std::move(chunk));
+  }
+  Node* node = free_nodes_;
+  free_nodes_ = node->next;
+  node->next = nullptr;
+  return node;
+}
+
+void DeferredWorkScheduler::FreeNode(Node* node) {
+  node->immediate_callback = nullptr;
+  node->delayed_callback = nullptr;
+  node->next = free_nodes_;
+  free_nodes_ = node;
+}
+
+void DeferredWorkScheduler::PushReady(Node* node) {
+  node->next = nullptr;
+  if (ready_tail_) {
+    ready_tail_->next = node;
+  } else {
+    ready_head_ = node;
+  }
+  ready_tail_ = node;
+}
+
+void DeferredWorkScheduler::InsertTimed(Node* node) {
+  if (wheel_.empty()) {
+    // The timer thread doesn't advance the wheel while it's empty.
+    wheel_.SkipTo(GetElapsedTicks());
+  }
+  wheel_.Insert(node, Wheel::GetTickCount(node->delay, kWheelTickDuration));
+}
+
+uint64_t DeferredWorkScheduler::GetElapsedTicks() const {
+  return uint64_t((std::chrono::steady_clock::now() - wheel_start_time_) /
+                  kWheelTickDuration);
+}
+
+void DeferredWorkScheduler::WorkerThread() {
+  std::unique_lock<xe_mutex> lock(lock_);
+  while (true) {
+    while (running_ && !ready_head_) {
+      worker_cond_.wait(lock);
+    }
+    if (!running_) {
+      break;
+    }
+    Node* node = ready_head_;
+    ready_head_ = node->next;
+    if (!ready_head_) {
+      ready_tail_ = nullptr;
+    }
+    Callback callback;
+    bool immediate = !node->immediate_done;
+    if (immediate) {
+      callback = std::move(node->immediate_callback);
+      node->immediate_done = true;
+    } else {
+      callback = std::move(node->delayed_callback);
+    }
+    lock.unlock();
+
+    if (callback) {
+      callback();
+      callback = nullptr;
+    }
+
+    lock.lock();
+    if (immediate && node->delayed_callback) {
+      if (node->delay.count() > 0) {
+        InsertTimed(node);
+        timer_cond_.notify_one();
+      } else {
+        PushReady(node);
+      }
+    } else {
+      FreeNode(node);
+    }
+  }
+}
+
+void DeferredWorkScheduler::TimerThread() {
+  std::unique_lock<xe_mutex> lock(lock_);
+  while (running_) {
+    if (wheel_.empty()) {
+      timer_cond_.wait(lock);
+      continue;
+    }
+    auto next_tick_time =
+        wheel_start_time_ +
+        kWheelTickDuration * int64_t(wheel_.current_tick() + 1);
+    if (std::chrono::steady_clock::now() < next_tick_time) {
+      timer_cond_.wait_until(lock, next_tick_time);
+      continue;
+    }
+    bool any_ready = false;
+    wheel_.Advance([this, &any_ready](Node* node) {
+      PushReady(node);
+      any_ready = true;
+    });
+    if (any_ready) {
+      worker_cond_.notify_all();
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace kernel
+}  // namespace xe
@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_KERNEL_UTIL_DEFERRED_WORK_SCHEDULER_H_
+#define XENIA_KERNEL_UTIL_DEFERRED_WORK_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+#include "xenia/base/threading.h"
+#include "xenia/kernel/util/kernel_fwd.h"
+#include "xenia/kernel/util/timer_wheel.h"
+#include "xenia/kernel/xobject.h"
+
+namespace xe {
+namespace kernel {
+namespace util {
+
+// Runs deferred work, such as the completion of asynchronous (overlapped)
+// operations, on a small pool of threads, so independent tasks don't wait for
+// each other. Artificial delays are tracked by a timer wheel rather than by
+// sleeping in the worker threads. Task nodes are recycled, so scheduling
+// doesn't allocate memory for them once enough have been created for the peak
+// number of pending tasks.
+class DeferredWorkScheduler {
+ public:
+  using Callback = std::function<void()>;
+
+  explicit DeferredWorkScheduler(KernelState* kernel_state);
+  ~DeferredWorkScheduler();
+
+  bool is_running() const {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  void Start(uint32_t worker_count);
+  // Pending tasks are dropped.
+  void Shutdown();
+
+  // Runs the immediate callback (if any) as soon as a worker is available, and
+  // the delayed callback (if any) at least the specified delay after that.
+  void Schedule(Callback immediate_callback, std::chrono::milliseconds delay,
+                Callback delayed_callback);
+
+ private:
+  static constexpr std::chrono::milliseconds kWheelTickDuration{10};
+  static constexpr uint32_t kNodeChunkSize = 32;
+
+  struct Node {
+    Node* next;
+    Callback immediate_callback;
+    Callback delayed_callback;
+    std::chrono::milliseconds delay;
+    // Full revolutions of the wheel remaining before the node is due.
+    uint32_t wheel_rounds;
+    bool immediate_done;
+  };
+  using Wheel = TimerWheel<Node, 64>;
+
+  // All require the lock to be held.
+  Node* AllocateNode();
+  void FreeNode(Node* node);
+  void PushReady(Node* node);
+  void InsertTimed(Node* node);
+  uint64_t GetElapsedTicks() const;
+
+  void WorkerThread();
+  void TimerThread();
+
+  KernelState* kernel_state_;
+
+  xe_mutex lock_;
+  std::condition_variable_any worker_cond_;
+  std::condition_variable_any timer_cond_;
+  // Modified with the lock held, but also checked without it.
+  std::atomic<bool> running_{false};
+
+  std::vector<std::unique_ptr<Node[]>> node_chunks_;
+  Node* free_nodes_ = nullptr;
+  Node* ready_head_ = nullptr;
+  Node* ready_tail_ = nullptr;
+
+  std::chrono::steady_clock::time_point wheel_start_time_;
+  Wheel wheel_;
+
+  std::vector<object_ref<XHostThread>> worker_threads_;
+  std::unique_ptr<xe::threading::Thread> timer_thread_;
+};
+
+}  // namespace util
+}  // namespace kernel
+}  // namespace xe
+
+#endif  // XENIA_KERNEL_UTIL_DEFERRED_WORK_SCHEDULER_H_
@@ -0,0 +1,122 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_KERNEL_UTIL_TIMER_WHEEL_H_
+#define XENIA_KERNEL_UTIL_TIMER_WHEEL_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "xenia/base/assert.h"
+
+namespace xe {
+namespace kernel {
+namespace util {
+
+// Hashed timer wheel with intrusive lists of nodes, which must have a
+// `T* next` and a `uint32_t wheel_rounds` member. Delays longer than a
+// revolution of the wheel are placed in the slot they end in, with the number
+// of full revolutions to skip before they're due. Advanced explicitly one tick
+// at a time, and not thread-safe.
+template <typename T, uint32_t SlotCount>
+class TimerWheel {
+ public:
+  static constexpr uint32_t kSlotCount = SlotCount;
+
+  struct Position {
+    uint32_t slot;
+    uint32_t rounds;
+  };
+
+  // Returns the number of ticks to wait for at least the delay. Rounded up,
+  // plus one more as the current tick may be partially over already.
+  static uint64_t GetTickCount(std::chrono::milliseconds delay,
+                               std::chrono::milliseconds tick_duration) {
+    delay = std::max(delay, std::chrono::milliseconds(0));
+    return uint64_t((delay + tick_duration - std::chrono::milliseconds(1)) /
+                    tick_duration) +
+           1;
+  }
+
+  // Where a node due in tick_count (at least 1) ticks after current_tick is
+  // placed.
+  static Position GetPosition(uint64_t current_tick, uint64_t tick_count) {
+    assert_not_zero(tick_count);
+    return {uint32_t((current_tick + tick_count) % kSlotCount),
+            uint32_t((tick_count - 1) / kSlotCount)};
+  }
+
+  uint64_t current_tick() const { return current_tick_; }
+  size_t size() const { return size_; }
+  bool empty() const { return !size_; }
+
+  // Moves the current tick forward to at least the specified one without
+  // processing the skipped slots, thus only valid while empty.
+  void SkipTo(uint64_t tick) {
+    assert_true(empty());
+    current_tick_ = std::max(current_tick_, tick);
+  }
+
+  void Insert(T* node, uint64_t tick_count) {
+    Position position = GetPosition(current_tick_, tick_count);
+    node->wheel_rounds = position.rounds;
+    node->next = slots_[position.slot];
+    slots_[position.slot] = node;
+    ++size_;
+  }
+
+  // Advances by one tick, unlinking the nodes that are due and passing them to
+  // on_due.
+  template <typename F>
+  void Advance(F on_due) {
+    ++current_tick_;
+    T** node_ptr = &slots_[current_tick_ % kSlotCount];
+    while (*node_ptr) {
+      T* node = *node_ptr;
+      if (node->wheel_rounds) {
+        --node->wheel_rounds;
+        node_ptr = &node->next;
+        continue;
+      }
+      *node_ptr = node->next;
+      node->next = nullptr;
+      --size_;
+      on_due(node);
+    }
+  }
+
+  // Unlinks all the nodes without them becoming due, passing them to
+  // on_removed.
+  template <typename F>
+  void Clear(F on_removed) {
+    for (T*& slot : slots_) {
+      while (slot) {
+        T* node = slot;
+        slot = node->next;
+        node->next = nullptr;
+        on_removed(node);
+      }
+    }
+    size_ = 0;
+  }
+
+ private:
+  uint64_t current_tick_ = 0;
+  size_t size_ = 0;
+  std::array<T*, SlotCount> slots_ = {};
+};
+
+}  // namespace util
+}  // namespace kernel
+}  // namespace xe
+
+#endif  // XENIA_KERNEL_UTIL_TIMER_WHEEL_H_
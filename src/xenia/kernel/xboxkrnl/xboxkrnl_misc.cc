@@ -122,6 +122,7 @@ DECLARE_XBOXKRNL_EXPORT1(KeSaveFloatingPointState, kNone, kImplemented);
 static qword_result_t KeQueryInterruptTime_entry(const ppc_context_t& ctx) {
   auto kstate = ctx->kernel_state;
   uint32_t ts_bundle = kstate->GetKeTimestampBundle();
+  kstate->UpdateKeTimestampBundle(true);
   X_TIME_STAMP_BUNDLE* bundle =
       ctx->TranslateVirtual<X_TIME_STAMP_BUNDLE*>(ts_bundle);
 
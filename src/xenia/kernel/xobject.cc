@@ -206,6 +206,8 @@ X_STATUS XObject::Wait(uint32_t wait_reason, uint32_t processor_mode,
 
   auto result =
       xe::threading::Wait(wait_handle, alertable ? true : false, timeout_ms);
+  // The guest may check the time in the timestamp bundle after waking up.
+  kernel_state_->UpdateKeTimestampBundle(false);
   switch (result) {
     case xe::threading::WaitResult::kSuccess:
       WaitCallback();
@@ -234,6 +236,7 @@ X_STATUS XObject::SignalAndWait(XObject* signal_object, XObject* wait_object,
   auto result = xe::threading::SignalAndWait(
       signal_object->GetWaitHandle(), wait_object->GetWaitHandle(),
       alertable ? true : false, timeout_ms);
+  wait_object->kernel_state()->UpdateKeTimestampBundle(false);
   switch (result) {
     case xe::threading::WaitResult::kSuccess:
       wait_object->WaitCallback();
@@ -270,6 +273,7 @@ X_STATUS XObject::WaitMultiple(uint32_t count, XObject** objects,
   if (wait_type) {
     auto result = xe::threading::WaitAny(wait_handles, count,
                                          alertable ? true : false, timeout_ms);
+    xe::kernel::kernel_state()->UpdateKeTimestampBundle(false);
     switch (result.first) {
       case xe::threading::WaitResult::kSuccess:
         objects[result.second]->WaitCallback();
@@ -290,6 +294,7 @@ X_STATUS XObject::WaitMultiple(uint32_t count, XObject** objects,
   } else {
     auto result = xe::threading::WaitAll(wait_handles, count,
                                          alertable ? true : false, timeout_ms);
+    xe::kernel::kernel_state()->UpdateKeTimestampBundle(false);
     switch (result) {
       case xe::threading::WaitResult::kSuccess:
         for (uint32_t i = 0; i < count; i++) {
@@ -768,6 +768,8 @@ X_STATUS XThread::Delay(uint32_t processor_mode, uint32_t alertable,
   if (alertable) {
     auto result =
         xe::threading::AlertableSleep(std::chrono::milliseconds(timeout_ms));
+    // The guest may check the time in the timestamp bundle after waking up.
+    kernel_state_->UpdateKeTimestampBundle(false);
     switch (result) {
       default:
       case xe::threading::SleepResult::kSuccess:
@@ -777,6 +779,7 @@ X_STATUS XThread::Delay(uint32_t processor_mode, uint32_t alertable,
     }
   } else {
     xe::threading::Sleep(std::chrono::milliseconds(timeout_ms));
+    kernel_state_->UpdateKeTimestampBundle(false);
     return X_STATUS_SUCCESS;
   }
 }
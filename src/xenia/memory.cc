@@ -33,6 +33,16 @@ DEFINE_bool(protect_on_release, false,
             "Protect released memory to prevent accesses.", "Memory");
 DEFINE_bool(scribble_heap, false,
             "Scribble 0xCD into all allocated heap memory.", "Memory");
+DEFINE_string(
+    physical_write_watch, "protect",
+    "Method of detecting guest CPU writes to physical memory with data cached "
+    "by the GPU emulation.\n"
+    " protect: Write-protect the pages and handle the access violation on the "
+    "first write to each.\n"
+    " userfaultfd: Let the host kernel record the written pages without "
+    "raising access violations, and collect them in batches at GPU submission "
+    "boundaries (Linux 6.7+, falls back to protect if unavailable).",
+    "Memory");
 
 namespace xe {
 uint32_t get_page_count(uint32_t value, uint32_t page_size) {
@@ -104,6 +114,14 @@ Memory::~Memory() {
     delete invalidation_callback;
   }
 
+  if (xe::memory::IsLargePageBackingPreferred() && virtual_membase_) {
+    // Only a proxy for the TLB effect, which needs to be measured with the
+    // host performance counters (such as dTLB-load-misses in perf stat).
+    XELOGI("Guest memory backed by large pages at shutdown: {} MB",
+           xe::memory::QueryLargePageBackedSize(mapping_base_, 0x120000000) >>
+               20);
+  }
+
   heaps_.v00000000.Dispose();
   heaps_.v40000000.Dispose();
   heaps_.v80000000.Dispose();
@@ -113,6 +131,8 @@ Memory::~Memory() {
   heaps_.vE0000000.Dispose();
   heaps_.physical.Dispose();
 
+  physical_write_watch_.reset();
+
   // Unmap all views and close mapping.
   if (mapping_ != xe::memory::kFileMappingHandleInvalid) {
     UnmapViews();
@@ -180,6 +200,17 @@ bool Memory::Initialize() {
   heaps_.vE0000000.Initialize(this, virtual_membase_, HeapType::kGuestPhysical,
                               0xE0000000, 0x1FD00000, 4096, &heaps_.physical);
 
+  if (cvars::physical_write_watch == "userfaultfd") {
+    // The virtual views of physical memory are contiguous.
+    physical_write_watch_ = xe::memory::WriteWatch::Create(
+        virtual_membase_ + 0xA0000000, 0x60000000);
+    if (!physical_write_watch_) {
+      XELOGW(
+          "Deferred physical memory write tracking is not supported by the "
+          "host, falling back to write protection");
+    }
+  }
+
   // Protect the first and last 64kb of memory.
   heaps_.v00000000.AllocFixed(
       0x00000000, 0x10000, 0x10000,
@@ -297,6 +328,21 @@ int Memory::MapViews(uint8_t* mapping_base) {
       return 1;
     }
   }
+  if (xe::memory::IsLargePageBackingPreferred()) {
+    // Advised once for the whole views - the heaps only commit within them,
+    // which keeps the advice.
+    bool large_pages_advised = true;
+    for (size_t n = 0; n < xe::countof(map_info); n++) {
+      if (!xe::memory::AdviseLargePages(
+              views_.all_views[n], map_info[n].virtual_address_end -
+                                       map_info[n].virtual_address_start + 1)) {
+        large_pages_advised = false;
+      }
+    }
+    if (!large_pages_advised) {
+      XELOGW("Large pages are not supported for the guest memory");
+    }
+  }
   return 0;
 }
 
@@ -580,6 +626,15 @@ void Memory::UnregisterPhysicalMemoryInvalidationCallback(
   delete entry;
 }
 
+void Memory::ReportPhysicalMemoryWrites() {
+  if (!physical_write_watch_) {
+    return;
+  }
+  heaps_.vA0000000.ReportWatchedWrites(*physical_write_watch_);
+  heaps_.vC0000000.ReportWatchedWrites(*physical_write_watch_);
+  heaps_.vE0000000.ReportWatchedWrites(*physical_write_watch_);
+}
+
 void Memory::EnablePhysicalMemoryAccessCallbacks(
     uint32_t physical_address, uint32_t length,
     bool enable_invalidation_notifications, bool enable_data_providers) {
@@ -1725,7 +1780,6 @@ template <bool enable_invalidation_notifications>
 XE_NOINLINE void PhysicalHeap::EnableAccessCallbacksInner(
     const uint32_t system_page_first, const uint32_t system_page_last,
     xe::memory::PageAccess protect_access) XE_RESTRICT {
-  uint8_t* protect_base = membase_ + heap_base_;
   uint32_t protect_system_page_first = UINT32_MAX;
 
   SystemPageFlagsBlock* XE_RESTRICT sys_page_flags = system_page_flags_.data();
@@ -1800,23 +1854,41 @@ XE_NOINLINE void PhysicalHeap::EnableAccessCallbacksInner(
       }
     } else {
       if (protect_system_page_first != UINT32_MAX) {
-        xe::memory::Protect(
-            protect_base + (protect_system_page_first << system_page_shift_),
-            (i - protect_system_page_first) << system_page_shift_,
-            protect_access);
+        ProtectSystemPagesForCallbacks(protect_system_page_first,
+                                       i - protect_system_page_first,
+                                       protect_access);
         protect_system_page_first = UINT32_MAX;
       }
     }
   }
 
   if (protect_system_page_first != UINT32_MAX) {
-    xe::memory::Protect(
-        protect_base + (protect_system_page_first << system_page_shift_),
-        (system_page_last + 1 - protect_system_page_first)
-            << system_page_shift_,
-        protect_access);
+    ProtectSystemPagesForCallbacks(
+        protect_system_page_first,
+        system_page_last + 1 - protect_system_page_first, protect_access);
+  }
+}
+
+void PhysicalHeap::ProtectSystemPagesForCallbacks(
+    uint32_t system_page_first, uint32_t system_page_count,
+    xe::memory::PageAccess protect_access) {
+  uint8_t* protect_address =
+      membase_ + heap_base_ + (system_page_first << system_page_shift_);
+  size_t protect_length = size_t(system_page_count) << system_page_shift_;
+  // Data providers need the access itself to be intercepted, only
+  // invalidation notifications can be deferred.
+  xe::memory::WriteWatch* write_watch = memory_->physical_write_watch_.get();
+  if (write_watch && protect_access == xe::memory::PageAccess::kReadOnly) {
+    if (write_watch->Reset(protect_address, protect_length)) {
+      return;
+    }
+    XELOGE(
+        "PhysicalHeap: Failed to reset the write watch, write-protecting the "
+        "pages instead");
   }
+  xe::memory::Protect(protect_address, protect_length, protect_access);
 }
+
 bool PhysicalHeap::TriggerCallbacks(
     global_unique_lock_type global_lock_locked_once, uint32_t virtual_address,
     uint32_t length, bool is_write, bool unwatch_exact_range, bool unprotect) {
@@ -1989,6 +2061,54 @@ bool PhysicalHeap::TriggerCallbacks(
   return true;
 }
 
+void PhysicalHeap::ReportWatchedWrites(xe::memory::WriteWatch& write_watch) {
+  // Only walk the host page tables for the 64-page blocks containing watched
+  // pages.
+  std::vector<std::pair<uint32_t, uint32_t>> block_runs;
+  {
+    auto global_lock = global_critical_region_.Acquire();
+    uint32_t block_count = uint32_t(system_page_flags_.size());
+    for (uint32_t i = 0; i < block_count; ++i) {
+      if (!system_page_flags_[i].notify_on_invalidation) {
+        continue;
+      }
+      if (!block_runs.empty() && block_runs.back().second == i) {
+        ++block_runs.back().second;
+      } else {
+        block_runs.emplace_back(i, i + 1);
+      }
+    }
+  }
+  if (block_runs.empty()) {
+    return;
+  }
+
+  uint8_t* host_base = membase_ + heap_base_;
+  uint32_t host_size = system_page_count_ << system_page_shift_;
+  std::vector<std::pair<size_t, size_t>> written_ranges;
+  for (const std::pair<uint32_t, uint32_t>& block_run : block_runs) {
+    uint32_t run_start = block_run.first << (system_page_shift_ + 6);
+    uint32_t run_end =
+        std::min(block_run.second << (system_page_shift_ + 6), host_size);
+    written_ranges.clear();
+    if (!write_watch.GetAndReset(host_base + run_start, run_end - run_start,
+                                 written_ranges)) {
+      // Don't know which pages have been modified, assume all of them.
+      XELOGE("PhysicalHeap: Failed to get the written pages");
+      written_ranges.emplace_back(0, run_end - run_start);
+    }
+    // Each range is a batch of adjacent pages, invalidated with one call of
+    // each callback.
+    for (const std::pair<size_t, size_t>& written_range : written_ranges) {
+      uint32_t host_offset = run_start + uint32_t(written_range.first);
+      TriggerCallbacks(
+          global_critical_region_.Acquire(),
+          heap_base_ + xe::sat_sub(host_offset, host_address_offset()),
+          uint32_t(written_range.second), true, true, false);
+    }
+  }
+}
+
 uint32_t PhysicalHeap::GetPhysicalAddress(uint32_t address) const {
   assert_true(address >= heap_base_);
   address -= heap_base_;
@@ -275,6 +275,11 @@ class PhysicalHeap : public BaseHeap {
   XE_NOINLINE void EnableAccessCallbacksInner(
       const uint32_t system_page_first, const uint32_t system_page_last,
       xe::memory::PageAccess protect_access) XE_RESTRICT;
+  // Raises the protection of the pages for access callbacks, or, if possible,
+  // starts tracking writes to them with the write watch.
+  void ProtectSystemPagesForCallbacks(uint32_t system_page_first,
+                                      uint32_t system_page_count,
+                                      xe::memory::PageAccess protect_access);
 
   // Returns true if any page in the range was watched.
   bool TriggerCallbacks(global_unique_lock_type global_lock_locked_once,
@@ -282,6 +287,10 @@ class PhysicalHeap : public BaseHeap {
                         bool is_write, bool unwatch_exact_range,
                         bool unprotect = true);
 
+  // Triggers the callbacks for the watched pages recorded as written by the
+  // write watch. Must be called without the global critical region locked.
+  void ReportWatchedWrites(xe::memory::WriteWatch& write_watch);
+
   uint32_t GetPhysicalAddress(uint32_t address) const;
 
   uint32_t SystemPagenumToGuestPagenum(uint32_t num) const {
@@ -503,6 +512,15 @@ class Memory {
       uint32_t length, bool is_write, bool unwatch_exact_range,
       bool unprotect = true);
 
+  // With deferred tracking of guest writes to physical memory (the
+  // physical_write_watch cvar), triggers the callbacks for the watched pages
+  // written since the last call - must be called where the guest CPU writes
+  // need to become visible to the GPU, such as submission boundaries. Does
+  // nothing if the pages are write-protected instead, as the callbacks are
+  // triggered by the first write in this case. Must be called without the
+  // global critical region locked.
+  void ReportPhysicalMemoryWrites();
+
   // Allocates virtual memory from the 'system' heap.
   // System memory is kept separate from game memory but is still accessible
   // using normal guest virtual addresses. Kernel structures and other internal
@@ -581,6 +599,10 @@ class Memory {
 
   std::unique_ptr<cpu::MMIOHandler> mmio_handler_;
 
+  // Guest writes to the virtual views of physical memory, if tracked without
+  // write-protecting the pages.
+  std::unique_ptr<xe::memory::WriteWatch> physical_write_watch_;
+
   struct {
     VirtualHeap v00000000;
     VirtualHeap v40000000;
@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xenia/base/clock.h"
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/logging.h"
+#include "xenia/memory.h"
+
+DEFINE_int32(bench_page_count, 4096,
+             "Number of watched 4 KB pages written in each iteration.",
+             "Memory");
+DEFINE_int32(bench_page_stride, 1,
+             "Write to every Nth page, to measure scattered writes.", "Memory");
+DEFINE_int32(bench_iterations, 256,
+             "Number of times to watch and write to the pages.", "Memory");
+
+DECLARE_string(physical_write_watch);
+
+namespace xe {
+
+namespace {
+
+struct CallbackStats {
+  uint64_t invocations = 0;
+  uint64_t invalidated_bytes = 0;
+};
+
+std::pair<uint32_t, uint32_t> CountInvalidationCallback(
+    void* context, uint32_t physical_address_start, uint32_t length,
+    bool exact_range) {
+  auto stats = reinterpret_cast<CallbackStats*>(context);
+  ++stats->invocations;
+  stats->invalidated_bytes += length;
+  // Only unwatch the written pages so every page is reported individually.
+  return std::make_pair(physical_address_start, length);
+}
+
+double TicksToSeconds(uint64_t ticks) {
+  return double(ticks) / double(Clock::QueryHostTickFrequency());
+}
+
+// Returns false if the method couldn't be tested.
+bool RunWriteWatchBench(const std::string& method) {
+  cvars::physical_write_watch = method;
+  auto memory = std::make_unique<Memory>();
+  if (!memory->Initialize()) {
+    XELOGE("{}: Failed to initialize the guest memory", method);
+    return false;
+  }
+
+  const uint32_t kPageSize = 4096;
+  uint32_t page_count = uint32_t(std::max(cvars::bench_page_count, 1));
+  uint32_t page_stride = uint32_t(std::max(cvars::bench_page_stride, 1));
+  uint32_t size = page_count * kPageSize;
+  uint32_t address =
+      memory->SystemHeapAlloc(size, kPageSize, kSystemHeapPhysical);
+  if (!address) {
+    XELOGE("{}: Failed to allocate {} bytes of physical memory", method, size);
+    return false;
+  }
+  uint32_t physical_address = memory->GetPhysicalAddress(address);
+
+  CallbackStats stats;
+  void* callback_handle = memory->RegisterPhysicalMemoryInvalidationCallback(
+      CountInvalidationCallback, &stats);
+
+  uint32_t iterations = uint32_t(std::max(cvars::bench_iterations, 1));
+  uint32_t pages_written = 0;
+  uint64_t watch_ticks = 0;
+  uint64_t write_ticks = 0;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    uint64_t watch_start = Clock::QueryHostTickCount();
+    memory->EnablePhysicalMemoryAccessCallbacks(physical_address, size, true,
+                                                false);
+    uint64_t write_start = Clock::QueryHostTickCount();
+    watch_ticks += write_start - watch_start;
+    // Like the guest, write through the virtual view of physical memory.
+    auto data = memory->TranslateVirtual<volatile uint32_t*>(address);
+    for (uint32_t j = 0; j < page_count; j += page_stride) {
+      data[j * (kPageSize / sizeof(uint32_t))] = i;
+      ++pages_written;
+    }
+    memory->ReportPhysicalMemoryWrites();
+    write_ticks += Clock::QueryHostTickCount() - write_start;
+  }
+
+  memory->UnregisterPhysicalMemoryInvalidationCallback(callback_handle);
+  memory->SystemHeapFree(address);
+
+  double write_seconds = TicksToSeconds(write_ticks);
+  XELOGI(
+      "{}: {} pages written, {} callback invocations ({} bytes invalidated)",
+      method, pages_written, stats.invocations, stats.invalidated_bytes);
+  XELOGI("{}: watching {:.3f} ms, writing and reporting {:.3f} ms", method,
+         TicksToSeconds(watch_ticks) * 1000.0, write_seconds * 1000.0);
+  XELOGI("{}: {:.0f} ns per written page, {:.0f} callbacks/s", method,
+         write_seconds * 1.0e9 / pages_written,
+         stats.invocations / write_seconds);
+  if (stats.invalidated_bytes < uint64_t(pages_written) * kPageSize) {
+    XELOGE("{}: Some writes were not reported", method);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int memory_write_watch_bench_main(const std::vector<std::string>& args) {
+  int result = 0;
+  for (const char* method : {"protect", "userfaultfd"}) {
+    if (!RunWriteWatchBench(method)) {
+      result = 1;
+    }
+  }
+  return result;
+}
+
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-memory-write-watch-bench",
+                      xe::memory_write_watch_bench_main, "");
@@ -7,6 +7,7 @@
  ******************************************************************************
  */
 #include <regex>
+#include <unordered_map>
 
 #include "xenia/base/cvar.h"
 #include "xenia/base/filesystem.h"
@@ -22,8 +23,10 @@ DEFINE_bool(apply_patches, true, "Enables custom patching functionality",
 namespace xe {
 namespace patcher {
 
-PatchDB::PatchDB(const std::filesystem::path patches_root) {
+PatchDB::PatchDB(const std::filesystem::path patches_root,
+                 const std::filesystem::path cache_root) {
   patches_root_ = patches_root;
+  cache_root_ = cache_root;
   LoadPatches();
 }
 
@@ -34,27 +37,150 @@ void PatchDB::LoadPatches() {
     return;
   }
 
+  std::filesystem::path index_path;
+  std::vector<PatchIndexEntry> cached_index;
+  if (!cache_root_.empty()) {
+    index_path = cache_root_ / "patches.idx";
+    if (ReadIndex(index_path)) {
+      cached_index = std::move(index_);
+    }
+  }
+  std::unordered_map<std::string, PatchIndexEntry*> cached_entries;
+  for (PatchIndexEntry& cached_entry : cached_index) {
+    cached_entries.emplace(cached_entry.file_name, &cached_entry);
+  }
+
   const std::filesystem::path patches_directory = patches_root_ / "patches";
   const std::vector<xe::filesystem::FileInfo> patch_files =
       filesystem::ListFiles(patches_directory);
 
+  index_.clear();
+  size_t reused_count = 0;
   for (const xe::filesystem::FileInfo& patch_file : patch_files) {
+    const std::string file_name = path_to_utf8(patch_file.name);
     // Skip files that doesn't have only title_id as name and .patch as
     // extension
-    if (!std::regex_match(path_to_utf8(patch_file.name),
-                          patch_filename_regex_)) {
+    if (!std::regex_match(file_name, patch_filename_regex_)) {
       XELOGE("PatchDB: Skipped loading file {} due to incorrect filename",
-             path_to_utf8(patch_file.name));
+             file_name);
       continue;
     }
 
-    const PatchFileEntry loaded_title_patches =
-        ReadPatchFile(patch_file.path / patch_file.name);
-    if (loaded_title_patches.title_id != -1) {
-      loaded_patches_.push_back(loaded_title_patches);
+    auto cached_it = cached_entries.find(file_name);
+    if (cached_it != cached_entries.end() &&
+        cached_it->second->write_timestamp == patch_file.write_timestamp &&
+        cached_it->second->file_size == patch_file.total_size) {
+      index_.push_back(std::move(*cached_it->second));
+      ++reused_count;
+    } else {
+      index_.push_back(IndexPatchFile(patch_file));
+    }
+  }
+
+  // Rewrite the index if any file was added, changed or removed.
+  if (!index_path.empty() &&
+      (reused_count != index_.size() || reused_count != cached_index.size())) {
+    WriteIndex(index_path);
+  }
+  XELOGI("PatchDB: Indexed {} patch files ({} parsed)", index_.size(),
+         index_.size() - reused_count);
+}
+
+PatchIndexEntry PatchDB::IndexPatchFile(
+    const xe::filesystem::FileInfo& file_info) {
+  PatchIndexEntry index_entry;
+  index_entry.file_name = path_to_utf8(file_info.name);
+  index_entry.write_timestamp = file_info.write_timestamp;
+  index_entry.file_size = file_info.total_size;
+  index_entry.title_id = uint32_t(-1);
+
+  std::shared_ptr<cpptoml::table> patch_toml_fields;
+  try {
+    patch_toml_fields = ParseFile(file_info.path / file_info.name);
+  } catch (...) {
+    XELOGE("PatchDB: Cannot load patch file: {}", index_entry.file_name);
+    return index_entry;
+  };
+
+  auto title_id = patch_toml_fields->get_as<std::string>("title_id");
+  if (!title_id) {
+    XELOGE("PatchDB: No title ID in patch file: {}", index_entry.file_name);
+    return index_entry;
+  }
+  index_entry.title_id = strtoul((*title_id).c_str(), NULL, 16);
+  ReadHashes(index_entry.hashes, patch_toml_fields);
+  return index_entry;
+}
+
+bool PatchDB::ReadIndex(const std::filesystem::path& index_path) {
+  FILE* file = xe::filesystem::OpenFile(index_path, "rb");
+  if (!file) {
+    return false;
+  }
+  auto read = [file](void* data, size_t size) {
+    return !size || fread(data, size, 1, file) == 1;
+  };
+  uint32_t header[3];
+  bool valid = read(header, sizeof(header)) && header[0] == kIndexMagic &&
+               header[1] == kIndexVersion;
+  index_.clear();
+  if (valid) {
+    // Not reserving the unchecked entry count, the entries are added as they
+    // are read, so a corrupt count just fails on the end of the file.
+    for (uint32_t i = 0; i < header[2]; ++i) {
+      PatchIndexEntry& index_entry = index_.emplace_back();
+      uint32_t name_length, hash_count;
+      if (!read(&index_entry.write_timestamp, sizeof(uint64_t)) ||
+          !read(&index_entry.file_size, sizeof(uint64_t)) ||
+          !read(&index_entry.title_id, sizeof(uint32_t)) ||
+          !read(&name_length, sizeof(uint32_t)) ||
+          !read(&hash_count, sizeof(uint32_t)) || name_length > 4096 ||
+          hash_count > 4096) {
+        valid = false;
+        break;
+      }
+      index_entry.file_name.resize(name_length);
+      index_entry.hashes.resize(hash_count);
+      if (!read(index_entry.file_name.data(), name_length) ||
+          !read(index_entry.hashes.data(), sizeof(uint64_t) * hash_count)) {
+        valid = false;
+        break;
+      }
     }
   }
-  XELOGI("PatchDB: Loaded patches for {} titles", loaded_patches_.size());
+  fclose(file);
+  if (!valid) {
+    XELOGW("PatchDB: Ignoring invalid patch index {}",
+           path_to_utf8(index_path));
+    index_.clear();
+  }
+  return valid;
+}
+
+bool PatchDB::WriteIndex(const std::filesystem::path& index_path) const {
+  std::error_code ec;
+  std::filesystem::create_directories(index_path.parent_path(), ec);
+  FILE* file = xe::filesystem::OpenFile(index_path, "wb");
+  if (!file) {
+    XELOGW("PatchDB: Cannot write patch index {}", path_to_utf8(index_path));
+    return false;
+  }
+  const uint32_t header[] = {kIndexMagic, kIndexVersion,
+                             uint32_t(index_.size())};
+  fwrite(header, sizeof(header), 1, file);
+  for (const PatchIndexEntry& index_entry : index_) {
+    const uint32_t name_length = uint32_t(index_entry.file_name.size());
+    const uint32_t hash_count = uint32_t(index_entry.hashes.size());
+    fwrite(&index_entry.write_timestamp, sizeof(uint64_t), 1, file);
+    fwrite(&index_entry.file_size, sizeof(uint64_t), 1, file);
+    fwrite(&index_entry.title_id, sizeof(uint32_t), 1, file);
+    fwrite(&name_length, sizeof(uint32_t), 1, file);
+    fwrite(&hash_count, sizeof(uint32_t), 1, file);
+    fwrite(index_entry.file_name.data(), 1, name_length, file);
+    fwrite(index_entry.hashes.data(), sizeof(uint64_t), hash_count, file);
+  }
+  fclose(file);
+  return true;
 }
 
 PatchFileEntry PatchDB::ReadPatchFile(const std::filesystem::path& file_path) {
@@ -74,7 +200,7 @@ PatchFileEntry PatchDB::ReadPatchFile(const std::filesystem::path& file_path) {
 
   patch_file.title_id = strtoul((*title_id).c_str(), NULL, 16);
   patch_file.title_name = *title_name;
-  ReadHashes(patch_file, patch_toml_fields);
+  ReadHashes(patch_file.hashes, patch_toml_fields);
 
   auto patch_table = patch_toml_fields->get_table_array("patch");
 
@@ -194,30 +320,54 @@ bool PatchDB::ReadPatchData(
 std::vector<PatchFileEntry> PatchDB::GetTitlePatches(
     const uint32_t title_id, const std::optional<uint64_t> hash) {
   std::vector<PatchFileEntry> title_patches;
+  if (!hash) {
+    return title_patches;
+  }
 
-  std::copy_if(
-      loaded_patches_.cbegin(), loaded_patches_.cend(),
-      std::back_inserter(title_patches), [=](const PatchFileEntry entry) {
-        bool hash_exist = std::find(entry.hashes.cbegin(), entry.hashes.cend(),
-                                    hash) != entry.hashes.cend();
-
-        return entry.title_id == title_id && hash_exist;
-      });
+  for (const PatchIndexEntry& index_entry : index_) {
+    if (index_entry.title_id != title_id ||
+        std::find(index_entry.hashes.cbegin(), index_entry.hashes.cend(),
+                  *hash) == index_entry.hashes.cend()) {
+      continue;
+    }
+    PatchFileEntry patch_file =
+        ReadPatchFile(patches_root_ / "patches" / index_entry.file_name);
+    if (patch_file.title_id != -1) {
+      title_patches.push_back(std::move(patch_file));
+    }
+  }
 
   return title_patches;
 }
 
-void PatchDB::ReadHashes(PatchFileEntry& patch_entry,
+std::vector<PatchFileEntry>& PatchDB::GetAllPatches() {
+  if (!all_patches_loaded_) {
+    all_patches_loaded_ = true;
+    for (const PatchIndexEntry& index_entry : index_) {
+      if (index_entry.title_id == uint32_t(-1)) {
+        continue;
+      }
+      PatchFileEntry patch_file =
+          ReadPatchFile(patches_root_ / "patches" / index_entry.file_name);
+      if (patch_file.title_id != -1) {
+        loaded_patches_.push_back(std::move(patch_file));
+      }
+    }
+  }
+  return loaded_patches_;
+}
+
+void PatchDB::ReadHashes(std::vector<uint64_t>& hashes,
                          std::shared_ptr<cpptoml::table> patch_toml_fields) {
   auto title_hashes = patch_toml_fields->get_array_of<std::string>("hash");
 
   for (const auto& hash : *title_hashes) {
-    patch_entry.hashes.push_back(strtoull(hash.c_str(), NULL, 16));
+    hashes.push_back(strtoull(hash.c_str(), NULL, 16));
   }
 
   auto single_hash = patch_toml_fields->get_as<std::string>("hash");
   if (single_hash) {
-    patch_entry.hashes.push_back(strtoull((*single_hash).c_str(), NULL, 16));
+    hashes.push_back(strtoull((*single_hash).c_str(), NULL, 16));
   }
 }
 
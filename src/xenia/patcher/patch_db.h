@@ -16,6 +16,7 @@
 #include <regex>
 
 #include "third_party/cpptoml/include/cpptoml.h"
+#include "xenia/base/filesystem.h"
 
 namespace xe {
 namespace patcher {
@@ -70,6 +71,17 @@ struct PatchFileEntry {
   std::vector<PatchInfoEntry> patch_info;
 };
 
+// What a patch file applies to, cached so only the files for the running title
+// have to be parsed.
+struct PatchIndexEntry {
+  std::string file_name;
+  uint64_t write_timestamp;
+  uint64_t file_size;
+  // -1 for files that failed to parse, so they're not retried until changed.
+  uint32_t title_id;
+  std::vector<uint64_t> hashes;
+};
+
 enum class PatchDataType {
   kBE8,
   kBE16,
@@ -91,9 +103,13 @@ struct PatchData {
 
 class PatchDB {
  public:
-  PatchDB(const std::filesystem::path patches_root);
+  // The index of the patch files is kept in the cache root if it's not empty.
+  PatchDB(const std::filesystem::path patches_root,
+          const std::filesystem::path cache_root = {});
   ~PatchDB();
 
+  // Updates the index for the patch files added, changed or removed since it
+  // was last written, parsing only those files.
   void LoadPatches();
 
   PatchFileEntry ReadPatchFile(const std::filesystem::path& file_path);
@@ -101,13 +117,22 @@ class PatchDB {
                      const std::pair<std::string, PatchData> data_type,
                      const std::shared_ptr<cpptoml::table>& patch_table);
 
+  // Parses the patch files for the title.
   std::vector<PatchFileEntry> GetTitlePatches(
       const uint32_t title_id, const std::optional<uint64_t> hash);
-  std::vector<PatchFileEntry>& GetAllPatches() { return loaded_patches_; }
+  // Parses all the patch files on the first call.
+  std::vector<PatchFileEntry>& GetAllPatches();
 
  private:
-  void ReadHashes(PatchFileEntry& patch_entry,
+  static constexpr uint32_t kIndexMagic = 0x49445058;  // 'XPDI'
+  static constexpr uint32_t kIndexVersion = 1;
+
+  void ReadHashes(std::vector<uint64_t>& hashes,
                   std::shared_ptr<cpptoml::table> patch_toml_fields);
+  PatchIndexEntry IndexPatchFile(const xe::filesystem::FileInfo& file_info);
+
+  bool ReadIndex(const std::filesystem::path& index_path);
+  bool WriteIndex(const std::filesystem::path& index_path) const;
 
   inline static const std::regex patch_filename_regex_ =
       std::regex("^[A-Fa-f0-9]{8}.*\\.patch\\.toml$");
@@ -123,8 +148,11 @@ class PatchDB {
       {"be16", PatchData(sizeof(uint16_t), PatchDataType::kBE16)},
       {"be8", PatchData(sizeof(uint8_t), PatchDataType::kBE8)}};
 
+  std::vector<PatchIndexEntry> index_;
   std::vector<PatchFileEntry> loaded_patches_;
+  bool all_patches_loaded_ = false;
   std::filesystem::path patches_root_;
+  std::filesystem::path cache_root_;
 };
 }  // namespace patcher
 }  // namespace xe
@@ -14,9 +14,10 @@
 namespace xe {
 namespace patcher {
 
-Patcher::Patcher(const std::filesystem::path patches_root) {
+Patcher::Patcher(const std::filesystem::path patches_root,
+                 const std::filesystem::path cache_root) {
   is_any_patch_applied_ = false;
-  patch_db_ = new PatchDB(patches_root);
+  patch_db_ = new PatchDB(patches_root, cache_root);
 }
 
 void Patcher::ApplyPatchesForTitle(Memory* memory, const uint32_t title_id,
@@ -12,3 +12,5 @@ project("xenia-patcher")
   defines({
   })
   recursive_platform_files()
+
+include("testing")
@@ -0,0 +1,153 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "xenia/base/filesystem.h"
+#include "xenia/patcher/patch_db.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::patcher::test {
+
+constexpr uint32_t kTitleId = 0x4D5307E6;
+constexpr uint64_t kHash = 0x0123456789ABCDEF;
+// What the hand-written indices claim about the patch file, different from
+// its contents, to tell whether the index has been used or rebuilt.
+constexpr uint32_t kIndexedTitleId = 0x58410912;
+constexpr uint64_t kIndexedHash = 0xFEDCBA9876543210;
+
+constexpr char kPatchFileName[] = "4D5307E6 - Patch Index Test.patch.toml";
+constexpr char kPatchFile[] =
+    "title_name = \"Patch Index Test\"\n"
+    "title_id = \"4D5307E6\"\n"
+    "hash = \"0123456789ABCDEF\"\n"
+    "\n"
+    "[[patch]]\n"
+    "    name = \"Test\"\n"
+    "    desc = \"Test patch\"\n"
+    "    author = \"Xenia\"\n"
+    "    is_enabled = true\n"
+    "\n"
+    "    [[patch.be32]]\n"
+    "        address = 0x82000000\n"
+    "        value = 0x60000000\n";
+
+std::vector<uint8_t> ReadBytes(const std::filesystem::path& path) {
+  std::vector<uint8_t> bytes;
+  FILE* file = filesystem::OpenFile(path, "rb");
+  REQUIRE(file);
+  uint8_t buffer[256];
+  size_t read_size;
+  while ((read_size = fread(buffer, 1, sizeof(buffer), file)) != 0) {
+    bytes.insert(bytes.end(), buffer, buffer + read_size);
+  }
+  fclose(file);
+  return bytes;
+}
+
+void WriteBytes(const std::filesystem::path& path,
+                const std::vector<uint8_t>& bytes) {
+  FILE* file = filesystem::OpenFile(path, "wb");
+  REQUIRE(file);
+  REQUIRE(fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+  fclose(file);
+}
+
+template <typename T>
+void AppendValue(std::vector<uint8_t>& bytes, T value) {
+  const uint8_t* value_bytes = reinterpret_cast<const uint8_t*>(&value);
+  bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(T));
+}
+
+// Builds patches.idx with a single entry for the patch file, with the entry
+// count in the header set to entry_count.
+std::vector<uint8_t> BuildIndex(const filesystem::FileInfo& file_info,
+                                uint32_t entry_count) {
+  std::vector<uint8_t> bytes;
+  AppendValue(bytes, uint32_t(0x49445058));  // 'XPDI'
+  AppendValue(bytes, uint32_t(1));
+  AppendValue(bytes, entry_count);
+  std::string file_name = path_to_utf8(file_info.name);
+  AppendValue(bytes, file_info.write_timestamp);
+  AppendValue(bytes, file_info.total_size);
+  AppendValue(bytes, kIndexedTitleId);
+  AppendValue(bytes, uint32_t(file_name.size()));
+  AppendValue(bytes, uint32_t(1));
+  bytes.insert(bytes.end(), file_name.cbegin(), file_name.cend());
+  AppendValue(bytes, kIndexedHash);
+  return bytes;
+}
+
+TEST_CASE("Patch index", "[patcher]") {
+  std::filesystem::path root =
+      std::filesystem::temp_directory_path() / "xenia_patch_index_test";
+  std::filesystem::path index_path = root / "patches.idx";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "patches");
+  FILE* patch_file =
+      filesystem::OpenFile(root / "patches" / kPatchFileName, "wb");
+  REQUIRE(patch_file);
+  fwrite(kPatchFile, 1, std::strlen(kPatchFile), patch_file);
+  fclose(patch_file);
+  std::vector<filesystem::FileInfo> patch_files =
+      filesystem::ListFiles(root / "patches");
+  REQUIRE(patch_files.size() == 1);
+
+  SECTION("Built from the patch files") {
+    PatchDB patch_db(root, root);
+    REQUIRE(patch_db.GetTitlePatches(kTitleId, kHash).size() == 1);
+    REQUIRE(patch_db.GetTitlePatches(kTitleId, kIndexedHash).empty());
+    REQUIRE(patch_db.GetTitlePatches(kIndexedTitleId, kHash).empty());
+    REQUIRE(std::filesystem::exists(index_path));
+  }
+
+  SECTION("Valid index") {
+    std::vector<uint8_t> index = BuildIndex(patch_files[0], 1);
+    WriteBytes(index_path, index);
+    // The file hasn't changed since indexing, so it's not parsed again.
+    PatchDB patch_db(root, root);
+    REQUIRE(patch_db.GetTitlePatches(kIndexedTitleId, kIndexedHash).size() ==
+            1);
+    REQUIRE(patch_db.GetTitlePatches(kTitleId, kHash).empty());
+    REQUIRE(ReadBytes(index_path) == index);
+  }
+
+  SECTION("Truncated index") {
+    std::vector<uint8_t> index = BuildIndex(patch_files[0], 1);
+    index.resize(index.size() - 4);
+    WriteBytes(index_path, index);
+    PatchDB patch_db(root, root);
+    REQUIRE(patch_db.GetTitlePatches(kTitleId, kHash).size() == 1);
+    REQUIRE(patch_db.GetTitlePatches(kIndexedTitleId, kIndexedHash).empty());
+    // Rebuilt.
+    REQUIRE(ReadBytes(index_path).size() == index.size() + 4);
+  }
+
+  SECTION("Bogus entry count") {
+    WriteBytes(index_path, BuildIndex(patch_files[0], 0x7FFFFFFF));
+    PatchDB patch_db(root, root);
+    REQUIRE(patch_db.GetTitlePatches(kTitleId, kHash).size() == 1);
+    REQUIRE(patch_db.GetTitlePatches(kIndexedTitleId, kIndexedHash).empty());
+    std::vector<uint8_t> rebuilt_index = ReadBytes(index_path);
+    REQUIRE(rebuilt_index.size() >= sizeof(uint32_t) * 3);
+    uint32_t rebuilt_entry_count;
+    std::memcpy(&rebuilt_entry_count, rebuilt_index.data() + 8,
+                sizeof(uint32_t));
+    REQUIRE(rebuilt_entry_count == 1);
+  }
+
+  std::filesystem::remove_all(root);
+}
+
+}  // namespace xe::patcher::test
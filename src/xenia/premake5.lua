@@ -13,3 +13,29 @@ project("xenia-core")
   defines({
   })
   files({"*.h", "*.cc"})
+  removefiles({"*_main.cc"})
+
+group("src")
+project("xenia-memory-write-watch-bench")
+  uuid("c4f1a2d7-5e8b-4b39-8f06-d1e27a9b3c54")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "capstone", -- cpu-backend-x64
+    "fmt",
+    "mspack",
+    "imgui",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-base",
+    "xenia-kernel",
+    "xenia-patcher",
+  })
+  files({
+    "memory_write_watch_bench_main.cc",
+    "base/console_app_main_"..platform_suffix..".cc",
+  })
+  filter("architecture:x86_64")
+    links({
+      "xenia-cpu-backend-x64",
+    })
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <filesystem>
 #include <string>
+#include <vector>
 
 #include "xenia/base/logging.h"
 #include "xenia/base/platform.h"
@@ -63,6 +64,25 @@ bool SpirvToolsContext::Initialize(unsigned int spirv_version) {
     Shutdown();
     return false;
   }
+  if (!LoadLibraryFunction(fn_spvOptimizerCreate_, "spvOptimizerCreate") ||
+      !LoadLibraryFunction(fn_spvOptimizerDestroy_, "spvOptimizerDestroy") ||
+      !LoadLibraryFunction(fn_spvOptimizerRegisterPerformancePasses_,
+                           "spvOptimizerRegisterPerformancePasses") ||
+      !LoadLibraryFunction(fn_spvOptimizerRegisterSizePasses_,
+                           "spvOptimizerRegisterSizePasses") ||
+      !LoadLibraryFunction(fn_spvOptimizerRun_, "spvOptimizerRun") ||
+      !LoadLibraryFunction(fn_spvOptimizerOptionsCreate_,
+                           "spvOptimizerOptionsCreate") ||
+      !LoadLibraryFunction(fn_spvOptimizerOptionsDestroy_,
+                           "spvOptimizerOptionsDestroy") ||
+      !LoadLibraryFunction(fn_spvBinaryDestroy_, "spvBinaryDestroy")) {
+    XELOGW("SPIRV-Tools: The optimizer interface is not available");
+    fn_spvOptimizerCreate_ = nullptr;
+  }
+  if (!LoadLibraryFunction(fn_spvSoftwareVersionDetailsString_,
+                           "spvSoftwareVersionDetailsString")) {
+    fn_spvSoftwareVersionDetailsString_ = nullptr;
+  }
   spv_target_env target_env;
   if (spirv_version >= 0x10500) {
     target_env = SPV_ENV_VULKAN_1_2;
@@ -73,6 +93,7 @@ bool SpirvToolsContext::Initialize(unsigned int spirv_version) {
   } else {
     target_env = SPV_ENV_VULKAN_1_0;
   }
+  target_env_ = target_env;
   context_ = fn_spvContextCreate_(target_env);
   if (!context_) {
     XELOGE("SPIRV-Tools: Failed to create a Vulkan 1.0 context");
@@ -87,6 +108,8 @@ void SpirvToolsContext::Shutdown() {
     fn_spvContextDestroy_(context_);
     context_ = nullptr;
   }
+  fn_spvOptimizerCreate_ = nullptr;
+  fn_spvSoftwareVersionDetailsString_ = nullptr;
   if (library_) {
 #if XE_PLATFORM_LINUX
     dlclose(library_);
@@ -118,6 +141,67 @@ spv_result_t SpirvToolsContext::Validate(const uint32_t* words,
   return result;
 }
 
+spv_result_t SpirvToolsContext::Optimize(
+    const uint32_t* words, size_t num_words, bool for_size,
+    std::vector<uint32_t>& optimized_out) const {
+  optimized_out.clear();
+  if (!IsOptimizerAvailable()) {
+    return SPV_UNSUPPORTED;
+  }
+  spv_optimizer_t* optimizer = fn_spvOptimizerCreate_(target_env_);
+  if (!optimizer) {
+    return SPV_ERROR_INTERNAL;
+  }
+  if (for_size) {
+    fn_spvOptimizerRegisterSizePasses_(optimizer);
+  } else {
+    fn_spvOptimizerRegisterPerformancePasses_(optimizer);
+  }
+  spv_optimizer_options options = fn_spvOptimizerOptionsCreate_();
+  spv_binary optimized_binary = nullptr;
+  spv_result_t result = fn_spvOptimizerRun_(optimizer, words, num_words,
+                                            &optimized_binary, options);
+  fn_spvOptimizerOptionsDestroy_(options);
+  fn_spvOptimizerDestroy_(optimizer);
+  if (optimized_binary) {
+    if (result == SPV_SUCCESS) {
+      optimized_out.assign(
+          optimized_binary->code,
+          optimized_binary->code + optimized_binary->wordCount);
+    }
+    fn_spvBinaryDestroy_(optimized_binary);
+  }
+  if (result == SPV_SUCCESS) {
+    std::string validation_error;
+    if (optimized_out.empty() ||
+        Validate(optimized_out.data(), optimized_out.size(),
+                 &validation_error) != SPV_SUCCESS) {
+      XELOGE("SPIRV-Tools: The optimizer produced invalid SPIR-V{}{}",
+             validation_error.empty() ? "" : ": ", validation_error);
+      optimized_out.clear();
+      result = SPV_ERROR_INVALID_BINARY;
+    }
+  }
+  return result;
+}
+
+size_t SpirvToolsContext::CountInstructions(const uint32_t* words,
+                                            size_t num_words) {
+  // The header is 5 words, then each instruction has its word count in the
+  // upper 16 bits of the first word.
+  size_t instruction_count = 0;
+  size_t word_index = 5;
+  while (word_index < num_words) {
+    uint32_t instruction_word_count = words[word_index] >> 16;
+    if (!instruction_word_count) {
+      break;
+    }
+    word_index += instruction_word_count;
+    ++instruction_count;
+  }
+  return instruction_count;
+}
+
 }  // namespace vulkan
 }  // namespace ui
 }  // namespace xe
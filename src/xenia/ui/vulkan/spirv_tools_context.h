@@ -12,6 +12,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "third_party/SPIRV-Tools/include/spirv-tools/libspirv.h"
 #include "xenia/base/platform.h"
@@ -38,6 +39,30 @@ class SpirvToolsContext {
   spv_result_t Validate(const uint32_t* words, size_t num_words,
                         std::string* error) const;
 
+  // The optimizer C interface is only available in newer SPIRV-Tools builds,
+  // the context is still usable for validation without it.
+  bool IsOptimizerAvailable() const {
+    return context_ && fn_spvOptimizerCreate_;
+  }
+  // Runs the SPIRV-Tools size or performance pass recipe on the module. Creates
+  // its own optimizer, so can be called from any thread. The optimized module
+  // is validated before being returned, and if it's invalid, the result is
+  // SPV_ERROR_INVALID_BINARY, and optimized_out is empty.
+  spv_result_t Optimize(const uint32_t* words, size_t num_words,
+                        bool for_size,
+                        std::vector<uint32_t>& optimized_out) const;
+
+  // Version and build details of the loaded library, or nullptr if the library
+  // doesn't provide them.
+  const char* GetVersionDetails() const {
+    return fn_spvSoftwareVersionDetailsString_
+               ? fn_spvSoftwareVersionDetailsString_()
+               : nullptr;
+  }
+
+  // Number of instructions in the module, excluding the header.
+  static size_t CountInstructions(const uint32_t* words, size_t num_words);
+
  private:
 #if XE_PLATFORM_LINUX
   void* library_ = nullptr;
@@ -61,7 +86,22 @@ class SpirvToolsContext {
   decltype(&spvContextDestroy) fn_spvContextDestroy_ = nullptr;
   decltype(&spvValidateBinary) fn_spvValidateBinary_ = nullptr;
   decltype(&spvDiagnosticDestroy) fn_spvDiagnosticDestroy_ = nullptr;
+  // Optional.
+  decltype(&spvOptimizerCreate) fn_spvOptimizerCreate_ = nullptr;
+  decltype(&spvOptimizerDestroy) fn_spvOptimizerDestroy_ = nullptr;
+  decltype(&spvOptimizerRegisterPerformancePasses)
+      fn_spvOptimizerRegisterPerformancePasses_ = nullptr;
+  decltype(&spvOptimizerRegisterSizePasses) fn_spvOptimizerRegisterSizePasses_ =
+      nullptr;
+  decltype(&spvOptimizerRun) fn_spvOptimizerRun_ = nullptr;
+  decltype(&spvOptimizerOptionsCreate) fn_spvOptimizerOptionsCreate_ = nullptr;
+  decltype(&spvOptimizerOptionsDestroy) fn_spvOptimizerOptionsDestroy_ =
+      nullptr;
+  decltype(&spvBinaryDestroy) fn_spvBinaryDestroy_ = nullptr;
+  decltype(&spvSoftwareVersionDetailsString)
+      fn_spvSoftwareVersionDetailsString_ = nullptr;
 
+  spv_target_env target_env_ = SPV_ENV_VULKAN_1_0;
   spv_context context_ = nullptr;
 };
 
@@ -794,7 +794,9 @@ void VulkanProvider::TryCreateDevice() {
     device_info_.ext_1_2_VK_KHR_spirv_1_4 = true;
   }
   if (properties.apiVersion >= VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+    device_info_.ext_1_3_VK_EXT_extended_dynamic_state = true;
     device_info_.ext_1_3_VK_EXT_shader_demote_to_helper_invocation = true;
+    device_info_.ext_1_3_VK_EXT_extended_dynamic_state2 = true;
     device_info_.ext_1_3_VK_KHR_maintenance4 = true;
   }
 
@@ -822,6 +824,8 @@ void VulkanProvider::TryCreateDevice() {
       EXTENSION(VK_EXT_memory_budget)
       EXTENSION(VK_EXT_fragment_shader_interlock)
       EXTENSION(VK_EXT_non_seamless_cube_map)
+      EXTENSION(VK_KHR_pipeline_library)
+      EXTENSION(VK_EXT_graphics_pipeline_library)
     } else {
       if (!std::strcmp(extension.extensionName, "VK_KHR_portability_subset")) {
         XELOGW(
@@ -852,7 +856,9 @@ void VulkanProvider::TryCreateDevice() {
     }
     if (properties.apiVersion < VK_MAKE_API_VERSION(0, 1, 3, 0)) {
       if (instance_extensions_.khr_get_physical_device_properties2) {
+        EXTENSION_PROMOTED(VK_EXT_extended_dynamic_state, 3)
         EXTENSION_PROMOTED(VK_EXT_shader_demote_to_helper_invocation, 3)
+        EXTENSION_PROMOTED(VK_EXT_extended_dynamic_state2, 3)
       }
       if (properties.apiVersion >= VK_MAKE_API_VERSION(0, 1, 1, 0)) {
         EXTENSION_PROMOTED(VK_KHR_maintenance4, 3)
@@ -1018,11 +1024,34 @@ void VulkanProvider::TryCreateDevice() {
   if (device_info_.ext_VK_EXT_fragment_shader_interlock) {
     FEATURES2_ADD(FragmentShaderInterlockFeaturesEXT)
   }
+  // The extended dynamic state features are not a part of
+  // VkPhysicalDeviceVulkan13Features - the functionality is required in Vulkan
+  // 1.3, so the feature structures are only needed for the extensions.
+  FEATURES2_DECLARE(ExtendedDynamicStateFeaturesEXT,
+                    EXTENDED_DYNAMIC_STATE_FEATURES_EXT)
+  if (device_info_.ext_1_3_VK_EXT_extended_dynamic_state &&
+      properties.apiVersion < VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+    FEATURES2_ADD(ExtendedDynamicStateFeaturesEXT)
+  }
+  FEATURES2_DECLARE(ExtendedDynamicState2FeaturesEXT,
+                    EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT)
+  if (device_info_.ext_1_3_VK_EXT_extended_dynamic_state2 &&
+      properties.apiVersion < VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+    FEATURES2_ADD(ExtendedDynamicState2FeaturesEXT)
+  }
   FEATURES2_DECLARE(ShaderDemoteToHelperInvocationFeatures,
                     SHADER_DEMOTE_TO_HELPER_INVOCATION_FEATURES)
   if (device_info_.ext_1_3_VK_EXT_shader_demote_to_helper_invocation) {
     FEATURES2_ADD_PROMOTED(ShaderDemoteToHelperInvocationFeatures, 3)
   }
+  FEATURES2_DECLARE(GraphicsPipelineLibraryFeaturesEXT,
+                    GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT)
+  PROPERTIES2_DECLARE(GraphicsPipelineLibraryPropertiesEXT,
+                      GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT)
+  if (device_info_.ext_VK_EXT_graphics_pipeline_library) {
+    FEATURES2_ADD(GraphicsPipelineLibraryFeaturesEXT)
+    PROPERTIES2_ADD(GraphicsPipelineLibraryPropertiesEXT)
+  }
   FEATURES2_DECLARE(NonSeamlessCubeMapFeaturesEXT,
                     NON_SEAMLESS_CUBE_MAP_FEATURES_EXT)
   if (device_info_.ext_VK_EXT_non_seamless_cube_map) {
@@ -1116,11 +1145,44 @@ void VulkanProvider::TryCreateDevice() {
     }
   }
 
+  if (device_info_.ext_1_3_VK_EXT_extended_dynamic_state) {
+    if (properties.apiVersion >= VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+      // Promoted - required in Vulkan 1.3.
+      device_info_.extendedDynamicState = true;
+      XELOGVK("* extendedDynamicState");
+    } else {
+      EXTENSION_FEATURE(ExtendedDynamicStateFeaturesEXT, extendedDynamicState)
+    }
+  }
+
   if (device_info_.ext_1_3_VK_EXT_shader_demote_to_helper_invocation) {
     EXTENSION_FEATURE_PROMOTED(ShaderDemoteToHelperInvocationFeatures,
                                shaderDemoteToHelperInvocation, 3)
   }
 
+  if (device_info_.ext_1_3_VK_EXT_extended_dynamic_state2) {
+    if (properties.apiVersion >= VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+      // Promoted - required in Vulkan 1.3 (without the optional logic op and
+      // patch control points states, which are not used).
+      device_info_.extendedDynamicState2 = true;
+      XELOGVK("* extendedDynamicState2");
+    } else {
+      EXTENSION_FEATURE(ExtendedDynamicState2FeaturesEXT,
+                        extendedDynamicState2)
+    }
+  }
+
+  // VK_EXT_graphics_pipeline_library requires VK_KHR_pipeline_library.
+  if (device_info_.ext_VK_KHR_pipeline_library &&
+      device_info_.ext_VK_EXT_graphics_pipeline_library) {
+    EXTENSION_FEATURE(GraphicsPipelineLibraryFeaturesEXT,
+                      graphicsPipelineLibrary)
+    if (device_info_.graphicsPipelineLibrary) {
+      EXTENSION_PROPERTY(GraphicsPipelineLibraryPropertiesEXT,
+                         graphicsPipelineLibraryFastLinking)
+    }
+  }
+
   if (device_info_.ext_VK_EXT_non_seamless_cube_map) {
     EXTENSION_FEATURE(NonSeamlessCubeMapFeaturesEXT, nonSeamlessCubeMap)
   }
@@ -1339,6 +1401,8 @@ void VulkanProvider::TryCreateDevice() {
 #include "xenia/ui/vulkan/functions/device_khr_get_memory_requirements2.inc"
   }
   if (properties.apiVersion >= VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+#include "xenia/ui/vulkan/functions/device_ext_extended_dynamic_state.inc"
+#include "xenia/ui/vulkan/functions/device_ext_extended_dynamic_state2.inc"
 #include "xenia/ui/vulkan/functions/device_khr_maintenance4.inc"
   }
 #undef XE_UI_VULKAN_FUNCTION_PROMOTED
@@ -1361,6 +1425,12 @@ void VulkanProvider::TryCreateDevice() {
     }
   }
   if (properties.apiVersion < VK_MAKE_API_VERSION(0, 1, 3, 0)) {
+    if (device_info_.ext_1_3_VK_EXT_extended_dynamic_state) {
+#include "xenia/ui/vulkan/functions/device_ext_extended_dynamic_state.inc"
+    }
+    if (device_info_.ext_1_3_VK_EXT_extended_dynamic_state2) {
+#include "xenia/ui/vulkan/functions/device_ext_extended_dynamic_state2.inc"
+    }
     if (device_info_.ext_1_3_VK_KHR_maintenance4) {
 #include "xenia/ui/vulkan/functions/device_khr_maintenance4.inc"
     }
@@ -194,12 +194,35 @@ class VulkanProvider : public GraphicsProvider {
     bool fragmentShaderSampleInterlock;
     bool fragmentShaderPixelInterlock;
 
+    // VK_EXT_extended_dynamic_state (#268, Vulkan 1.3).
+
+    bool ext_1_3_VK_EXT_extended_dynamic_state;
+
+    bool extendedDynamicState;
+
     // VK_EXT_shader_demote_to_helper_invocation (#277, Vulkan 1.3).
 
     bool ext_1_3_VK_EXT_shader_demote_to_helper_invocation;
 
     bool shaderDemoteToHelperInvocation;
 
+    // VK_KHR_pipeline_library (#291).
+
+    bool ext_VK_KHR_pipeline_library;
+
+    // VK_EXT_graphics_pipeline_library (#321).
+
+    bool ext_VK_EXT_graphics_pipeline_library;
+
+    bool graphicsPipelineLibrary;
+    bool graphicsPipelineLibraryFastLinking;
+
+    // VK_EXT_extended_dynamic_state2 (#378, Vulkan 1.3).
+
+    bool ext_1_3_VK_EXT_extended_dynamic_state2;
+
+    bool extendedDynamicState2;
+
     // VK_KHR_maintenance4 (#414, Vulkan 1.3).
 
     bool ext_1_3_VK_KHR_maintenance4;
@@ -327,6 +350,8 @@ class VulkanProvider : public GraphicsProvider {
 #define XE_UI_VULKAN_FUNCTION_PROMOTED(extension_name, core_name) \
   PFN_##core_name core_name;
 #include "xenia/ui/vulkan/functions/device_1_0.inc"
+#include "xenia/ui/vulkan/functions/device_ext_extended_dynamic_state.inc"
+#include "xenia/ui/vulkan/functions/device_ext_extended_dynamic_state2.inc"
 #include "xenia/ui/vulkan/functions/device_khr_bind_memory2.inc"
 #include "xenia/ui/vulkan/functions/device_khr_get_memory_requirements2.inc"
 #include "xenia/ui/vulkan/functions/device_khr_maintenance4.inc"
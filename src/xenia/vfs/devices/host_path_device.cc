@@ -9,12 +9,25 @@
 
 #include "xenia/vfs/devices/host_path_device.h"
 
+#include "xenia/base/cvar.h"
 #include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
+#include "xenia/base/platform.h"
 #include "xenia/kernel/xfile.h"
 #include "xenia/vfs/devices/host_path_entry.h"
 
+#if XE_PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif  // XE_PLATFORM_LINUX
+
+DEFINE_bool(vfs_host_path_watch, false,
+            "Pick up files added to mounted host directories while the title "
+            "is running, for directories the title has already listed. Linux "
+            "only.",
+            "Storage");
+
 namespace xe {
 namespace vfs {
 
@@ -26,7 +39,13 @@ HostPathDevice::HostPathDevice(const std::string_view mount_path,
       host_path_(host_path),
       read_only_(read_only) {}
 
-HostPathDevice::~HostPathDevice() = default;
+HostPathDevice::~HostPathDevice() {
+#if XE_PLATFORM_LINUX
+  if (watch_fd_ >= 0) {
+    close(watch_fd_);
+  }
+#endif  // XE_PLATFORM_LINUX
+}
 
 bool HostPathDevice::Initialize() {
   if (!std::filesystem::exists(host_path_)) {
@@ -39,10 +58,19 @@ bool HostPathDevice::Initialize() {
     }
   }
 
+#if XE_PLATFORM_LINUX
+  if (cvars::vfs_host_path_watch) {
+    watch_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch_fd_ < 0) {
+      XELOGW("Failed to watch the host path for changes");
+    }
+  }
+#endif  // XE_PLATFORM_LINUX
+
+  // Directories are listed when they're first looked into.
   auto root_entry = new HostPathEntry(this, nullptr, "", host_path_);
   root_entry->attributes_ = kFileAttributeDirectory;
   root_entry_ = std::unique_ptr<Entry>(root_entry);
-  PopulateEntry(root_entry);
 
   return true;
 }
@@ -60,18 +88,43 @@ Entry* HostPathDevice::ResolvePath(const std::string_view path) {
   return root_entry_->ResolvePath(path);
 }
 
-void HostPathDevice::PopulateEntry(HostPathEntry* parent_entry) {
-  auto child_infos = xe::filesystem::ListFiles(parent_entry->host_path());
-  for (auto& child_info : child_infos) {
-    auto child = HostPathEntry::Create(
-        this, parent_entry, parent_entry->host_path() / child_info.name,
-        child_info);
-    parent_entry->children_.push_back(std::unique_ptr<Entry>(child));
+int HostPathDevice::WatchDirectory(const std::filesystem::path& host_path) {
+#if XE_PLATFORM_LINUX
+  if (watch_fd_ >= 0) {
+    return inotify_add_watch(watch_fd_, host_path.c_str(),
+                             IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+  }
+#endif  // XE_PLATFORM_LINUX
+  return -1;
+}
 
-    if (child_info.type == xe::filesystem::FileInfo::Type::kDirectory) {
-      PopulateEntry(child);
+bool HostPathDevice::ConsumeDirectoryChange(int watch_descriptor,
+                                            uint32_t& seen_overflow_count) {
+  std::lock_guard<xe_mutex> lock(watch_mutex_);
+#if XE_PLATFORM_LINUX
+  alignas(inotify_event) char buffer[4096];
+  ssize_t length;
+  while ((length = read(watch_fd_, buffer, sizeof(buffer))) > 0) {
+    for (ssize_t offset = 0; offset < length;) {
+      auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost, so every directory may have changed.
+        ++watch_overflow_count_;
+      } else if (event->mask & IN_IGNORED) {
+        changed_watch_descriptors_.erase(event->wd);
+      } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+        changed_watch_descriptors_.insert(event->wd);
+      }
+      offset += sizeof(inotify_event) + event->len;
     }
   }
+#endif  // XE_PLATFORM_LINUX
+  bool changed = changed_watch_descriptors_.erase(watch_descriptor) != 0;
+  if (seen_overflow_count != watch_overflow_count_) {
+    seen_overflow_count = watch_overflow_count_;
+    changed = true;
+  }
+  return changed;
 }
 
 }  // namespace vfs
@@ -11,7 +11,9 @@
 #define XENIA_VFS_DEVICES_HOST_PATH_DEVICE_H_
 
 #include <string>
+#include <unordered_set>
 
+#include "xenia/base/mutex.h"
 #include "xenia/vfs/device.h"
 
 namespace xe {
@@ -44,13 +46,25 @@ class HostPathDevice : public Device {
   friend class HostPathEntry;
   std::filesystem::path host_path() const { return host_path_; }
 
- private:
-  void PopulateEntry(HostPathEntry* parent_entry);
+  // Starts watching a listed directory for files added on the host, returning
+  // the watch descriptor, or -1 if host changes are not watched.
+  int WatchDirectory(const std::filesystem::path& host_path);
+  // Whether files may have been added to the watched directory since the last
+  // call for it, which saw the returned number of event queue overflows.
+  bool ConsumeDirectoryChange(int watch_descriptor,
+                              uint32_t& seen_overflow_count);
 
+ private:
   std::string name_;
   std::filesystem::path host_path_;
   std::unique_ptr<Entry> root_entry_;
   bool read_only_;
+
+  // inotify instance if vfs_host_path_watch is enabled.
+  int watch_fd_ = -1;
+  xe_mutex watch_mutex_;
+  std::unordered_set<int> changed_watch_descriptors_;
+  uint32_t watch_overflow_count_ = 0;
 };
 
 }  // namespace vfs
@@ -9,6 +9,8 @@
 
 #include "xenia/vfs/devices/host_path_entry.h"
 
+#include <unordered_set>
+
 #include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/mapped_memory.h"
@@ -120,6 +122,41 @@ void HostPathEntry::RenameEntryInternal(const std::filesystem::path file_path) {
   host_path_ = new_host_path_;
 }
 
+void HostPathEntry::PopulateChildren() {
+  if (!(attributes_ & kFileAttributeDirectory)) {
+    return;
+  }
+  auto host_device = static_cast<HostPathDevice*>(device_);
+  bool refresh = children_populated_;
+  if (refresh) {
+    if (watch_descriptor_ < 0 ||
+        !host_device->ConsumeDirectoryChange(watch_descriptor_,
+                                             seen_watch_overflow_count_)) {
+      return;
+    }
+  } else {
+    // Watch before listing so no additions are missed.
+    watch_descriptor_ = host_device->WatchDirectory(host_path_);
+    children_populated_ = true;
+  }
+  // Only additions are picked up when refreshing. Entries of removed files
+  // stay, and OpenFile drops them when it finds the file gone, as entries may
+  // still be referenced by open files.
+  std::unordered_set<std::string> existing_names;
+  if (refresh) {
+    for (const auto& child : children_) {
+      existing_names.insert(child->name());
+    }
+  }
+  for (auto& child_info : xe::filesystem::ListFiles(host_path_)) {
+    if (refresh && existing_names.count(xe::path_to_utf8(child_info.name))) {
+      continue;
+    }
+    children_.emplace_back(HostPathEntry::Create(
+        device_, this, host_path_ / child_info.name, child_info));
+  }
+}
+
 void HostPathEntry::update() {
   xe::filesystem::FileInfo file_info;
   if (!xe::filesystem::GetInfo(host_path_, &file_info)) {
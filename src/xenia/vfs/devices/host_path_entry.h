@@ -47,8 +47,12 @@ class HostPathEntry : public Entry {
                                              uint32_t attributes) override;
   bool DeleteEntryInternal(Entry* entry) override;
   void RenameEntryInternal(const std::filesystem::path file_path) override;
+  void PopulateChildren() override;
 
   std::filesystem::path host_path_;
+  bool children_populated_ = false;
+  int watch_descriptor_ = -1;
+  uint32_t seen_watch_overflow_count_ = 0;
 };
 
 }  // namespace vfs
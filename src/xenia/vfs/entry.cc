@@ -16,6 +16,11 @@
 namespace xe {
 namespace vfs {
 
+// Hashing the names only pays off over the linear scan for big directories.
+constexpr size_t kMinIndexedChildCount = 16;
+
+std::atomic<uint32_t> Entry::tree_generation_{0};
+
 Entry::Entry(Device* device, Entry* parent, const std::string_view path)
     : device_(device),
       parent_(parent),
@@ -46,16 +51,47 @@ void Entry::Dump(xe::StringBuffer* string_buffer, int indent) {
 
 bool Entry::is_read_only() const { return device_->is_read_only(); }
 
+const std::vector<std::unique_ptr<Entry>>& Entry::children() {
+  std::lock_guard<xe_mutex> lock(children_mutex_);
+  PopulateChildren();
+  return children_;
+}
+
+size_t Entry::child_count() {
+  std::lock_guard<xe_mutex> lock(children_mutex_);
+  PopulateChildren();
+  return children_.size();
+}
+
 Entry* Entry::GetChild(const std::string_view name) {
-  auto global_lock = global_critical_region_.Acquire();
-  auto it = std::find_if(children_.cbegin(), children_.cend(),
-                         [&](const auto& child) {
-                           return xe::utf8::equal_case(child->name(), name);
-                         });
-  if (it == children_.cend()) {
+  std::lock_guard<xe_mutex> lock(children_mutex_);
+  PopulateChildren();
+  if (children_.size() < kMinIndexedChildCount) {
+    auto it = std::find_if(children_.cbegin(), children_.cend(),
+                           [&](const auto& child) {
+                             return xe::utf8::equal_case(child->name(), name);
+                           });
+    if (it == children_.cend()) {
+      return nullptr;
+    }
+    return (*it).get();
+  }
+  // Like the linear scan, prefer the first child if the names only differ in
+  // case (possible on host file systems).
+  for (; indexed_child_count_ < children_.size(); ++indexed_child_count_) {
+    Entry* child = children_[indexed_child_count_].get();
+    child_index_.emplace(string_key_case::create(child->name()), child);
+  }
+  auto it = child_index_.find(string_key_case(name));
+  if (it == child_index_.cend()) {
     return nullptr;
   }
-  return (*it).get();
+  return it->second;
+}
+
+void Entry::InvalidateChildIndex() {
+  child_index_.clear();
+  indexed_child_count_ = 0;
 }
 
 Entry* Entry::ResolvePath(const std::string_view path) {
@@ -73,7 +109,8 @@ Entry* Entry::ResolvePath(const std::string_view path) {
 
 Entry* Entry::IterateChildren(const xe::filesystem::WildcardEngine& engine,
                               size_t* current_index) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(children_mutex_);
+  PopulateChildren();
   while (*current_index < children_.size()) {
     auto& child = children_[*current_index];
     *current_index = *current_index + 1;
@@ -97,10 +134,15 @@ Entry* Entry::CreateEntry(const std::string_view name, uint32_t attributes) {
   if (!entry) {
     return nullptr;
   }
-  children_.push_back(std::move(entry));
+  Entry* created_entry = entry.get();
+  {
+    std::lock_guard<xe_mutex> lock(children_mutex_);
+    children_.push_back(std::move(entry));
+  }
+  AdvanceTreeGeneration();
   // TODO(benvanik): resort? would break iteration?
   Touch();
-  return children_.back().get();
+  return created_entry;
 }
 
 bool Entry::Delete(Entry* entry) {
@@ -114,12 +156,17 @@ bool Entry::Delete(Entry* entry) {
   if (!DeleteEntryInternal(entry)) {
     return false;
   }
-  for (auto it = children_.begin(); it != children_.end(); ++it) {
-    if (it->get() == entry) {
-      children_.erase(it);
-      break;
+  {
+    std::lock_guard<xe_mutex> lock(children_mutex_);
+    for (auto it = children_.begin(); it != children_.end(); ++it) {
+      if (it->get() == entry) {
+        children_.erase(it);
+        break;
+      }
     }
+    InvalidateChildIndex();
   }
+  AdvanceTreeGeneration();
   Touch();
   return true;
 }
@@ -147,7 +194,14 @@ void Entry::Rename(const std::filesystem::path file_path) {
   absolute_path_ = xe::utf8::join_guest_paths(device_->mount_path(),
                                               guest_path_without_root);
   path_ = guest_path_without_root;
-  name_ = xe::path_to_utf8(file_path.filename());
+  if (parent_) {
+    std::lock_guard<xe_mutex> lock(parent_->children_mutex_);
+    name_ = xe::path_to_utf8(file_path.filename());
+    parent_->InvalidateChildIndex();
+  } else {
+    name_ = xe::path_to_utf8(file_path.filename());
+  }
+  AdvanceTreeGeneration();
 }
 
 }  // namespace vfs
@@ -10,8 +10,10 @@
 #ifndef XENIA_VFS_ENTRY_H_
 #define XENIA_VFS_ENTRY_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "xenia/base/filesystem.h"
@@ -19,6 +21,7 @@
 #include "xenia/base/mapped_memory.h"
 #include "xenia/base/mutex.h"
 #include "xenia/base/string_buffer.h"
+#include "xenia/base/string_key.h"
 #include "xenia/xbox.h"
 
 namespace xe {
@@ -99,10 +102,8 @@ class Entry {
   Entry* GetChild(const std::string_view name);
   Entry* ResolvePath(const std::string_view path);
 
-  const std::vector<std::unique_ptr<Entry>>& children() const {
-    return children_;
-  }
-  size_t child_count() const { return children_.size(); }
+  const std::vector<std::unique_ptr<Entry>>& children();
+  size_t child_count();
   Entry* IterateChildren(const xe::filesystem::WildcardEngine& engine,
                          size_t* current_index);
 
@@ -112,6 +113,12 @@ class Entry {
   void Touch();
 
   void Rename(const std::filesystem::path file_path);
+
+  // Changes whenever an entry is created, deleted or renamed on any device, so
+  // cached path resolutions can be invalidated.
+  static uint32_t tree_generation() {
+    return tree_generation_.load(std::memory_order_acquire);
+  }
   // If successful, out_file points to a new file. When finished, call
   // file->Destroy()
   virtual X_STATUS Open(uint32_t desired_access, File** out_file) = 0;
@@ -133,6 +140,16 @@ class Entry {
   }
   virtual bool DeleteEntryInternal(Entry* entry) { return false; }
   virtual void RenameEntryInternal(const std::filesystem::path file_path) {}
+  // Called with children_mutex_ held before the children are looked up or
+  // enumerated, for devices listing directories on demand.
+  virtual void PopulateChildren() {}
+
+  // Must be called with children_mutex_ held when children_ is modified other
+  // than by appending.
+  void InvalidateChildIndex();
+  static void AdvanceTreeGeneration() {
+    tree_generation_.fetch_add(1, std::memory_order_acq_rel);
+  }
 
   xe::global_critical_region global_critical_region_;
   Device* device_;
@@ -147,6 +164,17 @@ class Entry {
   uint64_t access_timestamp_;
   uint64_t write_timestamp_;
   std::vector<std::unique_ptr<Entry>> children_;
+
+  // Guards children_ and the index, without the global lock.
+  xe_mutex children_mutex_;
+  // Case-insensitive index of the first indexed_child_count_ children by name.
+  // Devices append to children_ directly, so the new children are indexed on
+  // the next lookup. Small directories are scanned linearly instead.
+  std::unordered_map<string_key_case, Entry*> child_index_;
+  size_t indexed_child_count_ = 0;
+
+ private:
+  static std::atomic<uint32_t> tree_generation_;
 };
 
 }  // namespace vfs
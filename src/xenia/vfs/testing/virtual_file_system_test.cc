@@ -0,0 +1,91 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2023 Ben Vanik. All rights reserved.                             *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "xenia/base/filesystem.h"
+#include "xenia/vfs/devices/host_path_device.h"
+#include "xenia/vfs/virtual_file_system.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::vfs::test {
+
+TEST_CASE("VFS Resolve path", "[vfs]") {
+  std::filesystem::path host_path =
+      std::filesystem::temp_directory_path() / "xenia_vfs_resolve_path_test";
+  std::filesystem::remove_all(host_path);
+  // Enough files for the directory to be indexed rather than scanned.
+  std::filesystem::create_directories(host_path / "Data" / "Sub");
+  for (int i = 0; i < 32; ++i) {
+    FILE* file = filesystem::OpenFile(
+        host_path / "Data" / ("File" + std::to_string(i) + ".bin"), "wb");
+    REQUIRE(file);
+    fclose(file);
+  }
+
+  {
+    VirtualFileSystem vfs;
+    auto device = std::make_unique<HostPathDevice>("\\Device\\VfsTest",
+                                                   host_path, false);
+    REQUIRE(device->Initialize());
+    REQUIRE(vfs.RegisterDevice(std::move(device)));
+    REQUIRE(vfs.RegisterSymbolicLink("test:", "\\Device\\VfsTest"));
+
+    SECTION("Case-insensitive") {
+      Entry* entry = vfs.ResolvePath("test:\\data\\FILE17.BIN");
+      REQUIRE(entry);
+      REQUIRE(entry->name() == "File17.bin");
+      REQUIRE(vfs.ResolvePath("TEST:\\Data\\file17.bin") == entry);
+      REQUIRE(vfs.ResolvePath("test:\\Data\\Sub")->parent() ==
+              vfs.ResolvePath("test:\\Data"));
+      REQUIRE(!vfs.ResolvePath("test:\\Data\\File32.bin"));
+      REQUIRE(!vfs.ResolvePath("test:\\Data\\Sub\\File17.bin"));
+    }
+
+    SECTION("Create and delete") {
+      REQUIRE(!vfs.ResolvePath("test:\\Data\\New.bin"));
+      Entry* entry =
+          vfs.CreatePath("test:\\Data\\New.bin", kFileAttributeNormal);
+      REQUIRE(entry);
+      REQUIRE(vfs.ResolvePath("test:\\data\\new.bin") == entry);
+      REQUIRE(vfs.DeletePath("test:\\Data\\New.bin"));
+      REQUIRE(!vfs.ResolvePath("test:\\data\\new.bin"));
+      REQUIRE(vfs.ResolvePath("test:\\Data\\File0.bin"));
+      REQUIRE(vfs.DeletePath("test:\\Data\\File0.bin"));
+      REQUIRE(!vfs.ResolvePath("test:\\Data\\File0.bin"));
+      REQUIRE(vfs.ResolvePath("test:\\Data\\File1.bin"));
+    }
+
+    SECTION("Directories listed on demand") {
+      // Not listed yet, so a file added on the host after mounting is found.
+      FILE* file =
+          filesystem::OpenFile(host_path / "Data" / "Sub" / "Late.bin", "wb");
+      REQUIRE(file);
+      fclose(file);
+      Entry* sub = vfs.ResolvePath("test:\\Data\\Sub");
+      REQUIRE(sub);
+      REQUIRE(sub->child_count() == 1);
+      REQUIRE(vfs.ResolvePath("test:\\Data\\Sub\\late.bin"));
+    }
+
+    SECTION("Unregister device") {
+      REQUIRE(vfs.ResolvePath("test:\\Data\\File1.bin"));
+      REQUIRE(vfs.UnregisterDevice("\\Device\\VfsTest"));
+      REQUIRE(!vfs.ResolvePath("test:\\Data\\File1.bin"));
+    }
+  }
+
+  std::filesystem::remove_all(host_path);
+}
+
+}  // namespace xe::vfs::test
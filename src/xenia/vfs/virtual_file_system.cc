@@ -12,11 +12,17 @@
 #include "xenia/vfs/devices/xcontent_container_device.h"
 
 #include "devices/host_path_entry.h"
+#include "xenia/base/cvar.h"
 #include "xenia/base/literals.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/string.h"
 #include "xenia/kernel/xfile.h"
 
+DEFINE_int32(vfs_path_cache_size, 4096,
+             "Number of recently resolved guest file paths to remember, to "
+             "avoid walking the directory tree for them again. 0 to disable.",
+             "Storage");
+
 namespace xe {
 namespace vfs {
 
@@ -31,21 +37,26 @@ VirtualFileSystem::~VirtualFileSystem() {
 }
 
 void VirtualFileSystem::Clear() {
+  std::lock_guard<xe_mutex> lock(mutex_);
+  ClearPathCache();
   devices_.clear();
   symlinks_.clear();
 }
 
 bool VirtualFileSystem::RegisterDevice(std::unique_ptr<Device> device) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(mutex_);
+  // Paths not found before may now be on the new device, but only existing
+  // paths are cached.
   devices_.emplace_back(std::move(device));
   return true;
 }
 
 bool VirtualFileSystem::UnregisterDevice(const std::string_view path) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(mutex_);
   for (auto it = devices_.begin(); it != devices_.end(); ++it) {
     if ((*it)->mount_path() == path) {
       XELOGD("Unregistered device: {}", (*it)->mount_path());
+      ClearPathCache();
       devices_.erase(it);
       return true;
     }
@@ -55,7 +66,8 @@ bool VirtualFileSystem::UnregisterDevice(const std::string_view path) {
 
 bool VirtualFileSystem::RegisterSymbolicLink(const std::string_view path,
                                              const std::string_view target) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(mutex_);
+  ClearPathCache();
   symlinks_.insert({std::string(path), std::string(target)});
   XELOGD("Registered symbolic link: {} => {}", path, target);
 
@@ -63,7 +75,7 @@ bool VirtualFileSystem::RegisterSymbolicLink(const std::string_view path,
 }
 
 bool VirtualFileSystem::UnregisterSymbolicLink(const std::string_view path) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(mutex_);
   auto it = std::find_if(
       symlinks_.cbegin(), symlinks_.cend(),
       [&](const auto& s) { return xe::utf8::equal_case(path, s.first); });
@@ -72,6 +84,7 @@ bool VirtualFileSystem::UnregisterSymbolicLink(const std::string_view path) {
   }
   XELOGD("Unregistered symbolic link: {} => {}", it->first, it->second);
 
+  ClearPathCache();
   symlinks_.erase(it);
   return true;
 }
@@ -109,22 +122,62 @@ bool VirtualFileSystem::ResolveSymbolicLink(const std::string_view path,
   return was_resolved;
 }
 
+Entry* VirtualFileSystem::LookupCachedPath(const std::string_view path) {
+  uint32_t tree_generation = Entry::tree_generation();
+  if (path_cache_tree_generation_ != tree_generation) {
+    ClearPathCache();
+    path_cache_tree_generation_ = tree_generation;
+    return nullptr;
+  }
+  auto it = path_cache_index_.find(string_key_case(path));
+  if (it == path_cache_index_.end()) {
+    return nullptr;
+  }
+  path_cache_.splice(path_cache_.begin(), path_cache_, it->second);
+  return it->second->second;
+}
+
+void VirtualFileSystem::CachePath(const std::string_view path, Entry* entry) {
+  size_t cache_size = size_t(std::max(cvars::vfs_path_cache_size, 0));
+  if (!cache_size) {
+    return;
+  }
+  if (path_cache_.size() >= cache_size) {
+    path_cache_index_.erase(string_key_case(path_cache_.back().first));
+    path_cache_.pop_back();
+  }
+  path_cache_.emplace_front(std::string(path), entry);
+  path_cache_index_.emplace(string_key_case(path_cache_.front().first),
+                            path_cache_.begin());
+}
+
+void VirtualFileSystem::ClearPathCache() {
+  path_cache_index_.clear();
+  path_cache_.clear();
+}
+
 Entry* VirtualFileSystem::ResolvePath(const std::string_view path) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::lock_guard<xe_mutex> lock(mutex_);
 
   // Resolve relative paths
   auto normalized_path(xe::utf8::canonicalize_guest_path(path));
 
+  Entry* cached_entry = LookupCachedPath(normalized_path);
+  if (cached_entry) {
+    return cached_entry;
+  }
+
   // Resolve symlinks.
   std::string resolved_path;
+  std::string_view device_path = normalized_path;
   if (ResolveSymbolicLink(normalized_path, resolved_path)) {
-    normalized_path = resolved_path;
+    device_path = resolved_path;
   }
 
   // Find the device.
   auto it =
       std::find_if(devices_.cbegin(), devices_.cend(), [&](const auto& d) {
-        return xe::utf8::starts_with(normalized_path, d->mount_path());
+        return xe::utf8::starts_with(device_path, d->mount_path());
       });
   if (it == devices_.cend()) {
     // Supress logging the error for ShaderDumpxe:\CompareBackEnds as this is
@@ -136,8 +189,12 @@ Entry* VirtualFileSystem::ResolvePath(const std::string_view path) {
   }
 
   const auto& device = *it;
-  auto relative_path = normalized_path.substr(device->mount_path().size());
-  return device->ResolvePath(relative_path);
+  auto relative_path = device_path.substr(device->mount_path().size());
+  Entry* entry = device->ResolvePath(relative_path);
+  if (entry) {
+    CachePath(normalized_path, entry);
+  }
+  return entry;
 }
 
 Entry* VirtualFileSystem::CreatePath(const std::string_view path,
@@ -10,12 +10,15 @@
 #ifndef XENIA_VFS_VIRTUAL_FILE_SYSTEM_H_
 #define XENIA_VFS_VIRTUAL_FILE_SYSTEM_H_
 
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "xenia/base/mutex.h"
+#include "xenia/base/string_key.h"
 #include "xenia/vfs/device.h"
 #include "xenia/vfs/entry.h"
 #include "xenia/vfs/file.h"
@@ -58,11 +61,27 @@ class VirtualFileSystem {
                                    std::filesystem::path base_path);
 
  private:
-  xe::global_critical_region global_critical_region_;
+  // Guards the devices, the symbolic links and the path cache.
+  xe_mutex mutex_;
   std::vector<std::unique_ptr<Device>> devices_;
   std::unordered_map<std::string, std::string> symlinks_;
 
+  // Recently resolved canonical paths, most recently used first. The index
+  // keys point to the strings in the list nodes. Only paths that exist are
+  // cached, and the whole cache is dropped when the entry tree, the devices or
+  // the links change.
+  using PathCacheList = std::list<std::pair<std::string, Entry*>>;
+  PathCacheList path_cache_;
+  std::unordered_map<string_key_case, PathCacheList::iterator>
+      path_cache_index_;
+  uint32_t path_cache_tree_generation_ = 0;
+
   bool ResolveSymbolicLink(const std::string_view path, std::string& result);
+
+  // Must be called with mutex_ held.
+  Entry* LookupCachedPath(const std::string_view path);
+  void CachePath(const std::string_view path, Entry* entry);
+  void ClearPathCache();
 };
 
 }  // namespace vfs